@@ -19,6 +19,7 @@ HEADERS += \
     $$PWD/header/xlsxcelllocation.h \
     $$PWD/header/xlsxcellrange.h \
     $$PWD/header/xlsxcellreference.h \
+    $$PWD/header/xlsxcelltable_p.h \
     $$PWD/header/xlsxchart.h \
     $$PWD/header/xlsxchart_p.h \
     $$PWD/header/xlsxchartsheet.h \
@@ -56,14 +57,33 @@ HEADERS += \
     $$PWD/header/xlsxzipreader_p.h \
     $$PWD/header/xlsxzipwriter_p.h \
     $$PWD/aboutdialog.h \
+    $$PWD/acquisitionlog.h \
+    $$PWD/acquisitionlogformat.h \
+    $$PWD/binarytable.h \
+    $$PWD/commandtree.h \
     $$PWD/conversions.h \
+    $$PWD/currentmatcher.h \
+    $$PWD/latencydialog.h \
+    $$PWD/latencystats.h \
     $$PWD/magnetparams.h \
     $$PWD/multiaxisoperation.h \
     $$PWD/optionsdialog.h \
     $$PWD/parser.h \
     $$PWD/processmanager.h \
-    $$PWD/qtablewidgetwithcopypaste.h \
+    $$PWD/qtableviewwithcopypaste.h \
+    $$PWD/quenchwatchdog.h \
+    $$PWD/recordframing.h \
+    $$PWD/remoteserver.h \
+    $$PWD/reportwriter.h \
+    $$PWD/resultsjournal.h \
+    $$PWD/samplehistory.h \
+    $$PWD/sequencer.h \
     $$PWD/stdafx.h \
+    $$PWD/stripchart.h \
+    $$PWD/tableloader.h \
+    $$PWD/tablemodel.h \
+    $$PWD/tablevalidator.h \
+    $$PWD/tablewriter.h \
     $$PWD/version.h
 SOURCES += \
     $$PWD/optionsdialog.cpp \
@@ -74,6 +94,7 @@ SOURCES += \
     $$PWD/source/xlsxcelllocation.cpp \
     $$PWD/source/xlsxcellrange.cpp \
     $$PWD/source/xlsxcellreference.cpp \
+    $$PWD/source/xlsxcelltable.cpp \
     $$PWD/source/xlsxchart.cpp \
     $$PWD/source/xlsxchartsheet.cpp \
     $$PWD/source/xlsxcolor.cpp \
@@ -101,7 +122,12 @@ SOURCES += \
     $$PWD/source/xlsxzipreader.cpp \
     $$PWD/source/xlsxzipwriter.cpp \
     $$PWD/aboutdialog.cpp \
+    $$PWD/acquisitionlog.cpp \
+    $$PWD/binarytable.cpp \
     $$PWD/conversions.cpp \
+    $$PWD/currentmatcher.cpp \
+    $$PWD/latencydialog.cpp \
+    $$PWD/latencystats.cpp \
     $$PWD/magnetparams.cpp \
     $$PWD/main.cpp \
     $$PWD/multiaxisoperation-align.cpp \
@@ -111,11 +137,24 @@ SOURCES += \
     $$PWD/multiaxisoperation.cpp \
     $$PWD/parser.cpp \
     $$PWD/processmanager.cpp \
-    $$PWD/qtablewidgetwithcopypaste.cpp \
+    $$PWD/qtableviewwithcopypaste.cpp \
+    $$PWD/quenchwatchdog.cpp \
+    $$PWD/recordframing.cpp \
+    $$PWD/remoteserver.cpp \
+    $$PWD/reportwriter.cpp \
+    $$PWD/resultsjournal.cpp \
+    $$PWD/samplehistory.cpp \
+    $$PWD/sequencer.cpp \
+    $$PWD/stripchart.cpp \
+    $$PWD/tableloader.cpp \
+    $$PWD/tablemodel.cpp \
+    $$PWD/tablevalidator.cpp \
+    $$PWD/tablewriter.cpp \
     $$PWD/stdafx.cpp
 FORMS += ./multiaxisoperation.ui \
     $$PWD/multiaxisoperation.ui \
     $$PWD/optionsdialog.ui \
     ./magnetparams.ui \
-    ./aboutdialog.ui
+    ./aboutdialog.ui \
+    $$PWD/latencydialog.ui
 RESOURCES += multiaxisoperation.qrc
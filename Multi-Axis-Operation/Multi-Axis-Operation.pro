@@ -4,6 +4,7 @@
 
 TEMPLATE = app
 TARGET = Multi-Axis-Operation
+CONFIG += c++17
 QT += core network widgets gui concurrent gui-private
 DEFINES += QT_NETWORK_LIB QT_CONCURRENT_LIB QT_WIDGETS_LIB
 INCLUDEPATH += ./GeneratedFiles/$(ConfigurationName) \
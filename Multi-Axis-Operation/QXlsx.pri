@@ -60,8 +60,10 @@ $${QXLSX_HEADERPATH}xlsxabstractsheet_p.h \
 $${QXLSX_HEADERPATH}xlsxcell.h \
 $${QXLSX_HEADERPATH}xlsxcellformula.h \
 $${QXLSX_HEADERPATH}xlsxcellformula_p.h \
+$${QXLSX_HEADERPATH}xlsxcelllocation.h \
 $${QXLSX_HEADERPATH}xlsxcellrange.h \
 $${QXLSX_HEADERPATH}xlsxcellreference.h \
+$${QXLSX_HEADERPATH}xlsxcelltable_p.h \
 $${QXLSX_HEADERPATH}xlsxcell_p.h \
 $${QXLSX_HEADERPATH}xlsxchart.h \
 $${QXLSX_HEADERPATH}xlsxchartsheet.h \
@@ -73,6 +75,7 @@ $${QXLSX_HEADERPATH}xlsxconditionalformatting_p.h \
 $${QXLSX_HEADERPATH}xlsxcontenttypes_p.h \
 $${QXLSX_HEADERPATH}xlsxdatavalidation.h \
 $${QXLSX_HEADERPATH}xlsxdatavalidation_p.h \
+$${QXLSX_HEADERPATH}xlsxdatetype.h \
 $${QXLSX_HEADERPATH}xlsxdocpropsapp_p.h \
 $${QXLSX_HEADERPATH}xlsxdocpropscore_p.h \
 $${QXLSX_HEADERPATH}xlsxdocument.h \
@@ -104,14 +107,17 @@ $${QXLSX_SOURCEPATH}xlsxabstractooxmlfile.cpp \
 $${QXLSX_SOURCEPATH}xlsxabstractsheet.cpp \
 $${QXLSX_SOURCEPATH}xlsxcell.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellformula.cpp \
+$${QXLSX_SOURCEPATH}xlsxcelllocation.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellrange.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellreference.cpp \
+$${QXLSX_SOURCEPATH}xlsxcelltable.cpp \
 $${QXLSX_SOURCEPATH}xlsxchart.cpp \
 $${QXLSX_SOURCEPATH}xlsxchartsheet.cpp \
 $${QXLSX_SOURCEPATH}xlsxcolor.cpp \
 $${QXLSX_SOURCEPATH}xlsxconditionalformatting.cpp \
 $${QXLSX_SOURCEPATH}xlsxcontenttypes.cpp \
 $${QXLSX_SOURCEPATH}xlsxdatavalidation.cpp \
+$${QXLSX_SOURCEPATH}xlsxdatetype.cpp \
 $${QXLSX_SOURCEPATH}xlsxdocpropsapp.cpp \
 $${QXLSX_SOURCEPATH}xlsxdocpropscore.cpp \
 $${QXLSX_SOURCEPATH}xlsxdocument.cpp \
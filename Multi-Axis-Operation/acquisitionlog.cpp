@@ -0,0 +1,198 @@
+#include "stdafx.h"
+#include "acquisitionlog.h"
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+const int RECORDS_PER_CHUNK = 65536;	// 4 MB preallocated per chunk
+const qint64 CHUNK_BYTES = (qint64)RECORDS_PER_CHUNK * sizeof(AcqLogRecord);
+const int FLUSH_RECORDS = 64;			// flush after this many unflushed records
+const qint64 FLUSH_INTERVAL = 5000;		// or after this many msec
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+AcquisitionLog::AcquisitionLog()
+{
+	mapped = nullptr;
+	chunkOffset = 0;
+	chunkUsed = 0;
+	flushedUsed = 0;
+	sequence = 0;
+	lastFlush = 0;
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+AcquisitionLog::~AcquisitionLog()
+{
+	close();
+}
+
+//---------------------------------------------------------------------------
+bool AcquisitionLog::open(QString filename, int fieldUnits)
+{
+	close();
+
+	QFileInfo info(filename);
+	QDir().mkpath(info.absolutePath());
+
+	file.setFileName(filename);
+
+	if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+	{
+		qDebug() << "Unable to create acquisition log" << filename;
+		return false;
+	}
+
+	AcqLogHeader header;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ACQ_LOG_MAGIC, sizeof(header.magic));
+	header.version = ACQ_LOG_VERSION;
+	header.headerSize = sizeof(AcqLogHeader);
+	header.recordSize = sizeof(AcqLogRecord);
+	header.fieldUnits = fieldUnits;
+	header.startTime = QDateTime::currentMSecsSinceEpoch();
+	clock.start();
+
+	if (file.write((const char *)&header, sizeof(header)) != sizeof(header))
+	{
+		file.close();
+		return false;
+	}
+
+	sequence = 0;
+	lastFlush = 0;
+
+	if (!mapNextChunk())
+	{
+		file.close();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Unmaps the log and trims the unused preallocation, then marks the header
+// as cleanly closed with the final record count
+void AcquisitionLog::close(void)
+{
+	if (mapped == nullptr)
+		return;
+
+	flush();
+	file.unmap(mapped);
+	mapped = nullptr;
+
+	file.resize(sizeof(AcqLogHeader) + (qint64)sequence * sizeof(AcqLogRecord));
+
+	AcqLogHeader header;
+
+	if (file.seek(0) && file.read((char *)&header, sizeof(header)) == sizeof(header))
+	{
+		header.recordCount = sequence;
+		header.cleanClose = 1;
+		file.seek(0);
+		file.write((const char *)&header, sizeof(header));
+	}
+
+	file.close();
+}
+
+//---------------------------------------------------------------------------
+void AcquisitionLog::append(AcqLogRecord *record, AcqLogRecordType type)
+{
+	if (mapped == nullptr)
+		return;
+
+	if (chunkUsed >= RECORDS_PER_CHUNK)
+	{
+		if (!mapNextChunk())
+		{
+			qDebug() << "Acquisition log stopped, unable to extend" << file.fileName();
+			close();
+			return;
+		}
+	}
+
+	record->type = (quint16)type;
+	record->sequence = sequence++;
+	record->timestamp = clock.elapsed();
+
+	memcpy(mapped + (qint64)chunkUsed * sizeof(AcqLogRecord), record, sizeof(AcqLogRecord));
+	chunkUsed++;
+
+	// events are flushed at once, samples in batches
+	if (type != ACQ_RECORD_SAMPLE || (chunkUsed - flushedUsed) >= FLUSH_RECORDS || (record->timestamp - lastFlush) >= FLUSH_INTERVAL)
+		flush();
+}
+
+//---------------------------------------------------------------------------
+void AcquisitionLog::flush(void)
+{
+	if (mapped == nullptr)
+		return;
+
+	if (chunkUsed > flushedUsed)
+	{
+		sync(flushedUsed, chunkUsed - flushedUsed);
+		flushedUsed = chunkUsed;
+	}
+
+	lastFlush = clock.elapsed();
+}
+
+//---------------------------------------------------------------------------
+// Extends the file by one zero-filled chunk and maps it
+bool AcquisitionLog::mapNextChunk(void)
+{
+	qint64 offset = sizeof(AcqLogHeader);
+
+	if (mapped)
+	{
+		flush();
+		file.unmap(mapped);
+		mapped = nullptr;
+		offset = chunkOffset + CHUNK_BYTES;
+	}
+
+	if (!file.resize(offset + CHUNK_BYTES))
+		return false;
+
+	mapped = file.map(offset, CHUNK_BYTES);
+
+	if (mapped == nullptr)
+		return false;
+
+	chunkOffset = offset;
+	chunkUsed = 0;
+	flushedUsed = 0;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Schedules write-back of a range of records in the present chunk
+void AcquisitionLog::sync(int firstRecord, int numRecords)
+{
+	uchar *start = mapped + (qint64)firstRecord * sizeof(AcqLogRecord);
+	qint64 length = (qint64)numRecords * sizeof(AcqLogRecord);
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+	// msync requires a page aligned address, the mapping itself starts on a
+	// page boundary at or before the chunk so aligning down stays inside it
+	static const quintptr pageMask = ~((quintptr)sysconf(_SC_PAGESIZE) - 1);
+	uchar *aligned = (uchar *)((quintptr)start & pageMask);
+
+	msync(aligned, length + (start - aligned), MS_ASYNC);
+#elif defined(Q_OS_WIN)
+	FlushViewOfFile(start, length);
+#endif
+}
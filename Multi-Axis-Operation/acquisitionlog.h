@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QFile>
+#include <QElapsedTimer>
+#include "acquisitionlogformat.h"
+
+//---------------------------------------------------------------------------
+// Append-only writer for the binary acquisition log. Records are copied
+// into a memory-mapped, preallocated region of the file and flushed to disk
+// in batches, so an append costs a memcpy and mapped data survives an
+// application crash.
+//---------------------------------------------------------------------------
+class AcquisitionLog
+{
+public:
+	AcquisitionLog();
+	~AcquisitionLog();
+
+	bool open(QString filename, int fieldUnits);
+	void close(void);
+	bool isOpen(void) { return (mapped != nullptr); }
+	QString fileName(void) { return file.fileName(); }
+
+	// fills in type, sequence and timestamp
+	void append(AcqLogRecord *record, AcqLogRecordType type);
+	void flush(void);
+
+private:
+	QFile file;
+	QElapsedTimer clock;
+	uchar *mapped;			// present chunk
+	qint64 chunkOffset;		// file offset of present chunk
+	int chunkUsed;			// records written to present chunk
+	int flushedUsed;		// records in present chunk already flushed
+	quint32 sequence;
+	qint64 lastFlush;		// msec
+
+	bool mapNextChunk(void);
+	void sync(int firstRecord, int numRecords);
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QtGlobal>
+
+//---------------------------------------------------------------------------
+// On-disk layout of the binary acquisition log (*.maxlog). Shared by the
+// application writer (AcquisitionLog) and the acqlog2csv reader tool, so
+// this header must depend on QtCore only.
+//
+// The file is a 64 byte header followed by fixed-size 64 byte records in
+// little-endian byte order. The file is preallocated in zero-filled chunks
+// and records are written in sequence order, so after a crash the valid
+// records are those with a non-zero type and consecutive sequence numbers.
+//---------------------------------------------------------------------------
+
+const char ACQ_LOG_MAGIC[8] = { 'A', 'M', 'I', 'M', 'X', 'L', 'O', 'G' };
+const quint32 ACQ_LOG_VERSION = 1;
+
+enum AcqLogRecordType
+{
+	ACQ_RECORD_EMPTY = 0,		// preallocated, never written
+	ACQ_RECORD_SAMPLE = 1,		// periodic acquisition sample
+	ACQ_RECORD_TRANSITION = 2,	// system state changed, systemState holds the new state
+	ACQ_RECORD_QUENCH = 3		// quench detected, current holds quench/paused currents
+};
+
+#pragma pack(push, 1)
+
+struct AcqLogHeader
+{
+	char magic[8];
+	quint32 version;
+	quint32 headerSize;		// bytes
+	quint32 recordSize;		// bytes
+	qint32 fieldUnits;		// FieldUnits of field/target values
+	qint64 startTime;		// msec since epoch (UTC) of timestamp zero
+	quint64 recordCount;	// valid only if cleanClose is non-zero
+	quint32 cleanClose;
+	char reserved[20];
+};
+
+struct AcqLogRecord
+{
+	quint16 type;			// AcqLogRecordType
+	quint16 switches;		// bit per axis, set if switch heater is on
+	quint32 sequence;		// starts at 0, increments by one per record
+	qint64 timestamp;		// msec since header startTime (monotonic)
+	float field[3];			// field units
+	float current[3];		// A
+	float target[3];		// field units
+	float polarMagnitude;	// field units
+	float polarAngle;		// degrees
+	quint8 state[3];		// State of each axis
+	quint8 systemState;		// SystemState
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(AcqLogHeader) == 64, "AcqLogHeader must be 64 bytes");
+static_assert(sizeof(AcqLogRecord) == 64, "AcqLogRecord must be 64 bytes");
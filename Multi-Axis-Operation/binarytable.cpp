@@ -0,0 +1,383 @@
+#include "stdafx.h"
+#include "binarytable.h"
+#include <QtEndian>
+#include <climits>
+#include <cstring>
+
+const char BINARY_TABLE_MAGIC[8] = { 'A', 'M', 'I', 'T', 'A', 'B', 'L', 'E' };
+const quint32 BINARY_TABLE_VERSION = 1;
+const int BINARY_TABLE_HEADER_SIZE = 80;
+const int MAX_BINARY_TABLE_COLUMNS = 1024;
+
+//---------------------------------------------------------------------------
+template <typename T>
+static void writeLittleEndian(QIODevice *device, T value)
+{
+	char bytes[sizeof(T)];
+
+	qToLittleEndian(value, bytes);
+	device->write(bytes, sizeof(T));
+}
+
+//---------------------------------------------------------------------------
+static double readDouble(const uchar *src)
+{
+	quint64 bits = qFromLittleEndian<quint64>(src);
+	double value;
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+//---------------------------------------------------------------------------
+// Copies count doubles from a little-endian array
+//---------------------------------------------------------------------------
+static void copyValues(double *dest, const uchar *src, int count)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	memcpy(dest, src, count * sizeof(double));
+#else
+	for (int i = 0; i < count; i++)
+		dest[i] = readDouble(src + i * sizeof(double));
+#endif
+}
+
+//---------------------------------------------------------------------------
+BinaryTable::BinaryTable()
+{
+	data = nullptr;
+	size = 0;
+	valuesOffset = statesOffset = resultsOffset = textsOffset = 0;
+}
+
+//---------------------------------------------------------------------------
+BinaryTable::~BinaryTable()
+{
+	close();
+}
+
+//---------------------------------------------------------------------------
+// Validates a header and the section layout it describes against the
+// actual file size.
+bool BinaryTable::parseHeader(const uchar *header, qint64 length, qint64 fileSize, TableFileInfo *info, quint64 *offsets, QString *errorString)
+{
+	if (length < BINARY_TABLE_HEADER_SIZE)
+	{
+		*errorString = "the file header is truncated";
+		return false;
+	}
+
+	quint32 version = qFromLittleEndian<quint32>(header + 8);
+	quint32 headerSize = qFromLittleEndian<quint32>(header + 12);
+
+	if (version != BINARY_TABLE_VERSION)
+	{
+		*errorString = QString("unsupported table file version %1").arg(version);
+		return false;
+	}
+
+	info->tableType = qFromLittleEndian<qint32>(header + 16);
+	info->coordinates = qFromLittleEndian<qint32>(header + 20);
+	info->convention = qFromLittleEndian<qint32>(header + 24);
+	info->fieldUnits = qFromLittleEndian<qint32>(header + 28);
+
+	quint32 columns = qFromLittleEndian<quint32>(header + 32);
+	quint32 rows = qFromLittleEndian<quint32>(header + 36);
+
+	for (int i = 0; i < 4; i++)
+		offsets[i] = qFromLittleEndian<quint64>(header + 40 + i * 8);
+
+	quint64 recordedSize = qFromLittleEndian<quint64>(header + 72);
+
+	// sections must follow the header in order and fit in the file
+	if (headerSize < BINARY_TABLE_HEADER_SIZE || columns > MAX_BINARY_TABLE_COLUMNS || rows > INT_MAX ||
+		recordedSize != static_cast<quint64>(fileSize) ||
+		offsets[0] < headerSize || (offsets[0] % sizeof(double)) ||
+		offsets[1] < offsets[0] + static_cast<quint64>(columns) * rows * sizeof(double) ||
+		offsets[2] < offsets[1] + static_cast<quint64>(columns) * rows ||
+		offsets[3] < offsets[2] + rows ||
+		offsets[3] + sizeof(quint32) > recordedSize)
+	{
+		*errorString = "the file is truncated or corrupt";
+		return false;
+	}
+
+	info->columns = static_cast<int>(columns);
+	info->rows = static_cast<int>(rows);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Returns true if filename is a binary table, with errorString set if it
+// is damaged or of an unsupported version. Only the header is read.
+bool BinaryTable::readInfo(const QString &filename, TableFileInfo *info, QString *errorString)
+{
+	QFile in(filename);
+
+	errorString->clear();
+
+	if (!in.open(QIODevice::ReadOnly))
+		return false;
+
+	QByteArray header = in.read(BINARY_TABLE_HEADER_SIZE);
+
+	if (header.size() < static_cast<int>(sizeof(BINARY_TABLE_MAGIC)) || memcmp(header.constData(), BINARY_TABLE_MAGIC, sizeof(BINARY_TABLE_MAGIC)) != 0)
+		return false;
+
+	quint64 offsets[4];
+
+	if (!parseHeader(reinterpret_cast<const uchar *>(header.constData()), header.size(), in.size(), info, offsets, errorString))
+		*errorString = QDir::toNativeSeparators(filename) + ": " + *errorString;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Maps a binary table for reading
+bool BinaryTable::open(const QString &filename)
+{
+	close();
+	file.setFileName(filename);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		error = "Unable to open " + QDir::toNativeSeparators(filename);
+		return false;
+	}
+
+	size = file.size();
+	data = file.map(0, size);
+
+	quint64 offsets[4];
+
+	if (data == nullptr)
+	{
+		error = "Unable to map " + QDir::toNativeSeparators(filename);
+	}
+	else if (size < static_cast<qint64>(sizeof(BINARY_TABLE_MAGIC)) || memcmp(data, BINARY_TABLE_MAGIC, sizeof(BINARY_TABLE_MAGIC)) != 0)
+	{
+		error = QDir::toNativeSeparators(filename) + " is not a binary table file";
+	}
+	else if (!parseHeader(data, size, size, &fileInfo, offsets, &error))
+	{
+		error = QDir::toNativeSeparators(filename) + ": " + error;
+	}
+	else
+	{
+		valuesOffset = offsets[0];
+		statesOffset = offsets[1];
+		resultsOffset = offsets[2];
+		textsOffset = offsets[3];
+		error.clear();
+
+		return true;
+	}
+
+	close();
+	return false;
+}
+
+//---------------------------------------------------------------------------
+void BinaryTable::close(void)
+{
+	if (data)
+		file.unmap(const_cast<uchar *>(data));
+
+	file.close();
+	data = nullptr;
+	size = 0;
+	fileInfo = TableFileInfo();
+}
+
+//---------------------------------------------------------------------------
+double BinaryTable::value(int row, int column) const
+{
+	if (data == nullptr || row < 0 || row >= fileInfo.rows || column < 0 || column >= fileInfo.columns)
+		return 0.0;
+
+	return readDouble(data + valuesOffset + (static_cast<quint64>(column) * fileInfo.rows + row) * sizeof(double));
+}
+
+//---------------------------------------------------------------------------
+CellState BinaryTable::state(int row, int column) const
+{
+	if (data == nullptr || row < 0 || row >= fileInfo.rows || column < 0 || column >= fileInfo.columns)
+		return CELL_EMPTY;
+
+	quint8 cellState = data[statesOffset + static_cast<quint64>(column) * fileInfo.rows + row];
+
+	return cellState <= CELL_TEXT ? static_cast<CellState>(cellState) : CELL_EMPTY;
+}
+
+//---------------------------------------------------------------------------
+TableResult BinaryTable::result(int row) const
+{
+	if (data == nullptr || row < 0 || row >= fileInfo.rows)
+		return RESULT_NONE;
+
+	quint8 rowResult = data[resultsOffset + row];
+
+	return rowResult <= RESULT_FAIL ? static_cast<TableResult>(rowResult) : RESULT_NONE;
+}
+
+//---------------------------------------------------------------------------
+// Copies rows first to first + count - 1 into contents, renumbered from
+// zero. The numeric columns are straight array copies; only the text
+// section is scanned.
+bool BinaryTable::readRows(int first, int count, TableContents *contents) const
+{
+	if (data == nullptr || first < 0 || count < 0 || first > fileInfo.rows - count)
+		return false;
+
+	*contents = TableContents();
+	contents->rows = count;
+	contents->values.resize(fileInfo.columns);
+	contents->states.resize(fileInfo.columns);
+
+	for (int i = 0; i < fileInfo.columns; i++)
+	{
+		quint64 index = static_cast<quint64>(i) * fileInfo.rows + first;
+
+		contents->values[i].resize(count);
+		copyValues(contents->values[i].data(), data + valuesOffset + index * sizeof(double), count);
+
+		contents->states[i].resize(count);
+		memcpy(contents->states[i].data(), data + statesOffset + index, count);
+
+		// unknown states read as empty
+		for (int j = 0; j < count; j++)
+		{
+			if (contents->states[i][j] > CELL_TEXT)
+				contents->states[i][j] = CELL_EMPTY;
+		}
+	}
+
+	contents->results.resize(count);
+	memcpy(contents->results.data(), data + resultsOffset + first, count);
+
+	for (int j = 0; j < count; j++)
+	{
+		if (contents->results[j] > RESULT_FAIL)
+			contents->results[j] = RESULT_NONE;
+	}
+
+	// text entries in range
+	const uchar *p = data + textsOffset;
+	const uchar *end = data + size;
+	quint32 entries = qFromLittleEndian<quint32>(p);
+
+	p += sizeof(quint32);
+
+	for (quint32 i = 0; i < entries; i++)
+	{
+		if (end - p < 3 * static_cast<qint64>(sizeof(quint32)))
+			return false;
+
+		quint32 row = qFromLittleEndian<quint32>(p);
+		quint32 column = qFromLittleEndian<quint32>(p + 4);
+		quint32 length = qFromLittleEndian<quint32>(p + 8);
+
+		p += 3 * sizeof(quint32);
+
+		if (static_cast<quint64>(end - p) < length)
+			return false;
+
+		if (row >= static_cast<quint32>(first) && row < static_cast<quint32>(first + count) && column < static_cast<quint32>(fileInfo.columns))
+			contents->texts.insert(TableModel::textKey(row - first, column), QString::fromUtf8(reinterpret_cast<const char *>(p), length));
+
+		p += length;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Writes contents as a binary table; info supplies the table type,
+// coordinate system and units.
+bool BinaryTable::write(QIODevice *device, const TableContents &contents, const TableFileInfo &info)
+{
+	quint32 columns = contents.values.count();
+	quint32 rows = contents.rows;
+	quint64 valuesOffset = BINARY_TABLE_HEADER_SIZE;
+	quint64 statesOffset = valuesOffset + static_cast<quint64>(columns) * rows * sizeof(double);
+	quint64 resultsOffset = statesOffset + static_cast<quint64>(columns) * rows;
+	quint64 textsOffset = resultsOffset + rows;
+
+	// gather the text entries first, their size completes the header
+	QVector<quint64> keys;
+	QVector<QByteArray> texts;
+	quint64 textsSize = sizeof(quint32);
+
+	for (quint32 j = 0; j < columns; j++)
+	{
+		for (quint32 i = 0; i < rows; i++)
+		{
+			if (contents.states[j][i] == CELL_TEXT)
+			{
+				QByteArray utf8 = contents.texts.value(TableModel::textKey(i, j)).toUtf8();
+
+				keys.append(TableModel::textKey(i, j));
+				texts.append(utf8);
+				textsSize += 3 * sizeof(quint32) + utf8.size();
+			}
+		}
+	}
+
+	// header
+	device->write(BINARY_TABLE_MAGIC, sizeof(BINARY_TABLE_MAGIC));
+	writeLittleEndian<quint32>(device, BINARY_TABLE_VERSION);
+	writeLittleEndian<quint32>(device, BINARY_TABLE_HEADER_SIZE);
+	writeLittleEndian<qint32>(device, info.tableType);
+	writeLittleEndian<qint32>(device, info.coordinates);
+	writeLittleEndian<qint32>(device, info.convention);
+	writeLittleEndian<qint32>(device, info.fieldUnits);
+	writeLittleEndian<quint32>(device, columns);
+	writeLittleEndian<quint32>(device, rows);
+	writeLittleEndian<quint64>(device, valuesOffset);
+	writeLittleEndian<quint64>(device, statesOffset);
+	writeLittleEndian<quint64>(device, resultsOffset);
+	writeLittleEndian<quint64>(device, textsOffset);
+	writeLittleEndian<quint64>(device, textsOffset + textsSize);
+
+	// columns
+	for (quint32 j = 0; j < columns; j++)
+	{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+		device->write(reinterpret_cast<const char *>(contents.values[j].constData()), rows * sizeof(double));
+#else
+		for (quint32 i = 0; i < rows; i++)
+		{
+			quint64 bits;
+
+			memcpy(&bits, &contents.values[j][i], sizeof(bits));
+			writeLittleEndian<quint64>(device, bits);
+		}
+#endif
+	}
+
+	for (quint32 j = 0; j < columns; j++)
+		device->write(reinterpret_cast<const char *>(contents.states[j].constData()), rows);
+
+	// results are only meaningful in the model's result column
+	if (contents.resultColumn >= 0 && contents.results.count() >= static_cast<int>(rows))
+		device->write(reinterpret_cast<const char *>(contents.results.constData()), rows);
+	else
+		device->write(QByteArray(static_cast<int>(rows), static_cast<char>(RESULT_NONE)));
+
+	// text
+	writeLittleEndian<quint32>(device, keys.count());
+
+	for (int i = 0; i < keys.count(); i++)
+	{
+		writeLittleEndian<quint32>(device, static_cast<quint32>(keys[i] & 0xFFFFFFFF));
+		writeLittleEndian<quint32>(device, static_cast<quint32>(keys[i] >> 32));
+		writeLittleEndian<quint32>(device, texts[i].size());
+		device->write(texts[i]);
+	}
+
+	return device->pos() == static_cast<qint64>(textsOffset + textsSize);
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QFile>
+#include <QIODevice>
+#include "tablemodel.h"
+
+//---------------------------------------------------------------------------
+// Binary vector and polar table files. Values are stored as they are held
+// in TableModel, one array per column, so a table is loaded by mapping the
+// file and copying arrays, and any range of rows can be read without
+// touching the rest. All fields are little-endian:
+//
+//   header (BINARY_TABLE_HEADER_SIZE bytes)
+//     char[8] magic "AMITABLE"
+//     uint32 version
+//     uint32 header size
+//     int32 TableFileType
+//     int32 CoordinatesSelection, SphericalConvention, FieldUnits
+//     uint32 column count, uint32 row count
+//     uint64 offsets of the values, states, results and text sections
+//     uint64 file size
+//   values: per column, row count doubles (8 byte aligned)
+//   states: per column, row count uint8 CellState
+//   results: row count uint8 TableResult
+//   text: uint32 entry count, then per CELL_TEXT entry uint32 row,
+//     uint32 column, uint32 length and UTF-8 bytes
+//
+// Readers accept any header size of at least the version 1 size, so later
+// versions may append header fields.
+//---------------------------------------------------------------------------
+
+const char VECTOR_TABLE_SUFFIX[] = "vtb";
+const char POLAR_TABLE_SUFFIX[] = "ptb";
+
+enum TableFileType
+{
+	TABLE_VECTOR = 0,
+	TABLE_POLAR
+};
+
+struct TableFileInfo
+{
+	qint32 tableType = TABLE_VECTOR;
+	qint32 coordinates = 0;		// CoordinatesSelection
+	qint32 convention = 0;		// SphericalConvention
+	qint32 fieldUnits = -1;		// FieldUnits of the field columns
+	int columns = 0;
+	int rows = 0;
+};
+
+class BinaryTable
+{
+public:
+	BinaryTable();
+	~BinaryTable();
+
+	static bool readInfo(const QString &filename, TableFileInfo *info, QString *errorString);
+	static bool write(QIODevice *device, const TableContents &contents, const TableFileInfo &info);
+
+	bool open(const QString &filename);
+	void close(void);
+	QString errorString(void) { return error; }
+	const TableFileInfo &info(void) const { return fileInfo; }
+
+	// random access to the mapped file
+	double value(int row, int column) const;
+	CellState state(int row, int column) const;
+	TableResult result(int row) const;
+	bool readRows(int first, int count, TableContents *contents) const;
+
+private:
+	QFile file;
+	const uchar *data;
+	qint64 size;
+	quint64 valuesOffset;
+	quint64 statesOffset;
+	quint64 resultsOffset;
+	quint64 textsOffset;
+	TableFileInfo fileInfo;
+	QString error;
+
+	static bool parseHeader(const uchar *header, qint64 length, qint64 fileSize, TableFileInfo *info, quint64 *offsets, QString *errorString);
+};
@@ -0,0 +1,417 @@
+#pragma once
+
+#include <QtGlobal>
+#include <cstring>
+
+//---------------------------------------------------------------------------
+// Remote command tree for the stdin/stdout parser. Shared by the Parser and
+// the parserbench tool, so this header must depend on QtCore only.
+//
+// Each SCPI keyword is a node with its short and long forms and their
+// hashes, all computed at compile time. A command or query is resolved by
+// walking the tree one keyword at a time, comparing hashes before
+// characters, so the cost depends on the depth of the command and not on
+// the size of the command set. Adding a command means adding an id below
+// and a node in the tree; the Parser maps ids to its handler functions.
+//---------------------------------------------------------------------------
+
+enum CommandId
+{
+	CMD_NONE = 0,				// no match
+
+	// queries
+	QRY_IDN,
+	QRY_ALIGN1,
+	QRY_ALIGN1_CARTESIAN,
+	QRY_ALIGN2,
+	QRY_ALIGN2_CARTESIAN,
+	QRY_FIELD,
+	QRY_FIELD_CARTESIAN,
+	QRY_HISTORY,
+	QRY_PERSISTENT,
+	QRY_PLANE,
+	QRY_SEQUENCE_STATE,
+	QRY_STATE,
+	QRY_SYSTEM_ERROR,
+	QRY_SYSTEM_ERROR_COUNT,
+	QRY_SYSTEM_FORMAT,
+	QRY_SYSTEM_STATS,
+	QRY_SYSTEM_SUBSCRIBE,
+	QRY_TABLE_VECTOR,
+	QRY_TABLE_POLAR,
+	QRY_TARGET,
+	QRY_TARGET_CARTESIAN,
+	QRY_TARGET_TIME,
+	QRY_UNITS,
+
+	// commands
+	CMD_CLS,
+	CMD_EXIT,
+	CMD_CONF_ALIGN1,
+	CMD_CONF_ALIGN2,
+	CMD_CONF_TARGET_ALIGN1,
+	CMD_CONF_TARGET_ALIGN2,
+	CMD_CONF_TARGET_VECTOR,
+	CMD_CONF_TARGET_VECTOR_CARTESIAN,
+	CMD_CONF_TARGET_VECTOR_TABLE,
+	CMD_CONF_TARGET_POLAR,
+	CMD_CONF_TARGET_POLAR_TABLE,
+	CMD_CONF_UNITS,
+	CMD_LOAD,
+	CMD_LOAD_SETTINGS,
+	CMD_LOAD_VECTOR,
+	CMD_LOAD_POLAR,
+	CMD_PAUSE,
+	CMD_PERSISTENT,
+	CMD_RAMP,
+	CMD_SAVE,
+	CMD_SAVE_SETTINGS,
+	CMD_SEQUENCE_ABORT,
+	CMD_SEQUENCE_DEFINE,
+	CMD_SEQUENCE_LOAD,
+	CMD_SEQUENCE_RUN,
+	CMD_SYSTEM_CONNECT,
+	CMD_SYSTEM_DISCONNECT,
+	CMD_SYSTEM_FORMAT,
+	CMD_SYSTEM_SUBSCRIBE,
+	CMD_SYSTEM_UNSUBSCRIBE,
+	CMD_TABLE_VECTOR,
+	CMD_TABLE_POLAR,
+	CMD_WAIT_HOLDING,
+	CMD_WAIT_PERSISTENT,
+	CMD_WAIT_STEP,
+	CMD_ZERO,
+
+	NUM_COMMAND_IDS
+};
+
+//---------------------------------------------------------------------------
+// Keyword hashing (FNV-1a over the uppercase keyword)
+//---------------------------------------------------------------------------
+const quint32 KEYWORD_HASH_SEED = 2166136261u;
+const quint32 KEYWORD_HASH_PRIME = 16777619u;
+
+constexpr char keywordChar(char c)
+{
+	return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+constexpr quint32 keywordHashStep(quint32 hash, char c)
+{
+	return (hash ^ (quint8)keywordChar(c)) * KEYWORD_HASH_PRIME;
+}
+
+constexpr quint32 keywordHash(const char *str, quint32 hash = KEYWORD_HASH_SEED)
+{
+	return (*str == '\0') ? hash : keywordHash(str + 1, keywordHashStep(hash, *str));
+}
+
+constexpr bool isKeywordSeparator(char c)
+{
+	return (c == ':' || c == ' ' || c == '\t' || c == '\r' || c == '\n');	// colon or whitespace
+}
+
+//---------------------------------------------------------------------------
+// Command tree nodes
+//---------------------------------------------------------------------------
+struct CommandNode
+{
+	const char *shortForm;
+	const char *longForm;		// same as shortForm if not abbreviated
+	quint32 shortHash;
+	quint32 longHash;
+	quint32 shortLength;
+	quint32 longLength;
+	CommandId command;			// if the input ends at this node without a '?'
+	CommandId query;			// if the input ends at this node with a '?'
+	const CommandNode *children;
+	int numChildren;
+};
+
+constexpr quint32 keywordLength(const char *str)
+{
+	return (*str == '\0') ? 0 : 1 + keywordLength(str + 1);
+}
+
+constexpr CommandNode keyword(const char *shortForm, const char *longForm, CommandId command, CommandId query)
+{
+	return { shortForm, longForm, keywordHash(shortForm), keywordHash(longForm),
+		keywordLength(shortForm), keywordLength(longForm), command, query, nullptr, 0 };
+}
+
+template <int N>
+constexpr CommandNode keyword(const char *shortForm, const char *longForm, CommandId command, CommandId query, const CommandNode (&children)[N])
+{
+	return { shortForm, longForm, keywordHash(shortForm), keywordHash(longForm),
+		keywordLength(shortForm), keywordLength(longForm), command, query, children, N };
+}
+
+// sibling keywords must not share a hash, checked at compile time
+template <int N>
+constexpr bool uniqueKeywords(const CommandNode (&nodes)[N])
+{
+	for (int i = 0; i < N; i++)
+	{
+		for (int j = 0; j < N; j++)
+		{
+			if (i != j && (nodes[i].shortHash == nodes[j].shortHash || nodes[i].shortHash == nodes[j].longHash ||
+				nodes[i].longHash == nodes[j].longHash))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Command tree
+//---------------------------------------------------------------------------
+constexpr CommandNode ALIGN1_NODES[] =
+{
+	keyword("CART", "CARTESIAN", CMD_NONE, QRY_ALIGN1_CARTESIAN)
+};
+
+constexpr CommandNode ALIGN2_NODES[] =
+{
+	keyword("CART", "CARTESIAN", CMD_NONE, QRY_ALIGN2_CARTESIAN)
+};
+
+constexpr CommandNode FIELD_NODES[] =
+{
+	keyword("CART", "CARTESIAN", CMD_NONE, QRY_FIELD_CARTESIAN)
+};
+
+constexpr CommandNode SYSTEM_ERROR_NODES[] =
+{
+	keyword("COUN", "COUNT", CMD_NONE, QRY_SYSTEM_ERROR_COUNT)
+};
+
+constexpr CommandNode SYSTEM_NODES[] =
+{
+	keyword("CONN", "CONNECT", CMD_SYSTEM_CONNECT, CMD_NONE),
+	keyword("DISC", "DISCONNECT", CMD_SYSTEM_DISCONNECT, CMD_NONE),
+	keyword("ERR", "ERROR", CMD_NONE, QRY_SYSTEM_ERROR, SYSTEM_ERROR_NODES),
+	keyword("FORM", "FORMAT", CMD_SYSTEM_FORMAT, QRY_SYSTEM_FORMAT),
+	keyword("STAT", "STATS", CMD_NONE, QRY_SYSTEM_STATS),
+	keyword("SUBS", "SUBSCRIBE", CMD_SYSTEM_SUBSCRIBE, QRY_SYSTEM_SUBSCRIBE),
+	keyword("UNS", "UNSUBSCRIBE", CMD_SYSTEM_UNSUBSCRIBE, CMD_NONE)
+};
+
+constexpr CommandNode TARGET_QUERY_NODES[] =
+{
+	keyword("CART", "CARTESIAN", CMD_NONE, QRY_TARGET_CARTESIAN),
+	keyword("TIME", "TIME", CMD_NONE, QRY_TARGET_TIME)
+};
+
+constexpr CommandNode LOAD_NODES[] =
+{
+	keyword("SET", "SETTINGS", CMD_LOAD_SETTINGS, CMD_NONE),
+	keyword("VEC", "VECTOR", CMD_LOAD_VECTOR, CMD_NONE),
+	keyword("POL", "POLAR", CMD_LOAD_POLAR, CMD_NONE)
+};
+
+constexpr CommandNode SAVE_NODES[] =
+{
+	keyword("SET", "SETTINGS", CMD_SAVE_SETTINGS, CMD_NONE)
+};
+
+constexpr CommandNode SEQUENCE_NODES[] =
+{
+	keyword("ABOR", "ABORT", CMD_SEQUENCE_ABORT, CMD_NONE),
+	keyword("DEF", "DEFINE", CMD_SEQUENCE_DEFINE, CMD_NONE),
+	keyword("LOAD", "LOAD", CMD_SEQUENCE_LOAD, CMD_NONE),
+	keyword("RUN", "RUN", CMD_SEQUENCE_RUN, CMD_NONE),
+	keyword("STATE", "STATE", CMD_NONE, QRY_SEQUENCE_STATE)
+};
+
+constexpr CommandNode TARGET_VECTOR_NODES[] =
+{
+	keyword("CART", "CARTESIAN", CMD_CONF_TARGET_VECTOR_CARTESIAN, CMD_NONE),
+	keyword("TAB", "TABLE", CMD_CONF_TARGET_VECTOR_TABLE, CMD_NONE)
+};
+
+constexpr CommandNode TARGET_POLAR_NODES[] =
+{
+	keyword("TAB", "TABLE", CMD_CONF_TARGET_POLAR_TABLE, CMD_NONE)
+};
+
+constexpr CommandNode CONFIGURE_TARGET_NODES[] =
+{
+	keyword("ALIGN1", "ALIGN1", CMD_CONF_TARGET_ALIGN1, CMD_NONE),
+	keyword("ALIGN2", "ALIGN2", CMD_CONF_TARGET_ALIGN2, CMD_NONE),
+	keyword("VEC", "VECTOR", CMD_CONF_TARGET_VECTOR, CMD_NONE, TARGET_VECTOR_NODES),
+	keyword("POL", "POLAR", CMD_CONF_TARGET_POLAR, CMD_NONE, TARGET_POLAR_NODES)
+};
+
+constexpr CommandNode CONFIGURE_NODES[] =
+{
+	keyword("ALIGN1", "ALIGN1", CMD_CONF_ALIGN1, CMD_NONE),
+	keyword("ALIGN2", "ALIGN2", CMD_CONF_ALIGN2, CMD_NONE),
+	keyword("TARG", "TARGET", CMD_NONE, CMD_NONE, CONFIGURE_TARGET_NODES),
+	keyword("UNITS", "UNITS", CMD_CONF_UNITS, CMD_NONE)
+};
+
+constexpr CommandNode TABLE_NODES[] =
+{
+	keyword("VEC", "VECTOR", CMD_TABLE_VECTOR, QRY_TABLE_VECTOR),
+	keyword("POL", "POLAR", CMD_TABLE_POLAR, QRY_TABLE_POLAR)
+};
+
+constexpr CommandNode WAIT_NODES[] =
+{
+	keyword("HOLD", "HOLDING", CMD_WAIT_HOLDING, CMD_NONE),
+	keyword("PERS", "PERSISTENT", CMD_WAIT_PERSISTENT, CMD_NONE),
+	keyword("STEP", "STEP", CMD_WAIT_STEP, CMD_NONE)
+};
+
+constexpr CommandNode ROOT_NODES[] =
+{
+	keyword("*IDN", "*IDN", CMD_NONE, QRY_IDN),
+	keyword("*CLS", "*CLS", CMD_CLS, CMD_NONE),
+	keyword("ALIGN1", "ALIGN1", CMD_NONE, QRY_ALIGN1, ALIGN1_NODES),
+	keyword("ALIGN2", "ALIGN2", CMD_NONE, QRY_ALIGN2, ALIGN2_NODES),
+	keyword("CONF", "CONFIGURE", CMD_NONE, CMD_NONE, CONFIGURE_NODES),
+	keyword("EXIT", "EXIT", CMD_EXIT, CMD_NONE),
+	keyword("FIELD", "FIELD", CMD_NONE, QRY_FIELD, FIELD_NODES),
+	keyword("HIST", "HISTORY", CMD_NONE, QRY_HISTORY),
+	keyword("LOAD", "LOAD", CMD_LOAD, CMD_NONE, LOAD_NODES),
+	keyword("PAUSE", "PAUSE", CMD_PAUSE, CMD_NONE),
+	keyword("PERS", "PERSISTENT", CMD_PERSISTENT, QRY_PERSISTENT),
+	keyword("PLANE", "PLANE", CMD_NONE, QRY_PLANE),
+	keyword("RAMP", "RAMP", CMD_RAMP, CMD_NONE),
+	keyword("SAVE", "SAVE", CMD_SAVE, CMD_NONE, SAVE_NODES),
+	keyword("SEQ", "SEQUENCE", CMD_NONE, CMD_NONE, SEQUENCE_NODES),
+	keyword("STATE", "STATE", CMD_NONE, QRY_STATE),
+	keyword("SYST", "SYSTEM", CMD_NONE, CMD_NONE, SYSTEM_NODES),
+	keyword("TABLE", "TABLE", CMD_NONE, CMD_NONE, TABLE_NODES),
+	keyword("TARG", "TARGET", CMD_NONE, QRY_TARGET, TARGET_QUERY_NODES),
+	keyword("UNITS", "UNITS", CMD_NONE, QRY_UNITS),
+	keyword("WAIT", "WAIT", CMD_NONE, CMD_NONE, WAIT_NODES),
+	keyword("ZERO", "ZERO", CMD_ZERO, CMD_NONE)
+};
+
+static_assert(uniqueKeywords(ROOT_NODES) && uniqueKeywords(SYSTEM_NODES) && uniqueKeywords(TARGET_QUERY_NODES) &&
+	uniqueKeywords(CONFIGURE_NODES) && uniqueKeywords(CONFIGURE_TARGET_NODES) && uniqueKeywords(TARGET_VECTOR_NODES) &&
+	uniqueKeywords(LOAD_NODES) && uniqueKeywords(TABLE_NODES) && uniqueKeywords(WAIT_NODES) &&
+	uniqueKeywords(SEQUENCE_NODES),
+	"command keywords must have unique hashes within each level of the tree");
+
+//---------------------------------------------------------------------------
+// Resolves the keyword path at the start of the input. Keywords are
+// separated by a colon, space or tab and are not case sensitive. On return,
+// args points at the text following the last matched keyword, which is left
+// unmodified (filenames are case sensitive). For queries, pass the input up
+// to the '?'; a query must consume all of it.
+//---------------------------------------------------------------------------
+inline const CommandNode *findKeyword(const CommandNode *nodes, int numNodes, const char *word, quint32 length, quint32 hash)
+{
+	for (int i = 0; i < numNodes; i++)
+	{
+		const char *form;
+
+		if (hash == nodes[i].shortHash && length == nodes[i].shortLength)
+			form = nodes[i].shortForm;
+		else if (hash == nodes[i].longHash && length == nodes[i].longLength)
+			form = nodes[i].longForm;
+		else
+			continue;
+
+		quint32 j = 0;
+
+		while (j < length && keywordChar(word[j]) == form[j])
+			j++;
+
+		if (j == length)
+			return &nodes[i];
+	}
+
+	return nullptr;
+}
+
+//---------------------------------------------------------------------------
+inline CommandId resolveCommand(char *input, bool isQuery, char **args)
+{
+	const CommandNode *nodes = ROOT_NODES;
+	int numNodes = sizeof(ROOT_NODES) / sizeof(ROOT_NODES[0]);
+	const CommandNode *matched = nullptr;
+	char *next = input;
+
+	while (isKeywordSeparator(*next))
+		next++;
+
+	while (*next != '\0' && numNodes)
+	{
+		char *end = next;
+		quint32 hash = KEYWORD_HASH_SEED;
+
+		while (*end != '\0' && !isKeywordSeparator(*end))
+			hash = keywordHashStep(hash, *end++);
+
+		const CommandNode *node = findKeyword(nodes, numNodes, next, (quint32)(end - next), hash);
+
+		if (node == nullptr)
+			break;	// not a keyword, the remainder is arguments
+
+		matched = node;
+		nodes = node->children;
+		numNodes = node->numChildren;
+		next = end;
+
+		while (isKeywordSeparator(*next))
+			next++;
+	}
+
+	*args = next;
+
+	if (matched == nullptr)
+		return CMD_NONE;
+
+	if (isQuery)
+		return (*next == '\0') ? matched->query : CMD_NONE;	// a query must consume its whole path
+
+	return matched->command;
+}
+
+//---------------------------------------------------------------------------
+// Writes the short keyword path of a command or query, e.g. "SYST:ERR:COUN?",
+// for reports. Returns false if the id is not in the tree.
+//---------------------------------------------------------------------------
+inline bool findCommandPath(const CommandNode *nodes, int numNodes, CommandId id, char *name, int length, int size)
+{
+	for (int i = 0; i < numNodes; i++)
+	{
+		int start = length ? length + 1 : 0;
+		int end = start + (int)nodes[i].shortLength;
+
+		if (end + 2 > size)
+			continue;
+
+		if (length)
+			name[length] = ':';
+
+		memcpy(name + start, nodes[i].shortForm, nodes[i].shortLength);
+
+		if (nodes[i].command == id || nodes[i].query == id)
+		{
+			if (nodes[i].query == id)
+				name[end++] = '?';
+
+			name[end] = '\0';
+			return true;
+		}
+
+		if (findCommandPath(nodes[i].children, nodes[i].numChildren, id, name, end, size))
+			return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------
+inline bool commandName(CommandId id, char *name, int size)
+{
+	if (id == CMD_NONE || size < 1)
+		return false;
+
+	return findCommandPath(ROOT_NODES, sizeof(ROOT_NODES) / sizeof(ROOT_NODES[0]), id, name, 0, size);
+}
@@ -23,6 +23,39 @@ void sphericalToCartesian(double magnitude, double theta, double phi, double* x,
 	*z = magnitude * cos(phi / RAD_TO_DEG);
 }
 
+//---------------------------------------------------------------------------
+// Rotates the reference vector by angle (degrees) about the normal of the
+// sample alignment plane and scales it by magnitude
+//---------------------------------------------------------------------------
+void rotateInPlane(double magnitude, double angle, const QVector3D &normal, const QQuaternion &reference, QVector3D *conversion)
+{
+	// implementation of rotation in the alignment plane using quaternions
+	// see: https://en.wikipedia.org/wiki/Quaternions_and_spatial_rotation
+
+	double angleRad = angle / RAD_TO_DEG;
+
+	// specify the rotation quaternion based on the normal
+	QQuaternion rotationQuaternion;
+	QVector3D rotationVector;
+	rotationVector.setX(sin(angleRad / 2.0) * normal.x());
+	rotationVector.setY(sin(angleRad / 2.0) * normal.y());
+	rotationVector.setZ(sin(angleRad / 2.0) * normal.z());
+
+	rotationQuaternion.setVector(rotationVector);
+	rotationQuaternion.setScalar(cos(angleRad / 2.0));
+
+	// calculate polar rotation in sample alignment plane (Hamilton product)
+	// p' = q p q^(-1)
+	QQuaternion result = (rotationQuaternion * reference) * rotationQuaternion.conjugated();
+
+	// load conversion vector
+	conversion->setX(result.x());
+	conversion->setY(result.y());
+	conversion->setZ(result.z());
+
+	*conversion *= magnitude;	// multiply by magnitude
+}
+
 //---------------------------------------------------------------------------
 double avoidSignedZeroOutput(double number, int precision)
 {
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <QQuaternion>
+#include <QVector3D>
+
 extern void cartesianToSpherical(double x, double y, double z, double* magnitude, double* theta, double* phi);
 extern void sphericalToCartesian(double magnitude, double theta, double phi, double* x, double* y, double* z);
+extern void rotateInPlane(double magnitude, double angle, const QVector3D &normal, const QQuaternion &reference, QVector3D *conversion);
 extern double avoidSignedZeroOutput(double number, int precision);
\ No newline at end of file
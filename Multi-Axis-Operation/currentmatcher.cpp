@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "currentmatcher.h"
+
+const int MATCH_POLL_INTERVAL = 100;		// msec
+const double MATCH_TOLERANCE = 0.001;		// fractional mismatch (0.1%) allowed before heating switch
+const double MATCH_MIN_TOLERANCE = 0.001;	// A, floor for mismatch check near zero current
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+CurrentMatcher::CurrentMatcher(QObject *parent)
+	: QObject(parent)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		axes[i].process = nullptr;
+		axes[i].params = nullptr;
+		axes[i].state = MATCH_IDLE;
+		axes[i].targetCurrent = 0.0;
+		axes[i].savedRampRate = 0.0;
+	}
+
+	pollTimer = new QTimer(this);
+	pollTimer->setInterval(MATCH_POLL_INTERVAL);
+	connect(pollTimer, SIGNAL(timeout()), this, SLOT(pollTimerTick()));
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+CurrentMatcher::~CurrentMatcher()
+{
+	pollTimer->stop();
+}
+
+//---------------------------------------------------------------------------
+// Checks all active cooled switch axes for a supply/magnet current mismatch
+// and starts ramping every mismatched axis at once. The switch heater states
+// come from the latest acquisition sample; magnet and supply currents are
+// read from each supply. Returns MATCH_NOT_NEEDED if the switch(es) may be
+// heated immediately and MATCH_FAILED, with nothing ramped, if a current
+// could not be read. After MATCH_STARTED, matchComplete() is emitted once
+// all axes reach the magnet current, see pollTimerTick().
+MatchStart CurrentMatcher::start(ProcessManager *xProcess, ProcessManager *yProcess, ProcessManager *zProcess, MagnetParams *magnetParams,
+	const HistorySample &sample)
+{
+	stop();
+	error.clear();
+
+	axes[X_AXIS].process = xProcess;
+	axes[X_AXIS].params = magnetParams->GetXAxisParams();
+	axes[Y_AXIS].process = yProcess;
+	axes[Y_AXIS].params = magnetParams->GetYAxisParams();
+	axes[Z_AXIS].process = zProcess;
+	axes[Z_AXIS].params = magnetParams->GetZAxisParams();
+
+	// measure every axis before any is ramped
+	for (int i = 0; i < 3; i++)
+	{
+		MatchAxis *axis = &axes[i];
+
+		axis->state = MATCH_IDLE;
+		axis->savedRampRate = 0.0;
+
+		// a heated switch can have no mismatch
+		if (!axis->process || !axis->params || !axis->params->activate || !axis->params->switchInstalled ||
+			!axis->process->isActive() || sample.switchHeated[i])
+			continue;
+
+		bool magnetOk = false, supplyOk = false;
+		double magnetCurrent = axis->process->getMagnetCurrent(&magnetOk);
+		double supplyCurrent = axis->process->getSupplyCurrent(&supplyOk);
+
+		if (!magnetOk || !supplyOk)
+		{
+			stop();
+			error = "Unable to read the magnet and supply currents, switch heater(s) left off";
+			return MATCH_FAILED;
+		}
+
+		if (isMismatched(magnetCurrent, supplyCurrent))
+		{
+			axis->targetCurrent = magnetCurrent;
+			axis->state = MATCH_RAMPING;
+		}
+		else
+		{
+			axis->state = MATCH_DONE;	// close enough to exit persistent mode!
+		}
+	}
+
+	bool pending = false;
+
+	for (int i = 0; i < 3; i++)
+	{
+		MatchAxis *axis = &axes[i];
+
+		if (axis->state == MATCH_RAMPING)
+		{
+			// ramp at the fastest rate allowed for this axis
+			axis->savedRampRate = axis->process->rampRate();
+			axis->process->setRampRateCurr(axis->params, axis->params->maxRampRate);
+			axis->process->setTargetCurr(axis->params, axis->targetCurrent, false);
+			pending = true;
+		}
+	}
+
+	if (!pending)
+	{
+		stop();
+		return MATCH_NOT_NEEDED;
+	}
+
+	// start all mismatched axes together once their targets are configured
+	for (int i = 0; i < 3; i++)
+	{
+		if (axes[i].state == MATCH_RAMPING)
+			axes[i].process->sendRamp();
+	}
+
+	pollTimer->start();
+	return MATCH_STARTED;
+}
+
+//---------------------------------------------------------------------------
+void CurrentMatcher::stop(void)
+{
+	pollTimer->stop();
+	restoreRampRates();
+
+	// release references to the axis processes
+	for (int i = 0; i < 3; i++)
+	{
+		axes[i].process = nullptr;
+		axes[i].state = MATCH_IDLE;
+	}
+}
+
+//---------------------------------------------------------------------------
+// Puts back the ramp rate each matched axis used before it was ramped at
+// its maximum rate
+void CurrentMatcher::restoreRampRates(void)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		MatchAxis *axis = &axes[i];
+
+		if (axis->savedRampRate > 0 && axis->process && axis->process->isActive())
+			axis->process->setRampRateCurr(axis->params, axis->savedRampRate);
+
+		axis->savedRampRate = 0.0;
+	}
+}
+
+//---------------------------------------------------------------------------
+// Polls the state of each ramping axis, so completion and any quench are
+// seen within one poll interval instead of one acquisition tick
+void CurrentMatcher::pollTimerTick(void)
+{
+	bool pending = false;
+
+	for (int i = 0; i < 3; i++)
+	{
+		MatchAxis *axis = &axes[i];
+
+		if (axis->state != MATCH_RAMPING)
+			continue;
+
+		State state = axis->process->getState();
+
+		if (state == HOLDING)
+		{
+			axis->state = MATCH_DONE;	// reached matching current
+		}
+		else if (state == QUENCH)
+		{
+			stop();
+			emit matchAborted("Quench detected while matching supply and magnet currents");
+			return;
+		}
+		else
+		{
+			if (state == PAUSED || state == AT_ZERO)
+				axis->process->sendRamp();	// ramping was interrupted, resume
+
+			pending = true;
+		}
+	}
+
+	if (!pending)
+	{
+		stop();
+		emit matchComplete();
+	}
+}
+
+//---------------------------------------------------------------------------
+bool CurrentMatcher::isMismatched(double magnetCurrent, double supplyCurrent)
+{
+	double tolerance = fabs(magnetCurrent) * MATCH_TOLERANCE;
+
+	if (tolerance < MATCH_MIN_TOLERANCE)
+		tolerance = MATCH_MIN_TOLERANCE;
+
+	return (fabs(magnetCurrent - supplyCurrent) > tolerance);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include "magnetparams.h"
+#include "processmanager.h"
+#include "samplehistory.h"
+
+//---------------------------------------------------------------------------
+// Closed-loop controller that brings the supply current of each cooled
+// switch axis to the last known magnet current before the switch(es) are
+// heated. All mismatched axes are ramped simultaneously at their maximum
+// ramp rate, and the state of each ramping axis is polled at a high rate
+// until it reaches HOLDING. The ramp rate in use before matching is restored
+// when matching completes or is abandoned.
+//---------------------------------------------------------------------------
+enum MatchStart
+{
+	MATCH_STARTED = 0,		// matchComplete() or matchAborted() follows
+	MATCH_NOT_NEEDED,		// currents already match, switch(es) may be heated
+	MATCH_FAILED			// currents could not be read, see errorString()
+};
+
+class CurrentMatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	CurrentMatcher(QObject *parent);
+	~CurrentMatcher();
+	MatchStart start(ProcessManager *xProcess, ProcessManager *yProcess, ProcessManager *zProcess, MagnetParams *magnetParams,
+		const HistorySample &sample);
+	void stop(void);
+	bool isActive(void) { return pollTimer->isActive(); }
+	QString errorString(void) { return error; }
+
+signals:
+	void matchComplete(void);
+	void matchAborted(QString reason);
+
+private slots:
+	void pollTimerTick(void);
+
+private:
+	enum MatchState
+	{
+		MATCH_IDLE = 0,		// axis not participating
+		MATCH_RAMPING,		// target sent, waiting for HOLDING
+		MATCH_DONE
+	};
+
+	struct MatchAxis
+	{
+		ProcessManager *process;
+		AxesParams *params;
+		MatchState state;
+		double targetCurrent;	// A
+		double savedRampRate;	// A/s, rate to restore, <= 0 if none was sent
+	};
+
+	bool isMismatched(double magnetCurrent, double supplyCurrent);
+	void restoreRampRates(void);
+
+	QTimer *pollTimer;
+	MatchAxis axes[3];
+	QString error;
+};
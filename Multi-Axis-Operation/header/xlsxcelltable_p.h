@@ -0,0 +1,98 @@
+// xlsxcelltable_p.h
+
+#ifndef XLSXCELLTABLE_P_H
+#define XLSXCELLTABLE_P_H
+
+#include <QtGlobal>
+#include <QVariant>
+#include <QVector>
+#include <QString>
+#include <QSharedPointer>
+
+#include "xlsxglobal.h"
+#include "xlsxcell.h"
+#include "xlsxformat.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class Styles;
+
+/*
+  Dense cell storage of a worksheet. Rows are kept in a vector ordered by
+  row number and every row keeps its cells contiguously, ordered by column,
+  so filling a sheet row by row only ever appends. A cell record is a small
+  plain struct: its format is an index into the workbook styles, a number
+  is held inline and a string is an index into the string pool of the
+  table. A Cell object is only allocated for cells that need one (formulas,
+  rich text) or once Worksheet::cellAt() hands one out, after which the
+  Cell object is authoritative for that position.
+ */
+class CellTable
+{
+public:
+    enum ValueKind
+    {
+        NoValue,        // blank cell, no 'v' element
+        NumberValue,
+        BoolValue,
+        TextValue
+    };
+
+    struct Record
+    {
+        int column = 0;
+        qint32 xfIndex = -1;        // format in the workbook styles, -1 if none
+        qint32 styleNumber = -1;    // style index the cell was loaded with
+        mutable qint32 cell = -1;   // slot in the Cell objects, -1 if none
+        quint8 type = Cell::NumberType;
+        quint8 kind = NoValue;
+        union {
+            double number = 0.0;    // NumberValue, BoolValue
+            int text;               // TextValue, index into the string pool
+        };
+
+        Cell::CellType plainType() const { return Cell::CellType(type); }
+    };
+
+    struct Row
+    {
+        int row = 0;
+        QVector<Record> cells;
+    };
+
+    bool isEmpty() const { return m_rows.isEmpty(); }
+    void clear();
+    const QVector<Row> &rows() const { return m_rows; }
+
+    int rowIndex(int row) const;
+    const Row *findRow(int row) const;
+    const Record *find(int row, int column) const;
+
+    void insert(int row, int column, const QVariant &value, Cell::CellType type, qint32 xfIndex, qint32 styleNumber = -1);
+    void insert(int row, int column, const QSharedPointer<Cell> &cell);
+
+    Cell *cell(const Record &record) const;
+    QVariant value(const Record &record) const;
+    Cell::CellType cellType(const Record &record) const;
+    QVariant cellValue(const Record &record) const;
+    qint32 cellXfIndex(const Record &record) const;
+    Format cellFormat(const Record &record, Styles *styles) const;
+
+    QSharedPointer<Cell> cellOf(const Record &record, Worksheet *sheet) const;
+
+    static qint32 xfIndexOf(const Format &format) { return format.isEmpty() ? -1 : format.xfIndex(); }
+
+private:
+    Record &recordAt(int row, int column);
+
+    QVector<Row> m_rows;
+    QVector<QString> m_strings;
+    mutable QVector<QSharedPointer<Cell> > m_cells;
+};
+
+QT_END_NAMESPACE_XLSX
+
+Q_DECLARE_TYPEINFO(QXlsx::CellTable::Record, Q_MOVABLE_TYPE);
+
+#endif // XLSXCELLTABLE_P_H
@@ -114,6 +114,11 @@ public:
 	bool saveAs(const QString &xlsXname) const;
 	bool saveAs(QIODevice *device) const;
 
+	void setCompressionLevel(int level);
+	int compressionLevel() const;
+	void setConcurrentCompression(bool enable);
+	bool concurrentCompression() const;
+
 	// copy style from one xlsx file to other
 	static bool copyStyle(const QString &from, const QString &to);
 
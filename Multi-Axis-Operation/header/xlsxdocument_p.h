@@ -34,6 +34,8 @@ public:
     QSharedPointer<Workbook> workbook;
     QSharedPointer<ContentTypes> contentTypes;
 	bool isLoad; 
+	int compressionLevel; //zlib level of the package parts, 0 stores them
+	bool concurrentCompression; //deflate package parts on the thread pool
 };
 
 QT_END_NAMESPACE_XLSX
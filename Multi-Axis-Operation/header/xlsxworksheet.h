@@ -91,6 +91,9 @@ public:
     bool writeHyperlink(const CellReference &row_column, const QUrl &url, const Format &format=Format(), const QString &display=QString(), const QString &tip=QString());
     bool writeHyperlink(int row, int column, const QUrl &url, const Format &format=Format(), const QString &display=QString(), const QString &tip=QString());
 
+    bool appendRow(const QList<QVariant> &values, const QList<Format> &formats = QList<Format>());
+    bool isStreaming() const;
+
     bool addDataValidation(const DataValidation &validation);
     bool addConditionalFormatting(const ConditionalFormatting &cf);
 
@@ -9,6 +9,9 @@
 #include <QVector>
 #include <QImage>
 #include <QSharedPointer>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+#include <QXmlStreamWriter>
 
 #if QT_VERSION >= QT_VERSION_CHECK( 5, 0, 0 )
 #include <QRegularExpression>
@@ -19,6 +22,7 @@
 #include "xlsxworksheet.h"
 #include "xlsxabstractsheet_p.h"
 #include "xlsxcell.h"
+#include "xlsxcelltable_p.h"
 #include "xlsxdatavalidation.h"
 #include "xlsxconditionalformatting.h"
 #include "xlsxcellformula.h"
@@ -160,11 +164,14 @@ public:
     void validateDimension();
 
     void saveXmlSheetData(QXmlStreamWriter &writer) const;
-    void saveXmlCellData(QXmlStreamWriter &writer, int row, int col, QSharedPointer<Cell> cell) const;
+    void saveXmlCellData(QXmlStreamWriter &writer, int row, int col, const CellTable::Record &record) const;
     void saveXmlMergeCells(QXmlStreamWriter &writer) const;
     void saveXmlHyperlinks(QXmlStreamWriter &writer) const;
     void saveXmlDrawings(QXmlStreamWriter &writer) const;
     void saveXmlDataValidations(QXmlStreamWriter &writer) const;
+    void saveXmlStreamedCell(QXmlStreamWriter &writer, int row, int col, const QVariant &value, Format format);
+    void saveXmlStreamedRows(QXmlStreamWriter &writer, QIODevice *device) const;
+    int lastCellTableRow() const;
 
     int rowPixelsSize(int row) const;
     int colPixelsSize(int col) const;
@@ -185,7 +192,7 @@ public:
     SharedStrings *sharedStrings() const;
 
 public:
-    QMap<int, QMap<int, QSharedPointer<Cell> > > cellTable;
+    CellTable cellTable;
 
     QMap<int, QMap<int, QString> > comments;
     QMap<int, QMap<int, QSharedPointer<XlsxHyperlinkData> > > urlTable;
@@ -202,6 +209,13 @@ public:
     CellRange dimension;
     int previous_row;
 
+    // rows added with Worksheet::appendRow() are serialized on the spot
+    // into streamFile and copied into the sheet xml when it is saved
+    QScopedPointer<QTemporaryFile> streamFile;
+    QScopedPointer<QXmlStreamWriter> streamWriter;
+    int streamFirstRow;
+    int streamLastRow;
+
     mutable QMap<int, QString> row_spans;
     QMap<int, double> row_sizes;
     QMap<int, double> col_sizes;
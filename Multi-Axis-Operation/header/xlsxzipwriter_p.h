@@ -5,12 +5,13 @@
 
 #include <QtGlobal>
 #include <QString>
+#include <QByteArray>
+#include <QList>
 #include <QIODevice>
+#include <QSharedPointer>
 
 #include "xlsxglobal.h"
 
-class QZipWriter;
-
 QT_BEGIN_NAMESPACE_XLSX
 
 class ZipWriter
@@ -22,11 +23,61 @@ public:
 
     void addFile(const QString &filePath, QIODevice *device);
     void addFile(const QString &filePath, const QByteArray &data);
+
+    // Streamed entry: everything written to the returned device ends up in
+    // the archive. Unless the compression level is 0 it is collected and
+    // deflated by endFile() like an addFile() entry; past 128 MB, or at
+    // level 0, it goes straight into the archive stored uncompressed. Only
+    // one streamed entry can be open at a time and it must be ended before
+    // adding more.
+    QIODevice *beginFile(const QString &filePath);
+    void endFile();
+
+    // zlib level 1 to 9, 0 stores entries uncompressed and -1 (the
+    // default) uses the zlib default level
+    void setCompressionLevel(int level);
+
+    // Concurrent mode deflates the entries given to addFile() on the global
+    // thread pool. Entries are still written in the order they were added.
+    void setConcurrent(bool enable);
+
     bool error() const;
     void close();
 
 private:
-    QZipWriter *m_writer;
+    class EntryDevice;
+    class CompressJob;
+
+    struct Entry
+    {
+        QByteArray name;
+        quint16 flags;
+        quint16 method;
+        quint32 crc;
+        quint32 compressedSize;
+        quint32 size;
+        quint32 offset;
+    };
+
+    void init();
+    void writeLocalHeader(const Entry &entry);
+    bool writeRaw(const QByteArray &data);
+    void writeEntry(Entry &entry, const QByteArray &payload);
+    bool beginStoredEntry(const QString &filePath);
+    void writePending(bool wait);
+
+    QIODevice *m_device;
+    bool m_ownsDevice;
+    bool m_error;
+    bool m_closed;
+    quint64 m_offset;   // bytes written to the archive so far
+    quint16 m_time;
+    quint16 m_date;
+    QList<Entry> m_entries;
+    EntryDevice *m_entryDevice;
+    int m_level;
+    bool m_concurrent;
+    QList<QSharedPointer<CompressJob> > m_pending;   // in the order added
 };
 
 QT_END_NAMESPACE_XLSX
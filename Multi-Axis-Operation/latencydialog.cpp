@@ -0,0 +1,97 @@
+#include "stdafx.h"
+#include "latencydialog.h"
+#include "latencystats.h"
+
+const int REFRESH_MSEC = 1000;
+
+//---------------------------------------------------------------------------
+LatencyDialog::LatencyDialog(QWidget *parent)
+	: QDialog(parent)
+{
+	ui.setupUi(this);
+	setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+	refreshTimer = new QTimer(this);
+	refreshTimer->setInterval(REFRESH_MSEC);
+
+	connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+	connect(ui.buttonBox, SIGNAL(clicked(QAbstractButton*)), this, SLOT(buttonClicked(QAbstractButton*)));
+
+#if defined(Q_OS_MACOS)
+	// Mac base font scaling is different than Linux and Windows
+	this->setFont(QFont(".SF NS Text", 13));
+#endif
+}
+
+//---------------------------------------------------------------------------
+LatencyDialog::~LatencyDialog()
+{
+}
+
+//---------------------------------------------------------------------------
+void LatencyDialog::showEvent(QShowEvent *event)
+{
+	refresh();
+	refreshTimer->start();
+	QDialog::showEvent(event);
+}
+
+//---------------------------------------------------------------------------
+void LatencyDialog::hideEvent(QHideEvent *event)
+{
+	refreshTimer->stop();
+	QDialog::hideEvent(event);
+}
+
+//---------------------------------------------------------------------------
+void LatencyDialog::buttonClicked(QAbstractButton* whichButton)
+{
+	QDialogButtonBox::StandardButton stdButton = ui.buttonBox->standardButton(whichButton);
+
+	switch (stdButton)
+	{
+	case QDialogButtonBox::Reset:
+		LatencyStats::reset();
+		refresh();
+		break;
+
+	case QDialogButtonBox::Close:
+		close();
+		break;
+
+	default:
+		break;
+	}
+}
+
+//---------------------------------------------------------------------------
+// Fills the table from the same rows as SYST:STATS?
+//---------------------------------------------------------------------------
+void LatencyDialog::refresh(void)
+{
+	QStringList rows = LatencyStats::report();
+
+	ui.statsTable->setRowCount(rows.count());
+
+	for (int i = 0; i < rows.count(); i++)
+	{
+		QStringList fields = rows[i].split(',');
+
+		for (int j = 0; j < fields.count() && j < ui.statsTable->columnCount(); j++)
+		{
+			QTableWidgetItem *item = ui.statsTable->item(i, j);
+
+			if (item == nullptr)
+			{
+				item = new QTableWidgetItem;
+
+				if (j >= 2)
+					item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+				ui.statsTable->setItem(i, j, item);
+			}
+
+			item->setText(fields[j]);
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QDialog>
+#include <QTimer>
+#include "ui_latencydialog.h"
+
+//---------------------------------------------------------------------------
+// Debug view of the latency statistics, refreshed while shown
+//---------------------------------------------------------------------------
+class LatencyDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	LatencyDialog(QWidget *parent = Q_NULLPTR);
+	~LatencyDialog();
+
+protected:
+	void showEvent(QShowEvent *event);
+	void hideEvent(QHideEvent *event);
+
+private slots:
+	void buttonClicked(QAbstractButton*);
+	void refresh(void);
+
+private:
+	Ui::LatencyDialog ui;
+	QTimer *refreshTimer;
+};
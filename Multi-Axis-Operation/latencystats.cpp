@@ -0,0 +1,262 @@
+#include "stdafx.h"
+#include "latencystats.h"
+#include "commandtree.h"
+#include <chrono>
+#include <cmath>
+
+const int LINEAR_BUCKETS = 32;		// exact values below this
+const int SUB_BUCKETS = 16;			// per power of two above it
+
+static const char *stageNames[NUM_LATENCY_STAGES] = { "GUI_QUEUE", "GUI_TICK", "GUI_ACTION" };
+
+static const char *axisQueryNames[NUM_AXIS_QUERIES] =
+{
+	"CURR:MAG?", "CURR:SUPP?", "FIELD:MAG?", "QU:CURR?", "CURR:LIM?",
+	"VOLT:LIM?", "COIL?", "IND?", "PS:INST?", "PS:CURR?",
+	"PS:HTIME?", "PS:CTIME?", "FIELD:UNITS?", "STATE?", "PS?"
+};
+
+static const char *axisNames[3] = { "X", "Y", "Z" };
+
+static std::atomic<LatencyHistogram *> commandHistograms[NUM_COMMAND_IDS];
+static std::atomic<LatencyHistogram *> stageHistograms[NUM_LATENCY_STAGES];
+static std::atomic<LatencyHistogram *> axisQueryHistograms[3][NUM_AXIS_QUERIES];
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+//---------------------------------------------------------------------------
+int LatencyHistogram::bucketIndex(qint64 value)
+{
+	if (value < LINEAR_BUCKETS)
+		return (int)value;
+
+	// shift keeps the top 5 bits, a value in [16,31] above the shift
+	int shift = (63 - qCountLeadingZeroBits((quint64)value)) - 4;
+
+	return SUB_BUCKETS * shift + (int)(value >> shift);
+}
+
+//---------------------------------------------------------------------------
+qint64 LatencyHistogram::bucketHighest(int index)
+{
+	if (index < LINEAR_BUCKETS)
+		return index;
+
+	int shift = index / SUB_BUCKETS - 1;
+	qint64 lowest = (qint64)(index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+
+	return lowest + ((qint64)1 << shift) - 1;
+}
+
+//---------------------------------------------------------------------------
+void LatencyHistogram::record(qint64 usec)
+{
+	if (usec < 0)
+		usec = 0;
+	else if (usec > MAX_VALUE)
+		usec = MAX_VALUE;
+
+	counts[bucketIndex(usec)].fetch_add(1, std::memory_order_relaxed);
+
+	qint64 previous = max.load(std::memory_order_relaxed);
+
+	while (usec > previous && !max.compare_exchange_weak(previous, usec, std::memory_order_relaxed))
+		;
+}
+
+//---------------------------------------------------------------------------
+void LatencyHistogram::reset(void)
+{
+	for (int i = 0; i < NUM_BUCKETS; i++)
+		counts[i].store(0, std::memory_order_relaxed);
+
+	max.store(0, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+quint64 LatencyHistogram::count(void) const
+{
+	quint64 total = 0;
+
+	for (int i = 0; i < NUM_BUCKETS; i++)
+		total += counts[i].load(std::memory_order_relaxed);
+
+	return total;
+}
+
+//---------------------------------------------------------------------------
+// Samples may be recorded meanwhile, so the result is approximate to the
+// extent of the samples that arrive during the scan
+//---------------------------------------------------------------------------
+qint64 LatencyHistogram::percentile(double percent) const
+{
+	quint64 total = count();
+
+	if (total == 0)
+		return 0;
+
+	quint64 target = (quint64)ceil(total * percent / 100.0);
+	quint64 cumulative = 0;
+
+	if (target < 1)
+		target = 1;
+
+	for (int i = 0; i < NUM_BUCKETS; i++)
+	{
+		cumulative += counts[i].load(std::memory_order_relaxed);
+
+		if (cumulative >= target)
+			return qMin(bucketHighest(i), maximum());
+	}
+
+	return maximum();
+}
+
+//---------------------------------------------------------------------------
+// Returns the histogram in the slot, allocating it on first use. A thread
+// that loses the race to install one discards its own.
+//---------------------------------------------------------------------------
+static LatencyHistogram *histogram(std::atomic<LatencyHistogram *> &slot)
+{
+	LatencyHistogram *existing = slot.load(std::memory_order_acquire);
+
+	if (existing)
+		return existing;
+
+	LatencyHistogram *created = new LatencyHistogram;
+
+	if (slot.compare_exchange_strong(existing, created, std::memory_order_acq_rel))
+		return created;
+
+	delete created;
+	return existing;
+}
+
+//---------------------------------------------------------------------------
+static void appendReport(QVector<LatencyReport> *entries, const char *group, const QString &name, const std::atomic<LatencyHistogram *> &slot)
+{
+	LatencyHistogram *histogram = slot.load(std::memory_order_acquire);
+	quint64 count = histogram ? histogram->count() : 0;
+
+	if (count == 0)
+		return;
+
+	LatencyReport entry = { group, name, count, histogram->percentile(50.0), histogram->percentile(90.0),
+		histogram->percentile(99.0), histogram->percentile(99.9), histogram->maximum() };
+
+	entries->append(entry);
+}
+
+//---------------------------------------------------------------------------
+qint64 LatencyStats::now(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//---------------------------------------------------------------------------
+// Time spent by the parser in a command handler, for queued commands this
+// is the time to check and queue it (see ActionLatency for the rest), for
+// WAIT commands the time waited
+//---------------------------------------------------------------------------
+void LatencyStats::recordCommand(int command, qint64 usec)
+{
+	if (command > CMD_NONE && command < NUM_COMMAND_IDS)
+		histogram(commandHistograms[command])->record(usec);
+}
+
+//---------------------------------------------------------------------------
+void LatencyStats::recordStage(LatencyStage stage, qint64 usec)
+{
+	histogram(stageHistograms[stage])->record(usec);
+}
+
+//---------------------------------------------------------------------------
+ActionLatency::ActionLatency(qint64 sent)
+	: sent(sent)
+{
+	LatencyStats::recordStage(STAGE_GUI_QUEUE, LatencyStats::now() - sent);
+}
+
+//---------------------------------------------------------------------------
+ActionLatency::~ActionLatency()
+{
+	LatencyStats::recordStage(STAGE_GUI_ACTION, LatencyStats::now() - sent);
+}
+
+//---------------------------------------------------------------------------
+// Magnet-DAQ query round trip, including the Model 430 supply behind it
+//---------------------------------------------------------------------------
+void LatencyStats::recordAxisQuery(Axis axis, AxisQuery query, qint64 usec)
+{
+	histogram(axisQueryHistograms[axis][query])->record(usec);
+}
+
+//---------------------------------------------------------------------------
+void LatencyStats::reset(void)
+{
+	for (int i = 0; i < NUM_COMMAND_IDS; i++)
+	{
+		if (LatencyHistogram *entry = commandHistograms[i].load(std::memory_order_acquire))
+			entry->reset();
+	}
+
+	for (int i = 0; i < NUM_LATENCY_STAGES; i++)
+	{
+		if (LatencyHistogram *entry = stageHistograms[i].load(std::memory_order_acquire))
+			entry->reset();
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int i = 0; i < NUM_AXIS_QUERIES; i++)
+		{
+			if (LatencyHistogram *entry = axisQueryHistograms[axis][i].load(std::memory_order_acquire))
+				entry->reset();
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+QVector<LatencyReport> LatencyStats::reportEntries(void)
+{
+	QVector<LatencyReport> entries;
+	char name[64];
+
+	for (int i = CMD_NONE + 1; i < NUM_COMMAND_IDS; i++)
+	{
+		if (commandName((CommandId)i, name, sizeof(name)))
+			appendReport(&entries, "CMD", name, commandHistograms[i]);
+	}
+
+	for (int i = 0; i < NUM_LATENCY_STAGES; i++)
+		appendReport(&entries, "STAGE", stageNames[i], stageHistograms[i]);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int i = 0; i < NUM_AXIS_QUERIES; i++)
+			appendReport(&entries, "AXIS", QString(axisNames[axis]) + ":" + axisQueryNames[i], axisQueryHistograms[axis][i]);
+	}
+
+	return entries;
+}
+
+//---------------------------------------------------------------------------
+QStringList LatencyStats::report(void)
+{
+	QVector<LatencyReport> entries = reportEntries();
+	QStringList rows;
+
+	for (const LatencyReport &entry : entries)
+	{
+		rows.append(QString("%1,%2,%3,%4,%5,%6,%7,%8").arg(entry.group).arg(entry.name).arg(entry.count)
+			.arg(entry.p50).arg(entry.p90).arg(entry.p99).arg(entry.p999).arg(entry.max));
+	}
+
+	return rows;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include "magnetparams.h"
+
+//---------------------------------------------------------------------------
+// Type declarations
+//---------------------------------------------------------------------------
+enum LatencyStage
+{
+	STAGE_GUI_QUEUE = 0,		// parser signal until its slot runs on the GUI thread
+	STAGE_GUI_TICK,				// GUI thread busy in one data acquisition tick
+	STAGE_GUI_ACTION,			// parser signal until its slot has returned
+	NUM_LATENCY_STAGES
+};
+
+enum AxisQuery
+{
+	AXIS_QUERY_MAGNET_CURRENT = 0,
+	AXIS_QUERY_SUPPLY_CURRENT,
+	AXIS_QUERY_FIELD,
+	AXIS_QUERY_QUENCH_CURRENT,
+	AXIS_QUERY_CURRENT_LIMIT,
+	AXIS_QUERY_VOLTAGE_LIMIT,
+	AXIS_QUERY_COIL_CONSTANT,
+	AXIS_QUERY_INDUCTANCE,
+	AXIS_QUERY_SWITCH_INSTALLED,
+	AXIS_QUERY_SWITCH_CURRENT,
+	AXIS_QUERY_SWITCH_HEATING_TIME,
+	AXIS_QUERY_SWITCH_COOLING_TIME,
+	AXIS_QUERY_UNITS,
+	AXIS_QUERY_STATE,
+	AXIS_QUERY_SWITCH_HEATER,
+	NUM_AXIS_QUERIES
+};
+
+//---------------------------------------------------------------------------
+// Latency histogram with log-linear buckets in the style of HdrHistogram:
+// values below 32 usec are exact, larger ones fall into 16 buckets per
+// power of two (about 6% resolution) up to MAX_VALUE. Recording is a few
+// relaxed atomic adds, safe from any thread without a lock.
+//---------------------------------------------------------------------------
+class LatencyHistogram
+{
+public:
+	static const qint64 MAX_VALUE = 0xFFFFFFFFLL;	// usec, larger values are clamped
+	static const int NUM_BUCKETS = 464;
+
+	LatencyHistogram();
+
+	void record(qint64 usec);
+	void reset(void);
+	quint64 count(void) const;
+	qint64 percentile(double percent) const;		// usec, highest value in the bucket
+	qint64 maximum(void) const { return max.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<quint64> counts[NUM_BUCKETS];
+	std::atomic<qint64> max;
+
+	static int bucketIndex(qint64 value);
+	static qint64 bucketHighest(int index);
+};
+
+//---------------------------------------------------------------------------
+// One histogram of a report, percentiles and maximum in usec
+//---------------------------------------------------------------------------
+struct LatencyReport
+{
+	const char *group;			// CMD, STAGE or AXIS
+	QString name;
+	quint64 count;
+	qint64 p50;
+	qint64 p90;
+	qint64 p99;
+	qint64 p999;
+	qint64 max;
+};
+
+//---------------------------------------------------------------------------
+// Latency statistics for the remote path, from parsing a command through
+// the GUI thread to the Magnet-DAQ round trips of each axis. Histograms
+// are allocated on first use. All functions are thread safe.
+//---------------------------------------------------------------------------
+class LatencyStats
+{
+public:
+	static qint64 now(void);		// monotonic usec
+
+	static void recordCommand(int command, qint64 usec);
+	static void recordStage(LatencyStage stage, qint64 usec);
+	static void recordAxisQuery(Axis axis, AxisQuery query, qint64 usec);
+	static void reset(void);
+
+	// the histograms with samples, and the same as rows of
+	// <group>,<name>,<count>,<p50>,<p90>,<p99>,<p99.9>,<max>
+	static QVector<LatencyReport> reportEntries(void);
+	static QStringList report(void);
+};
+
+//---------------------------------------------------------------------------
+// Times a queued parser action in its slot on the GUI thread, from sent
+// (LatencyStats::now() when the signal was emitted): STAGE_GUI_QUEUE on
+// entry and STAGE_GUI_ACTION when the slot returns.
+//---------------------------------------------------------------------------
+class ActionLatency
+{
+public:
+	ActionLatency(qint64 sent);
+	~ActionLatency();
+
+private:
+	qint64 sent;
+};
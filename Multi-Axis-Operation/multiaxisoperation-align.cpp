@@ -87,6 +87,7 @@ void MultiAxisOperation::alignmentTabLoadFromStream(QTextStream *stream)
 	makeAlignVector2Active(false);
 
 	recalculateRotationVector();
+	publishSnapshot();
 }
 
 //---------------------------------------------------------------------------
@@ -263,6 +264,8 @@ void MultiAxisOperation::alignVector1ValueChanged(double value)
 
 	if (qobject_cast<QDoubleSpinBox *>(sender()) == ui.alignPhiSpinBox1)
 		phi1ShadowVal = ui.alignPhiSpinBox1->value();
+
+	publishSnapshot();
 }
 
 //---------------------------------------------------------------------------
@@ -465,6 +468,8 @@ void MultiAxisOperation::alignVector2ValueChanged(double value)
 
 	if (qobject_cast<QDoubleSpinBox *>(sender()) == ui.alignPhiSpinBox2)
 		phi2ShadowVal = ui.alignPhiSpinBox2->value();
+
+	publishSnapshot();
 }
 
 //---------------------------------------------------------------------------
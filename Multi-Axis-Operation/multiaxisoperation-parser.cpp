@@ -1,11 +1,9 @@
 #include "stdafx.h"
 #include "multiaxisoperation.h"
 #include "conversions.h"
+#include "latencystats.h"
 
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-#include <unistd.h>
-#endif
-
+const int HISTORY_BATCH_ROWS = 8192;	// samples copied per remote history request
 
 //---------------------------------------------------------------------------
 // Contains methods related to the stdin/stdout parser thread.
@@ -14,32 +12,76 @@
 // Broken out from multiaxisoperation.cpp for ease of editing.
 //---------------------------------------------------------------------------
 
-void MultiAxisOperation::system_connect(void)
+// names of remote target actions for EVENT_ACTION
+static const char *remoteActionName(RemoteAction action)
+{
+	static const char *names[] = { "VECTOR", "POLAR", "ALIGN1", "ALIGN2" };
+
+	return names[action];
+}
+
+//---------------------------------------------------------------------------
+// Ramp, pause and zero from a parser, the toolbar actions share the slots
+// without latency stats
+void MultiAxisOperation::remote_ramp(qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	actionRamp();
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::remote_pause(qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	actionPause();
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::remote_zero(qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	actionZero();
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::system_connect(qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	ui.actionConnect->setChecked(true);
 	actionConnect();
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::system_disconnect(void)
+void MultiAxisOperation::system_disconnect(qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	ui.actionConnect->setChecked(false);
 	actionConnect();
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::exit_app(void)
+void MultiAxisOperation::exit_app(qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	// first disconnect
-	system_disconnect();
+	ui.actionConnect->setChecked(false);
+	actionConnect();
 
 	// then close app
 	close();
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::load_settings(FILE *file, bool *success)
+void MultiAxisOperation::load_settings(FILE *file, bool *success, qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	loadFromFile(file);
 
 	// sync the UI with the newly loaded values
@@ -54,16 +96,20 @@ void MultiAxisOperation::load_settings(FILE *file, bool *success)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::save_settings(FILE *file, bool *success)
+void MultiAxisOperation::save_settings(FILE *file, bool *success, qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	saveToFile(file);
 
 	fclose(file);
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_units(int value)
+void MultiAxisOperation::set_units(int value, qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	if ((FieldUnits)value != fieldUnits)	// only convert if units have changed!
 	{
 		setFieldUnits((FieldUnits)value, true);
@@ -74,45 +120,27 @@ void MultiAxisOperation::set_units(int value)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_align1(double mag, double azimuth, double inclination)
+void MultiAxisOperation::set_align1(double mag, double azimuth, double inclination, qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	ui.alignMagValueSpinBox1->setValue(mag);
 	ui.alignThetaSpinBox1->setValue(azimuth);
 	ui.alignPhiSpinBox1->setValue(inclination);
 
 	ui.makeAlignActiveButton1->setChecked(true);
 
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
-
-	makeAlignVector1Active(true);
+	runRemoteAction(ACTION_ALIGN1, -1);
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_align1_active(void)
+void MultiAxisOperation::set_align1_active(qint64 sent)
 {
-	ui.makeAlignActiveButton1->setChecked(true);
+	ActionLatency latency(sent);
 
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
+	ui.makeAlignActiveButton1->setChecked(true);
 
-	makeAlignVector1Active(true);
+	runRemoteAction(ACTION_ALIGN1, -1);
 }
 
 //---------------------------------------------------------------------------
@@ -130,45 +158,27 @@ void MultiAxisOperation::get_align1_cartesian(double *x, double *y, double *z)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_align2(double mag, double azimuth, double inclination)
+void MultiAxisOperation::set_align2(double mag, double azimuth, double inclination, qint64 sent)
 {
+	ActionLatency latency(sent);
+
 	ui.alignMagValueSpinBox2->setValue(mag);
 	ui.alignThetaSpinBox2->setValue(azimuth);
 	ui.alignPhiSpinBox2->setValue(inclination);
 
 	ui.makeAlignActiveButton2->setChecked(true);
 
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
-
-	makeAlignVector2Active(true);
+	runRemoteAction(ACTION_ALIGN2, -1);
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_align2_active(void)
+void MultiAxisOperation::set_align2_active(qint64 sent)
 {
-	ui.makeAlignActiveButton2->setChecked(true);
+	ActionLatency latency(sent);
 
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
+	ui.makeAlignActiveButton2->setChecked(true);
 
-	makeAlignVector2Active(true);
+	runRemoteAction(ACTION_ALIGN2, -1);
 }
 
 //---------------------------------------------------------------------------
@@ -223,6 +233,206 @@ void MultiAxisOperation::get_plane(double *x, double *y, double *z)
 	*z = crossResult.z();
 }
 
+//---------------------------------------------------------------------------
+// Copies the state for the remote interface under the snapshot lock.
+// Called on the GUI thread after each acquisition and whenever values
+// reported by queries change outside of acquisition.
+void MultiAxisOperation::publishSnapshot(void)
+{
+	RemoteSnapshot snapshot;
+
+	snapshot.timestamp = QDateTime::currentMSecsSinceEpoch();
+	snapshot.connected = connected;
+	snapshot.persistent = isPersistent();
+	snapshot.switchInstalled = switchInstalled;
+	snapshot.state = (int)systemState;
+	snapshot.fieldUnits = (int)fieldUnits;
+	snapshot.remainingTime = remainingTime;
+	get_field_cartesian(&snapshot.field[0], &snapshot.field[1], &snapshot.field[2]);
+	get_field(&snapshot.fieldSpherical[0], &snapshot.fieldSpherical[1], &snapshot.fieldSpherical[2]);
+	get_active_cartesian(&snapshot.target[0], &snapshot.target[1], &snapshot.target[2]);
+	get_active(&snapshot.targetSpherical[0], &snapshot.targetSpherical[1], &snapshot.targetSpherical[2]);
+	get_align1(&snapshot.align1[0], &snapshot.align1[1], &snapshot.align1[2]);
+	get_align2(&snapshot.align2[0], &snapshot.align2[1], &snapshot.align2[2]);
+	get_plane(&snapshot.plane[0], &snapshot.plane[1], &snapshot.plane[2]);
+	snapshot.tableCoordinates = (int)loadedCoordinates;
+	snapshot.autostepActive = autostepTimer->isActive() || autostepPolarTimer->isActive();
+	snapshot.vectorLoading = vectorLoader->isRunning();
+	snapshot.polarLoading = polarLoader->isRunning();
+	snapshot.stepRow = remoteStepRow;
+	snapshot.pendingActions = pendingActions.count();
+	snapshot.appRunning = remoteAppRunning;
+	snapshot.appExitCode = remoteAppExitCode;
+	snapshot.syncToken = remoteSyncToken;
+
+	QMutexLocker lock(&snapshotMutex);
+	snapshot.sequence = remoteSnapshot.sequence + 1;
+	remoteSnapshot = snapshot;
+	snapshotPublished.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+// Thread-safe copy of the last published snapshot
+void MultiAxisOperation::get_snapshot(RemoteSnapshot *snapshot)
+{
+	QMutexLocker lock(&snapshotMutex);
+	*snapshot = remoteSnapshot;
+}
+
+//---------------------------------------------------------------------------
+// Waits up to msec for a snapshot newer than the one passed in and copies
+// it out, returns false on timeout with the passed snapshot refreshed
+bool MultiAxisOperation::wait_snapshot(RemoteSnapshot *snapshot, unsigned long msec)
+{
+	QMutexLocker lock(&snapshotMutex);
+	quint64 sequence = snapshot->sequence;
+
+	if (remoteSnapshot.sequence == sequence)
+		snapshotPublished.wait(&snapshotMutex, msec);
+
+	*snapshot = remoteSnapshot;
+
+	return snapshot->sequence != sequence;
+}
+
+//---------------------------------------------------------------------------
+// Republishes the snapshot tagged with the token. Queued behind any
+// commands the parser emitted before the token, so a snapshot carrying it
+// reflects those commands. Tokens from several sessions may arrive out of
+// order, the highest one seen is kept. The time since sent measures how
+// far the GUI thread is behind the parsers.
+void MultiAxisOperation::remote_sync(quint64 token, qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	if (token > remoteSyncToken)
+		remoteSyncToken = token;
+
+	publishSnapshot();
+}
+
+//---------------------------------------------------------------------------
+// Called by the table auto-step as each row completes (row is 1-based)
+void MultiAxisOperation::autostepRowCompleted(const char *table, int row, bool last)
+{
+	remoteStepRow = row;
+	publishSnapshot();
+
+	// notify remote subscribers, last field flags the final row
+	emit remote_event(EVENT_STEP, QVariantList() << QString(table) << row << (last ? 1 : 0));
+}
+
+//---------------------------------------------------------------------------
+// Runs a remote target action now if the first measurement after connecting
+// has been made, otherwise queues it until dataTimerTick() makes one. An
+// action sent while not connected is cancelled.
+//---------------------------------------------------------------------------
+void MultiAxisOperation::runRemoteAction(RemoteAction action, int row)
+{
+	PendingAction pending = { action, row };
+
+	if (!ui.actionConnect->isChecked())
+	{
+		pendingActions.append(pending);
+		completePendingActions(false);
+	}
+	else if (madeFirstMeasurement.load() && pendingActions.isEmpty())
+	{
+		executeRemoteAction(pending);
+	}
+	else
+	{
+		pendingActions.append(pending);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Runs (or cancels on disconnect) the queued actions in the order received
+void MultiAxisOperation::completePendingActions(bool execute)
+{
+	while (!pendingActions.isEmpty())
+	{
+		PendingAction pending = pendingActions.takeFirst();
+
+		if (execute)
+		{
+			executeRemoteAction(pending);
+		}
+		else
+		{
+			emit remote_event(EVENT_ACTION, QVariantList() << QString(remoteActionName(pending.action)) << pending.row + 1 << 0);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// Sets the target for an action and reports it to remote subscribers as
+// <action>,<row>,<executed 0|1> with a 1-based table row (0 for alignment
+// vectors). A table row removed while the action was queued cancels it.
+void MultiAxisOperation::executeRemoteAction(const PendingAction &pending)
+{
+	bool executed = true;
+
+	switch (pending.action)
+	{
+	case ACTION_VECTOR:
+		if (vec_table_row_in_range(pending.row))
+		{
+			ui.vectorsTableView->selectRow(pending.row);
+			goToSelectedVector();
+		}
+		else
+			executed = false;
+		break;
+
+	case ACTION_POLAR:
+		if (polar_table_row_in_range(pending.row))
+		{
+			ui.polarTableView->selectRow(pending.row);
+			goToSelectedPolarVector();
+		}
+		else
+			executed = false;
+		break;
+
+	case ACTION_ALIGN1:
+		makeAlignVector1Active(true);
+		break;
+
+	case ACTION_ALIGN2:
+		makeAlignVector2Active(true);
+		break;
+	}
+
+	emit remote_event(EVENT_ACTION, QVariantList() << QString(remoteActionName(pending.action)) << pending.row + 1 << (executed ? 1 : 0));
+}
+
+//---------------------------------------------------------------------------
+// Runs the app configured on the vector or polar tab for a sequence EXEC.
+// The snapshot reports it running until finishedApp() or finishedPolarApp(),
+// and an exit code of -1 if it could not be launched.
+void MultiAxisOperation::execute_app(int table, qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	remoteAppRunning = false;
+	remoteAppExitCode = -1;
+
+	// Execute Now is disabled while an app or auto-step is running
+	if (connected && ui.executeNowButton->isEnabled())
+	{
+		if (table == POLAR_TABLE)
+			executePolarNowClick();
+		else
+			executeNowClick();
+
+		// a launched app disables Execute Now until it exits
+		remoteAppRunning = !ui.executeNowButton->isEnabled();
+	}
+
+	publishSnapshot();
+}
+
 //---------------------------------------------------------------------------
 VectorError MultiAxisOperation::check_vector(double x, double y, double z)
 {
@@ -280,19 +490,20 @@ VectorError MultiAxisOperation::check_vector(double x, double y, double z)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_vector(double mag, double az, double inc, int time)
+void MultiAxisOperation::set_vector(double mag, double az, double inc, int time, qint64 sent)
 {
-	int newRow = ui.vectorsTableWidget->rowCount();
-	ui.vectorsTableWidget->insertRow(newRow);
-	initNewRow(newRow);
+	ActionLatency latency(sent);
+
+	int newRow = vectorTable->rowCount();
+	vectorTable->insertRow(newRow);
 
 	if (loadedCoordinates == SPHERICAL_COORDINATES)
 	{
 		// set the spherical coordinate values for new row
-		ui.vectorsTableWidget->item(newRow, 0)->setText(QString::number(mag, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 1)->setText(QString::number(az, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 2)->setText(QString::number(inc, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 3)->setText(QString::number(time));
+		vectorTable->setValue(newRow, 0, mag);
+		vectorTable->setValue(newRow, 1, az);
+		vectorTable->setValue(newRow, 2, inc);
+		vectorTable->setValue(newRow, 3, time);
 	}
 	else if (loadedCoordinates == CARTESIAN_COORDINATES)
 	{
@@ -300,35 +511,24 @@ void MultiAxisOperation::set_vector(double mag, double az, double inc, int time)
 		sphericalToCartesian(mag, az, inc, &x, &y, &z);
 
 		// set the Cartesian coordinate values for new row
-		ui.vectorsTableWidget->item(newRow, 0)->setText(QString::number(x, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 1)->setText(QString::number(y, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 2)->setText(QString::number(z, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 3)->setText(QString::number(time));
+		vectorTable->setValue(newRow, 0, x);
+		vectorTable->setValue(newRow, 1, y);
+		vectorTable->setValue(newRow, 2, z);
+		vectorTable->setValue(newRow, 3, time);
 	}
 
 	// make present vector and goto
-	ui.vectorsTableWidget->selectRow(newRow);
-
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
-
-	goToSelectedVector();
+	ui.vectorsTableView->selectRow(newRow);
+	runRemoteAction(ACTION_VECTOR, newRow);
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_vector_cartesian(double x, double y, double z, int time)
+void MultiAxisOperation::set_vector_cartesian(double x, double y, double z, int time, qint64 sent)
 {
-	int newRow = ui.vectorsTableWidget->rowCount();
-	ui.vectorsTableWidget->insertRow(newRow);
-	initNewRow(newRow);
+	ActionLatency latency(sent);
+
+	int newRow = vectorTable->rowCount();
+	vectorTable->insertRow(newRow);
 
 	if (loadedCoordinates == SPHERICAL_COORDINATES)
 	{
@@ -336,41 +536,29 @@ void MultiAxisOperation::set_vector_cartesian(double x, double y, double z, int
 		cartesianToSpherical(x, y, z, &mag, &az, &inc);
 
 		// set the spherical coordinate values for new row
-		ui.vectorsTableWidget->item(newRow, 0)->setText(QString::number(mag, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 1)->setText(QString::number(az, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 2)->setText(QString::number(inc, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 3)->setText(QString::number(time));
+		vectorTable->setValue(newRow, 0, mag);
+		vectorTable->setValue(newRow, 1, az);
+		vectorTable->setValue(newRow, 2, inc);
+		vectorTable->setValue(newRow, 3, time);
 	}
 	else if (loadedCoordinates == CARTESIAN_COORDINATES)
 	{
 		// set the Cartesian coordinate values for new row
-		ui.vectorsTableWidget->item(newRow, 0)->setText(QString::number(x, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 1)->setText(QString::number(y, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 2)->setText(QString::number(z, 'g', 10));
-		ui.vectorsTableWidget->item(newRow, 3)->setText(QString::number(time));
+		vectorTable->setValue(newRow, 0, x);
+		vectorTable->setValue(newRow, 1, y);
+		vectorTable->setValue(newRow, 2, z);
+		vectorTable->setValue(newRow, 3, time);
 	}
 
 	// make present vector and goto
-	ui.vectorsTableWidget->selectRow(newRow);
-
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
-
-	goToSelectedVector();
+	ui.vectorsTableView->selectRow(newRow);
+	runRemoteAction(ACTION_VECTOR, newRow);
 }
 
 //---------------------------------------------------------------------------
 bool MultiAxisOperation::vec_table_row_in_range(int tableRow)
 {
-	if (tableRow >= 0 && tableRow < ui.vectorsTableWidget->rowCount())
+	if (tableRow >= 0 && tableRow < vectorTable->rowCount())
 		return true;
 
 	return false;
@@ -385,19 +573,19 @@ VectorError MultiAxisOperation::check_vector_table(int tableRow)
 	double temp;
 
 	// get vector values and check for numerical conversion
-	temp = ui.vectorsTableWidget->item(tableRow, 0)->text().toDouble(&ok);
+	temp = vectorTable->value(tableRow, 0, &ok);
 	if (ok)
 		coord1 = temp;
 	else
 		error = true;	// error
 
-	temp = ui.vectorsTableWidget->item(tableRow, 1)->text().toDouble(&ok);
+	temp = vectorTable->value(tableRow, 1, &ok);
 	if (ok)
 		coord2 = temp;
 	else
 		error = true;	// error
 
-	temp = ui.vectorsTableWidget->item(tableRow, 2)->text().toDouble(&ok);
+	temp = vectorTable->value(tableRow, 2, &ok);
 	if (ok)
 		coord3 = temp;
 	else
@@ -438,90 +626,76 @@ VectorError MultiAxisOperation::check_vector_table(int tableRow)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::goto_vector(int tableRow)
+// Checks a vector table row for a remote target and, if it is valid, makes
+// it the target. The outcome is returned to the session under the token.
+void MultiAxisOperation::goto_vector(int tableRow, quint64 token, qint64 sent)
 {
-	if (tableRow >= 0 && tableRow < ui.vectorsTableWidget->rowCount())
-	{
-		ui.vectorsTableWidget->selectRow(tableRow);
+	ActionLatency latency(sent);
+	RemoteRowCheck check;
 
-		// wait for first measurement to occur
-		while (!madeFirstMeasurement.load())
-		{
-			QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-			usleep(100000);
-#else
-			Sleep(100);
-#endif
-		}
+	check.loading = vectorLoader->isRunning();	// the row is about to be replaced
 
-		goToSelectedVector();
+	if (!check.loading)
+	{
+		check.inRange = vec_table_row_in_range(tableRow);
+
+		if (check.inRange)
+			check.error = check_vector_table(tableRow);
 	}
-	else
+
+	if (returnRowCheck(token, check) && check.inRange && check.error == NO_VECTOR_ERROR)
 	{
-		; // tableRow out of range (should already be checked)
+		ui.vectorsTableView->selectRow(tableRow);
+		runRemoteAction(ACTION_VECTOR, tableRow);
 	}
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_polar(double mag, double angle, int time)
+void MultiAxisOperation::set_polar(double mag, double angle, int time, qint64 sent)
 {
-	int newRow = ui.polarTableWidget->rowCount();
-	ui.polarTableWidget->insertRow(newRow);
-	initNewPolarRow(newRow);
+	ActionLatency latency(sent);
+
+	int newRow = polarTable->rowCount();
+	polarTable->insertRow(newRow);
 
 	// set the polar coordinate values for new row
-	ui.polarTableWidget->item(newRow, 0)->setText(QString::number(mag, 'g', 10));
-	ui.polarTableWidget->item(newRow, 1)->setText(QString::number(angle, 'g', 10));
-	ui.polarTableWidget->item(newRow, 2)->setText(QString::number(time));
+	polarTable->setValue(newRow, 0, mag);
+	polarTable->setValue(newRow, 1, angle);
+	polarTable->setValue(newRow, 2, time);
 
 	// make present vector and goto
-	ui.polarTableWidget->selectRow(newRow);
-
-	// wait for first measurement to occur
-	while (!madeFirstMeasurement.load())
-	{
-		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		usleep(100000);
-#else
-		Sleep(100);
-#endif
-	}
-
-	goToSelectedPolarVector();
+	ui.polarTableView->selectRow(newRow);
+	runRemoteAction(ACTION_POLAR, newRow);
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::goto_polar(int tableRow)
+// Checks a polar table row for a remote target, see goto_vector()
+void MultiAxisOperation::goto_polar(int tableRow, quint64 token, qint64 sent)
 {
-	if (tableRow >= 0 && tableRow < ui.polarTableWidget->rowCount())
-	{
-		ui.polarTableWidget->selectRow(tableRow);
+	ActionLatency latency(sent);
+	RemoteRowCheck check;
 
-		// wait for first measurement to occur
-		while (!madeFirstMeasurement.load())
-		{
-			QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-			usleep(100000);
-#else
-			Sleep(100);
-#endif
-		}
+	check.loading = polarLoader->isRunning();
 
-		goToSelectedPolarVector();
+	if (!check.loading)
+	{
+		check.inRange = polar_table_row_in_range(tableRow);
+
+		if (check.inRange)
+			check.error = check_polar_table(tableRow);
 	}
-	else
+
+	if (returnRowCheck(token, check) && check.inRange && check.error == NO_VECTOR_ERROR)
 	{
-		; // tableRow out of range
+		ui.polarTableView->selectRow(tableRow);
+		runRemoteAction(ACTION_POLAR, tableRow);
 	}
 }
 
 //---------------------------------------------------------------------------
 bool MultiAxisOperation::polar_table_row_in_range(int tableRow)
 {
-	if (tableRow >= 0 && tableRow < ui.polarTableWidget->rowCount())
+	if (tableRow >= 0 && tableRow < polarTable->rowCount())
 		return true;
 
 	return false;
@@ -535,7 +709,7 @@ VectorError MultiAxisOperation::check_polar_table(int tableRow)
 	double temp;
 
 	// get vector values and check for numerical conversion
-	temp = ui.polarTableWidget->item(tableRow, 0)->text().toDouble(&ok);
+	temp = polarTable->value(tableRow, 0, &ok);
 	if (ok)
 	{
 		coord1 = temp;
@@ -549,7 +723,7 @@ VectorError MultiAxisOperation::check_polar_table(int tableRow)
 	else
 		error = true;	// error
 
-	temp = ui.polarTableWidget->item(tableRow, 1)->text().toDouble(&ok);
+	temp = polarTable->value(tableRow, 1, &ok);
 	if (ok)
 		coord2 = temp;
 	else
@@ -574,8 +748,272 @@ VectorError MultiAxisOperation::check_polar_table(int tableRow)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::set_persistence(bool persistent)
+// Replaces the vector table with rows validated by the parser, each
+// "<c1>,<c2>,<c3>,<hold>,<persist>" in the present field units with an
+// empty persist field for the default. The table is rebuilt in one model
+// reset so the view updates once.
+void MultiAxisOperation::set_vector_table(QStringList rows, int coordinates, qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	if (autostepTimer->isActive() || vectorLoader->isRunning())
+		return;	// no load during auto-stepping or a file load
+
+	// if ramping, set system to PAUSE
+	actionPause();
+
+	bool hasSwitch = magnetParams->switchInstalled();
+	bool defaultPersistence = optionsDialog->enterPersistence();
+	int numColumns = vectorTable->getMinimumNumCols();
+
+	vectorTable->beginBulkUpdate();
+	vectorTable->setRowCount(0);
+	vectorTable->setColumnCount(numColumns);	// drops any quench columns
+	vectorTable->setRowCount(rows.count());
+
+	for (int i = 0; i < rows.count(); i++)
+	{
+		QStringList fields = rows[i].split(',');
+
+		for (int j = 0; j < 4; j++)
+			vectorTable->setText(i, j, fields[j]);
+
+		if (hasSwitch)
+			vectorTable->setChecked(i, fields[4].isEmpty() ? defaultPersistence : fields[4] == "1");
+	}
+
+	vectorTable->endBulkUpdate();
+
+	presentVector = lastVector = -1;	// no selection
+	lastTargetMsg.clear();
+	setStatusMsg("");
+	statusMisc->clear();
+
+	loadedCoordinates = (CoordinatesSelection)coordinates;
+	setTableHeader();
+	vectorSelectionChanged();
+	recalculateRemainingTime();
+}
+
+//---------------------------------------------------------------------------
+// Replaces the polar table with rows validated by the parser, each
+// "<mag>,<angle>,<hold>,<persist>" in the present field units
+void MultiAxisOperation::set_polar_table(QStringList rows, qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	if (autostepPolarTimer->isActive() || polarLoader->isRunning())
+		return;	// no load during auto-stepping or a file load
+
+	// if ramping, set system to PAUSE
+	actionPause();
+
+	bool hasSwitch = magnetParams->switchInstalled();
+	bool defaultPersistence = optionsDialog->enterPersistence();
+	int numColumns = polarTable->getMinimumNumCols();
+
+	polarTable->beginBulkUpdate();
+	polarTable->setRowCount(0);
+	polarTable->setColumnCount(numColumns);
+	polarTable->setRowCount(rows.count());
+
+	for (int i = 0; i < rows.count(); i++)
+	{
+		QStringList fields = rows[i].split(',');
+
+		for (int j = 0; j < numColumns; j++)
+			polarTable->setText(i, j, fields[j]);
+
+		if (hasSwitch)
+			polarTable->setChecked(i, fields[3].isEmpty() ? defaultPersistence : fields[3] == "1");
+	}
+
+	polarTable->endBulkUpdate();
+
+	presentPolar = lastPolar = -1;	// no selection
+	lastTargetMsg.clear();
+	setStatusMsg("");
+	statusMisc->clear();
+
+	setPolarTableHeader();
+	polarSelectionChanged();
+	recalculateRemainingPolarTime();
+}
+
+//---------------------------------------------------------------------------
+// Copies a table for a remote dump and wakes the requesting session. The
+// contents are implicitly shared, so only the persistence checks are
+// copied here; the session formats the rows as it writes them.
+void MultiAxisOperation::remote_table_dump(int table, quint64 token, qint64 sent)
+{
+	ActionLatency latency(sent);
+
+	RemoteTableDump dump;
+	TableModel *model = (table == POLAR_TABLE) ? polarTable : vectorTable;
+	bool hasSwitch = magnetParams->switchInstalled();
+
+	dump.table = table;
+	dump.coordinates = (int)loadedCoordinates;
+	model->getContents(&dump.contents);
+	dump.checks.fill(false, dump.contents.rows);
+
+	if (hasSwitch)
+	{
+		for (int i = 0; i < dump.contents.rows; i++)
+			dump.checks[i] = model->isChecked(i);
+	}
+
+	{
+		QMutexLocker lock(&snapshotMutex);
+
+		// the session timed out while the request was queued
+		if (discardedDumps.remove(token))
+			return;
+
+		tableDumps.insert(token, dump);
+	}
+
+	publishSnapshot();	// wakes the waiting session
+}
+
+//---------------------------------------------------------------------------
+// Takes a table dump requested with the token, returns false if not ready
+bool MultiAxisOperation::take_table_dump(quint64 token, RemoteTableDump *dump)
+{
+	QMutexLocker lock(&snapshotMutex);
+
+	if (!tableDumps.contains(token))
+		return false;
+
+	*dump = tableDumps.take(token);
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Drops a table dump the session stopped waiting for, now or once it is made
+void MultiAxisOperation::discard_table_dump(quint64 token)
+{
+	QMutexLocker lock(&snapshotMutex);
+
+	if (!tableDumps.remove(token))
+		discardedDumps.insert(token);
+}
+
+//---------------------------------------------------------------------------
+// Copies up to HISTORY_BATCH_ROWS acquisition samples with times in [from,
+// to] (msec since the history started) for a remote HISTORY? query and
+// wakes the requesting session. A batch is a few hundred KB at most, so the
+// GUI thread is never held up by a long range.
+void MultiAxisOperation::remote_history(qint64 from, qint64 to, quint64 token, qint64 sent)
+{
+	ActionLatency latency(sent);
+	RemoteHistoryBatch batch;
+	int first, last;
+
+	history.range(from, to, &first, &last);
+
+	batch.total = last - first;
+	batch.units = (int)history.units();
+	batch.start = history.startTime().toMSecsSinceEpoch();
+	batch.rows.resize(qMin(batch.total, HISTORY_BATCH_ROWS));
+
+	for (int i = 0; i < batch.rows.count(); i++)
+	{
+		RemoteHistoryRow &row = batch.rows[i];
+
+		row.time = history.time(first + i);
+		row.magnitude = history.magnitude(first + i);
+
+		for (int j = 0; j < 3; j++)
+		{
+			row.field[j] = history.field((Axis)j, first + i);
+			row.current[j] = history.current((Axis)j, first + i);
+		}
+	}
+
+	{
+		QMutexLocker lock(&snapshotMutex);
+
+		// the session timed out while the request was queued
+		if (discardedDumps.remove(token))
+			return;
+
+		historyBatches.insert(token, batch);
+	}
+
+	publishSnapshot();	// wakes the waiting session
+}
+
+//---------------------------------------------------------------------------
+// Takes a history batch requested with the token, returns false if not ready
+bool MultiAxisOperation::take_history_batch(quint64 token, RemoteHistoryBatch *batch)
 {
+	QMutexLocker lock(&snapshotMutex);
+
+	if (!historyBatches.contains(token))
+		return false;
+
+	*batch = historyBatches.take(token);
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Drops a history batch the session stopped waiting for
+void MultiAxisOperation::discard_history_batch(quint64 token)
+{
+	QMutexLocker lock(&snapshotMutex);
+
+	if (!historyBatches.remove(token))
+		discardedDumps.insert(token);
+}
+
+//---------------------------------------------------------------------------
+// Hands a row check to the waiting session, returns false without doing so
+// if the session timed out, in which case the target must not be set
+bool MultiAxisOperation::returnRowCheck(quint64 token, const RemoteRowCheck &check)
+{
+	{
+		QMutexLocker lock(&snapshotMutex);
+
+		if (discardedDumps.remove(token))
+			return false;
+
+		rowChecks.insert(token, check);
+	}
+
+	publishSnapshot();	// wakes the waiting session
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Takes a row check requested with the token, returns false if not ready
+bool MultiAxisOperation::take_row_check(quint64 token, RemoteRowCheck *check)
+{
+	QMutexLocker lock(&snapshotMutex);
+
+	if (!rowChecks.contains(token))
+		return false;
+
+	*check = rowChecks.take(token);
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Drops a row check the session stopped waiting for
+void MultiAxisOperation::discard_row_check(quint64 token)
+{
+	QMutexLocker lock(&snapshotMutex);
+
+	if (!rowChecks.remove(token))
+		discardedDumps.insert(token);
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::set_persistence(bool persistent, qint64 sent)
+{
+	ActionLatency latency(sent);
+
 	if (switchInstalled = magnetParams->switchInstalled())
 	{
 		if (persistent)
@@ -47,7 +47,7 @@ void MultiAxisOperation::restorePolarTab(QSettings *settings)
 	connect(ui.polarAppLocationButton, SIGNAL(clicked()), this, SLOT(browseForPolarAppPath()));
 	connect(ui.polarPythonLocationButton, SIGNAL(clicked()), this, SLOT(browseForPolarPythonPath()));
 	connect(ui.executePolarNowButton, SIGNAL(clicked()), this, SLOT(executePolarNowClick()));
-	connect(ui.polarTableWidget, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(polarTableItemChanged(QTableWidgetItem*)));
+	connect(polarValidator, SIGNAL(validated()), this, SLOT(polarTableDataChanged()));
 
 	setPolarTableHeader();
 }
@@ -71,35 +71,14 @@ void MultiAxisOperation::setNormalUnitVector(QVector3D *v1, QVector3D *v2)
 
 	referenceQuaternion.setVector(referenceVector);
 	referenceQuaternion.setScalar(0.0);
+
+	updateTableValidation();
 }
 
 //---------------------------------------------------------------------------
 void MultiAxisOperation::polarToCartesian(double magnitude, double angle, QVector3D *conversion)
 {
-	// implementation of rotation in the alignment plane using quaternions
-	// see: https://en.wikipedia.org/wiki/Quaternions_and_spatial_rotation
-
-	double angleRad = angle / RAD_TO_DEG;
-
-	// specify the rotation quaternion based on the crossResult
-	QVector3D rotationVector;
-	rotationVector.setX(sin(angleRad / 2.0) * crossResult.x());
-	rotationVector.setY(sin(angleRad / 2.0) * crossResult.y());
-	rotationVector.setZ(sin(angleRad / 2.0) * crossResult.z());
-
-	rotationQuaternion.setVector(rotationVector);
-	rotationQuaternion.setScalar(cos(angleRad / 2.0));
-
-	// calculate polar rotation in sample alignment plane (Hamilton product)
-	// p' = q p q^(-1)
-	QQuaternion result = (rotationQuaternion * referenceQuaternion) * rotationQuaternion.conjugated();
-
-	// load conversion vector
-	conversion->setX(result.x());
-	conversion->setY(result.y());
-	conversion->setZ(result.z());
-
-    *conversion *= magnitude;	// multiply by magnitude
+	rotateInPlane(magnitude, angle, crossResult, referenceQuaternion, conversion);
 }
 
 //---------------------------------------------------------------------------
@@ -163,21 +142,41 @@ void MultiAxisOperation::actionLoad_Polar_Table(void)
 	lastPolarLoadPath = settings.value("LastPolarFilePath").toString();
 	bool convertFieldUnits = false;
 
-	if (autostepPolarTimer->isActive())
-		return;	// no load during autostepping
+	if (autostepPolarTimer->isActive() || polarLoader->isRunning())
+		return;	// no load during autostepping or another load
 
-	polarFileName = QFileDialog::getOpenFileName(this, "Choose Polar File", lastPolarLoadPath, "Polar Definition Files (*.txt *.log *.csv)");
+	polarFileName = QFileDialog::getOpenFileName(this, "Choose Polar File", lastPolarLoadPath, "Polar Definition Files (*.txt *.log *.csv *." + QString(POLAR_TABLE_SUFFIX) + ")");
 
 	if (!polarFileName.isEmpty())
 	{
+		TableFileInfo info;
+		QString errorString;
+		bool binaryTable = BinaryTable::readInfo(polarFileName, &info, &errorString);
+
+		if (binaryTable && errorString.isEmpty() && info.tableType != TABLE_POLAR)
+			errorString = QDir::toNativeSeparators(polarFileName) + " is not a polar table";
+
+		if (!errorString.isEmpty())
+		{
+			showErrorString(errorString);
+			return;
+		}
+
 		QApplication::setOverrideCursor(Qt::WaitCursor);
 
 		lastPolarLoadPath = polarFileName;
 
 		FILE *inFile;
-		inFile = fopen(polarFileName.toLocal8Bit(), "r");
 
-        if (inFile != nullptr)
+		if (binaryTable)
+		{
+			// binary tables carry the units in the header
+			tableIsLoading = true;
+
+			if ((info.fieldUnits == KG && fieldUnits == TESLA) || (info.fieldUnits == TESLA && fieldUnits == KG))
+				convertFieldUnits = true;
+		}
+		else if ((inFile = fopen(polarFileName.toLocal8Bit(), "r")) != nullptr)
 		{
 			QTextStream in(inFile);
 
@@ -213,67 +212,56 @@ void MultiAxisOperation::actionLoad_Polar_Table(void)
 		// if ramping, set system to PAUSE
 		actionPause();
 
-		// now read in data
-		if (magnetParams->switchInstalled())
-		{
-			ui.polarTableWidget->loadFromFile(polarFileName, 1);
-
-			// set persistence if switched
-			if (optionsDialog->enterPersistence())
-				setPolarTablePersistence(true);
-			else
-				setPolarTablePersistence(false);
-		}
-		else
-			ui.polarTableWidget->loadFromFile(polarFileName, 1);
-
 		// save path
 		settings.setValue("LastPolarFilePath", lastPolarLoadPath);
 
-		presentPolar = -1;	// no selection
-
-		// set headings as appropriate
-		setPolarTableHeader();
-
-		if (convertFieldUnits)
-		{
-			convertPolarFieldValues(fieldUnits);
-		}
-
-		QApplication::restoreOverrideCursor();
-		polarSelectionChanged();
-		tableIsLoading = false;
+		// now read in data, finished in polarTableLoaded()
+		convertPolarUnits = convertFieldUnits;
+		polarLoader->start(polarFileName, 1, polarTable->getMinimumNumCols());
+		publishSnapshot();	// remote table commands are refused until loaded
 	}
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::convertPolarFieldValues(FieldUnits newUnits)
+void MultiAxisOperation::polarTableLoaded(void)
 {
-	// loop through polar table and convert magnitude only
-	int numRows = ui.polarTableWidget->rowCount();
+	TableContents contents;
 
-	for (int i = 0; i < numRows; i++)
-	{
-		QTableWidgetItem *cell = ui.polarTableWidget->item(i, 0);
-		QString cellStr = cell->text();
+	polarLoader->takeContents(&contents);
+	polarTable->setContents(contents);
 
-		if (!cellStr.isEmpty())
-		{
-			// try to convert to number
-			bool ok;
-			double value = cellStr.toDouble(&ok);
+	// set persistence if switched
+	if (magnetParams->switchInstalled())
+		setPolarTablePersistence(optionsDialog->enterPersistence());
 
-			if (ok)
-			{
-				if (newUnits == TESLA)	// convert from KG
-					value /= 10.0;
-				else if (newUnits == KG)
-					value *= 10.0;
+	presentPolar = -1;	// no selection
 
-				cell->setText(QString::number(value, 'g', 10));
-			}
-		}
+	// set headings as appropriate
+	setPolarTableHeader();
+
+	if (convertPolarUnits)
+	{
+		convertPolarFieldValues(fieldUnits);
 	}
+
+	QApplication::restoreOverrideCursor();
+	setStatusMsg("");
+	polarSelectionChanged();
+	tableIsLoading = false;
+	publishSnapshot();
+
+	if (!polarLoader->errorString().isEmpty())
+		showErrorString(polarLoader->errorString());
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::convertPolarFieldValues(FieldUnits newUnits)
+{
+	// convert magnitude only in polar table
+	if (newUnits == TESLA)	// convert from KG
+		polarTable->scaleColumn(0, 1.0, 10.0);
+	else
+		polarTable->scaleColumn(0, 10.0);
 }
 
 //---------------------------------------------------------------------------
@@ -281,41 +269,54 @@ void MultiAxisOperation::setPolarTableHeader(void)
 {
 	if (fieldUnits == KG)
 	{
-		ui.polarTableWidget->horizontalHeaderItem(0)->setText("Magnitude (kG)");
+		polarTable->setHeader(0, "Magnitude (kG)");
 	}
 	else
 	{
-		ui.polarTableWidget->horizontalHeaderItem(0)->setText("Magnitude (T)");
+		polarTable->setHeader(0, "Magnitude (T)");
 	}
 
 	// set hold time format
 	if (magnetParams->switchInstalled())
-		ui.polarTableWidget->horizontalHeaderItem(2)->setText("Enter Persistence?/\nHold Time (sec)");
+		polarTable->setHeader(2, "Enter Persistence?/\nHold Time (sec)");
 	else
-		ui.polarTableWidget->horizontalHeaderItem(2)->setText("Hold Time (sec)");
+		polarTable->setHeader(2, "Hold Time (sec)");
+
+	polarTable->setCheckable(magnetParams->switchInstalled());
 }
 
 //---------------------------------------------------------------------------
 void MultiAxisOperation::actionSave_Polar_Table(void)
 {
+	if (polarWriter->isRunning())
+		return;
+
 	QSettings settings;
 	lastPolarSavePath = settings.value("LastPolarSavePath").toString();
 
-	savePolarFileName = QFileDialog::getSaveFileName(this, "Save Polar File", lastPolarSavePath, "Run Test Files (*.txt *.log *.csv)");
+	savePolarFileName = QFileDialog::getSaveFileName(this, "Save Polar File", lastPolarSavePath, "Run Test Files (*.txt *.log *.csv);;Binary Polar Tables (*." + QString(POLAR_TABLE_SUFFIX) + ")");
 
 	if (!savePolarFileName.isEmpty())
 	{
-		QApplication::setOverrideCursor(Qt::WaitCursor);
-
 		lastPolarSavePath = savePolarFileName;
 
-		// save table contents
-		ui.polarTableWidget->saveToFile(savePolarFileName, false);
+		// save table contents in the background
+		if (QFileInfo(savePolarFileName).suffix().compare(POLAR_TABLE_SUFFIX, Qt::CaseInsensitive) == 0)
+		{
+			TableFileInfo info;
+
+			info.tableType = TABLE_POLAR;
+			info.fieldUnits = fieldUnits;
+
+			polarWriter->start(savePolarFileName, polarTable, info);
+		}
+		else
+		{
+			polarWriter->start(savePolarFileName, polarTable);
+		}
 
 		// save path
 		settings.setValue("LastPolarSavePath", lastPolarSavePath);
-
-		QApplication::restoreOverrideCursor();
 	}
 }
 
@@ -329,7 +330,8 @@ void MultiAxisOperation::recalculateRemainingPolarTime(void)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::polarTableItemChanged(QTableWidgetItem *item)
+// Called once edited rows are revalidated, see TableValidator
+void MultiAxisOperation::polarTableDataChanged(void)
 {
 	// recalculate time after change and check for errors
 	if (!tableIsLoading)
@@ -351,9 +353,9 @@ void MultiAxisOperation::polarSelectionChanged(void)
 	else
 	{
 		// any selected vectors?
-		QList<QTableWidgetItem *> list = ui.polarTableWidget->selectedItems();
+		int selectedRow = ui.polarTableView->selectedRow();
 
-		if (list.count())
+		if (selectedRow >= 0)
 		{
 			ui.polarAddRowAboveToolButton->setEnabled(true);
 			ui.polarAddRowBelowToolButton->setEnabled(true);
@@ -361,7 +363,7 @@ void MultiAxisOperation::polarSelectionChanged(void)
 		}
 		else
 		{
-			if (ui.polarTableWidget->rowCount())
+			if (polarTable->rowCount())
 			{
 				ui.polarAddRowAboveToolButton->setEnabled(false);
 				ui.polarAddRowBelowToolButton->setEnabled(false);
@@ -375,7 +377,7 @@ void MultiAxisOperation::polarSelectionChanged(void)
 			ui.polarRemoveRowToolButton->setEnabled(false);
 		}
 
-		if (ui.polarTableWidget->rowCount())
+		if (polarTable->rowCount())
 		{
 			ui.polarTableClearToolButton->setEnabled(true);
 
@@ -397,26 +399,24 @@ void MultiAxisOperation::polarTableAddRowAbove(void)
 	tableIsLoading = true;
 
 	// find selected vector
-	QList<QTableWidgetItem *> list = ui.polarTableWidget->selectedItems();
+	int currentRow = ui.polarTableView->selectedRow();
 
-	if (list.count())
+	if (currentRow >= 0)
 	{
-		int currentRow = list[0]->row();
-		ui.polarTableWidget->insertRow(currentRow);
+		polarTable->insertRow(currentRow);
 		newRow = currentRow;
 	}
 	else
 	{
-		if (ui.polarTableWidget->rowCount() == 0)
+		if (polarTable->rowCount() == 0)
 		{
-			ui.polarTableWidget->insertRow(0);
+			polarTable->insertRow(0);
 			newRow = 0;
 		}
 	}
 
 	if (newRow > -1)
 	{
-		initNewPolarRow(newRow);
 		updatePresentPolar(newRow, false);
 
 		tableIsLoading = false;
@@ -433,26 +433,24 @@ void MultiAxisOperation::polarTableAddRowBelow(void)
 	tableIsLoading = true;
 
 	// find selected vector
-	QList<QTableWidgetItem *> list = ui.polarTableWidget->selectedItems();
+	int currentRow = ui.polarTableView->selectedRow();
 
-	if (list.count())
+	if (currentRow >= 0)
 	{
-		int currentRow = list[0]->row();
-		ui.polarTableWidget->insertRow(currentRow + 1);
+		polarTable->insertRow(currentRow + 1);
 		newRow = currentRow + 1;
 	}
 	else
 	{
-		if (ui.polarTableWidget->rowCount() == 0)
+		if (polarTable->rowCount() == 0)
 		{
-			ui.polarTableWidget->insertRow(0);
+			polarTable->insertRow(0);
 			newRow = 0;
 		}
 	}
 
 	if (newRow > -1)
 	{
-		initNewPolarRow(newRow);
 		updatePresentPolar(newRow, false);
 
 		tableIsLoading = false;
@@ -462,28 +460,6 @@ void MultiAxisOperation::polarTableAddRowBelow(void)
 	tableIsLoading = false;
 }
 
-//---------------------------------------------------------------------------
-void MultiAxisOperation::initNewPolarRow(int newRow)
-{
-	int numColumns = ui.polarTableWidget->columnCount();
-
-	// initialize cells
-	for (int i = 0; i < numColumns; ++i)
-	{
-		QTableWidgetItem *cell = ui.polarTableWidget->item(newRow, i);
-
-        if (cell == nullptr)
-			ui.polarTableWidget->setItem(newRow, i, cell = new QTableWidgetItem(""));
-		else
-			cell->setText("");
-
-		if (i == 2 && magnetParams->switchInstalled())
-			cell->setCheckState(Qt::Unchecked);
-
-		cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-	}
-}
-
 //---------------------------------------------------------------------------
 void MultiAxisOperation::updatePresentPolar(int row, bool removed)
 {
@@ -524,12 +500,11 @@ void MultiAxisOperation::updatePresentPolar(int row, bool removed)
 void MultiAxisOperation::polarTableRemoveRow(void)
 {
 	// find selected vector
-	QList<QTableWidgetItem *> list = ui.polarTableWidget->selectedItems();
+	int currentRow = ui.polarTableView->selectedRow();
 
-	if (list.count())
+	if (currentRow >= 0)
 	{
-		int currentRow = list[0]->row();
-		ui.polarTableWidget->removeRow(currentRow);
+		polarTable->removeRow(currentRow);
 		updatePresentPolar(currentRow, true);
 		polarSelectionChanged();
 	}
@@ -538,13 +513,7 @@ void MultiAxisOperation::polarTableRemoveRow(void)
 //---------------------------------------------------------------------------
 void MultiAxisOperation::polarTableClear(void)
 {
-	int numRows = ui.polarTableWidget->rowCount();
-
-	if (numRows)
-	{
-		for (int i = numRows; i > 0; i--)
-			ui.polarTableWidget->removeRow(i - 1);
-	}
+	polarTable->clear();
 
 	presentPolar = lastPolar = -1;
 	lastTargetMsg.clear();
@@ -556,46 +525,14 @@ void MultiAxisOperation::polarTableClear(void)
 // Set persistence for all entries in table.
 void MultiAxisOperation::setPolarTablePersistence(bool state)
 {
-	int numRows = ui.polarTableWidget->rowCount();
-
-	if (numRows)
-	{
-		for (int i = numRows; i > 0; i--)
-		{
-			QTableWidgetItem *cell = ui.polarTableWidget->item(i - 1, 2);
-
-			if (cell)
-			{
-				if (state)
-					cell->setCheckState(Qt::Checked);
-				else
-					cell->setCheckState(Qt::Unchecked);
-			}
-		}
-	}
+	polarTable->setAllChecked(state);
 }
 
 //---------------------------------------------------------------------------
 // Toggles persistence for all entries in table.
 void MultiAxisOperation::polarTableTogglePersistence(void)
 {
-	int numRows = ui.polarTableWidget->rowCount();
-
-	if (numRows)
-	{
-		for (int i = numRows; i > 0; i--)
-		{
-			QTableWidgetItem *cell = ui.polarTableWidget->item(i - 1, 2);
-
-			if (cell)
-			{
-				if (cell->checkState() == Qt::Checked)
-					cell->setCheckState(Qt::Unchecked);
-				else
-					cell->setCheckState(Qt::Checked);
-			}
-		}
-	}
+	polarTable->toggleAllChecked();
 }
 
 //---------------------------------------------------------------------------
@@ -607,11 +544,11 @@ void MultiAxisOperation::goToSelectedPolarVector(void)
 		deactivateAlignmentVectors();
 
 		// find selected vector
-		QList<QTableWidgetItem *> list = ui.polarTableWidget->selectedItems();
+		int selectedRow = ui.polarTableView->selectedRow();
 
-		if (list.count())
+		if (selectedRow >= 0)
 		{
-			presentPolar = list[0]->row();
+			presentPolar = selectedRow;
 			magnetState = RAMPING;
 			systemState = SYSTEM_RAMPING;
 			goToPolarVector(presentPolar, true);
@@ -628,19 +565,19 @@ void MultiAxisOperation::goToNextPolarVector(void)
 		deactivateAlignmentVectors();
 
 		// find selected vector
-		QList<QTableWidgetItem *> list = ui.polarTableWidget->selectedItems();
+		int selectedRow = ui.polarTableView->selectedRow();
 
-		if (list.count())
+		if (selectedRow >= 0)
 		{
-			presentPolar = list[0]->row();
+			presentPolar = selectedRow;
 
 			// is next vector a valid request?
-			if (((presentPolar + 1) >= 1) && ((presentPolar + 1) < ui.polarTableWidget->rowCount()))
+			if (((presentPolar + 1) >= 1) && ((presentPolar + 1) < polarTable->rowCount()))
 			{
 				presentPolar++;	// choose next vector
 
 				// highlight row in table
-				ui.polarTableWidget->selectRow(presentPolar);
+				ui.polarTableView->selectRow(presentPolar);
 
 				magnetState = RAMPING;
 				systemState = SYSTEM_RAMPING;
@@ -658,7 +595,7 @@ void MultiAxisOperation::goToPolarVector(int polarIndex, bool makeTarget)
 	double temp;
 
 	// get vector values and check for numerical conversion
-	temp = ui.polarTableWidget->item(polarIndex, 0)->text().toDouble(&ok);
+	temp = polarTable->value(polarIndex, 0, &ok);
 	if (ok)
 	{
 		coord1 = temp;
@@ -675,7 +612,7 @@ void MultiAxisOperation::goToPolarVector(int polarIndex, bool makeTarget)
 	else
 		error = true;	// error
 
-	temp = ui.polarTableWidget->item(polarIndex, 1)->text().toDouble(&ok);
+	temp = polarTable->value(polarIndex, 1, &ok);
 	if (ok)
 		coord2 = temp;
 	else
@@ -734,9 +671,9 @@ void MultiAxisOperation::polarRangeChanged(void)
 		autostepStartIndexPolar = ui.startIndexEditPolar->text().toInt();
 		autostepEndIndexPolar = ui.endIndexEditPolar->text().toInt();
 
-		if (autostepStartIndexPolar < 1 || autostepStartIndexPolar > ui.polarTableWidget->rowCount())
+		if (autostepStartIndexPolar < 1 || autostepStartIndexPolar > polarTable->rowCount())
 			return;
-		else if (autostepEndIndexPolar <= autostepStartIndexPolar || autostepEndIndexPolar > ui.polarTableWidget->rowCount())
+		else if (autostepEndIndexPolar <= autostepStartIndexPolar || autostepEndIndexPolar > polarTable->rowCount())
 			return;
 		else
 			calculatePolarRemainingTime(autostepStartIndexPolar, autostepEndIndexPolar);
@@ -759,54 +696,55 @@ void MultiAxisOperation::calculatePolarRemainingTime(int startIndex, int endInde
 	if (startIndex < autostepStartIndexPolar || endIndex > autostepEndIndexPolar)	// out of range
 		return;
 
+	// rows are converted, checked and timed by the validator
+	polarValidator->setContext(validationContext(TableValidator::POLAR_ROWS));
+	polarValidator->waitForCurrent();
+
+	int errorIndex = polarValidator->firstError(startIndex - 1, endIndex);
+
+	if (errorIndex >= 0)
+		endIndex = errorIndex;	// stop at any polar vector error
+
 	// calculate total remaining time
 	for (int i = startIndex - 1; i < endIndex; i++)
 	{
-		double coord1, coord2;
-		double rampX, rampY, rampZ;	// unused in this context
-
-		goToPolarVector(i, false);	// check vector for errors
-
-		if (!vectorError)
+		if (i == startIndex - 1)
 		{
-			// get vector values
-			coord1 = ui.polarTableWidget->item(i, 0)->text().toDouble();
-			coord2 = ui.polarTableWidget->item(i, 1)->text().toDouble();
-
-			// get polar vector in magnet axes coordinates
-			QVector3D vector;
-
-			polarToCartesian(coord1, coord2, &vector);
-
-			// calculate ramping time
-			polarRemainingTime += calculateRampingTime(vector.x(), vector.y(), vector.z(), lastX, lastY, lastZ, rampX, rampY, rampZ);
+			double x, y, z;
+			double rampX, rampY, rampZ;	// unused in this context
 
-			// save as start for next step
-			lastX = vector.x();
-			lastY = vector.y();
-			lastZ = vector.z();
+			// first step ramps from the present field
+			polarValidator->vector(i, &x, &y, &z);
+			polarRemainingTime += calculateRampingTime(x, y, z, lastX, lastY, lastZ, rampX, rampY, rampZ);
+		}
+		else
+		{
+			polarRemainingTime += polarValidator->rampTime(i);
+		}
 
-			// add any hold time
-			bool ok;
-			double temp = 0;
+		// add any hold time
+		bool ok;
+		double temp = 0;
 
-			temp = ui.polarTableWidget->item(i, 2)->text().toDouble(&ok);
-			if (ok)
-                polarRemainingTime += static_cast<int>(temp);
+		temp = polarTable->value(i, 2, &ok);
+		if (ok)
+			polarRemainingTime += static_cast<int>(temp);
 
-			if (magnetParams->switchInstalled())
+		if (magnetParams->switchInstalled())
+		{
+			// transition switch at this step?
+			if (polarTable->isChecked(i))
 			{
-				// transition switch at this step?
-				if (ui.polarTableWidget->item(i, 2)->checkState() == Qt::Checked)
-				{
-					// add time required to cool and reheat switch, plus settling time
-					polarRemainingTime += longestCoolingTime + longestHeatingTime + optionsDialog->settlingTime();
-				}
+				// add time required to cool and reheat switch, plus settling time
+				polarRemainingTime += longestCoolingTime + longestHeatingTime + optionsDialog->settlingTime();
 			}
 		}
-		else
-			break;	// break on any polar vector error
 	}
+
+	if (errorIndex >= 0)
+		goToPolarVector(errorIndex, false);	// annunciate the error
+	else if (startIndex <= endIndex)
+		vectorError = NO_VECTOR_ERROR;
 }
 
 //---------------------------------------------------------------------------
@@ -827,6 +765,9 @@ void MultiAxisOperation::displayPolarRemainingTime(void)
 //---------------------------------------------------------------------------
 void MultiAxisOperation::startPolarAutostep(void)
 {
+	if (polarLoader->isRunning())
+		return;	// the table is being replaced
+
 	if (connected)
 	{
 		if (systemState < SYSTEM_QUENCH)
@@ -840,11 +781,11 @@ void MultiAxisOperation::startPolarAutostep(void)
 
 			if (vectorError == NO_VECTOR_ERROR)
 			{
-				if (autostepStartIndexPolar < 1 || autostepStartIndexPolar > ui.polarTableWidget->rowCount())
+				if (autostepStartIndexPolar < 1 || autostepStartIndexPolar > polarTable->rowCount())
 				{
 					showErrorString("Starting Polar Index is out of range!");
 				}
-				else if (autostepEndIndexPolar <= autostepStartIndexPolar || autostepEndIndexPolar > ui.polarTableWidget->rowCount())
+				else if (autostepEndIndexPolar <= autostepStartIndexPolar || autostepEndIndexPolar > polarTable->rowCount())
 				{
 					showErrorString("Ending Polar Index is out of range!");
 				}
@@ -893,10 +834,11 @@ void MultiAxisOperation::startPolarAutostep(void)
 						ui.actionPersistentMode->setEnabled(false);
 
 					// begin with first vector
+					remoteStepRow = 0;
 					presentPolar = autostepStartIndexPolar - 1;
 
 					// highlight row in table
-					ui.polarTableWidget->selectRow(presentPolar);
+					ui.polarTableView->selectRow(presentPolar);
 					magnetState = RAMPING;
 					systemState = SYSTEM_RAMPING;
 					polarSelectionChanged(); // lockout row changes
@@ -994,7 +936,7 @@ void MultiAxisOperation::autostepPolarTimerTick(void)
 				// if a switch is installed, check to see if we want to enter persistent mode
 				if (magnetParams->switchInstalled())
 				{
-					if (ui.polarTableWidget->item(presentPolar, 2)->checkState() == Qt::Checked)
+					if (polarTable->isChecked(presentPolar))
 					{
 						// enter settling time
 						polarAutostepState = POLAR_TABLE_SETTLING_AT_VECTOR;
@@ -1067,13 +1009,13 @@ void MultiAxisOperation::autostepPolarTimerTick(void)
 				elapsedHoldTimerTicksPolar++;
 
 				// check time
-				if (ui.polarTableWidget->item(presentPolar, 2) != nullptr)
+				if (!polarTable->isEmpty(presentPolar, 2))
 				{
 					bool ok;
 					double temp;
 
 					// get time
-					temp = ui.polarTableWidget->item(presentPolar, 2)->text().toDouble(&ok);
+					temp = polarTable->value(presentPolar, 2, &ok);
 
 					if (ok)	// time is a number
 					{
@@ -1098,7 +1040,7 @@ void MultiAxisOperation::autostepPolarTimerTick(void)
 							// first check to see if we need to exit persistence
 							if (magnetParams->switchInstalled())
 							{
-								if (ui.polarTableWidget->item(presentPolar, 2)->checkState() == Qt::Checked || ui.actionPersistentMode->isChecked())
+								if (polarTable->isChecked(presentPolar) || ui.actionPersistentMode->isChecked())
 								{
 									if (ui.actionPersistentMode->isChecked())	// heater is OFF, persistent
 									{
@@ -1179,7 +1121,7 @@ void MultiAxisOperation::autostepPolarTimerTick(void)
 		//////////////////////////////////////
 		else if (polarAutostepState == POLAR_TABLE_HEATING_SWITCH)
 		{
-		if (matchMagnetCurrentTimer->isActive() == false && switchHeatingTimer->isActive() == false)
+		if (currentMatcher->isActive() == false && switchHeatingTimer->isActive() == false)
 				polarAutostepState = POLAR_TABLE_NEXT_VECTOR;
 		}
 
@@ -1188,11 +1130,13 @@ void MultiAxisOperation::autostepPolarTimerTick(void)
 		//////////////////////////////////////
 		else if (polarAutostepState == POLAR_TABLE_NEXT_VECTOR)
 		{
+			autostepRowCompleted("POLAR", presentPolar + 1, presentPolar + 1 >= autostepEndIndexPolar);
+
 			if (presentPolar + 1 < autostepEndIndexPolar)
 			{
 				// highlight row in table
 				presentPolar++;
-				ui.polarTableWidget->selectRow(presentPolar);
+				ui.polarTableView->selectRow(presentPolar);
 				magnetState = RAMPING;
 				systemState = SYSTEM_RAMPING;
 
@@ -1453,6 +1397,13 @@ void MultiAxisOperation::executePolarApp(void)
 //---------------------------------------------------------------------------
 void MultiAxisOperation::finishedPolarApp(int exitCode, QProcess::ExitStatus exitStatus)
 {
+	if (remoteAppRunning)
+	{
+		remoteAppRunning = false;
+		remoteAppExitCode = (exitStatus == QProcess::NormalExit) ? exitCode : -1;
+		publishSnapshot();
+	}
+
 	if (!connected)
 		return;
 
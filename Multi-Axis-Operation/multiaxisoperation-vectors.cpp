@@ -4,12 +4,6 @@
 
 #if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
 #include <unistd.h>
-// on Linux and macOS we include the Qxlsx source in the ./header and ./source folders
-#include "header/xlsxdocument.h"
-#else
-// right now keep using the library form of QtXlsxWriter on Windows due to issues with
-// linking Qxlsx to private API, and using pre-compiled headers in VS2017
-#include <xlsxdocument.h>
 #endif
 
 //---------------------------------------------------------------------------
@@ -52,7 +46,7 @@ void MultiAxisOperation::restoreVectorTab(QSettings *settings)
 	connect(ui.appLocationButton, SIGNAL(clicked()), this, SLOT(browseForAppPath()));
 	connect(ui.pythonLocationButton, SIGNAL(clicked()), this, SLOT(browseForPythonPath()));
 	connect(ui.executeNowButton, SIGNAL(clicked()), this, SLOT(executeNowClick()));
-	connect(ui.vectorsTableWidget, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(vectorTableItemChanged(QTableWidgetItem*)));
+	connect(vectorValidator, SIGNAL(validated()), this, SLOT(vectorTableDataChanged()));
 
 	setTableHeader();
 }
@@ -65,21 +59,43 @@ void MultiAxisOperation::actionLoad_Vector_Table(void)
 	lastVectorsLoadPath = settings.value("LastVectorFilePath").toString();
 	bool convertFieldUnits = false;
 
-	if (autostepTimer->isActive())
-		return;	// no load during auto-stepping
+	if (autostepTimer->isActive() || vectorLoader->isRunning())
+		return;	// no load during auto-stepping or another load
 
-	vectorsFileName = QFileDialog::getOpenFileName(this, "Choose Vector File", lastVectorsLoadPath, "Vector Definition Files (*.txt *.log *.csv)");
+	vectorsFileName = QFileDialog::getOpenFileName(this, "Choose Vector File", lastVectorsLoadPath, "Vector Definition Files (*.txt *.log *.csv *." + QString(VECTOR_TABLE_SUFFIX) + ")");
 
 	if (!vectorsFileName.isEmpty())
 	{
+		TableFileInfo info;
+		QString errorString;
+		bool binaryTable = BinaryTable::readInfo(vectorsFileName, &info, &errorString);
+
+		if (binaryTable && errorString.isEmpty() && info.tableType != TABLE_VECTOR)
+			errorString = QDir::toNativeSeparators(vectorsFileName) + " is not a vector table";
+
+		if (!errorString.isEmpty())
+		{
+			showErrorString(errorString);
+			return;
+		}
+
 		QApplication::setOverrideCursor(Qt::WaitCursor);
 
 		lastVectorsLoadPath = vectorsFileName;
 
 		FILE *inFile;
-		inFile = fopen(vectorsFileName.toLocal8Bit(), "r");
 
-        if (inFile != nullptr)
+		if (binaryTable)
+		{
+			// binary tables carry the coordinate system and units in the header
+			tableIsLoading = true;
+			loadedCoordinates = info.coordinates == CARTESIAN_COORDINATES ? CARTESIAN_COORDINATES : SPHERICAL_COORDINATES;
+			convention = info.convention == ISO ? ISO : MATHEMATICAL;
+
+			if ((info.fieldUnits == KG && fieldUnits == TESLA) || (info.fieldUnits == TESLA && fieldUnits == KG))
+				convertFieldUnits = true;
+		}
+		else if ((inFile = fopen(vectorsFileName.toLocal8Bit(), "r")) != nullptr)
 		{
 			QTextStream in(inFile);
 
@@ -153,45 +169,67 @@ void MultiAxisOperation::actionLoad_Vector_Table(void)
 		// if ramping, set system to PAUSE
 		actionPause();
 
-		// now read in data
-		if (magnetParams->switchInstalled())
-		{
-			ui.vectorsTableWidget->loadFromFile(vectorsFileName, skipCnt);
-
-			// set persistence if switched
-			if (optionsDialog->enterPersistence())
-				setVectorTablePersistence(true);
-			else
-				setVectorTablePersistence(false);
-		}
-		else
-			ui.vectorsTableWidget->loadFromFile(vectorsFileName, skipCnt);
-
 		// save path
 		settings.setValue("LastVectorFilePath", lastVectorsLoadPath);
 
-		presentVector = -1;	// no selection
-		//ui.vectorsTableWidget->selectRow(presentVector);
+		// now read in data, finished in vectorTableLoaded()
+		convertVectorUnits = convertFieldUnits;
+		vectorLoader->start(vectorsFileName, skipCnt, vectorTable->getMinimumNumCols(), vectorTable->getResultColumn());
+		publishSnapshot();	// remote table commands are refused until loaded
+	}
+}
 
-		// set alignment on "Pass/Fail" column
-		ui.vectorsTableWidget->setColumnAlignment(4, (Qt::AlignCenter | Qt::AlignVCenter));
+//---------------------------------------------------------------------------
+void MultiAxisOperation::vectorTableLoaded(void)
+{
+	TableContents contents;
 
-		// set headings as appropriate
-		setTableHeader();
+	vectorLoader->takeContents(&contents);
+	vectorTable->setContents(contents);
 
-		if (convertFieldUnits)
-		{
-			convertFieldValues(fieldUnits, false);
-		}
+	// set persistence if switched
+	if (magnetParams->switchInstalled())
+		setVectorTablePersistence(optionsDialog->enterPersistence());
 
-		// set the spherical coordinate convention since it may have changed
-		if (loadedCoordinates == SPHERICAL_COORDINATES)
-			setSphericalConvention(convention, true);
+	presentVector = -1;	// no selection
 
-		QApplication::restoreOverrideCursor();
-		vectorSelectionChanged();
-		tableIsLoading = false;
+	// set headings as appropriate
+	setTableHeader();
+
+	if (convertVectorUnits)
+	{
+		convertFieldValues(fieldUnits, false);
 	}
+
+	// set the spherical coordinate convention since it may have changed
+	if (loadedCoordinates == SPHERICAL_COORDINATES)
+		setSphericalConvention(convention, true);
+
+	QApplication::restoreOverrideCursor();
+	setStatusMsg("");
+	vectorSelectionChanged();
+	tableIsLoading = false;
+	publishSnapshot();
+
+	if (!vectorLoader->errorString().isEmpty())
+		showErrorString(vectorLoader->errorString());
+}
+
+//---------------------------------------------------------------------------
+// Shows the progress of a table load in the status bar
+void MultiAxisOperation::tableLoadProgress(int percent)
+{
+	setStatusMsg("Loading table... " + QString::number(percent) + "%");
+}
+
+//---------------------------------------------------------------------------
+// Reports the outcome of a background vector or polar table save
+void MultiAxisOperation::tableSaved(void)
+{
+	TableWriter *writer = qobject_cast<TableWriter *>(sender());
+
+	if (writer && !writer->errorString().isEmpty())
+		showErrorString(writer->errorString());
 }
 
 //---------------------------------------------------------------------------
@@ -201,82 +239,101 @@ void MultiAxisOperation::setTableHeader(void)
 	{
 		if (fieldUnits == KG)
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(0)->setText("Magnitude (kG)");
+			vectorTable->setHeader(0, "Magnitude (kG)");
 		}
 		else
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(0)->setText("Magnitude (T)");
+			vectorTable->setHeader(0, "Magnitude (T)");
 		}
 
 		if (convention == MATHEMATICAL)
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(1)->setText(thetaStr);
-			ui.vectorsTableWidget->horizontalHeaderItem(2)->setText(phiStr);
+			vectorTable->setHeader(1, thetaStr);
+			vectorTable->setHeader(2, phiStr);
 		}
 		else
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(1)->setText(phiStr);
-			ui.vectorsTableWidget->horizontalHeaderItem(2)->setText(thetaStr);
+			vectorTable->setHeader(1, phiStr);
+			vectorTable->setHeader(2, thetaStr);
 		}
 	}
 	else if (loadedCoordinates == CARTESIAN_COORDINATES)
 	{
 		if (fieldUnits == KG)
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(0)->setText("X (kG)");
-			ui.vectorsTableWidget->horizontalHeaderItem(1)->setText("Y (kG)");
-			ui.vectorsTableWidget->horizontalHeaderItem(2)->setText("Z (kG)");
+			vectorTable->setHeader(0, "X (kG)");
+			vectorTable->setHeader(1, "Y (kG)");
+			vectorTable->setHeader(2, "Z (kG)");
 		}
 		else
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(0)->setText("X (T)");
-			ui.vectorsTableWidget->horizontalHeaderItem(1)->setText("Y (T)");
-			ui.vectorsTableWidget->horizontalHeaderItem(2)->setText("Z (T)");
+			vectorTable->setHeader(0, "X (T)");
+			vectorTable->setHeader(1, "Y (T)");
+			vectorTable->setHeader(2, "Z (T)");
 		}
 	}
 
 	// set quench current header if present
-	if (ui.vectorsTableWidget->columnCount() > 5)
-	{
-		if (ui.vectorsTableWidget->columnCount() >= 8)
-		{
-			ui.vectorsTableWidget->setHorizontalHeaderItem(5, new QTableWidgetItem("X Quench (A)"));
-			ui.vectorsTableWidget->horizontalHeaderItem(5)->font().setBold(true);
-			ui.vectorsTableWidget->setHorizontalHeaderItem(6, new QTableWidgetItem("Y Quench (A)"));
-			ui.vectorsTableWidget->horizontalHeaderItem(6)->font().setBold(true);
-			ui.vectorsTableWidget->setHorizontalHeaderItem(7, new QTableWidgetItem("Z Quench (A)"));
-			ui.vectorsTableWidget->horizontalHeaderItem(7)->font().setBold(true);
-		}
-	}
+	if (vectorTable->columnCount() >= 8)
+		addQuenchColumns();
 
 	// set hold time format
 	if (magnetParams->switchInstalled())
-		ui.vectorsTableWidget->horizontalHeaderItem(3)->setText("Enter Persistence?/\nHold Time (sec)");
+		vectorTable->setHeader(3, "Enter Persistence?/\nHold Time (sec)");
 	else
-		ui.vectorsTableWidget->horizontalHeaderItem(3)->setText("Hold Time (sec)");
+		vectorTable->setHeader(3, "Hold Time (sec)");
+
+	vectorTable->setCheckable(magnetParams->switchInstalled());
+
+	// coordinate system may have changed
+	updateTableValidation();
+}
+
+//---------------------------------------------------------------------------
+// Adds the X/Y/Z quench current columns filled in on a quench.
+void MultiAxisOperation::addQuenchColumns(void)
+{
+	if (vectorTable->columnCount() < 8)
+		vectorTable->setColumnCount(8);
+
+	vectorTable->setHeader(5, "X Quench (A)");
+	vectorTable->setHeader(6, "Y Quench (A)");
+	vectorTable->setHeader(7, "Z Quench (A)");
+
+	for (int i = 5; i < 8; i++)
+		vectorTable->setPrecision(i, 3);
 }
 
 //---------------------------------------------------------------------------
 void MultiAxisOperation::actionSave_Vector_Table(void)
 {
+	if (vectorWriter->isRunning())
+		return;
+
 	QSettings settings;
 	lastVectorsSavePath = settings.value("LastVectorSavePath").toString();
 
-	saveVectorsFileName = QFileDialog::getSaveFileName(this, "Save Vector File", lastVectorsSavePath, "Run Test Files (*.txt *.log *.csv)");
+	saveVectorsFileName = QFileDialog::getSaveFileName(this, "Save Vector File", lastVectorsSavePath, "Run Test Files (*.txt *.log *.csv);;Binary Vector Tables (*." + QString(VECTOR_TABLE_SUFFIX) + ")");
 
 	if (!saveVectorsFileName.isEmpty())
 	{
-		QApplication::setOverrideCursor(Qt::WaitCursor);
-
 		lastVectorsSavePath = saveVectorsFileName;
 
-		FILE *outFile;
-		outFile = fopen(saveVectorsFileName.toLocal8Bit(), "w");
+		// save table contents in the background
+		if (QFileInfo(saveVectorsFileName).suffix().compare(VECTOR_TABLE_SUFFIX, Qt::CaseInsensitive) == 0)
+		{
+			TableFileInfo info;
+
+			info.tableType = TABLE_VECTOR;
+			info.coordinates = loadedCoordinates;
+			info.convention = convention;
+			info.fieldUnits = fieldUnits;
 
-		// save coordinate system and convention designation
-        if (outFile != nullptr)
+			vectorWriter->start(saveVectorsFileName, vectorTable, info);
+		}
+		else
 		{
-			QTextStream out(outFile);
+			// coordinate system and convention designation precede the table
 			QString tempStr;
 
 			if (loadedCoordinates == SPHERICAL_COORDINATES)
@@ -292,19 +349,11 @@ void MultiAxisOperation::actionSave_Vector_Table(void)
 				tempStr = "CARTESIAN";
 			}
 
-			out << tempStr << "\n";
-
-			Qt::flush(out);
-			fclose(outFile);
+			vectorWriter->start(saveVectorsFileName, vectorTable, tempStr);
 		}
 
-		// save table contents
-		ui.vectorsTableWidget->saveToFile(saveVectorsFileName, true);
-
 		// save path
 		settings.setValue("LastVectorSavePath", lastVectorsSavePath);
-
-		QApplication::restoreOverrideCursor();
 	}
 }
 
@@ -318,7 +367,8 @@ void MultiAxisOperation::recalculateRemainingTime(void)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::vectorTableItemChanged(QTableWidgetItem *item)
+// Called once edited rows are revalidated, see TableValidator
+void MultiAxisOperation::vectorTableDataChanged(void)
 {
 	// recalculate time after change and check for errors
 	if (!tableIsLoading)
@@ -340,9 +390,9 @@ void MultiAxisOperation::vectorSelectionChanged(void)
 	else
 	{
 		// any selected vectors?
-		QList<QTableWidgetItem *> list = ui.vectorsTableWidget->selectedItems();
+		int selectedRow = ui.vectorsTableView->selectedRow();
 
-		if (list.count())
+		if (selectedRow >= 0)
 		{
 			ui.vectorAddRowAboveToolButton->setEnabled(true);
 			ui.vectorAddRowBelowToolButton->setEnabled(true);
@@ -350,7 +400,7 @@ void MultiAxisOperation::vectorSelectionChanged(void)
 		}
 		else
 		{
-			if (ui.vectorsTableWidget->rowCount())
+			if (vectorTable->rowCount())
 			{
 				ui.vectorAddRowAboveToolButton->setEnabled(false);
 				ui.vectorAddRowBelowToolButton->setEnabled(false);
@@ -364,7 +414,7 @@ void MultiAxisOperation::vectorSelectionChanged(void)
 			ui.vectorRemoveRowToolButton->setEnabled(false);
 		}
 
-		if (ui.vectorsTableWidget->rowCount())
+		if (vectorTable->rowCount())
 		{
 			ui.vectorTableClearToolButton->setEnabled(true);
 
@@ -386,26 +436,24 @@ void MultiAxisOperation::vectorTableAddRowAbove(void)
 	tableIsLoading = true;
 
 	// find selected vector
-	QList<QTableWidgetItem *> list = ui.vectorsTableWidget->selectedItems();
+	int currentRow = ui.vectorsTableView->selectedRow();
 
-	if (list.count())
+	if (currentRow >= 0)
 	{
-		int currentRow = list[0]->row();
-		ui.vectorsTableWidget->insertRow(currentRow);
+		vectorTable->insertRow(currentRow);
 		newRow = currentRow;
 	}
 	else
 	{
-		if (ui.vectorsTableWidget->rowCount() == 0)
+		if (vectorTable->rowCount() == 0)
 		{
-			ui.vectorsTableWidget->insertRow(0);
+			vectorTable->insertRow(0);
 			newRow = 0;
 		}
 	}
 
 	if (newRow > -1)
 	{
-		initNewRow(newRow);
 		updatePresentVector(newRow, false);
 
 		tableIsLoading = false;
@@ -422,26 +470,24 @@ void MultiAxisOperation::vectorTableAddRowBelow(void)
 	tableIsLoading = true;
 
 	// find selected vector
-	QList<QTableWidgetItem *> list = ui.vectorsTableWidget->selectedItems();
+	int currentRow = ui.vectorsTableView->selectedRow();
 
-	if (list.count())
+	if (currentRow >= 0)
 	{
-		int currentRow = list[0]->row();
-		ui.vectorsTableWidget->insertRow(currentRow + 1);
+		vectorTable->insertRow(currentRow + 1);
 		newRow = currentRow + 1;
 	}
 	else
 	{
-		if (ui.vectorsTableWidget->rowCount() == 0)
+		if (vectorTable->rowCount() == 0)
 		{
-			ui.vectorsTableWidget->insertRow(0);
+			vectorTable->insertRow(0);
 			newRow = 0;
 		}
 	}
 
 	if (newRow > -1)
 	{
-		initNewRow(newRow);
 		updatePresentVector(newRow, false);
 
 		tableIsLoading = false;
@@ -451,31 +497,6 @@ void MultiAxisOperation::vectorTableAddRowBelow(void)
 	tableIsLoading = false;
 }
 
-//---------------------------------------------------------------------------
-void MultiAxisOperation::initNewRow(int newRow)
-{
-	int numColumns = ui.vectorsTableWidget->columnCount();
-
-	// initialize cells
-	for (int i = 0; i < numColumns; ++i)
-	{
-		QTableWidgetItem *cell = ui.vectorsTableWidget->item(newRow, i);
-
-        if (cell == nullptr)
-			ui.vectorsTableWidget->setItem(newRow, i, cell = new QTableWidgetItem(""));
-		else
-			cell->setText("");
-
-		if (i == 3 && magnetParams->switchInstalled())
-			cell->setCheckState(Qt::Unchecked);
-
-		if (i == (numColumns - 1))
-			cell->setTextAlignment(Qt::AlignCenter);
-		else
-			cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-	}
-}
-
 //---------------------------------------------------------------------------
 void MultiAxisOperation::updatePresentVector(int row, bool removed)
 {
@@ -516,12 +537,11 @@ void MultiAxisOperation::updatePresentVector(int row, bool removed)
 void MultiAxisOperation::vectorTableRemoveRow(void)
 {
 	// find selected vector
-	QList<QTableWidgetItem *> list = ui.vectorsTableWidget->selectedItems();
+	int currentRow = ui.vectorsTableView->selectedRow();
 
-	if (list.count())
+	if (currentRow >= 0)
 	{
-		int currentRow = list[0]->row();
-		ui.vectorsTableWidget->removeRow(currentRow);
+		vectorTable->removeRow(currentRow);
 		updatePresentVector(currentRow, true);
 		vectorSelectionChanged();
 	}
@@ -530,13 +550,7 @@ void MultiAxisOperation::vectorTableRemoveRow(void)
 //---------------------------------------------------------------------------
 void MultiAxisOperation::vectorTableClear(void)
 {
-	int numRows = ui.vectorsTableWidget->rowCount();
-
-	if (numRows)
-	{
-		for (int i = numRows; i > 0; i--)
-			ui.vectorsTableWidget->removeRow(i - 1);
-	}
+	vectorTable->clear();
 
 	presentVector = lastVector = -1;
 	lastTargetMsg.clear();
@@ -548,46 +562,14 @@ void MultiAxisOperation::vectorTableClear(void)
 // Set persistence for all entries in table.
 void MultiAxisOperation::setVectorTablePersistence(bool state)
 {
-	int numRows = ui.vectorsTableWidget->rowCount();
-
-	if (numRows)
-	{
-		for (int i = numRows; i > 0; i--)
-		{
-			QTableWidgetItem *cell = ui.vectorsTableWidget->item(i - 1, 3);
-
-			if (cell)
-			{
-				if (state)
-					cell->setCheckState(Qt::Checked);
-				else
-					cell->setCheckState(Qt::Unchecked);
-			}
-		}
-	}
+	vectorTable->setAllChecked(state);
 }
 
 //---------------------------------------------------------------------------
 // Toggles persistence for all entries in table.
 void MultiAxisOperation::vectorTableTogglePersistence(void)
 {
-	int numRows = ui.vectorsTableWidget->rowCount();
-
-	if (numRows)
-	{
-		for (int i = numRows; i > 0; i--)
-		{
-			QTableWidgetItem *cell = ui.vectorsTableWidget->item(i - 1, 3);
-
-			if (cell)
-			{
-				if (cell->checkState() == Qt::Checked)
-					cell->setCheckState(Qt::Unchecked);
-				else
-					cell->setCheckState(Qt::Checked);
-			}
-		}
-	}
+	vectorTable->toggleAllChecked();
 }
 
 //---------------------------------------------------------------------------
@@ -598,199 +580,88 @@ void MultiAxisOperation::actionGenerate_Excel_Report(void)
 
 	reportFileName = QFileDialog::getSaveFileName(this, "Save Excel Report File", lastReportPath, "Excel Report Files (*.xlsx)");
 
-	if (!reportFileName.isEmpty())
-		saveReport(reportFileName);
+	// during an auto-step run the report is materialized from its journal
+	reportWriter->setCompressionLevel(-1);
+	if (!reportFileName.isEmpty() && !saveReport(reportFileName, autostepTimer->isActive() && resultsJournal.isOpen()))
+		showErrorString("A report is still being saved, please try again shortly");
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::saveReport(QString reportFileName)
+// Snapshot of the magnet parameters and vector table for a report or the
+// results journal
+void MultiAxisOperation::getReportData(ReportData *data)
 {
-	if (!reportFileName.isEmpty())
-	{
-		QSettings settings;
-		QString tempStr;
-		QXlsx::Document xlsx;
-
-		// save filename path
-		settings.setValue("LastReportPath", reportFileName);
-
-		// set document properties
-		xlsx.setDocumentProperty("title", "Multi-Axis Magnet " + magnetParams->getMagnetID() + " Test Report");
-		xlsx.setDocumentProperty("subject", "Magnet ID " + magnetParams->getMagnetID());
-		xlsx.setDocumentProperty("company", "American Magnetics, Inc.");
-		xlsx.setDocumentProperty("description", "Test Results");
-
-		QXlsx::Format alignRightFormat;
-		QXlsx::Format alignCenterFormat;
-		QXlsx::Format boldAlignRightFormat;
-		QXlsx::Format boldAlignCenterFormat;
-		alignRightFormat.setHorizontalAlignment(QXlsx::Format::AlignRight);
-		alignCenterFormat.setHorizontalAlignment(QXlsx::Format::AlignHCenter);
-		boldAlignRightFormat.setFontBold(true);
-		boldAlignRightFormat.setHorizontalAlignment(QXlsx::Format::AlignRight);
-		boldAlignCenterFormat.setFontBold(true);
-		boldAlignCenterFormat.setHorizontalAlignment(QXlsx::Format::AlignHCenter);
-
-		xlsx.deleteSheet("Sheet1");
-		xlsx.addSheet("Parameters and Limits");
-		xlsx.setColumnWidth(1, 30);
-		xlsx.setColumnWidth(2, 4, 15);
-
-		// write magnet ID
-		xlsx.write("A1", "Magnet ID", boldAlignRightFormat);
-		xlsx.write("B1", magnetParams->getMagnetID(), alignRightFormat);
-
-		// write magnitude limit
-		tempStr = "Magnitude Limit (";
-		if (fieldUnits == KG)
-			tempStr += "kG)";
-		else
-			tempStr += "T)";
-		xlsx.write("A2", tempStr, boldAlignRightFormat);
-		xlsx.write("B2", magnetParams->getMagnitudeLimit());
-
-		// write magnet axes settings
-
-		// write header
-		xlsx.write("A4", "Parameter", boldAlignCenterFormat);
-		xlsx.write("B4", "X-Axis", boldAlignCenterFormat);
-		xlsx.write("C4", "Y-Axis", boldAlignCenterFormat);
-		xlsx.write("D4", "Z-Axis", boldAlignCenterFormat);
-
-		// write first column labels
-		xlsx.write("A5", "IP Addr", alignCenterFormat);
-		xlsx.write("A6", "Current Limit (A)", alignCenterFormat);
-		xlsx.write("A7", "Voltage Limit (A)", alignCenterFormat);
-		xlsx.write("A8", "Max Ramp Rate (A/s)", alignCenterFormat);
-		tempStr = "Coil Constant (";
-		if (fieldUnits == KG)
-			tempStr += "kG/A)";
-		else
-			tempStr += "T/A)";
-		xlsx.write("A9", tempStr, alignCenterFormat);
-		xlsx.write("A10", "Inductance (H)", alignCenterFormat);
-		xlsx.write("A11", "Switch Installed", alignCenterFormat);
-		xlsx.write("A12", "Switch Heater Current (mA)", alignCenterFormat);
-		xlsx.write("A13", "Switch Cooling Time (s)", alignCenterFormat);
-		xlsx.write("A14", "Switch Heating Time (s)", alignCenterFormat);
-
+	*data = ReportData();
+	data->magnetID = magnetParams->getMagnetID();
+	data->magnitudeLimit = magnetParams->getMagnitudeLimit();
+	data->fieldUnits = fieldUnits;
+	data->axes[X_AXIS] = *magnetParams->GetXAxisParams();
+	data->axes[Y_AXIS] = *magnetParams->GetYAxisParams();
+	data->axes[Z_AXIS] = *magnetParams->GetZAxisParams();
+	data->switchInstalled = (switchInstalled = magnetParams->switchInstalled());
+	data->timestamp = QDateTime::currentDateTime();
+	vectorTable->getContents(&data->results);
+
+	data->checks.resize(data->results.rows);
+	for (int i = 0; i < data->results.rows; i++)
+		data->checks[i] = vectorTable->isChecked(i);
+}
 
-		// write X parameters
-		if (magnetParams->GetXAxisParams()->activate)
-		{
-			xlsx.write("B5", magnetParams->GetXAxisParams()->ipAddress, alignCenterFormat);
-			xlsx.write("B6", magnetParams->GetXAxisParams()->currentLimit, alignRightFormat);
-			xlsx.write("B7", magnetParams->GetXAxisParams()->voltageLimit, alignRightFormat);
-			xlsx.write("B8", magnetParams->GetXAxisParams()->maxRampRate, alignRightFormat);
-			xlsx.write("B9", magnetParams->GetXAxisParams()->coilConst, alignRightFormat);
-			xlsx.write("B10", magnetParams->GetXAxisParams()->inductance, alignRightFormat);
-			xlsx.write("B11", magnetParams->GetXAxisParams()->switchInstalled, alignRightFormat);
-
-			if (magnetParams->GetXAxisParams()->switchInstalled)
-			{
-				xlsx.write("B12", magnetParams->GetXAxisParams()->switchHeaterCurrent, alignRightFormat);
-				xlsx.write("B13", magnetParams->GetXAxisParams()->switchCoolingTime, alignRightFormat);
-				xlsx.write("B14", magnetParams->GetXAxisParams()->switchHeatingTime, alignRightFormat);
-			}
-		}
-		else
-			xlsx.write("B5", "N/A", alignCenterFormat);
+//---------------------------------------------------------------------------
+// Starts the report on a worker thread, from a snapshot of the vector table
+// or from the results journal of the present run; reportSaved() follows
+// once it is written. Returns false if a report is still being saved.
+bool MultiAxisOperation::saveReport(QString reportFileName, bool fromJournal)
+{
+	if (reportFileName.isEmpty() || reportWriter->isRunning())
+		return false;
 
-		// write Y parameters
-		if (magnetParams->GetYAxisParams()->activate)
-		{
-			xlsx.write("C5", magnetParams->GetYAxisParams()->ipAddress, alignCenterFormat);
-			xlsx.write("C6", magnetParams->GetYAxisParams()->currentLimit, alignRightFormat);
-			xlsx.write("C7", magnetParams->GetYAxisParams()->voltageLimit, alignRightFormat);
-			xlsx.write("C8", magnetParams->GetYAxisParams()->maxRampRate, alignRightFormat);
-			xlsx.write("C9", magnetParams->GetYAxisParams()->coilConst, alignRightFormat);
-			xlsx.write("C10", magnetParams->GetYAxisParams()->inductance, alignRightFormat);
-			xlsx.write("C11", magnetParams->GetYAxisParams()->switchInstalled, alignRightFormat);
-
-			if (magnetParams->GetYAxisParams()->switchInstalled)
-			{
-				xlsx.write("C12", magnetParams->GetYAxisParams()->switchHeaterCurrent, alignRightFormat);
-				xlsx.write("C13", magnetParams->GetYAxisParams()->switchCoolingTime, alignRightFormat);
-				xlsx.write("C14", magnetParams->GetYAxisParams()->switchHeatingTime, alignRightFormat);
-			}
-		}
-		else
-			xlsx.write("C5", "N/A", alignCenterFormat);
+	QSettings settings;
 
-		// write Y parameters
-		if (magnetParams->GetZAxisParams()->activate)
-		{
-			xlsx.write("D5", magnetParams->GetZAxisParams()->ipAddress, alignCenterFormat);
-			xlsx.write("D6", magnetParams->GetZAxisParams()->currentLimit, alignRightFormat);
-			xlsx.write("D7", magnetParams->GetZAxisParams()->voltageLimit, alignRightFormat);
-			xlsx.write("D8", magnetParams->GetZAxisParams()->maxRampRate, alignRightFormat);
-			xlsx.write("D9", magnetParams->GetZAxisParams()->coilConst, alignRightFormat);
-			xlsx.write("D10", magnetParams->GetZAxisParams()->inductance, alignRightFormat);
-			xlsx.write("D11", magnetParams->GetZAxisParams()->switchInstalled, alignRightFormat);
-
-			if (magnetParams->GetZAxisParams()->switchInstalled)
-			{
-				xlsx.write("D12", magnetParams->GetZAxisParams()->switchHeaterCurrent, alignRightFormat);
-				xlsx.write("D13", magnetParams->GetZAxisParams()->switchCoolingTime, alignRightFormat);
-				xlsx.write("D14", magnetParams->GetZAxisParams()->switchHeatingTime, alignRightFormat);
-			}
-		}
-		else
-			xlsx.write("D5", "N/A", alignCenterFormat);
+	// save filename path
+	settings.setValue("LastReportPath", reportFileName);
 
-		// create vector table output sheet
-		xlsx.addSheet("Vector Table Results");
-		xlsx.setColumnWidth(1, 8, 15);
+	if (fromJournal)
+	{
+		reportWriter->start(reportFileName, resultsJournal.fileName());
+	}
+	else
+	{
+		ReportData data;
 
-		// output date/time
-		xlsx.write("A1", "Date", boldAlignRightFormat);
-		xlsx.write("B1", QDate::currentDate().toString());
-		xlsx.write("A2", "Time", boldAlignRightFormat);
-		xlsx.write("B2", QTime::currentTime().toString());
+		getReportData(&data);
+		reportWriter->start(reportFileName, data);
+	}
 
-		// output headers
-		xlsx.write("F3", "Quench");
-		xlsx.mergeCells("F3:H3", boldAlignCenterFormat);
+	return true;
+}
 
-		for (int i = 0; i < ui.vectorsTableWidget->columnCount(); i++)
-		{
-			xlsx.write(4, i + 1, ui.vectorsTableWidget->horizontalHeaderItem(i)->text(), boldAlignCenterFormat);
-		}
+//---------------------------------------------------------------------------
+// Reports the outcome of a background report save
+void MultiAxisOperation::reportSaved(void)
+{
+	if (!reportWriter->errorString().isEmpty())
+	{
+		// an autosave may be retried at the next opportunity
+		if (autosavingReport)
+			haveAutosavedReport = false;
 
-		xlsx.write("F4", "X-Axis", boldAlignCenterFormat);
-		xlsx.write("G4", "Y-Axis", boldAlignCenterFormat);
-		xlsx.write("H4", "Z-Axis", boldAlignCenterFormat);
+		showErrorString(reportWriter->errorString());
+	}
+	else if (autosavingReport)
+	{
+		QFileInfo reportFile(reportWriter->fileName());
 
-		// output vector data
-		for (int i = 0; i < ui.vectorsTableWidget->rowCount(); i++)
-		{
-			for (int j = 0; j < ui.vectorsTableWidget->columnCount(); j++)
-			{
-				QTableWidgetItem *item;
+		setStatusMsg(statusMisc->text() + " : Saved as " + reportFile.fileName());
+	}
 
-				if ((item = ui.vectorsTableWidget->item(i, j)))
-				{
-					if (item->text() == "Pass" || item->text() == "Fail" || item->text().isEmpty())
-					{
-						xlsx.write(i + 1 + 4, j + 1, ui.vectorsTableWidget->item(i, j)->text(), alignCenterFormat);
-					}
-					else
-					{
-						if (((switchInstalled = magnetParams->switchInstalled())) && j == 3)
-						{
-							if (item->checkState() == Qt::Checked)
-								xlsx.write(i + 1 + 4, j + 1, "Yes / " + ui.vectorsTableWidget->item(i, j)->text(), alignRightFormat);
-							else
-								xlsx.write(i + 1 + 4, j + 1, "No / " + ui.vectorsTableWidget->item(i, j)->text(), alignRightFormat);
-						}
-						else
-							xlsx.write(i + 1 + 4, j + 1, ui.vectorsTableWidget->item(i, j)->text().toDouble(), alignRightFormat);
-					}
-				}
-			}
-		}
+	autosavingReport = false;
 
-		xlsx.saveAs(reportFileName);
+	// an autosave that found the writer busy goes next
+	if (autosavePending)
+	{
+		autosavePending = false;
+		doAutosaveReport();
 	}
 }
 
@@ -803,11 +674,11 @@ void MultiAxisOperation::goToSelectedVector(void)
 		deactivateAlignmentVectors();
 
 		// find selected vector
-		QList<QTableWidgetItem *> list = ui.vectorsTableWidget->selectedItems();
+		int selectedRow = ui.vectorsTableView->selectedRow();
 
-		if (list.count())
+		if (selectedRow >= 0)
 		{
-			presentVector = list[0]->row();
+			presentVector = selectedRow;
 			magnetState = RAMPING;
 			systemState = SYSTEM_RAMPING;
 			goToVector(presentVector, true);
@@ -824,19 +695,19 @@ void MultiAxisOperation::goToNextVector(void)
 		deactivateAlignmentVectors();
 
 		// find selected vector
-		QList<QTableWidgetItem *> list = ui.vectorsTableWidget->selectedItems();
+		int selectedRow = ui.vectorsTableView->selectedRow();
 
-		if (list.count())
+		if (selectedRow >= 0)
 		{
-			presentVector = list[0]->row();
+			presentVector = selectedRow;
 
 			// is next vector a valid request?
-			if (((presentVector + 1) >= 1) && ((presentVector + 1) < ui.vectorsTableWidget->rowCount()))
+			if (((presentVector + 1) >= 1) && ((presentVector + 1) < vectorTable->rowCount()))
 			{
 				presentVector++;	// choose next vector
 
 				// highlight row in table
-				ui.vectorsTableWidget->selectRow(presentVector);
+				ui.vectorsTableView->selectRow(presentVector);
 
 				magnetState = RAMPING;
 				systemState = SYSTEM_RAMPING;
@@ -857,19 +728,19 @@ void MultiAxisOperation::goToVector(int vectorIndex, bool makeTarget)
 	double temp;
 
 	// get vector values and check for numerical conversion
-	temp = ui.vectorsTableWidget->item(vectorIndex, 0)->text().toDouble(&ok);
+	temp = vectorTable->value(vectorIndex, 0, &ok);
 	if (ok)
 		coord1 = temp;
 	else
 		error = true;	// error
 
-	temp = ui.vectorsTableWidget->item(vectorIndex, 1)->text().toDouble(&ok);
+	temp = vectorTable->value(vectorIndex, 1, &ok);
 	if (ok)
 		coord2 = temp;
 	else
 		error = true;	// error
 
-	temp = ui.vectorsTableWidget->item(vectorIndex, 2)->text().toDouble(&ok);
+	temp = vectorTable->value(vectorIndex, 2, &ok);
 	if (ok)
 		coord3 = temp;
 	else
@@ -946,9 +817,9 @@ void MultiAxisOperation::autostepRangeChanged(void)
 		autostepStartIndex = ui.startIndexEdit->text().toInt();
 		autostepEndIndex = ui.endIndexEdit->text().toInt();
 
-		if (autostepStartIndex < 1 || autostepStartIndex > ui.vectorsTableWidget->rowCount())
+		if (autostepStartIndex < 1 || autostepStartIndex > vectorTable->rowCount())
 			return;
-		else if (autostepEndIndex <= autostepStartIndex || autostepEndIndex > ui.vectorsTableWidget->rowCount())
+		else if (autostepEndIndex <= autostepStartIndex || autostepEndIndex > vectorTable->rowCount())
 			return;
 		else
 			calculateAutostepRemainingTime(autostepStartIndex, autostepEndIndex);
@@ -971,62 +842,55 @@ void MultiAxisOperation::calculateAutostepRemainingTime(int startIndex, int endI
 	if (startIndex < autostepStartIndex || endIndex > autostepEndIndex)	// out of range
 		return;
 
+	// rows are converted, checked and timed by the validator
+	vectorValidator->setContext(validationContext(TableValidator::VECTOR_ROWS));
+	vectorValidator->waitForCurrent();
+
+	int errorIndex = vectorValidator->firstError(startIndex - 1, endIndex);
+
+	if (errorIndex >= 0)
+		endIndex = errorIndex;	// stop at any vector error
+
 	// calculate total remaining time
 	for (int i = startIndex - 1; i < endIndex; i++)
 	{
-		double coord1, coord2, coord3;
-		double x, y, z;
-		double rampX, rampY, rampZ;	// unused in this context
-
-		goToVector(i, false);	// check vector for errors
-
-		if (!vectorError)
+		if (i == startIndex - 1)
 		{
-			// get vector values
-			coord1 = ui.vectorsTableWidget->item(i, 0)->text().toDouble();
-			coord2 = ui.vectorsTableWidget->item(i, 1)->text().toDouble();
-			coord3 = ui.vectorsTableWidget->item(i, 2)->text().toDouble();
+			double x, y, z;
+			double rampX, rampY, rampZ;	// unused in this context
 
-			if (loadedCoordinates == CARTESIAN_COORDINATES)
-			{
-				x = coord1;
-				y = coord2;
-				z = coord3;
-			}
-			else if (loadedCoordinates == SPHERICAL_COORDINATES)
-			{
-				sphericalToCartesian(coord1, coord2, coord3, &x, &y, &z);
-			}
-
-			// calculate ramping time
+			// first step ramps from the present field
+			vectorValidator->vector(i, &x, &y, &z);
 			autostepRemainingTime += calculateRampingTime(x, y, z, lastX, lastY, lastZ, rampX, rampY, rampZ);
+		}
+		else
+		{
+			autostepRemainingTime += vectorValidator->rampTime(i);
+		}
 
-			// save as start for next step
-			lastX = x;
-			lastY = y;
-			lastZ = z;
-
-			// add any hold time
-			bool ok;
-			double temp = 0;
+		// add any hold time
+		bool ok;
+		double temp = 0;
 
-			temp = ui.vectorsTableWidget->item(i, 3)->text().toDouble(&ok);
-			if (ok)
-                autostepRemainingTime += static_cast<int>(temp);
+		temp = vectorTable->value(i, 3, &ok);
+		if (ok)
+			autostepRemainingTime += static_cast<int>(temp);
 
-			if (magnetParams->switchInstalled())
+		if (magnetParams->switchInstalled())
+		{
+			// transition switch at this step?
+			if (vectorTable->isChecked(i))
 			{
-				// transition switch at this step?
-				if (ui.vectorsTableWidget->item(i, 3)->checkState() == Qt::Checked)
-				{
-					// add time required to cool and reheat switch, plus settling time
-					autostepRemainingTime += longestCoolingTime + longestHeatingTime + optionsDialog->settlingTime();
-				}
+				// add time required to cool and reheat switch, plus settling time
+				autostepRemainingTime += longestCoolingTime + longestHeatingTime + optionsDialog->settlingTime();
 			}
 		}
-		else
-			break;	// break on any vector error
 	}
+
+	if (errorIndex >= 0)
+		goToVector(errorIndex, false);	// annunciate the error
+	else if (startIndex <= endIndex)
+		vectorError = NO_VECTOR_ERROR;
 }
 
 //---------------------------------------------------------------------------
@@ -1046,6 +910,9 @@ void MultiAxisOperation::displayAutostepRemainingTime(void)
 //---------------------------------------------------------------------------
 void MultiAxisOperation::startAutostep(void)
 {
+	if (vectorLoader->isRunning())
+		return;	// the table is being replaced
+
 	if (connected)
 	{
 		// deactivate any alignment vectors
@@ -1059,11 +926,11 @@ void MultiAxisOperation::startAutostep(void)
 
 			if (vectorError == NO_VECTOR_ERROR)
 			{
-				if (autostepStartIndex < 1 || autostepStartIndex > ui.vectorsTableWidget->rowCount())
+				if (autostepStartIndex < 1 || autostepStartIndex > vectorTable->rowCount())
 				{
 					showErrorString("Starting Index is out of range!");
 				}
-				else if (autostepEndIndex <= autostepStartIndex || autostepEndIndex > ui.vectorsTableWidget->rowCount())
+				else if (autostepEndIndex <= autostepStartIndex || autostepEndIndex > vectorTable->rowCount())
 				{
 					showErrorString("Ending Index is out of range!");
 				}
@@ -1111,16 +978,28 @@ void MultiAxisOperation::startAutostep(void)
 						ui.actionPersistentMode->setEnabled(false);
 
 					// begin with first vector
+					remoteStepRow = 0;
 					presentVector = autostepStartIndex - 1;
 
 					// highlight row in table
-					ui.vectorsTableWidget->selectRow(presentVector);
+					ui.vectorsTableView->selectRow(presentVector);
 					magnetState = RAMPING;
 					systemState = SYSTEM_RAMPING;
 					vectorSelectionChanged(); // lockout row changes
 					haveAutosavedReport = false;
+					autosavePending = false;
+
+					// journal each step of the run as it completes, making room
+					// for it among the journals of earlier runs
+					ReportData run;
+					QString resultsPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/Results";
+					getReportData(&run);
+					ResultsJournal::removeOld(resultsPath, RESULTS_JOURNALS_KEPT - 1);
+					resultsJournal.open(resultsPath + "/Results-" +
+						QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".maxres", run);
 
 					goToVector(presentVector, true);
+					resultsJournal.stepStarted(presentVector, vectorTable);
 					settlingTime = 0;
 					suspendAutostepFlag = false;
 					vectorAutostepState = VECTOR_TABLE_RAMPING_TO_NEXT_VECTOR;
@@ -1214,7 +1093,7 @@ void MultiAxisOperation::autostepTimerTick(void)
 				// if a switch is installed, check to see if we want to enter persistent mode
 				if (magnetParams->switchInstalled())
 				{
-					if (ui.vectorsTableWidget->item(presentVector, 3)->checkState() == Qt::Checked)
+					if (vectorTable->isChecked(presentVector))
 					{
 						// enter settling time
 						vectorAutostepState = VECTOR_TABLE_SETTLING_AT_VECTOR;
@@ -1287,13 +1166,13 @@ void MultiAxisOperation::autostepTimerTick(void)
 				elapsedHoldTimerTicks++;
 
 				// check time
-				if (ui.vectorsTableWidget->item(presentVector, 3) != nullptr)
+				if (!vectorTable->isEmpty(presentVector, 3))
 				{
 					bool ok;
 					double temp;
 
 					// get time
-					temp = ui.vectorsTableWidget->item(presentVector, 3)->text().toDouble(&ok);
+					temp = vectorTable->value(presentVector, 3, &ok);
 
 					if (ok)	// time is a number
 					{
@@ -1305,6 +1184,7 @@ void MultiAxisOperation::autostepTimerTick(void)
 							if ((elapsedHoldTimerTicks >= (static_cast<int>(temp) - executionTime)) && !haveExecuted)
 							{
 								haveExecuted = true;
+								resultsJournal.appStarted();
 								executeApp();
 							}
 						}
@@ -1318,7 +1198,7 @@ void MultiAxisOperation::autostepTimerTick(void)
 							// first check to see if we need to exit persistence
 							if (magnetParams->switchInstalled())
 							{
-								if (ui.vectorsTableWidget->item(presentVector, 3)->checkState() == Qt::Checked || ui.actionPersistentMode->isChecked())
+								if (vectorTable->isChecked(presentVector) || ui.actionPersistentMode->isChecked())
 								{
 									if (ui.actionPersistentMode->isChecked())	// heater is OFF, persistent
 									{
@@ -1399,7 +1279,7 @@ void MultiAxisOperation::autostepTimerTick(void)
 		//////////////////////////////////////
 		else if (vectorAutostepState == VECTOR_TABLE_HEATING_SWITCH)
 		{
-			if (matchMagnetCurrentTimer->isActive() == false && switchHeatingTimer->isActive() == false)
+			if (currentMatcher->isActive() == false && switchHeatingTimer->isActive() == false)
 				vectorAutostepState = VECTOR_TABLE_NEXT_VECTOR;
 		}
 
@@ -1408,11 +1288,14 @@ void MultiAxisOperation::autostepTimerTick(void)
 		//////////////////////////////////////
 		else if (vectorAutostepState == VECTOR_TABLE_NEXT_VECTOR)
 		{
+			resultsJournal.stepEnded(presentVector);
+			autostepRowCompleted("VECTOR", presentVector + 1, presentVector + 1 >= autostepEndIndex);
+
 			if (presentVector + 1 < autostepEndIndex)
 			{
 				// highlight row in table
 				presentVector++;
-				ui.vectorsTableWidget->selectRow(presentVector);
+				ui.vectorsTableView->selectRow(presentVector);
 				magnetState = RAMPING;
 				systemState = SYSTEM_RAMPING;
 
@@ -1423,6 +1306,7 @@ void MultiAxisOperation::autostepTimerTick(void)
 				// go to next vector!
 				///////////////////////////////////////////////
 				goToVector(presentVector, true);
+				resultsJournal.stepStarted(presentVector, vectorTable);
 				haveExecuted = false;
 				vectorAutostepState = VECTOR_TABLE_RAMPING_TO_NEXT_VECTOR;
 			}
@@ -1470,15 +1354,19 @@ void MultiAxisOperation::doAutosaveReport(void)
 						i++;
 					}
 
-					// filename constructed, now autosave the report
-					saveReport(reportName);
-
-					QFileInfo reportFile(reportName);
-
-					if (reportFile.exists())
+					// filename constructed, now autosave the report in the background,
+					// materialized from the journal if the run was journaled, and
+					// stored uncompressed so it is written as quickly as possible
+					reportWriter->setCompressionLevel(0);
+					if (saveReport(reportName, resultsJournal.isOpen()))
 					{
-						setStatusMsg(statusMisc->text() + " : Saved as " + reportFile.fileName());
-						haveAutosavedReport = true;
+						haveAutosavedReport = autosavingReport = true;
+						resultsJournal.close();
+					}
+					else
+					{
+						// another report is being written, retried from reportSaved()
+						autosavePending = true;
 					}
 				}
 			}
@@ -1704,6 +1592,13 @@ void MultiAxisOperation::executeApp(void)
 //---------------------------------------------------------------------------
 void MultiAxisOperation::finishedApp(int exitCode, QProcess::ExitStatus exitStatus)
 {
+	if (remoteAppRunning)
+	{
+		remoteAppRunning = false;
+		remoteAppExitCode = (exitStatus == QProcess::NormalExit) ? exitCode : -1;
+		publishSnapshot();
+	}
+
 	if (!connected)
 		return;
 
@@ -1711,6 +1606,7 @@ void MultiAxisOperation::finishedApp(int exitCode, QProcess::ExitStatus exitStat
 
 	// strip cr/lf
 	output = output.simplified();
+	resultsJournal.appFinished((exitStatus == QProcess::NormalExit) ? exitCode : -1, output);
 
 	process->deleteLater();
 	process = nullptr;
@@ -4,6 +4,9 @@
 #include "conversions.h"
 #include "aboutdialog.h"
 #include "parser.h"
+#include "remoteserver.h"
+#include "sequencer.h"
+#include "latencystats.h"
 
 // minimum programmable ramp rate (A/s) for purposes of multi-axis control
 const double MIN_RAMP_RATE = 0.001;
@@ -16,8 +19,11 @@ const int SAVE_FILE_VERSION = 7;
 // stdin parsing support
 static Parser *parser;
 
-// quench logged flag to prevent duplicate log messages
-static bool quenchLogged = false;
+// local socket scripting server
+static RemoteServer *remoteServer;
+
+// sequence scripts run for the scripting interface
+static Sequencer *sequencer;
 
 
 //---------------------------------------------------------------------------
@@ -31,16 +37,59 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	// no context menu for toolbar
 	ui.mainToolBar->setContextMenuPolicy(Qt::PreventContextMenu);
 
-	// min columns for vector table
-	ui.vectorsTableWidget->setMinimumNumCols(5);
-	ui.polarTableWidget->setMinimumNumCols(3);
+	// vector and polar table models, min columns for each
+	vectorTable = new TableModel(5, this);
+	vectorTable->setHeader(0, "Magnitude (kG)");
+	vectorTable->setHeader(1, "θ (degrees)");
+	vectorTable->setHeader(2, "φ (degrees)");
+	vectorTable->setHeader(3, "Time (sec)");
+	vectorTable->setHeader(4, "Pass/Fail");
+	vectorTable->setCheckColumn(3);
+	vectorTable->setResultColumn(4);
+	ui.vectorsTableView->setModel(vectorTable);
+
+	polarTable = new TableModel(3, this);
+	polarTable->setHeader(0, "Magnitude (kG)");
+	polarTable->setHeader(1, "θ (degrees)");
+	polarTable->setHeader(2, "Time (sec)");
+	polarTable->setCheckColumn(2);
+	ui.polarTableView->setModel(polarTable);
+
+	// table files are parsed on worker threads
+	vectorLoader = new TableLoader(this);
+	polarLoader = new TableLoader(this);
+	connect(vectorLoader, SIGNAL(progress(int)), this, SLOT(tableLoadProgress(int)));
+	connect(vectorLoader, SIGNAL(finished()), this, SLOT(vectorTableLoaded()));
+	connect(polarLoader, SIGNAL(progress(int)), this, SLOT(tableLoadProgress(int)));
+	connect(polarLoader, SIGNAL(finished()), this, SLOT(polarTableLoaded()));
+	convertVectorUnits = convertPolarUnits = false;
+
+	// and saved on worker threads
+	vectorWriter = new TableWriter(this);
+	polarWriter = new TableWriter(this);
+	connect(vectorWriter, SIGNAL(finished()), this, SLOT(tableSaved()));
+	connect(polarWriter, SIGNAL(finished()), this, SLOT(tableSaved()));
+
+	// as are Excel reports, so a report never holds up auto-stepping
+	reportWriter = new ReportWriter(this);
+	connect(reportWriter, SIGNAL(finished()), this, SLOT(reportSaved()));
+	autosavingReport = false;
+	autosavePending = false;
+
+	// and validated on worker threads as they are edited
+	vectorValidator = new TableValidator(vectorTable, TableValidator::VECTOR_ROWS, "Vector #", this);
+	polarValidator = new TableValidator(polarTable, TableValidator::POLAR_ROWS, "Polar Table #", this);
+
+	// uniform row heights let large tables scroll without measuring rows
+	ui.vectorsTableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	ui.polarTableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 
 #if defined(Q_OS_LINUX)
     this->setWindowIcon(QIcon(":multiaxis/Resources/app.ico"));
     QGuiApplication::setFont(QFont("Ubuntu", 9));
     this->setFont(QFont("Ubuntu", 9));
     QFont::insertSubstitution("Segoe UI", "Ubuntu");
-    ui.vectorsTableWidget->setFont(QFont("Ubuntu", 9));
+    ui.vectorsTableView->setFont(QFont("Ubuntu", 9));
 #elif defined(Q_OS_MACOS)
     // Mac base font scaling is different than Linux and Windows
     // use ~ 96/72 = 1.333 factor for upscaling every font size
@@ -62,8 +111,10 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 
 	// initialization
 	optionsDialog = new OptionsDialog(this);	// create here to initialize all optional settings
+	latencyDialog = nullptr;
 	loadedCoordinates = SPHERICAL_COORDINATES;
 	systemState = DISCONNECTED;
+	lastLoggedState = DISCONNECTED;
     magnetParams = nullptr;
     xProcess = nullptr;
     yProcess = nullptr;
@@ -90,6 +141,11 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	yTarget = 0.0;
 	zTarget = 0.0;
 	remainingTime = 0;
+	memset(&remoteSnapshot, 0, sizeof(remoteSnapshot));
+	remoteStepRow = 0;
+	remoteSyncToken = 0;
+	remoteAppRunning = false;
+	remoteAppExitCode = -1;
 	autostepRemainingTime = 0;
 	polarRemainingTime = 0;
 
@@ -170,6 +226,11 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 		ui.mainTabWidget->insertTab(alignTabIndex, ui.alignmentTab, "Sample Alignment");
 	}
 
+	// live field plot reads from the acquisition history
+	stripChart = new StripChart(this);
+	stripChart->setHistory(&history);
+	ui.mainTabWidget->addTab(stripChart, "Field Plot");
+
 	ui.mainTabWidget->setCurrentIndex(settings.value("CurrentTab").toInt());
 
 	// restore alignment tab settings
@@ -191,10 +252,14 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	switchHeatingTimer->setInterval(1000);
 	connect(switchHeatingTimer, SIGNAL(timeout()), this, SLOT(switchHeatingTimerTick()));
 
-	// create supply/magnet current mismatch timer
-	matchMagnetCurrentTimer = new QTimer(this);
-	matchMagnetCurrentTimer->setInterval(1000);
-	connect(matchMagnetCurrentTimer, SIGNAL(timeout()), this, SLOT(matchMagnetCurrentTimerTick()));
+	// create supply/magnet current matching controller
+	currentMatcher = new CurrentMatcher(this);
+	connect(currentMatcher, SIGNAL(matchComplete()), this, SLOT(currentMatchComplete()));
+	connect(currentMatcher, SIGNAL(matchAborted(QString)), this, SLOT(currentMatchAborted(QString)));
+
+	// create quench watchdog
+	quenchWatchdog = new QuenchWatchdog(this);
+	connect(quenchWatchdog, SIGNAL(quenchDetected()), this, SLOT(quenchDetected()));
 
 	// create switch cooling timer
 	switchCoolingTimer = new QTimer(this);
@@ -230,6 +295,7 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	connect(ui.actionAbout_2, SIGNAL(triggered()), this, SLOT(actionAbout()));
 	connect(ui.actionView_Help, SIGNAL(triggered()), this, SLOT(actionHelp()));
 	connect(ui.actionHelp, SIGNAL(triggered()), this, SLOT(actionHelp()));
+	connect(ui.actionLatency_Statistics, SIGNAL(triggered()), this, SLOT(actionLatencyStatistics()));
 	connect(ui.actionConnect, SIGNAL(triggered()), this, SLOT(actionConnect()));
 	connect(ui.actionLoad_Settings, SIGNAL(triggered()), this, SLOT(actionLoad_Settings()));
 	connect(ui.actionSave_Settings, SIGNAL(triggered()), this, SLOT(actionSave_Settings()));
@@ -255,10 +321,10 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	connect(ui.actionOptions, SIGNAL(triggered()), this, SLOT(actionOptions()));
 
 	// other actions
-	connect(ui.vectorsTableWidget, SIGNAL(itemSelectionChanged()), this, SLOT(vectorSelectionChanged()));
+	connect(ui.vectorsTableView->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)), this, SLOT(vectorSelectionChanged()));
 	connect(ui.startIndexEdit, SIGNAL(editingFinished()), this, SLOT(autostepRangeChanged()));
 	connect(ui.endIndexEdit, SIGNAL(editingFinished()), this, SLOT(autostepRangeChanged()));
-	connect(ui.polarTableWidget, SIGNAL(itemSelectionChanged()), this, SLOT(polarSelectionChanged()));
+	connect(ui.polarTableView->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)), this, SLOT(polarSelectionChanged()));
 	connect(ui.startIndexEditPolar, SIGNAL(editingFinished()), this, SLOT(polarRangeChanged()));
 	connect(ui.endIndexEditPolar, SIGNAL(editingFinished()), this, SLOT(polarRangeChanged()));
 
@@ -282,6 +348,8 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	The command line parser allows options:
 
 	-p	Start the stdin/stdout parser function (for QProcess use).
+	--tcp <port>	Accept scripting clients on a localhost TCP port.
+	--socket <name>	Accept scripting clients on a local (Unix domain) socket.
 	--simulate	Start in localhost simulation mode (for AMI use only).
 	************************************************************/
 
@@ -303,6 +371,16 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 		QCoreApplication::translate("main", "Enable stdin parsing for interprocess communication."));
 	cmdLineParse.addOption(parsingOption);
 
+	// Scripting server on localhost TCP (--tcp) and/or a local socket (--socket)
+	QCommandLineOption tcpOption("tcp",
+		QCoreApplication::translate("main", "Accept scripting clients on a localhost TCP port."),
+		QCoreApplication::translate("main", "port"));
+	cmdLineParse.addOption(tcpOption);
+	QCommandLineOption socketOption("socket",
+		QCoreApplication::translate("main", "Accept scripting clients on a local socket."),
+		QCoreApplication::translate("main", "name"));
+	cmdLineParse.addOption(socketOption);
+
 	// Process the actual command line arguments given by the user
 	cmdLineParse.process(*(QCoreApplication::instance()));
 
@@ -320,6 +398,7 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 	}
 
 	useParser = cmdLineParse.isSet(parsingOption);
+	publishSnapshot();
 
 	if (useParser)	// start stdin/stdout parser for scripting control
 	{
@@ -328,35 +407,84 @@ MultiAxisOperation::MultiAxisOperation(QWidget *parent)
 
 		parser->setDataSource(this);
 		parser->moveToThread(parserThread);
-		connect(parser, SIGNAL(error_msg(QString)), this, SLOT(parserErrorString(QString)));
 		connect(parserThread, SIGNAL(started()), parser, SLOT(process()));
 		connect(parser, SIGNAL(finished()), parserThread, SLOT(quit()));
 		connect(parser, SIGNAL(finished()), parser, SLOT(deleteLater()));
 		connect(parserThread, SIGNAL(finished()), parserThread, SLOT(deleteLater()));
 
-		// connect cross-thread actions
-		connect(parser, SIGNAL(system_connect()), this, SLOT(system_connect()));
-		connect(parser, SIGNAL(system_disconnect()), this, SLOT(system_disconnect()));
-		connect(parser, SIGNAL(exit_app()), this, SLOT(exit_app()));
-		connect(parser, SIGNAL(ramp()), this, SLOT(actionRamp()));
-		connect(parser, SIGNAL(pause()), this, SLOT(actionPause()));
-		connect(parser, SIGNAL(zero()), this, SLOT(actionZero()));
-		connect(parser, SIGNAL(load_settings(FILE *, bool *)), this, SLOT(load_settings(FILE *,bool *)));
-		connect(parser, SIGNAL(save_settings(FILE *, bool *)), this, SLOT(save_settings(FILE *, bool *)));
-		connect(parser, SIGNAL(set_align1(double, double, double)), this, SLOT(set_align1(double, double, double)));
-		connect(parser, SIGNAL(set_align2(double, double, double)), this, SLOT(set_align2(double, double, double)));
-		connect(parser, SIGNAL(set_align1_active()), this, SLOT(set_align1_active()));
-		connect(parser, SIGNAL(set_align2_active()), this, SLOT(set_align2_active()));
-		connect(parser, SIGNAL(set_units(int)), this, SLOT(set_units(int)));
-		connect(parser, SIGNAL(set_vector(double, double, double, int)), this, SLOT(set_vector(double, double, double, int)));
-		connect(parser, SIGNAL(set_vector_cartesian(double, double, double, int)), this, SLOT(set_vector_cartesian(double, double, double, int)));
-		connect(parser, SIGNAL(goto_vector(int)), this, SLOT(goto_vector(int)));
-		connect(parser, SIGNAL(set_polar(double, double, int)), this, SLOT(set_polar(double, double, int)));
-		connect(parser, SIGNAL(goto_polar(int)), this, SLOT(goto_polar(int)));
-		connect(parser, SIGNAL(set_persistence(bool)), this, SLOT(set_persistence(bool)));
+		attachParser(parser);
 
 		parserThread->start();
 	}
+
+	if (useParser || cmdLineParse.isSet(tcpOption) || cmdLineParse.isSet(socketOption))
+	{
+		// sequence scripts run in their own thread like another session
+		QThread* sequencerThread = new QThread;
+		sequencer = new Sequencer();
+
+		sequencer->setDataSource(this);
+		sequencer->moveToThread(sequencerThread);
+		connect(sequencerThread, SIGNAL(started()), sequencer, SLOT(process()));
+		connect(sequencer, SIGNAL(finished()), sequencerThread, SLOT(quit()));
+		connect(sequencer, SIGNAL(finished()), sequencer, SLOT(deleteLater()));
+		connect(sequencerThread, SIGNAL(finished()), sequencerThread, SLOT(deleteLater()));
+		connect(sequencer, SIGNAL(sequence_event(int, QVariantList)), this, SIGNAL(remote_event(int, QVariantList)), Qt::DirectConnection);
+
+		attachParser(sequencer);
+
+		sequencerThread->start();
+	}
+
+	if (cmdLineParse.isSet(tcpOption) || cmdLineParse.isSet(socketOption))
+	{
+		remoteServer = new RemoteServer(this);
+
+		if (cmdLineParse.isSet(tcpOption))
+			remoteServer->listenTcp((quint16)cmdLineParse.value(tcpOption).toUInt());
+
+		if (cmdLineParse.isSet(socketOption))
+			remoteServer->listenLocal(cmdLineParse.value(socketOption));
+	}
+}
+
+//---------------------------------------------------------------------------
+// Connects a scripting session (stdin parser or socket client) to the
+// action slots and remote events
+//---------------------------------------------------------------------------
+void MultiAxisOperation::attachParser(Parser *session)
+{
+	connect(session, SIGNAL(error_msg(QString)), this, SLOT(parserErrorString(QString)));
+
+	// connect cross-thread actions
+	connect(session, SIGNAL(system_connect(qint64)), this, SLOT(system_connect(qint64)));
+	connect(session, SIGNAL(system_disconnect(qint64)), this, SLOT(system_disconnect(qint64)));
+	connect(session, SIGNAL(exit_app(qint64)), this, SLOT(exit_app(qint64)));
+	connect(session, SIGNAL(ramp(qint64)), this, SLOT(remote_ramp(qint64)));
+	connect(session, SIGNAL(pause(qint64)), this, SLOT(remote_pause(qint64)));
+	connect(session, SIGNAL(zero(qint64)), this, SLOT(remote_zero(qint64)));
+	connect(session, SIGNAL(load_settings(FILE *, bool *, qint64)), this, SLOT(load_settings(FILE *,bool *, qint64)));
+	connect(session, SIGNAL(save_settings(FILE *, bool *, qint64)), this, SLOT(save_settings(FILE *, bool *, qint64)));
+	connect(session, SIGNAL(set_align1(double, double, double, qint64)), this, SLOT(set_align1(double, double, double, qint64)));
+	connect(session, SIGNAL(set_align2(double, double, double, qint64)), this, SLOT(set_align2(double, double, double, qint64)));
+	connect(session, SIGNAL(set_align1_active(qint64)), this, SLOT(set_align1_active(qint64)));
+	connect(session, SIGNAL(set_align2_active(qint64)), this, SLOT(set_align2_active(qint64)));
+	connect(session, SIGNAL(set_units(int, qint64)), this, SLOT(set_units(int, qint64)));
+	connect(session, SIGNAL(set_vector(double, double, double, int, qint64)), this, SLOT(set_vector(double, double, double, int, qint64)));
+	connect(session, SIGNAL(set_vector_cartesian(double, double, double, int, qint64)), this, SLOT(set_vector_cartesian(double, double, double, int, qint64)));
+	connect(session, SIGNAL(goto_vector(int, quint64, qint64)), this, SLOT(goto_vector(int, quint64, qint64)));
+	connect(session, SIGNAL(set_polar(double, double, int, qint64)), this, SLOT(set_polar(double, double, int, qint64)));
+	connect(session, SIGNAL(goto_polar(int, quint64, qint64)), this, SLOT(goto_polar(int, quint64, qint64)));
+	connect(session, SIGNAL(set_persistence(bool, qint64)), this, SLOT(set_persistence(bool, qint64)));
+	connect(session, SIGNAL(sync(quint64, qint64)), this, SLOT(remote_sync(quint64, qint64)));
+	connect(session, SIGNAL(set_vector_table(QStringList, int, qint64)), this, SLOT(set_vector_table(QStringList, int, qint64)));
+	connect(session, SIGNAL(set_polar_table(QStringList, qint64)), this, SLOT(set_polar_table(QStringList, qint64)));
+	connect(session, SIGNAL(dump_table(int, quint64, qint64)), this, SLOT(remote_table_dump(int, quint64, qint64)));
+	connect(session, SIGNAL(history_range(qint64, qint64, quint64, qint64)), this, SLOT(remote_history(qint64, qint64, quint64, qint64)));
+	connect(session, SIGNAL(execute_app(int, qint64)), this, SLOT(execute_app(int, qint64)));
+
+	// events are only queued on the GUI thread, the session thread writes them
+	connect(this, SIGNAL(remote_event(int, QVariantList)), session, SLOT(pushEvent(int, QVariantList)), Qt::DirectConnection);
 }
 
 //---------------------------------------------------------------------------
@@ -398,6 +526,17 @@ MultiAxisOperation::~MultiAxisOperation()
         parser = nullptr;
 	}
 
+	// disconnect any socket scripting clients
+	delete remoteServer;
+	remoteServer = nullptr;
+
+	// abort any running sequence and end its thread
+	if (sequencer)
+	{
+		sequencer->shutdown();
+		sequencer = nullptr;
+	}
+
 	closeConnection();
 
 	// delete timers
@@ -464,6 +603,11 @@ void MultiAxisOperation::closeConnection()
 	connected = false;
 	systemState = DISCONNECTED;
 
+	// abandon any supply/magnet current matching in progress
+	currentMatcher->stop();
+	quenchWatchdog->stop();
+	acquisitionLog.close();
+
 	// close and delete all connected processes
 	if (xProcess)
 	{
@@ -501,6 +645,14 @@ void MultiAxisOperation::closeConnection()
 	ui.actionConnect->setChecked(false);
 
 	alignmentTabDisconnect();
+	completePendingActions(false);
+	publishSnapshot();
+
+	if (lastLoggedState != DISCONNECTED)
+	{
+		lastLoggedState = DISCONNECTED;
+		emit remote_event(EVENT_STATE, QVariantList() << (int)DISCONNECTED);
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -522,6 +674,19 @@ void MultiAxisOperation::actionHelp(void)
 	QDesktopServices::openUrl(QUrl(link));
 }
 
+//---------------------------------------------------------------------------
+// Shows the latency statistics, modeless so they can be watched while
+// operating
+void MultiAxisOperation::actionLatencyStatistics(void)
+{
+	if (latencyDialog == nullptr)
+		latencyDialog = new LatencyDialog(this);
+
+	latencyDialog->show();
+	latencyDialog->raise();
+	latencyDialog->activateWindow();
+}
+
 //---------------------------------------------------------------------------
 void MultiAxisOperation::actionConnect(void)
 {
@@ -795,8 +960,16 @@ void MultiAxisOperation::actionConnect(void)
 			magnetParams->syncUI();
 
 			// start data collection timer
+			history.reset(fieldUnits);
+			lastLoggedState = DISCONNECTED;
+			acquisitionLog.open(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/Logs/Acquisition-" +
+				QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".maxlog", fieldUnits);
 			dataTimer->start();
 
+			// start quench monitoring of all active axes
+			quenchWatchdog->setInterval(optionsDialog->quenchWatchdogInterval());
+			quenchWatchdog->start(xProcess, yProcess, zProcess, magnetParams);
+
 			// if a switch is present, check for persistence mode
 			if (switchInstalled)
 			{
@@ -936,6 +1109,7 @@ void MultiAxisOperation::actionLoad_Settings(void)
 			magnetParams->save();
 
 			updateWindowTitle();
+			updateTableValidation();
 			vectorSelectionChanged();
 			polarSelectionChanged();
 		}
@@ -1002,110 +1176,73 @@ bool MultiAxisOperation::loadFromFile(FILE *pFile)
 			switchInstalled = true;
 
 		// reload vector table
-		ui.vectorsTableWidget->setRowCount(stream.readLine().toInt());
+		vectorTable->beginBulkUpdate();
+		vectorTable->setRowCount(stream.readLine().toInt());
 
 		// load columns count
 		int columnCount = stream.readLine().toInt();
 
 		if (version == 1)
 		{
-			if (columnCount > ui.vectorsTableWidget->columnCount())
-			{
-				ui.vectorsTableWidget->setColumnCount(columnCount);
+			vectorTable->setColumnCount(columnCount);
 
-				if (columnCount >= 8)
-				{
-					ui.vectorsTableWidget->setHorizontalHeaderItem(5, new QTableWidgetItem("X Quench (A)"));
-					ui.vectorsTableWidget->horizontalHeaderItem(5)->font().setBold(true);
-					ui.vectorsTableWidget->setHorizontalHeaderItem(6, new QTableWidgetItem("Y Quench (A)"));
-					ui.vectorsTableWidget->horizontalHeaderItem(6)->font().setBold(true);
-					ui.vectorsTableWidget->setHorizontalHeaderItem(7, new QTableWidgetItem("Z Quench (A)"));
-				}
-			}
-			else
-				ui.vectorsTableWidget->setColumnCount(columnCount);
+			if (columnCount >= 8)
+				addQuenchColumns();
 		}
 		else if (version >= 2)
 		{
 			// recover horizontal header labels (v2)
-			if (columnCount > ui.vectorsTableWidget->columnCount())
-				ui.vectorsTableWidget->setColumnCount(columnCount);
-			else
-				ui.vectorsTableWidget->setColumnCount(columnCount);
+			vectorTable->setColumnCount(columnCount);
 
 			for (int i = 0; i < columnCount; i++)
 			{
 				// read saved header label
 				QString tempStr = stream.readLine();
-				QTableWidgetItem *item;
 
 				if (tempStr.contains("Persistence"))
 					tempStr = "Enter Persistence?\nHold Time (sec)";
 
-				item = ui.vectorsTableWidget->horizontalHeaderItem(i);
-
-                if (item == nullptr)
-					ui.vectorsTableWidget->setHorizontalHeaderItem(i, item = new QTableWidgetItem(tempStr));
-				else
-					ui.vectorsTableWidget->horizontalHeaderItem(i)->setText(tempStr);
+				vectorTable->setHeader(i, tempStr);
 			}
 
 			if (convention == MATHEMATICAL)
 			{
-				ui.vectorsTableWidget->horizontalHeaderItem(1)->setText(thetaStr);
-				ui.vectorsTableWidget->horizontalHeaderItem(2)->setText(phiStr);
+				vectorTable->setHeader(1, thetaStr);
+				vectorTable->setHeader(2, phiStr);
 			}
 			else
 			{
-				ui.vectorsTableWidget->horizontalHeaderItem(1)->setText(phiStr);
-				ui.vectorsTableWidget->horizontalHeaderItem(2)->setText(thetaStr);
+				vectorTable->setHeader(1, phiStr);
+				vectorTable->setHeader(2, thetaStr);
 			}
 		}
 
 		// recover table text for each item
-		for (int i = 0; i < ui.vectorsTableWidget->rowCount(); i++)
+		for (int i = 0; i < vectorTable->rowCount(); i++)
 		{
 			for (int j = 0; j < columnCount; j++)
 			{
-				QTableWidgetItem *item;
-
-				item = ui.vectorsTableWidget->item(i, j);
-
 				// read saved text
 				QString tempStr = stream.readLine();
 
-                if (item == nullptr)
-					ui.vectorsTableWidget->setItem(i, j, item = new QTableWidgetItem(tempStr));
-				else
-					item->setText(tempStr);
+				vectorTable->setText(i, j, tempStr);
 
 				if (j == 3 && switchInstalled)
 				{
-					if (item->text().length() > 0)
-						item->setCheckState(Qt::Checked);
-					else
-						item->setCheckState(Qt::Unchecked);
+					vectorTable->setChecked(i, tempStr.length() > 0);
 
 					if (version >= 5)
 					{
 						// read check state from saved file
 						QString tempStr = stream.readLine();
-						bool checked = (bool)(tempStr.toUShort());
-
-						if (checked)
-							item->setCheckState(Qt::Checked);
-						else
-							item->setCheckState(Qt::Unchecked);
+						vectorTable->setChecked(i, (bool)(tempStr.toUShort()));
 					}
 				}
-
-				if (j == 4)
-					item->setTextAlignment(Qt::AlignCenter | Qt::AlignVCenter);
-				else
-					item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
 			}
 		}
 
+		vectorTable->endBulkUpdate();
+
 		if (version >= 5)
 		{
 			// recover vector table executable setup
@@ -1139,74 +1276,54 @@ bool MultiAxisOperation::loadFromFile(FILE *pFile)
 
 			// reload polar table
 			int rowCount = stream.readLine().toInt();
-			ui.polarTableWidget->setRowCount(rowCount);
+			polarTable->beginBulkUpdate();
+			polarTable->setRowCount(rowCount);
 
 			// load columns count
 			int columnCount = stream.readLine().toInt();
 
 			// recover horizontal header labels
-			if (columnCount >= ui.polarTableWidget->getMinimumNumCols())
-				ui.polarTableWidget->setColumnCount(columnCount);
+			if (columnCount >= polarTable->getMinimumNumCols())
+				polarTable->setColumnCount(columnCount);
 
 			for (int i = 0; i < columnCount; i++)
 			{
 				// read saved header label
 				QString tempStr = stream.readLine();
-				QTableWidgetItem *item;
 
 				if (tempStr.contains("Persistence"))
 					tempStr = "Enter Persistence?\nHold Time (sec)";
 
-				item = ui.polarTableWidget->horizontalHeaderItem(i);
-
-                if (item == nullptr)
-					ui.polarTableWidget->setHorizontalHeaderItem(i, item = new QTableWidgetItem(tempStr));
-				else
-					ui.polarTableWidget->horizontalHeaderItem(i)->setText(tempStr);
+				polarTable->setHeader(i, tempStr);
 			}
 
-			ui.polarTableWidget->horizontalHeaderItem(1)->setText(thetaStr);
+			polarTable->setHeader(1, thetaStr);
 
 			// recover table text for each item
-			for (int i = 0; i < ui.polarTableWidget->rowCount(); i++)
+			for (int i = 0; i < polarTable->rowCount(); i++)
 			{
 				for (int j = 0; j < columnCount; j++)
 				{
-					QTableWidgetItem *item;
-
-					item = ui.polarTableWidget->item(i, j);
-
 					// read saved text
 					QString tempStr = stream.readLine();
 
-                    if (item == nullptr)
-						ui.polarTableWidget->setItem(i, j, item = new QTableWidgetItem(tempStr));
-					else
-						item->setText(tempStr);
+					polarTable->setText(i, j, tempStr);
 
 					if (j == 2 && switchInstalled)
 					{
-						if (item->text().length() > 0)
-							item->setCheckState(Qt::Checked);
-						else
-							item->setCheckState(Qt::Unchecked);
+						polarTable->setChecked(i, tempStr.length() > 0);
 
 						if (version >= 5)
 						{
 							// read check state from saved file
 							QString tempStr = stream.readLine();
-							bool checked = (bool)(tempStr.toUShort());
-
-							if (checked)
-								item->setCheckState(Qt::Checked);
-							else
-								item->setCheckState(Qt::Unchecked);
+							polarTable->setChecked(i, (bool)(tempStr.toUShort()));
 						}
 					}
-
-					item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
 				}
 			}
+
+			polarTable->endBulkUpdate();
 		}
 
 		if (version >= 5)
@@ -1258,8 +1375,8 @@ bool MultiAxisOperation::loadFromFile(FILE *pFile)
 	}
 
 #if defined(Q_OS_MACOS)
-        ui.vectorsTableWidget->repaint();
-        ui.polarTableWidget->repaint();
+        ui.vectorsTableView->repaint();
+        ui.polarTableView->repaint();
 #endif
 	return true;
 }
@@ -1366,54 +1483,25 @@ bool MultiAxisOperation::saveToFile(FILE *pFile)
 	saveParams(&stream, params);
 
 	// save vector table
-	stream << ui.vectorsTableWidget->rowCount() << "\n";
-	stream << ui.vectorsTableWidget->columnCount() << "\n";
+	stream << vectorTable->rowCount() << "\n";
+	stream << vectorTable->columnCount() << "\n";
 
 	// save horizontal header labels
-	for (int i = 0; i < ui.vectorsTableWidget->columnCount(); i++)
+	for (int i = 0; i < vectorTable->columnCount(); i++)
 	{
-		QTableWidgetItem *item;
-
-		item = ui.vectorsTableWidget->horizontalHeaderItem(i);
-
-		if (item == nullptr)
-		{
-			stream << "\n";
-		}
-		else
-		{
-			if (item->text().contains('\n'))
-			{
-				QString tmp = item->text().remove('\n');
-				stream << tmp << "\n";
-			}
-			else
-				stream << item->text() << "\n";
-		}
+		stream << vectorTable->header(i).remove('\n') << "\n";
 	}
 
 	// save vector table contents
-	for (int i = 0; i < ui.vectorsTableWidget->rowCount(); i++)
+	for (int i = 0; i < vectorTable->rowCount(); i++)
 	{
-		for (int j = 0; j < ui.vectorsTableWidget->columnCount(); j++)
+		for (int j = 0; j < vectorTable->columnCount(); j++)
 		{
-			QTableWidgetItem *item;
-
-			item = ui.vectorsTableWidget->item(i, j);
-
-            if (item == nullptr)
-				stream << "\n";
-			else
-				stream << item->text() << "\n";
+			stream << vectorTable->text(i, j) << "\n";
 
 			// save checked state for persistence (added with file version 5)
 			if (j == 3 && magnetParams->switchInstalled())
-			{
-				if (item == nullptr)
-					stream << "\n";
-				else
-					stream << (bool)item->checkState() << "\n";
-			}
+				stream << vectorTable->isChecked(i) << "\n";
 		}
 	}
 
@@ -1432,54 +1520,25 @@ bool MultiAxisOperation::saveToFile(FILE *pFile)
 	alignmentTabSaveToStream(&stream);
 
 	// save polar table
-	stream << ui.polarTableWidget->rowCount() << "\n";
-	stream << ui.polarTableWidget->columnCount() << "\n";
+	stream << polarTable->rowCount() << "\n";
+	stream << polarTable->columnCount() << "\n";
 
 	// save horizontal header labels
-	for (int i = 0; i < ui.polarTableWidget->columnCount(); i++)
+	for (int i = 0; i < polarTable->columnCount(); i++)
 	{
-		QTableWidgetItem *item;
-
-		item = ui.polarTableWidget->horizontalHeaderItem(i);
-
-		if (item == nullptr)
-		{
-			stream << "\n";
-		}
-		else
-		{
-			if (item->text().contains('\n'))
-			{
-				QString tmp = item->text().remove('\n');
-				stream << tmp << "\n";
-			}
-			else
-				stream << item->text() << "\n";
-		}
+		stream << polarTable->header(i).remove('\n') << "\n";
 	}
 
 	// save polar table contents
-	for (int i = 0; i < ui.polarTableWidget->rowCount(); i++)
+	for (int i = 0; i < polarTable->rowCount(); i++)
 	{
-		for (int j = 0; j < ui.polarTableWidget->columnCount(); j++)
+		for (int j = 0; j < polarTable->columnCount(); j++)
 		{
-			QTableWidgetItem *item;
-
-			item = ui.polarTableWidget->item(i, j);
-
-            if (item == nullptr)
-				stream << "\n";
-			else
-				stream << item->text() << "\n";
+			stream << polarTable->text(i, j) << "\n";
 
 			// save checked state for persistence (added with file version 5)
 			if (j == 2 && magnetParams->switchInstalled())
-			{
-				if (item == nullptr)
-					stream << "\n";
-				else
-					stream << (bool)item->checkState() << "\n";
-			}
+				stream << polarTable->isChecked(i) << "\n";
 		}
 	}
 
@@ -1536,6 +1595,7 @@ void MultiAxisOperation::actionDefine(void)
 
 	updateWindowTitle();
 	setStabilizingResistorAvailability();
+	updateTableValidation();
 }
 
 //---------------------------------------------------------------------------
@@ -1817,17 +1877,17 @@ void MultiAxisOperation::showErrorString(QString errMsg)
 	// reselect last good vector row if applicable
 	if (targetSource == VECTOR_TABLE)
 	{
-		if (lastVector >= 0 && lastVector < ui.vectorsTableWidget->rowCount())
+		if (lastVector >= 0 && lastVector < vectorTable->rowCount())
 		{
-			ui.vectorsTableWidget->selectRow(lastVector);
+			ui.vectorsTableView->selectRow(lastVector);
 			presentVector = lastVector;
 		}
 	}
 	else if (targetSource == POLAR_TABLE)
 	{
-		if (lastPolar >= 0 && lastPolar < ui.polarTableWidget->rowCount())
+		if (lastPolar >= 0 && lastPolar < polarTable->rowCount())
 		{
-			ui.polarTableWidget->selectRow(lastPolar);
+			ui.polarTableView->selectRow(lastPolar);
 			presentPolar = lastPolar;
 		}
 	}
@@ -1899,8 +1959,8 @@ void MultiAxisOperation::setFieldUnits(FieldUnits newUnits, bool updateMenuState
 		tempStr = ui.magnetMagnitudeLabel->text().replace("(T)", "(kG)");
 		ui.magnetMagnitudeLabel->setText(tempStr);
 
-		tempStr = ui.vectorsTableWidget->horizontalHeaderItem(0)->text().replace("(T)", "(kG)");
-		ui.vectorsTableWidget->horizontalHeaderItem(0)->setText(tempStr);
+		tempStr = vectorTable->header(0).replace("(T)", "(kG)");
+		vectorTable->setHeader(0, tempStr);
 
 		tempStr = ui.alignMagLabel1->text().replace("(T)", "(kG)");
 		ui.alignMagLabel1->setText(tempStr);
@@ -1908,8 +1968,8 @@ void MultiAxisOperation::setFieldUnits(FieldUnits newUnits, bool updateMenuState
 		tempStr = ui.alignMagLabel2->text().replace("(T)", "(kG)");
 		ui.alignMagLabel2->setText(tempStr);
 
-		tempStr = ui.polarTableWidget->horizontalHeaderItem(0)->text().replace("(T)", "(kG)");
-		ui.polarTableWidget->horizontalHeaderItem(0)->setText(tempStr);
+		tempStr = polarTable->header(0).replace("(T)", "(kG)");
+		polarTable->setHeader(0, tempStr);
 
 		tempStr = ui.polarMagnitudeLabel->text().replace("(T)", "(kG)");
 		ui.polarMagnitudeLabel->setText(tempStr);
@@ -1923,8 +1983,8 @@ void MultiAxisOperation::setFieldUnits(FieldUnits newUnits, bool updateMenuState
 		tempStr = ui.magnetMagnitudeLabel->text().replace("(kG)", "(T)");
 		ui.magnetMagnitudeLabel->setText(tempStr);
 
-		tempStr = ui.vectorsTableWidget->horizontalHeaderItem(0)->text().replace("(kG)", "(T)");
-		ui.vectorsTableWidget->horizontalHeaderItem(0)->setText(tempStr);
+		tempStr = vectorTable->header(0).replace("(kG)", "(T)");
+		vectorTable->setHeader(0, tempStr);
 
 		tempStr = ui.alignMagLabel1->text().replace("(kG)", "(T)");
 		ui.alignMagLabel1->setText(tempStr);
@@ -1932,8 +1992,8 @@ void MultiAxisOperation::setFieldUnits(FieldUnits newUnits, bool updateMenuState
 		tempStr = ui.alignMagLabel2->text().replace("(kG)", "(T)");
 		ui.alignMagLabel2->setText(tempStr);
 
-		tempStr = ui.polarTableWidget->horizontalHeaderItem(0)->text().replace("(kG)", "(T)");
-		ui.polarTableWidget->horizontalHeaderItem(0)->setText(tempStr);
+		tempStr = polarTable->header(0).replace("(kG)", "(T)");
+		polarTable->setHeader(0, tempStr);
 
 		tempStr = ui.polarMagnitudeLabel->text().replace("(kG)", "(T)");
 		ui.polarMagnitudeLabel->setText(tempStr);
@@ -1949,75 +2009,33 @@ void MultiAxisOperation::setFieldUnits(FieldUnits newUnits, bool updateMenuState
 		ui.actionKilogauss->setChecked(!fieldUnits);
 		ui.actionTesla->setChecked(fieldUnits);
 	}
+
+	publishSnapshot();
 }
 
 //---------------------------------------------------------------------------
 void MultiAxisOperation::convertFieldValues(FieldUnits newUnits, bool convertMagnetParams)
 {
+	double multiplier = (newUnits == TESLA) ? 1.0 : 10.0;	// to KG
+	double divisor = (newUnits == TESLA) ? 10.0 : 1.0;	// from KG
+
 	if (loadedCoordinates == CARTESIAN_COORDINATES)
 	{
-		// loop through vector table and convert X,Y,Z values
-		int numRows = ui.vectorsTableWidget->rowCount();
-
-		for (int i = 0; i < numRows; i++)
-		{
-			for (int j = 0; j < 3; j++)
-			{
-				QTableWidgetItem *cell = ui.vectorsTableWidget->item(i, j);
-				QString cellStr = cell->text();
-
-				if (!cellStr.isEmpty())
-				{
-					// try to convert to number
-					bool ok;
-					double value = cellStr.toDouble(&ok);
-
-					if (ok)
-					{
-						if (newUnits == TESLA)	// convert from KG
-							value /= 10.0;
-						else if (newUnits == KG)
-							value *= 10.0;
-
-						cell->setText(QString::number(value, 'g', 10));
-					}
-				}
-			}
-		}
-
+		// convert X,Y,Z values in vector table
+		for (int j = 0; j < 3; j++)
+			vectorTable->scaleColumn(j, multiplier, divisor);
 	}
 	else if (loadedCoordinates == SPHERICAL_COORDINATES)
 	{
-		// loop through vector table and convert magnitude only
-		int numRows = ui.vectorsTableWidget->rowCount();
-
-		for (int i = 0; i < numRows; i++)
-		{
-			QTableWidgetItem *cell = ui.vectorsTableWidget->item(i, 0);
-			QString cellStr = cell->text();
-
-			if (!cellStr.isEmpty())
-			{
-				// try to convert to number
-				bool ok;
-				double value = cellStr.toDouble(&ok);
-
-				if (ok)
-				{
-					if (newUnits == TESLA)	// convert from KG
-						value /= 10.0;
-					else if (newUnits == KG)
-						value *= 10.0;
-
-					cell->setText(QString::number(value, 'g', 10));
-				}
-			}
-		}
+		// convert magnitude only in vector table
+		vectorTable->scaleColumn(0, multiplier, divisor);
 	}
 
 	// now convert the magnet parameters
 	if (convertMagnetParams)
 		magnetParams->convertFieldValues(newUnits);
+
+	updateTableValidation();
 }
 
 //---------------------------------------------------------------------------
@@ -2035,8 +2053,8 @@ void MultiAxisOperation::setSphericalConvention(SphericalConvention selection, b
 		ui.alignPhiLabel2->setText("Inclination, " + phiStr);
 		if (loadedCoordinates == SPHERICAL_COORDINATES) // don't relabel tables in Cartesian coordinates
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(1)->setText(thetaStr);
-			ui.vectorsTableWidget->horizontalHeaderItem(2)->setText(phiStr);
+			vectorTable->setHeader(1, thetaStr);
+			vectorTable->setHeader(2, phiStr);
 		}
 	}
 	else if (convention == ISO)
@@ -2049,8 +2067,8 @@ void MultiAxisOperation::setSphericalConvention(SphericalConvention selection, b
 		ui.alignPhiLabel2->setText("Inclination, " + thetaStr);
 		if (loadedCoordinates == SPHERICAL_COORDINATES) // don't relabel tables in Cartesian coordinates
 		{
-			ui.vectorsTableWidget->horizontalHeaderItem(1)->setText(phiStr);
-			ui.vectorsTableWidget->horizontalHeaderItem(2)->setText(thetaStr);
+			vectorTable->setHeader(1, phiStr);
+			vectorTable->setHeader(2, thetaStr);
 		}
 	}
 
@@ -2064,6 +2082,7 @@ void MultiAxisOperation::setSphericalConvention(SphericalConvention selection, b
 //---------------------------------------------------------------------------
 void MultiAxisOperation::dataTimerTick(void)
 {
+	qint64 tickStart = LatencyStats::now();
 	bool x_activated = magnetParams->GetXAxisParams()->activate;
 	bool y_activated = magnetParams->GetYAxisParams()->activate;
 	bool z_activated = magnetParams->GetZAxisParams()->activate;
@@ -2246,14 +2265,10 @@ void MultiAxisOperation::dataTimerTick(void)
 	// update state
 	//---------------------------------------------------------------------------
 
-	if (switchInstalled)
-		checkForSupplyMagnetCurrentMismatch(false);
-
 	if ((x_activated && xState == QUENCH) ||
 		(y_activated && yState == QUENCH) ||
 		(z_activated && zState == QUENCH))
 	{
-		bool autoSave = false;
 		magnetState = QUENCH;
 		systemState = SYSTEM_QUENCH;
 		statusState->setStyleSheet("color: red; font: bold;");
@@ -2262,121 +2277,9 @@ void MultiAxisOperation::dataTimerTick(void)
 		if (switchInstalled)
 			ui.actionPersistentMode->setEnabled(false);
 
-		// stop any autostep cycle
-		if (autostepTimer->isActive())
-		{
-			autoSave = true;	// do the autosave on quench condition
-			stopAutostep();
-			lastTargetMsg.clear();
-			setStatusMsg("Auto-Stepping aborted due to quench detection");
-		}
-
-		if (autostepPolarTimer->isActive())
-		{
-			stopPolarAutostep();
-			lastTargetMsg.clear();
-			setStatusMsg("Polar Auto-Stepping aborted due to quench detection");
-		}
-
-		// mark vector as fail only in Vector Table
-		if (targetSource == VECTOR_TABLE)
-		{
-			if (presentVector >= 0)
-			{
-				QTableWidgetItem *cell = ui.vectorsTableWidget->item(presentVector, 4);
-
-				if (cell)
-					cell->setText("Fail");
-
-				// if needed, add columns for X/Y/Z quench currents
-				if (ui.vectorsTableWidget->columnCount() < 6)
-				{
-					ui.vectorsTableWidget->setColumnCount(8);
-					ui.vectorsTableWidget->setHorizontalHeaderItem(5, new QTableWidgetItem("X Quench (A)"));
-					ui.vectorsTableWidget->horizontalHeaderItem(5)->font().setBold(true);
-					ui.vectorsTableWidget->setHorizontalHeaderItem(6, new QTableWidgetItem("Y Quench (A)"));
-					ui.vectorsTableWidget->horizontalHeaderItem(6)->font().setBold(true);
-					ui.vectorsTableWidget->setHorizontalHeaderItem(7, new QTableWidgetItem("Z Quench (A)"));
-					ui.vectorsTableWidget->horizontalHeaderItem(7)->font().setBold(true);
-					ui.vectorsTableWidget->repaint();
-				}
-
-				// add quench data
-				if (x_activated && xState == QUENCH)
-				{
-					bool ok;
-					QString cellStr = QString::number(xProcess->getQuenchCurrent(&ok), 'g', 3);
-
-					if (ok)
-					{
-						QTableWidgetItem *cell = ui.vectorsTableWidget->item(presentVector, 5);
-
-                        if (cell == nullptr)
-							ui.vectorsTableWidget->setItem(presentVector, 5, cell = new QTableWidgetItem(cellStr));
-						else
-							cell->setText(cellStr);
-
-						cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-					}
-				}
-
-				if (y_activated && yState == QUENCH)
-				{
-					bool ok;
-					QString cellStr = QString::number(yProcess->getQuenchCurrent(&ok), 'g', 3);
-
-					if (ok)
-					{
-						QTableWidgetItem *cell = ui.vectorsTableWidget->item(presentVector, 6);
-
-                        if (cell == nullptr)
-							ui.vectorsTableWidget->setItem(presentVector, 6, cell = new QTableWidgetItem(cellStr));
-						else
-							cell->setText(cellStr);
-
-						cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-					}
-				}
-
-				if (z_activated && zState == QUENCH)
-				{
-					bool ok;
-					QString cellStr = QString::number(zProcess->getQuenchCurrent(&ok), 'g', 3);
-
-					if (ok)
-					{
-						QTableWidgetItem *cell = ui.vectorsTableWidget->item(presentVector, 7);
-
-                        if (cell == nullptr)
-							ui.vectorsTableWidget->setItem(presentVector, 7, cell = new QTableWidgetItem(cellStr));
-						else
-							cell->setText(cellStr);
-
-						cell->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-					}
-				}
-			}
-
-			doAutosaveReport();
-		}
-		else if (!quenchLogged) // log only once
-		{
-			// Save quench data in log
-			bool ok;
-			QString msg = "Quench Detect!! ";
-
-			if (x_activated && xState == QUENCH)
-				msg += ": X=" + QString::number(xProcess->getQuenchCurrent(&ok), 'g', 3) + " A";
-
-			if (y_activated && yState == QUENCH)
-				msg += ": Y=" + QString::number(yProcess->getQuenchCurrent(&ok), 'g', 3) + " A";
-
-			if (z_activated && zState == QUENCH)
-				msg += ": Z=" + QString::number(zProcess->getQuenchCurrent(&ok), 'g', 3) + " A";
-
-			qDebug() << msg;
-			quenchLogged = true;
-		}
+		// normally caught first by the watchdog, otherwise handle it now
+		if (!quenchWatchdog->isTripped())
+			quenchWatchdog->poll();
 	}
 	else if (switchHeatingTimer->isActive())
 	{
@@ -2434,8 +2337,6 @@ void MultiAxisOperation::dataTimerTick(void)
 		}
 		else
 			statusState->setText("RAMPING");
-
-		quenchLogged = false;
 	}
 	else if ((!x_activated || (x_activated && xState == HOLDING)) &&
 			 (!y_activated || (y_activated && yState == HOLDING)) &&
@@ -2453,7 +2354,6 @@ void MultiAxisOperation::dataTimerTick(void)
 			systemState = SYSTEM_HOLDING;
 			statusState->setStyleSheet("color: green; font: bold;");
 			statusState->setText("HOLDING");
-			quenchLogged = false;
 
 			if (switchInstalled)
 			{
@@ -2466,26 +2366,14 @@ void MultiAxisOperation::dataTimerTick(void)
 			{
 				if (presentVector >= 0 && !vectorError)
 				{
-					QTableWidgetItem *cell = ui.vectorsTableWidget->item(presentVector, 4);
-
-					if (cell)
-						cell->setText("Pass");
+					vectorTable->setResult(presentVector, RESULT_PASS);
 
 					// clear any quench data
-					cell = ui.vectorsTableWidget->item(presentVector, 5);
-
-					if (cell)
-						cell->setText("");
-
-					cell = ui.vectorsTableWidget->item(presentVector, 6);
+					for (int i = 5; i < vectorTable->columnCount() && i < 8; i++)
+						vectorTable->setText(presentVector, i, "");
 
-					if (cell)
-						cell->setText("");
-
-					cell = ui.vectorsTableWidget->item(presentVector, 7);
-
-					if (cell)
-						cell->setText("");
+					if (autostepTimer->isActive())
+						resultsJournal.stepResult(presentVector, vectorTable);
 				}
 			}
 
@@ -2500,7 +2388,6 @@ void MultiAxisOperation::dataTimerTick(void)
 		systemState = SYSTEM_PAUSED;
 		statusState->setStyleSheet("color: black; font: bold;");
 		statusState->setText("PAUSED");
-		quenchLogged = false;
 
 		if (switchInstalled)
 		{
@@ -2516,7 +2403,6 @@ void MultiAxisOperation::dataTimerTick(void)
 		systemState = SYSTEM_ZEROING;
 		statusState->setStyleSheet("color: black; font: bold;");
 		statusState->setText("ZEROING");
-		quenchLogged = false;
 
 		if (switchInstalled)
 		{
@@ -2534,13 +2420,204 @@ void MultiAxisOperation::dataTimerTick(void)
 		systemState = SYSTEM_AT_ZERO;
 		statusState->setStyleSheet("color: black; font: bold;");
 		statusState->setText("AT ZERO");
-		quenchLogged = false;
 
 		if (switchInstalled)
 			ui.actionPersistentMode->setEnabled(true);
 	}
 
+	publishSnapshot();
+	recordHistorySample();
 	madeFirstMeasurement.store(true);
+
+	// remote target actions held for this first measurement
+	if (!pendingActions.isEmpty())
+	{
+		completePendingActions(true);
+		publishSnapshot();
+	}
+
+	LatencyStats::recordStage(STAGE_GUI_TICK, LatencyStats::now() - tickStart);
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::makeHistorySample(HistorySample *sample)
+{
+	AxesParams *params[3] = { magnetParams->GetXAxisParams(), magnetParams->GetYAxisParams(), magnetParams->GetZAxisParams() };
+
+	sample->field[0] = xField;
+	sample->field[1] = yField;
+	sample->field[2] = zField;
+	sample->target[0] = xTarget;
+	sample->target[1] = yTarget;
+	sample->target[2] = zTarget;
+	sample->state[0] = xState;
+	sample->state[1] = yState;
+	sample->state[2] = zState;
+	sample->polarMagnitude = polarMagnitude;
+	sample->polarAngle = polarAngle;
+
+	for (int i = 0; i < 3; i++)
+	{
+		// magnet current follows from field and coil constant, no extra query needed
+		if (params[i]->activate && params[i]->coilConst > 0)
+			sample->current[i] = sample->field[i] / params[i]->coilConst;
+		else
+			sample->current[i] = 0.0;
+
+		sample->switchHeated[i] = (params[i]->activate && params[i]->switchInstalled && switchHeaterState[i]);
+	}
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::recordHistorySample(void)
+{
+	HistorySample sample;
+
+	makeHistorySample(&sample);
+	history.append(sample);
+	stripChart->samplesAppended();
+
+	// binary log of every sample, plus any state transition
+	logAcquisitionRecord(sample, ACQ_RECORD_SAMPLE);
+
+	if (systemState != lastLoggedState)
+	{
+		logAcquisitionRecord(sample, ACQ_RECORD_TRANSITION);
+		lastLoggedState = systemState;
+
+		// notify remote subscribers
+		emit remote_event(EVENT_STATE, QVariantList() << (int)systemState);
+
+		if (systemState == SYSTEM_HOLDING)
+			emit remote_event(EVENT_TARGET, QVariantList() << xTarget << yTarget << zTarget);
+	}
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::logAcquisitionRecord(const HistorySample &sample, AcqLogRecordType type)
+{
+	if (!acquisitionLog.isOpen())
+		return;
+
+	AcqLogRecord record;
+
+	record.switches = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		record.field[i] = (float)sample.field[i];
+		record.current[i] = (float)sample.current[i];
+		record.target[i] = (float)sample.target[i];
+		record.state[i] = (quint8)sample.state[i];
+
+		if (sample.switchHeated[i])
+			record.switches |= (1 << i);
+	}
+
+	record.polarMagnitude = (float)sample.polarMagnitude;
+	record.polarAngle = (float)sample.polarAngle;
+	record.systemState = (quint8)systemState;
+
+	acquisitionLog.append(&record, type);
+}
+
+//---------------------------------------------------------------------------
+void MultiAxisOperation::quenchDetected(void)
+{
+	const QuenchEvent &event = quenchWatchdog->lastEvent();
+	const QString axisName[3] = { "X", "Y", "Z" };
+
+	magnetState = QUENCH;
+	systemState = SYSTEM_QUENCH;
+	statusState->setStyleSheet("color: red; font: bold;");
+	statusState->setText("QUENCH!");
+
+	// record the captured currents in the binary log
+	HistorySample sample;
+
+	makeHistorySample(&sample);
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (event.valid[i])
+			sample.current[i] = event.current[i];
+
+		if (event.quenched[i])
+			sample.state[i] = QUENCH;
+	}
+
+	logAcquisitionRecord(sample, ACQ_RECORD_QUENCH);
+
+	// refuse remote commands at once and notify subscribers
+	publishSnapshot();
+	emit remote_event(EVENT_QUENCH, QVariantList() << sample.current[0] << sample.current[1] << sample.current[2]);
+
+	if (switchInstalled)
+		ui.actionPersistentMode->setEnabled(false);
+
+	// abandon any supply/magnet current matching and release the interface
+	if (currentMatcher->isActive())
+	{
+		currentMatcher->stop();
+		ui.menuBar->setEnabled(true);
+		ui.mainTabWidget->setEnabled(true);
+		ui.mainToolBar->setEnabled(true);
+	}
+
+	// stop any autostep cycle
+	bool autostepping = autostepTimer->isActive();
+
+	if (autostepping)
+	{
+		stopAutostep();
+		lastTargetMsg.clear();
+		setStatusMsg("Auto-Stepping aborted due to quench detection");
+	}
+
+	if (autostepPolarTimer->isActive())
+	{
+		stopPolarAutostep();
+		lastTargetMsg.clear();
+		setStatusMsg("Polar Auto-Stepping aborted due to quench detection");
+	}
+
+	// mark vector as fail only in Vector Table
+	if (targetSource == VECTOR_TABLE)
+	{
+		if (presentVector >= 0)
+		{
+			vectorTable->setResult(presentVector, RESULT_FAIL);
+
+			// if needed, add columns for X/Y/Z quench currents
+			if (vectorTable->columnCount() < 8)
+				addQuenchColumns();
+
+			// add quench data captured by the watchdog
+			for (int i = 0; i < 3; i++)
+			{
+				if (event.quenched[i] && event.valid[i])
+					vectorTable->setValue(presentVector, 5 + i, event.current[i]);
+			}
+
+			if (autostepping)
+				resultsJournal.stepResult(presentVector, vectorTable);
+		}
+
+		doAutosaveReport();
+	}
+
+	// save quench data in log
+	QString msg = "Quench Detect!! " + event.timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz");
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (event.quenched[i])
+			msg += ": " + axisName[i] + "=" + QString::number(event.current[i], 'g', 3) + " A";
+		else if (event.valid[i])
+			msg += ": " + axisName[i] + " paused at " + QString::number(event.current[i], 'g', 3) + " A";
+	}
+
+	qDebug() << msg;
 }
 
 //---------------------------------------------------------------------------
@@ -2642,6 +2719,49 @@ void MultiAxisOperation::switchCoolingTimerTick(void)
 	}
 }
 
+//---------------------------------------------------------------------------
+// Magnet limits and the coordinate conversion the table validators check
+// rows against
+ValidationContext MultiAxisOperation::validationContext(TableValidator::TableKind kind)
+{
+	ValidationContext context;
+	AxesParams *axes[3] = { magnetParams->GetXAxisParams(), magnetParams->GetYAxisParams(), magnetParams->GetZAxisParams() };
+
+	for (int i = 0; i < 3; i++)
+	{
+		context.axes[i].activate = axes[i]->activate;
+		context.axes[i].coilConst = axes[i]->coilConst;
+		context.axes[i].currentLimit = axes[i]->currentLimit;
+		context.axes[i].maxRampRate = axes[i]->maxRampRate;
+	}
+
+	context.magnitudeLimit = magnetParams->getMagnitudeLimit();
+
+	if (kind == TableValidator::VECTOR_ROWS)
+	{
+		context.cartesian = (loadedCoordinates == CARTESIAN_COORDINATES);
+	}
+	else
+	{
+		context.normal = crossResult;
+		context.reference = referenceQuaternion;
+	}
+
+	return context;
+}
+
+//---------------------------------------------------------------------------
+// Revalidates in the background whatever depends on a changed limit,
+// unit or coordinate system
+void MultiAxisOperation::updateTableValidation(void)
+{
+	if (magnetParams)
+	{
+		vectorValidator->setContext(validationContext(TableValidator::VECTOR_ROWS));
+		polarValidator->setContext(validationContext(TableValidator::POLAR_ROWS));
+	}
+}
+
 //---------------------------------------------------------------------------
 VectorError MultiAxisOperation::checkNextVector(double x, double y, double z, QString label)
 {
@@ -2941,8 +3061,22 @@ void MultiAxisOperation::actionPersistentMode(void)
 		}
 		else
 		{
-			// first, check all active axes for magnet and supply current match
-			supplyCurrentMismatch = checkForSupplyMagnetCurrentMismatch(false);
+			// first, check all active axes for magnet and supply current match,
+			// any mismatched axes are ramped to the present magnet current
+			HistorySample sample;
+
+			makeHistorySample(&sample);
+			MatchStart match = currentMatcher->start(xProcess, yProcess, zProcess, magnetParams, sample);
+
+			if (match == MATCH_FAILED)
+			{
+				// remain in persistent mode, the interface was never locked
+				ui.actionPersistentMode->setChecked(true);
+				showErrorString(currentMatcher->errorString());
+				return;
+			}
+
+			supplyCurrentMismatch = (match == MATCH_STARTED);
 
 			// exit persistent mode, heat switch(es) when supplyCurrentMismatch clears
 			if (!supplyCurrentMismatch)
@@ -2956,17 +3090,12 @@ void MultiAxisOperation::actionPersistentMode(void)
 			}
 			else
 			{
-				// we have to match current to the last known magnet field
+				// we have to match current to the present magnet current
 				// it could be any value, therefore we can't mark a table row as passed
 				remainingTime = 0;	// clear any prior target ramp time
 				targetSource = NO_SOURCE;	// clear any prior table source
 
-				// clear target sent flags
-				for (int i = 0; i < 3; i++)
-					magnetCurrentTargetSent[i] = false;
-
-				matchMagnetCurrentTimer->start();
-				setStatusMsg("Matching supply and last known magnet currents, please wait...");
+				setStatusMsg("Matching supply and magnet currents, please wait...");
 			}
 
 			ui.menuBar->setEnabled(false);
@@ -2977,246 +3106,29 @@ void MultiAxisOperation::actionPersistentMode(void)
 }
 
 //---------------------------------------------------------------------------
-void MultiAxisOperation::matchMagnetCurrentTimerTick(void)
+void MultiAxisOperation::currentMatchComplete(void)
 {
-	//check all active axes for magnet and supply current match
-	supplyCurrentMismatch = checkForSupplyMagnetCurrentMismatch(true);
+	// all active axes now have matched supply and magnet currents
+	supplyCurrentMismatch = false;
 
-	if (!supplyCurrentMismatch)
-	{
-		matchMagnetCurrentTimer->stop();
-		switchControl(true);	// turn on heater
+	switchControl(true);	// turn on heater
 
-		systemState = SYSTEM_HEATING;
-		setStatusMsg("Heating switches, please wait...");
-		elapsedHeatingTicks = 0;
-		switchHeatingTimer->start();
-	}
+	systemState = SYSTEM_HEATING;
+	setStatusMsg("Heating switches, please wait...");
+	elapsedHeatingTicks = 0;
+	switchHeatingTimer->start();
 }
 
 //---------------------------------------------------------------------------
-bool MultiAxisOperation::checkForSupplyMagnetCurrentMismatch(bool forceMatch)
+void MultiAxisOperation::currentMatchAborted(QString reason)
 {
-	bool xMismatch = true;
-	bool yMismatch = true;
-	bool zMismatch = true;
-
-	if (magnetParams->GetXAxisParams()->activate && magnetParams->GetXAxisParams()->switchInstalled)
-	{
-		if (xProcess)
-		{
-			if (xProcess->isActive())
-			{
-				if (!xProcess->getPSwitchHeaterState())
-				{
-					bool ok;
-
-					// check for supply current mismatch
-					double magnetCurrent = xProcess->getMagnetCurrent(&ok);
-					double supplyCurrent = xProcess->getSupplyCurrent(&ok);
-
-					if (ok)
-					{
-						// if mismatch larger than 0.1%, then set and ramp 430 to magnet current
-						if (((fabs(magnetCurrent - supplyCurrent) / magnetCurrent) > 0.001) && !magnetCurrentTargetSent[0])
-						{
-							if (forceMatch)
-							{
-								// set target current to last known magnet current
-								xProcess->setTargetCurr(magnetParams->GetXAxisParams(), magnetCurrent, false);
-								magnetCurrentTargetSent[0] = true;
-
-								State state = xProcess->getState();
-								if (state != HOLDING)
-								{
-									xProcess->sendRamp();	// start ramping to target
-									xMismatch = true;
-								}
-								else
-									xMismatch = false;	 // we are HOLDING and target is set to magnet current
-							}
-							else
-								xMismatch = true;
-						}
-						else
-						{
-							if (systemState == SYSTEM_HOLDING)
-								xMismatch = false;	// close enough to exit persistent mode!
-							else
-							{
-								State state = xProcess->getState();
-
-								if (forceMatch && (state == PAUSED || state == AT_ZERO))
-									xProcess->sendRamp();	// start ramping to target
-								else if (forceMatch && state == HOLDING)
-									xMismatch = false;	// reached matching current
-							}
-						}
-					}
-				}
-				else
-				{
-					xMismatch = false;	// switch is heated so there can be no mismatch!
-                    //State state = xProcess->getState();
-
-                    //if (state == PAUSED || state == AT_ZERO)
-                    //	xProcess->sendRamp();	// ramp it to HOLDING state
-				}
-			}
-			else
-				xMismatch = false; // axes not active
-		}
-		else
-			xMismatch = false; // axes not active
-	}
-	else
-		xMismatch = false; // axis not active or has no switch
-
-
-	if (magnetParams->GetYAxisParams()->activate && magnetParams->GetYAxisParams()->switchInstalled)
-	{
-		if (yProcess)
-		{
-			if (yProcess->isActive())
-			{
-				if (!yProcess->getPSwitchHeaterState())
-				{
-					bool ok;
-
-					// check for supply current mismatch
-					double magnetCurrent = yProcess->getMagnetCurrent(&ok);
-					double supplyCurrent = yProcess->getSupplyCurrent(&ok);
-
-					if (ok)
-					{
-						// if mismatch larger than 0.1%, then set and ramp 430 to magnet current
-						if (((fabs(magnetCurrent - supplyCurrent) / magnetCurrent) > 0.001) && !magnetCurrentTargetSent[1])
-						{
-							if (forceMatch)
-							{
-								// set target current to last known magnet current
-								yProcess->setTargetCurr(magnetParams->GetYAxisParams(), magnetCurrent, false);
-								magnetCurrentTargetSent[1] = true;
-
-								State state = yProcess->getState();
-								if (state != HOLDING)
-								{
-									yProcess->sendRamp();	// start ramping to target
-									yMismatch = true;
-								}
-								else
-									yMismatch = false;	 // we are HOLDING and target is set to magnet current
-							}
-							else
-								yMismatch = true;
-						}
-						else
-						{
-							if (systemState == SYSTEM_HOLDING)
-								yMismatch = false;	// close enough to exit persistent mode!
-							else
-							{
-								State state = yProcess->getState();
-
-								if (forceMatch && (state == PAUSED || state == AT_ZERO))
-									yProcess->sendRamp();	// start ramping to target
-								else if (forceMatch && state == HOLDING)
-									yMismatch = false;	// reached matching current
-							}
-						}
-					}
-				}
-				else
-				{
-					yMismatch = false;	// switch is heated so there can be no mismatch!
-                    //State state = yProcess->getState();
-
-                    //if (state == PAUSED || state == AT_ZERO)
-                    //	yProcess->sendRamp();	// ramp it to HOLDING state
-				}
-			}
-			else
-				yMismatch = false; // axes not active
-		}
-		else
-			yMismatch = false; // axes not active
-	}
-	else
-		yMismatch = false; // axis not active or has no switch
-
-
-	if (magnetParams->GetZAxisParams()->activate && magnetParams->GetZAxisParams()->switchInstalled)
-	{
-		if (zProcess)
-		{
-			if (zProcess->isActive())
-			{
-				if (!zProcess->getPSwitchHeaterState())
-				{
-					bool ok;
-
-					// check for supply current mismatch
-					double magnetCurrent = zProcess->getMagnetCurrent(&ok);
-					double supplyCurrent = zProcess->getSupplyCurrent(&ok);
-
-					if (ok)
-					{
-						// if mismatch larger than 0.1%, then set and ramp 430 to magnet current
-						if (((fabs(magnetCurrent - supplyCurrent) / magnetCurrent) > 0.001) && !magnetCurrentTargetSent[2])
-						{
-							if (forceMatch)
-							{
-								// set target current to last known magnet current
-								zProcess->setTargetCurr(magnetParams->GetZAxisParams(), magnetCurrent, false);
-								magnetCurrentTargetSent[2] = true;
-
-								State state = zProcess->getState();
-								if (state != HOLDING)
-								{
-									zProcess->sendRamp();	// start ramping to target
-									zMismatch = true;
-								}
-								else
-									zMismatch = false;	 // we are HOLDING and target is set to magnet current
-							}
-							else
-								zMismatch = true;
-						}
-						else
-						{
-							if (systemState == SYSTEM_HOLDING)
-								zMismatch = false;	// close enough to exit persistent mode!
-							else
-							{
-								State state = zProcess->getState();
-
-								if (forceMatch && (state == PAUSED || state == AT_ZERO))
-									zProcess->sendRamp();	// start ramping to target
-                                else if (forceMatch && state == HOLDING)
-                                    zMismatch = false;	// reached matching current
-							}
-						}
-					}
-				}
-				else
-				{
-					zMismatch = false;	// switch is heated so there can be no mismatch!
-                    //State state = zProcess->getState();
-
-                    //if (state == PAUSED || state == AT_ZERO)
-                    //	zProcess->sendRamp();	// ramp it to HOLDING state
-				}
-			}
-			else
-				zMismatch = false; // axes not active
-		}
-		else
-			zMismatch = false; // axes not active
-	}
-	else
-		zMismatch = false; // axis not active or has no switch
+	// remain in persistent mode and release the interface
+	ui.actionPersistentMode->setChecked(true);
+	ui.menuBar->setEnabled(true);
+	ui.mainTabWidget->setEnabled(true);
+	ui.mainToolBar->setEnabled(true);
 
-	return (xMismatch || yMismatch || zMismatch);
+	showErrorString(reason);
 }
 
 //---------------------------------------------------------------------------
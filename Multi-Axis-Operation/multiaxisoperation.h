@@ -4,10 +4,24 @@
 #include <QVector3D>
 #include <QQuaternion>
 #include <QSettings>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSet>
 #include "ui_multiaxisoperation.h"
 #include "magnetparams.h"
 #include "processmanager.h"
+#include "currentmatcher.h"
+#include "quenchwatchdog.h"
+#include "samplehistory.h"
+#include "acquisitionlog.h"
+#include "stripchart.h"
 #include "optionsdialog.h"
+#include "latencydialog.h"
+#include "tableloader.h"
+#include "tablewriter.h"
+#include "reportwriter.h"
+#include "resultsjournal.h"
+#include "tablevalidator.h"
 #include <atomic>
 
 //---------------------------------------------------------------------------
@@ -38,22 +52,6 @@ enum SystemState
 	SYSTEM_COOLING
 };
 
-enum VectorError
-{
-	NO_VECTOR_ERROR = 0,		// no error
-
-	NON_NUMERICAL_ENTRY,		// non-numerical parameter
-	EXCEEDS_MAGNITUDE_LIMIT,	// vector magnitude exceeds magnet limit
-	NEGATIVE_MAGNITUDE,			// magnitude cannot be negative
-	INCLINATION_OUT_OF_RANGE,	// inclination angle must be >=0 and <= 180
-	EXCEEDS_X_RANGE,			// vector exceeds x-axis current limit
-	INACTIVE_X_AXIS,			// vector requires x-axis field component which is inactive
-	EXCEEDS_Y_RANGE,			// vector exceeds y-axis current limit
-	INACTIVE_Y_AXIS,			// vector requires y-axis field component which is inactive
-	EXCEEDS_Z_RANGE,			// vector exceeds z-axis current limit
-	INACTIVE_Z_AXIS				// vector requires z-axis field component which is inactive
-};
-
 enum TargetSource
 {
 	NO_SOURCE = 0,
@@ -62,6 +60,103 @@ enum TargetSource
 	POLAR_TABLE
 };
 
+//---------------------------------------------------------------------------
+// State published for the remote interface from the GUI thread, so every
+// command in a command line sees the same values
+//---------------------------------------------------------------------------
+struct RemoteSnapshot
+{
+	quint64 sequence;			// increments on each publish
+	qint64 timestamp;			// msec since epoch
+	bool connected;
+	bool persistent;
+	bool switchInstalled;
+	int state;					// SystemState
+	int fieldUnits;				// FieldUnits
+	int remainingTime;			// sec
+	double field[3];			// x, y, z
+	double fieldSpherical[3];	// magnitude, azimuth, inclination
+	double target[3];
+	double targetSpherical[3];
+	double align1[3];			// magnitude, azimuth, inclination
+	double align2[3];
+	double plane[3];
+	int tableCoordinates;		// CoordinatesSelection of the vector table
+	bool autostepActive;		// vector or polar table auto-step running
+	bool vectorLoading;			// a vector table file is loading
+	bool polarLoading;			// a polar table file is loading
+	int stepRow;				// last row completed by auto-step, 1-based
+	int pendingActions;			// remote target actions waiting for a measurement
+	bool appRunning;			// app started by execute_app() has not exited
+	int appExitCode;			// of the last app started by execute_app(), -1 if it did not run
+	quint64 syncToken;			// last remote_sync() processed
+};
+
+//---------------------------------------------------------------------------
+// Copy of a vector or polar table for a remote dump, taken on the GUI
+// thread and formatted row by row as the session writes it
+//---------------------------------------------------------------------------
+struct RemoteTableDump
+{
+	int table = VECTOR_TABLE;	// TargetSource
+	int coordinates = 0;		// CoordinatesSelection of a vector table
+	TableContents contents;		// shared with the model until it is next edited
+	QVector<bool> checks;		// persistence of each row, all false without a switch
+};
+
+//---------------------------------------------------------------------------
+// Outcome of a remote CONF:TARG:VEC:TAB or CONF:TARG:POL:TAB, the row is
+// checked on the GUI thread since only it may read the table models
+//---------------------------------------------------------------------------
+struct RemoteRowCheck
+{
+	bool loading = false;		// the table is being replaced by a file load
+	bool inRange = false;
+	VectorError error = NO_VECTOR_ERROR;	// of the row, if in range
+};
+
+//---------------------------------------------------------------------------
+// Batch of acquisition history samples for a remote HISTORY? query, copied
+// on the GUI thread a batch at a time as the session writes the rows
+//---------------------------------------------------------------------------
+struct RemoteHistoryRow
+{
+	qint64 time;				// msec since the history started
+	float field[3];
+	float magnitude;
+	float current[3];
+};
+
+struct RemoteHistoryBatch
+{
+	int total = 0;				// samples from the start of the batch to the end of the range
+	int units = TESLA;			// FieldUnits of the history
+	qint64 start = 0;			// msec since the epoch when the history started
+	QVector<RemoteHistoryRow> rows;
+};
+
+// asynchronous events for remote subscribers
+enum RemoteEvent
+{
+	EVENT_STATE = 0x01,			// systemState changed
+	EVENT_TARGET = 0x02,		// HOLDING reached at the target
+	EVENT_STEP = 0x04,			// table auto-step completed a row
+	EVENT_QUENCH = 0x08,		// quench detected
+	EVENT_ACTION = 0x10,		// remote target action executed or cancelled
+	EVENT_SEQUENCE = 0x20		// sequence script started, completed or failed
+};
+
+// remote target actions that wait for the first measurement after connecting
+enum RemoteAction
+{
+	ACTION_VECTOR = 0,			// go to a vector table row
+	ACTION_POLAR,				// go to a polar table row
+	ACTION_ALIGN1,				// make alignment vector 1 the target
+	ACTION_ALIGN2				// make alignment vector 2 the target
+};
+
+
+class Parser;
 
 //---------------------------------------------------------------------------
 // MultiAxisOperation Class Header
@@ -78,6 +173,7 @@ public:
 	void polarToCartesian(double magnitude, double angle, QVector3D *conversion);
 	void altPolarToCartesian(double magnitude, double angle, QVector3D* conversion);
 	void cartesianToPolar(double x, double y, double z);
+	const SampleHistory &sampleHistory(void) const { return history; }
 
 	// accessors for parser
 	bool isConnected(void) { return connected; }
@@ -96,10 +192,18 @@ public:
 	void get_field_cartesian(double *x, double *y, double *z);
 	void get_plane(double *x, double *y, double *z);
 	VectorError check_vector(double x, double y, double z);
-	bool vec_table_row_in_range(int tableRow);
-	VectorError check_vector_table(int tableRow);
-	bool polar_table_row_in_range(int tableRow);
-	VectorError check_polar_table(int tableRow);
+	void get_snapshot(RemoteSnapshot *snapshot);
+	void attachParser(Parser *session);
+	bool wait_snapshot(RemoteSnapshot *snapshot, unsigned long msec);
+	bool take_table_dump(quint64 token, RemoteTableDump *dump);
+	void discard_table_dump(quint64 token);
+	bool take_history_batch(quint64 token, RemoteHistoryBatch *batch);
+	void discard_history_batch(quint64 token);
+	bool take_row_check(quint64 token, RemoteRowCheck *check);
+	void discard_row_check(quint64 token);
+
+signals:
+	void remote_event(int event, QVariantList fields);
 
 private slots:
 	void actionConnect(void);
@@ -110,6 +214,7 @@ private slots:
 	void closeConnection(void);
 	void actionAbout(void);
 	void actionHelp(void);
+	void actionLatencyStatistics(void);
 	void actionDefine(void);
 	void actionShow_Cartesian_Coordinates(void);
 	void actionShow_Spherical_Coordinates(void);
@@ -134,27 +239,33 @@ private slots:
 	void dataTimerTick(void);
 	void switchHeatingTimerTick(void);
 	void switchCoolingTimerTick(void);
-	void matchMagnetCurrentTimerTick(void);
+	void currentMatchComplete(void);
+	void currentMatchAborted(QString reason);
+	void quenchDetected(void);
 	VectorError checkNextVector(double x, double y, double z, QString label);
 	void sendNextVector(double x, double y, double z);
 	int calculateRampingTime(double x, double y, double z, double _xField, double _yField, double _zField, double &xRampRate, double &yRampRate, double &zRampRate);
 
 	// vector table slots
 	void actionLoad_Vector_Table(void);
+	void vectorTableLoaded(void);
+	void tableLoadProgress(int percent);
+	void tableSaved(void);
 	void setTableHeader(void);
 	void actionSave_Vector_Table(void);
-	void vectorTableItemChanged(QTableWidgetItem *item);
+	void vectorTableDataChanged(void);
 	void vectorSelectionChanged(void);
 	void vectorTableAddRowAbove(void);
-	void initNewRow(int newRow);
 	void updatePresentVector(int row, bool removed);
 	void vectorTableAddRowBelow(void);
 	void vectorTableRemoveRow(void);
 	void vectorTableClear(void);
 	void setVectorTablePersistence(bool state);
+	void addQuenchColumns(void);
 	void vectorTableTogglePersistence(void);
 	void actionGenerate_Excel_Report(void);
-	void saveReport(QString reportFileName);
+	bool saveReport(QString reportFileName, bool fromJournal = false);
+	void reportSaved(void);
 	void goToSelectedVector(void);
 	void goToNextVector(void);
 	void goToVector(int vectorIndex, bool makeTarget);
@@ -204,14 +315,14 @@ private slots:
 	// polar table slots
 	void setNormalUnitVector(QVector3D *v1, QVector3D *v2);
 	void actionLoad_Polar_Table(void);
+	void polarTableLoaded(void);
 	void convertPolarFieldValues(FieldUnits newUnits);
 	void setPolarTableHeader(void);
 	void actionSave_Polar_Table(void);
-	void polarTableItemChanged(QTableWidgetItem *item);
+	void polarTableDataChanged(void);
 	void polarSelectionChanged(void);
 	void polarTableAddRowAbove(void);
 	void polarTableAddRowBelow(void);
-	void initNewPolarRow(int newRow);
 	void updatePresentPolar(int row, bool removed);
 	void polarTableRemoveRow(void);
 	void polarTableClear(void);
@@ -236,33 +347,56 @@ private slots:
 	void polarAppCheckBoxChanged(int state);
 	void polarPythonCheckBoxChanged(int state);
 
-	// parser actions
-	void system_connect(void);
-	void system_disconnect(void);
-	void exit_app(void);
-	void load_settings(FILE *file, bool *success);
-	void save_settings(FILE * file, bool * success);
-	void set_align1(double mag, double azimuth, double inclination);
-	void set_align1_active(void);
-	void set_align2(double mag, double azimuth, double inclination);
-	void set_align2_active(void);
-	void set_units(int value);
-	void set_vector(double mag, double az, double inc, int time);
-	void set_vector_cartesian(double x, double y, double z, int time);
-	void goto_vector(int tableRow);
-	void set_polar(double mag, double angle, int time);
-	void goto_polar(int tableRow);
-	void set_persistence(bool persistent);
+	// parser actions, sent is when the parser queued the action
+	void remote_ramp(qint64 sent);
+	void remote_pause(qint64 sent);
+	void remote_zero(qint64 sent);
+	void system_connect(qint64 sent);
+	void system_disconnect(qint64 sent);
+	void exit_app(qint64 sent);
+	void load_settings(FILE *file, bool *success, qint64 sent);
+	void save_settings(FILE * file, bool * success, qint64 sent);
+	void set_align1(double mag, double azimuth, double inclination, qint64 sent);
+	void set_align1_active(qint64 sent);
+	void set_align2(double mag, double azimuth, double inclination, qint64 sent);
+	void set_align2_active(qint64 sent);
+	void set_units(int value, qint64 sent);
+	void set_vector(double mag, double az, double inc, int time, qint64 sent);
+	void set_vector_cartesian(double x, double y, double z, int time, qint64 sent);
+	void goto_vector(int tableRow, quint64 token, qint64 sent);
+	void set_polar(double mag, double angle, int time, qint64 sent);
+	void goto_polar(int tableRow, quint64 token, qint64 sent);
+	void set_persistence(bool persistent, qint64 sent);
+	void remote_sync(quint64 token, qint64 sent);
+	void set_vector_table(QStringList rows, int coordinates, qint64 sent);
+	void set_polar_table(QStringList rows, qint64 sent);
+	void remote_table_dump(int table, quint64 token, qint64 sent);
+	void remote_history(qint64 from, qint64 to, quint64 token, qint64 sent);
+	void execute_app(int table, qint64 sent);
 
 private:
 	Ui::MultiAxisOperationClass ui;
 	OptionsDialog *optionsDialog;
+	LatencyDialog *latencyDialog;
+	TableModel *vectorTable;
+	TableModel *polarTable;
+	TableLoader *vectorLoader;
+	TableLoader *polarLoader;
+	TableWriter *vectorWriter;
+	TableWriter *polarWriter;
+	ReportWriter *reportWriter;
+	TableValidator *vectorValidator;
+	TableValidator *polarValidator;
+	bool convertVectorUnits;
+	bool convertPolarUnits;
 	QActionGroup *unitsGroup;
 	QActionGroup *sphericalConvention;
 	bool connected;	// are we connected?
 	SystemState systemState;
 	bool autosaveReport;
 	bool haveAutosavedReport;
+	bool autosavingReport;	// report being written is an autosave
+	bool autosavePending;	// autosave waiting for the report being written
 	bool simulation;	// use simulated system
 	bool useParser;		// if true, enable stdin/stdout parser
 	int remainingTime;	// time remaining for arrival at target
@@ -295,7 +429,50 @@ private:
 	int longestHeatingTime;
 	int elapsedHeatingTicks;
 	QTimer *switchHeatingTimer;
-	QTimer *matchMagnetCurrentTimer;
+	CurrentMatcher *currentMatcher;
+
+	// quench detection
+	QuenchWatchdog *quenchWatchdog;
+
+	// acquisition history
+	SampleHistory history;
+	AcquisitionLog acquisitionLog;
+	ResultsJournal resultsJournal;	// auto-step results, appended as each step completes
+	SystemState lastLoggedState;
+	StripChart *stripChart;
+	void makeHistorySample(HistorySample *sample);
+	void recordHistorySample(void);
+	void logAcquisitionRecord(const HistorySample &sample, AcqLogRecordType type);
+	void getReportData(ReportData *data);
+
+	// remote interface snapshot
+	QMutex snapshotMutex;
+	RemoteSnapshot remoteSnapshot;
+	QWaitCondition snapshotPublished;
+	int remoteStepRow;
+	bool remoteAppRunning;
+	int remoteAppExitCode;
+	quint64 remoteSyncToken;
+	QMap<quint64, RemoteTableDump> tableDumps;	// remote table dumps by token, not yet taken
+	QMap<quint64, RemoteHistoryBatch> historyBatches;	// remote history batches by token, not yet taken
+	QMap<quint64, RemoteRowCheck> rowChecks;	// remote table row targets by token, not yet taken
+	QSet<quint64> discardedDumps;	// tokens of dumps, batches and row checks given up on before they were made
+	struct PendingAction
+	{
+		RemoteAction action;
+		int row;				// table row for ACTION_VECTOR and ACTION_POLAR
+	};
+	QList<PendingAction> pendingActions;	// waiting for the first measurement
+	void runRemoteAction(RemoteAction action, int row);
+	void executeRemoteAction(const PendingAction &pending);
+	void completePendingActions(bool execute);
+	bool vec_table_row_in_range(int tableRow);
+	VectorError check_vector_table(int tableRow);
+	bool polar_table_row_in_range(int tableRow);
+	VectorError check_polar_table(int tableRow);
+	bool returnRowCheck(quint64 token, const RemoteRowCheck &check);
+	void publishSnapshot(void);
+	void autostepRowCompleted(const char *table, int row, bool last);
 
 	int longestCoolingTime;
 	int elapsedCoolingTicks;
@@ -318,7 +495,6 @@ private:
 	// switch heater states
 	bool switchHeaterState[3];
 	bool supplyCurrentMismatch;	// if true, one or more switches are cooled with supply current != magnet current
-	bool magnetCurrentTargetSent[3]; // if true, the present Target Setpoint is set to the last known magnet current
 
 	// magnet parameters dialog
 	MagnetParams *magnetParams;
@@ -382,7 +558,6 @@ private:
 	// rotation within alignment axis
 	QVector3D crossResult;	// normalized "normal" vector to sample alignment plane
 	QQuaternion referenceQuaternion;
-	QQuaternion rotationQuaternion;
 
 	// present polar state
 	double polarMagnitude;
@@ -416,7 +591,8 @@ private:
 	bool loadFromFile(FILE *pFile);	// returns true if success
 	bool saveToFile(FILE *pFile);	// returns true if success
 	void setStatusMsg(QString msg);
-	bool checkForSupplyMagnetCurrentMismatch(bool forceMatch);
+	ValidationContext validationContext(TableValidator::TableKind kind);
+	void updateTableValidation(void);
 
 	void restoreVectorTab(QSettings *settings);
 	void calculateAutostepRemainingTime(int startIndex, int endIndex);
@@ -61,6 +61,9 @@ void OptionsDialog::restoreSettings(void)
 		ui.autoModeDisableCheckBox->setChecked(true);
 	else
 		ui.autoModeDisableCheckBox->setChecked(false);
+
+	m_quenchWatchdogInterval = settings.value("Options/QuenchWatchdogInterval", 100).toInt();
+	ui.quenchWatchdogIntervalEdit->setText(QString::number(m_quenchWatchdogInterval));
 }
 
 //---------------------------------------------------------------------------
@@ -73,6 +76,7 @@ void OptionsDialog::saveSettings(void)
 	settings.setValue("Options/MagnetDAQLocation", m_magnetDAQLocation);
 	settings.setValue("Options/MagnetDAQMinimzed", m_magnetDAQMinimized);
 	settings.setValue("Options/DisableAutoStability", m_disableAutoStability);
+	settings.setValue("Options/QuenchWatchdogInterval", m_quenchWatchdogInterval);
 }
 
 //---------------------------------------------------------------------------
@@ -115,6 +119,17 @@ bool OptionsDialog::readSettingsFromDialog(void)
 	// read AUTO Stability Mode override
 	m_disableAutoStability = ui.autoModeDisableCheckBox->isChecked();
 
+	// check quench watchdog interval
+	checkValue = ui.quenchWatchdogIntervalEdit->text().toInt(&ok);
+	if (ok && checkValue >= 20 && checkValue <= 1000)
+		m_quenchWatchdogInterval = checkValue;
+	else
+	{
+		showError("Invalid Quench Watchdog Interval value, please check.");	// error
+		ui.quenchWatchdogIntervalEdit->setFocus();
+		return false;
+	}
+
 	saveSettings();
 
 	return true;	// all settings good!
@@ -17,6 +17,7 @@ public:
 	QString magnetDAQLocation(void) { return m_magnetDAQLocation; }
 	bool magnetDAQMinimized(void) { return m_magnetDAQMinimized; }
 	bool disableAutoStability(void) { return m_disableAutoStability; }
+	int quenchWatchdogInterval(void) { return m_quenchWatchdogInterval; }
 
 signals:
 	void configChanged(void);
@@ -34,6 +35,7 @@ private:
 	QString m_magnetDAQLocation;	// location of Magnet-DAQ app bundle or executable
 	bool m_magnetDAQMinimized;		// if true, launch Magnet-DAQ instances in minimized (shrunk to taskbar icon) state
 	bool m_disableAutoStability;	// if true, any manual Stability Setting is preserved for all connected Model 430's
+	int m_quenchWatchdogInterval;	// quench watchdog axis state polling interval in msec
 
 	void restoreSettings(void);
 	void saveSettings(void);
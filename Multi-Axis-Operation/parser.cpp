@@ -2,6 +2,10 @@
 #include "parser.h"
 #include <iostream>
 #include "conversions.h"
+#include "commandtree.h"
+#include "sequencer.h"
+#include "latencystats.h"
+#include <QDeadlineTimer>
 
 #if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
 #include <sys/time.h>
@@ -11,11 +15,44 @@
 #include <fcntl.h>
 #endif
 
-#define DELIMITER	":"		// colon
-#define SEPARATOR ": \t"	// colon, space, or tab
 #define SPACE " \t"			// space or tab
 #define COMMA ","			// comma
-#define EOL "\r\n"			// end of line
+#define LIST ", \t"			// comma, space, or tab
+
+const int MAX_TABLE_ROWS = 100000;		// rows in one table upload
+const int TABLE_DUMP_TIMEOUT = 10000;	// msec for the GUI to copy a table
+const int SYNC_TIMEOUT = 10000;			// msec for the GUI to execute queued commands
+const int HISTORY_TIMEOUT = 10000;		// msec for the GUI to copy a batch of history
+const int HISTORY_PRECISION = 7;		// significant digits of history values (floats)
+const int HISTORY_FIELDS = 8;			// fields in a HISTory? row
+const int ROW_CHUNK_BYTES = 65536;		// dump rows written between output flushes
+const int MAX_QUEUED_EVENTS = 256;		// events pending for the session thread
+const int INPUT_POLL_MSEC = 50;			// event delivery latency while stdin is idle
+
+//---------------------------------------------------------------------------
+// Subscription event names
+//---------------------------------------------------------------------------
+struct EventName
+{
+	RemoteEvent event;
+	const char *name;
+};
+
+const EventName eventNames[] =
+{
+	{ EVENT_STATE, "STATE" },
+	{ EVENT_TARGET, "TARGET" },
+	{ EVENT_STEP, "STEP" },
+	{ EVENT_QUENCH, "QUENCH" },
+	{ EVENT_ACTION, "ACTION" },
+	{ EVENT_SEQUENCE, "SEQUENCE" }
+};
+
+const int NUM_EVENT_NAMES = sizeof(eventNames) / sizeof(eventNames[0]);
+
+std::atomic<quint64> Parser::syncTokens(0);
+QMutex Parser::commandMutex;
+std::atomic<quint64> Parser::switchCommands(0);
 
 /************************************************************
 	This file is designed to support using this app as a
@@ -35,52 +72,6 @@
 	allow this type of interprocess communication.
 ************************************************************/
 
-//---------------------------------------------------------------------------
-// Command and query parsing tokens
-//---------------------------------------------------------------------------
-const char _SYST[] = "SYST";
-const char _SYSTEM[] = "SYSTEM";
-const char _ERR[] = "ERR";
-const char _ERROR[] = "ERROR";
-const char _EXIT[] = "EXIT";
-const char _COUN[] = "COUN";
-const char _COUNT[] = "COUNT";
-const char _CONN[] = "CONN";
-const char _CONNECT[] = "CONNECT";
-const char _DISC[] = "DISC";
-const char _DISCONNECT[] = "DISCONNECT";
-const char _CONFIGURE[] = "CONFIGURE";
-const char _CONF[] = "CONF";
-const char _IDN[] = "*IDN";
-const char _CLS[] = "*CLS";
-const char _PAUSE[] = "PAUSE";
-const char _RAMP[] = "RAMP";
-const char _UNITS[] = "UNITS";
-const char _FIELD[] = "FIELD";
-const char _STATE[] = "STATE";
-const char _ZERO[] = "ZERO";
-const char _LOAD[] = "LOAD";
-const char _SAVE[] = "SAVE";
-const char _SET[] = "SET";
-const char _SETTINGS[] = "SETTINGS";
-const char _ALIGN1[] = "ALIGN1";
-const char _ALIGN2[] = "ALIGN2";
-const char _CART[] = "CART";
-const char _CARTESIAN[] = "CARTESIAN";
-const char _TARG[] = "TARG";
-const char _TARGET[] = "TARGET";
-const char _PLANE[] = "PLANE";
-const char _VEC[] = "VEC";
-const char _VECTOR[] = "VECTOR";
-const char _TAB[] = "TAB";
-const char _TABLE[] = "TABLE";
-const char _POL[] = "POL";
-const char _POLAR[] = "POLAR";
-const char _TIME[] = "TIME";
-const char _PERS[] = "PERS";
-const char _PERSISTENT[] = "PERSISTENT";
-
-
 //---------------------------------------------------------------------------
 // Incoming data type tests and conversions
 //---------------------------------------------------------------------------
@@ -218,6 +209,22 @@ bool isValue(const char* buf)
 	return true;	// all tests satisfied, valid number
 }
 
+//---------------------------------------------------------------------------
+// Tests the first field of a comma, space or tab separated line
+bool startsWithValue(const char *str)
+{
+	char field[64];
+	size_t length = strcspn(str, LIST);
+
+	if (length == 0 || length >= sizeof(field))
+		return false;
+
+	memcpy(field, str, length);
+	field[length] = '\0';
+
+	return isValue(field);
+}
+
 
 //---------------------------------------------------------------------------
 // Class methods
@@ -227,13 +234,18 @@ Parser::Parser(QObject *parent)
 {
 	stopProcessing = false;
 	source = NULL;
+	subscriptions.store(0);
+	outputFormat.store(FORMAT_TEXT);
+	recordSequence = 0;
+	droppedEvents = 0;
+	switchCommandsSeen = 0;
 }
 
 //---------------------------------------------------------------------------
 Parser::~Parser()
 {
 	stopProcessing = true;
-	qDebug("Multi-Axis Operation stdin Parser End");
+	qDebug("Multi-Axis Operation Parser End");
 }
 
 
@@ -252,8 +264,7 @@ void Parser::process(void)
 
 		// allocate resources and start parsing
 		qDebug("Multi-Axis Operation stdin Parser Start");
-		char input[1024];
-		char output[1024];
+		std::string input;
 
 #if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
         fd_set read_fds;
@@ -262,8 +273,8 @@ void Parser::process(void)
 
 		while (!stopProcessing)
 		{
-			input[0] = '\0';
-			output[0] = '\0';
+			input.clear();
+			flushOutput();	// events queued since the last line
 
 #if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
 			//we want to receive data from stdin so add these file
@@ -273,7 +284,12 @@ void Parser::process(void)
 			FD_ZERO(&read_fds);
             FD_SET(sfd, &read_fds);
 
-            result = select(sfd + 1, &read_fds, nullptr, nullptr, nullptr);
+			// wake periodically so events are written while stdin is idle
+			struct timeval timeout = { 0, INPUT_POLL_MSEC * 1000 };
+            result = select(sfd + 1, &read_fds, nullptr, nullptr, &timeout);
+
+			if (result == 0)
+				continue;
 
 			if (result == -1 && errno != EINTR)
 			{
@@ -291,27 +307,27 @@ void Parser::process(void)
 			{
 				if (FD_ISSET(STDIN_FILENO, &read_fds))
 				{
-					std::cin.getline(input, sizeof(input));
+					std::getline(std::cin, input);
 				}
 			}
 #else
-			std::cin.getline(input, sizeof(input));
+			std::getline(std::cin, input);
 
 			// skip any NULL input
-			if (input[0] == NULL)
+			if (input.empty())
 			{
 				Sleep(10);	// throttle checks of NULL input
 				continue;
 			}
 
-			struprt(input);	// convert to all uppercase because filenames are not case sensitive on Windows
+			struprt(&input[0]);	// convert to all uppercase because filenames are not case sensitive on Windows
 #endif
 
 			// save original string
-			inputStr = QString(input);
+			inputStr = QString::fromStdString(input);
 
 			// parse stdin
-			parseInput(input, output);
+			parseLine(&input[0]);
 		}
 	}
 
@@ -319,1563 +335,2608 @@ void Parser::process(void)
 }
 
 //---------------------------------------------------------------------------
-void Parser::addToErrorQueue(SystemError error)
+// Message of an error code, as reported by SYSTem:ERRor?
+//---------------------------------------------------------------------------
+const char *Parser::errorText(SystemError error)
 {
-	QString errMsg;
-
 	switch (error)
 	{
 	case ERR_UNRECOGNIZED_COMMAND:
-		errMsg = QString::number((int)ERR_UNRECOGNIZED_COMMAND) + ",\"Unrecognized command\"";
-		break;
+		return "Unrecognized command";
 
 	case ERR_INVALID_ARGUMENT:
-		errMsg = QString::number((int)ERR_INVALID_ARGUMENT) + ",\"Invalid argument\"";
-		break;
+		return "Invalid argument";
 
 	case ERR_NON_BOOLEAN_ARGUMENT:
-		errMsg = QString::number((int)ERR_NON_BOOLEAN_ARGUMENT) + ",\"Non-boolean argument\"";
-		break;
+		return "Non-boolean argument";
 
 	case ERR_MISSING_PARAMETER:
-		errMsg = QString::number((int)ERR_MISSING_PARAMETER) + ",\"Missing parameter\"";
-		break;
+		return "Missing parameter";
 
 	case ERR_OUT_OF_RANGE:
-		errMsg = QString::number((int)ERR_OUT_OF_RANGE) + ",\"Value out of range\"";
-		break;
+		return "Value out of range";
 
 	case ERR_NON_NUMERICAL_ENTRY:
-		errMsg = QString::number((int)ERR_NON_NUMERICAL_ENTRY) + ",\"Non-numerical entry\"";
-		break;
+		return "Non-numerical entry";
 
 	case ERR_EXCEEDS_MAGNITUDE_LIMIT:
-		errMsg = QString::number((int)ERR_EXCEEDS_MAGNITUDE_LIMIT) + ",\"Magnitude exceeds limit\"";
-		break;
+		return "Magnitude exceeds limit";
 
 	case ERR_NEGATIVE_MAGNITUDE:
-		errMsg = QString::number((int)ERR_NEGATIVE_MAGNITUDE) + ",\"Negative magnitude\"";
-		break;
+		return "Negative magnitude";
 
 	case ERR_INCLINATION_OUT_OF_RANGE:
-		errMsg = QString::number((int)ERR_INCLINATION_OUT_OF_RANGE) + ",\"Inclination out of range\"";
-		break;
+		return "Inclination out of range";
 
 	case ERR_EXCEEDS_X_RANGE:
-		errMsg = QString::number((int)ERR_EXCEEDS_X_RANGE) + ",\"Field exceeds x-coil limit\"";
-		break;
+		return "Field exceeds x-coil limit";
 
 	case ERR_INACTIVE_X_AXIS:
-		errMsg = QString::number((int)ERR_INACTIVE_X_AXIS) + ",\"Field requires x-coil\"";
-		break;
+		return "Field requires x-coil";
 
 	case ERR_EXCEEDS_Y_RANGE:
-		errMsg = QString::number((int)ERR_EXCEEDS_Y_RANGE) + ",\"Field exceeds y-coil limit\"";
-		break;
+		return "Field exceeds y-coil limit";
 
 	case ERR_INACTIVE_Y_AXIS:
-		errMsg = QString::number((int)ERR_INACTIVE_Y_AXIS) + ",\"Field requires y-coil\"";
-		break;
+		return "Field requires y-coil";
 
 	case ERR_EXCEEDS_Z_RANGE:
-		errMsg = QString::number((int)ERR_EXCEEDS_Z_RANGE) + ",\"Field exceeds z-coil limit\"";
-		break;
+		return "Field exceeds z-coil limit";
 
 	case ERR_INACTIVE_Z_AXIS:
-		errMsg = QString::number((int)ERR_INACTIVE_Z_AXIS) + ",\"Field requires z-coil\"";
-		break;
+		return "Field requires z-coil";
 
 	case ERR_UNRECOGNIZED_QUERY:
-		errMsg = QString::number((int)ERR_UNRECOGNIZED_QUERY) + ",\"Unrecognized query\"";
-		break;
+		return "Unrecognized query";
 
 	case ERR_NOT_CONNECTED:
-		errMsg = QString::number((int)ERR_NOT_CONNECTED) + ",\"Not connected\"";
-		break;
+		return "Not connected";
 
 	case ERR_SWITCH_TRANSITION:
-		errMsg = QString::number((int)ERR_SWITCH_TRANSITION) + ",\"Switch in transition\"";
-		break;
+		return "Switch in transition";
 
 	case ERR_QUENCH_CONDITION:
-		errMsg = QString::number((int)ERR_QUENCH_CONDITION) + ",\"Quench condition\"";
-		break;
+		return "Quench condition";
 
 	case ERR_NO_UNITS_CHANGE:
-		errMsg = QString::number((int)ERR_NO_UNITS_CHANGE) + ",\"No units change while connected\"";
-		break;
+		return "No units change while connected";
 
 	case ERR_NO_PERSISTENCE:
-		errMsg = QString::number((int)ERR_NO_PERSISTENCE) + ",\"Cannot enter persistence\"";
-		break;
+		return "Cannot enter persistence";
 
 	case ERR_IS_PERSISTENT:
-		errMsg = QString::number((int)ERR_IS_PERSISTENT) + ",\"System is persistent\"";
-		break;
+		return "System is persistent";
 
 	case ERR_NO_SWITCH:
-		errMsg = QString::number((int)ERR_NO_SWITCH) + ",\"No switch installed\"";
-		break;
+		return "No switch installed";
 
 	case ERR_CANNOT_LOAD:
-		errMsg = QString::number((int)ERR_CANNOT_LOAD) + ",\"Cannot LOAD while connected\"";
-		break;
+		return "Cannot LOAD while connected";
+
+	case ERR_TABLE_BUSY:
+		return "Table in use by auto-step or loading";
+
+	case ERR_SEQUENCE_SYNTAX:
+		return "Sequence syntax error";
+
+	case ERR_SEQUENCE_BUSY:
+		return "Sequence is running";
+
+	case ERR_SEQUENCE_WAIT:
+		return "Sequence WAIT not met";
+
+	case ERR_APP_FAILED:
+		return "App/script did not run or failed";
+
+	case ERR_TABLE_TIMEOUT:
+		return "Timed out copying table";
+
+	case ERR_HISTORY_TIMEOUT:
+		return "Timed out copying history";
+
+	case ERR_HISTORY_INCOMPLETE:
+		return "History samples lost while copying";
+
+	case ERR_ROW_CHECK_TIMEOUT:
+		return "Timed out checking table row";
 
 	default:
-		errMsg = QString::number((int)error) + ",\"Error\"";
-		break;
+		return "Error";
 	}
+}
 
-	if (!errMsg.isEmpty())
-	{
-		errorStack.push(errMsg);
-		emit error_msg(errMsg);
+//---------------------------------------------------------------------------
+void Parser::addToErrorQueue(SystemError error)
+{
+	errorStack.push(error);
+	emit error_msg(QString::number((int)error) + ",\"" + errorText(error) + "\"");
 
 #if defined(Q_OS_WIN)
-		Beep(1000, 600);
+	Beep(1000, 600);
 #else
-        QApplication::beep();
+	QApplication::beep();
 #endif
-	}
 }
 
 //---------------------------------------------------------------------------
-void Parser::parseInput(char *commbuf, char* outputBuffer)
+// Handlers indexed by CommandId, must follow the order of the enum in
+// commandtree.h
+//---------------------------------------------------------------------------
+const Parser::CommandHandler Parser::commandHandlers[] =
 {
-	char* word;    // string tokens
-	char* value;   // start of argument
-	char* pos;
+	nullptr,										// CMD_NONE
+
+	// queries
+	&Parser::query_idn,								// QRY_IDN
+	&Parser::query_align1,							// QRY_ALIGN1
+	&Parser::query_align1_cartesian,				// QRY_ALIGN1_CARTESIAN
+	&Parser::query_align2,							// QRY_ALIGN2
+	&Parser::query_align2_cartesian,				// QRY_ALIGN2_CARTESIAN
+	&Parser::query_field,							// QRY_FIELD
+	&Parser::query_field_cartesian,					// QRY_FIELD_CARTESIAN
+	&Parser::query_history,							// QRY_HISTORY
+	&Parser::query_persistent,						// QRY_PERSISTENT
+	&Parser::query_plane,							// QRY_PLANE
+	&Parser::query_sequence_state,					// QRY_SEQUENCE_STATE
+	&Parser::query_state,							// QRY_STATE
+	&Parser::query_system_error,					// QRY_SYSTEM_ERROR
+	&Parser::query_system_error_count,				// QRY_SYSTEM_ERROR_COUNT
+	&Parser::query_system_format,					// QRY_SYSTEM_FORMAT
+	&Parser::query_system_stats,					// QRY_SYSTEM_STATS
+	&Parser::query_system_subscribe,				// QRY_SYSTEM_SUBSCRIBE
+	&Parser::query_table_vector,					// QRY_TABLE_VECTOR
+	&Parser::query_table_polar,						// QRY_TABLE_POLAR
+	&Parser::query_target,							// QRY_TARGET
+	&Parser::query_target_cartesian,				// QRY_TARGET_CARTESIAN
+	&Parser::query_target_time,						// QRY_TARGET_TIME
+	&Parser::query_units,							// QRY_UNITS
+
+	// commands
+	&Parser::command_cls,							// CMD_CLS
+	&Parser::command_exit,							// CMD_EXIT
+	&Parser::command_conf_align1,					// CMD_CONF_ALIGN1
+	&Parser::command_conf_align2,					// CMD_CONF_ALIGN2
+	&Parser::command_conf_target_align1,			// CMD_CONF_TARGET_ALIGN1
+	&Parser::command_conf_target_align2,			// CMD_CONF_TARGET_ALIGN2
+	&Parser::command_conf_target_vector,			// CMD_CONF_TARGET_VECTOR
+	&Parser::command_conf_target_vector_cartesian,	// CMD_CONF_TARGET_VECTOR_CARTESIAN
+	&Parser::command_conf_target_vector_table,		// CMD_CONF_TARGET_VECTOR_TABLE
+	&Parser::command_conf_target_polar,				// CMD_CONF_TARGET_POLAR
+	&Parser::command_conf_target_polar_table,		// CMD_CONF_TARGET_POLAR_TABLE
+	&Parser::command_conf_units,					// CMD_CONF_UNITS
+	&Parser::command_load,							// CMD_LOAD
+	&Parser::command_load_settings,					// CMD_LOAD_SETTINGS
+	&Parser::command_load_vector,					// CMD_LOAD_VECTOR
+	&Parser::command_load_polar,					// CMD_LOAD_POLAR
+	&Parser::command_pause,							// CMD_PAUSE
+	&Parser::command_persistent,					// CMD_PERSISTENT
+	&Parser::command_ramp,							// CMD_RAMP
+	&Parser::command_save,							// CMD_SAVE
+	&Parser::command_save_settings,					// CMD_SAVE_SETTINGS
+	&Parser::command_sequence_abort,				// CMD_SEQUENCE_ABORT
+	&Parser::command_sequence_define,				// CMD_SEQUENCE_DEFINE
+	&Parser::command_sequence_load,					// CMD_SEQUENCE_LOAD
+	&Parser::command_sequence_run,					// CMD_SEQUENCE_RUN
+	&Parser::command_system_connect,				// CMD_SYSTEM_CONNECT
+	&Parser::command_system_disconnect,				// CMD_SYSTEM_DISCONNECT
+	&Parser::command_system_format,					// CMD_SYSTEM_FORMAT
+	&Parser::command_system_subscribe,				// CMD_SYSTEM_SUBSCRIBE
+	&Parser::command_system_unsubscribe,			// CMD_SYSTEM_UNSUBSCRIBE
+	&Parser::command_table_vector,					// CMD_TABLE_VECTOR
+	&Parser::command_table_polar,					// CMD_TABLE_POLAR
+	&Parser::command_wait_holding,					// CMD_WAIT_HOLDING
+	&Parser::command_wait_persistent,				// CMD_WAIT_PERSISTENT
+	&Parser::command_wait_step,						// CMD_WAIT_STEP
+	&Parser::command_zero							// CMD_ZERO
+};
 
-	pos = strchr(commbuf, '?');
+//---------------------------------------------------------------------------
+// Semicolon ending the command, NULL if it is the last in the line. A
+// semicolon inside a quoted argument (e.g. a file name) is not a separator.
+//---------------------------------------------------------------------------
+static char *findSeparator(char *command)
+{
+	bool quoted = false;
 
-	// Quench condition is active, refuse all remote scripting
-	if (SYSTEM_QUENCH == (SystemState)source->get_state())
+	for (char *pos = command; *pos != '\0'; pos++)
 	{
-		addToErrorQueue(ERR_QUENCH_CONDITION);
-		return;
+		if (*pos == '"')
+			quoted = !quoted;
+		else if (*pos == ';' && !quoted)
+			return pos;
 	}
 
-	/************************************************************
-	The input is a query.
-	************************************************************/
-	if (pos != NULL)
-	{		// found a ?
-			// terminate string at the question mark
-		*pos = '\0';
+	return NULL;
+}
 
-		// no case-sensitive issues with queries, convert all to uppercase
-		commbuf = struprt(commbuf);
+//---------------------------------------------------------------------------
+// The command acts on the GUI, so the snapshot no longer shows its effect.
+// Session settings, WAITs (which refresh the snapshot) and saves do not.
+//---------------------------------------------------------------------------
+static bool changesState(CommandId id)
+{
+	switch (id)
+	{
+	case CMD_CLS:
+	case CMD_EXIT:
+	case CMD_SAVE:
+	case CMD_SAVE_SETTINGS:
+	case CMD_SYSTEM_FORMAT:
+	case CMD_SYSTEM_SUBSCRIBE:
+	case CMD_SYSTEM_UNSUBSCRIBE:
+	case CMD_WAIT_HOLDING:
+	case CMD_WAIT_PERSISTENT:
+	case CMD_WAIT_STEP:
+		return false;
+
+	default:
+		return id >= CMD_CLS;
+	}
+}
+
+//---------------------------------------------------------------------------
+// Parses a line holding one command or a list of commands separated by
+// semicolons. All commands in the line see the same state snapshot, except
+// that a WAIT command refreshes it for the commands following it, and a
+// query following a command that changed the state waits for the GUI to
+// execute that command first (e.g. "CONF:TARG:VEC 1,0,0;TARG?"). The
+// responses of queries and WAIT commands are returned together on one line,
+// separated by semicolons. In a list, a query that fails leaves its field
+// empty so the remaining responses keep their positions.
+//---------------------------------------------------------------------------
+void Parser::parseLine(char *line)
+{
+	QByteArray response;
+	RecordFields fields;
+	int numResponses = 0;
+	bool responded = false;
+	bool stale = false;		// a command in the line changed the state since the snapshot
+	char *next = line;
+
+	source->get_snapshot(&snapshot);
+
+	while (next != NULL)
+	{
+		char *command = next;
+		CommandId id;
+
+		// terminate this command at the next separator
+		next = findSeparator(command);
 
-		// get first token
-		word = strtok(commbuf, DELIMITER);
+		if (next != NULL)
+			*next++ = '\0';
 
-		if (word == NULL)
+		if (stale && strchr(command, '?') != NULL)
 		{
-			addToErrorQueue(ERR_UNRECOGNIZED_QUERY);
-			return; // no match
+			syncSnapshot();
+			stale = false;
 		}
 
-		// switch on first character
-		switch (*word)
+		fields.clear();
+
+		bool responds = parseInput(command, &fields, &id);
+
+		if (changesState(id))
+			stale = true;
+
+		if (responds)
 		{
-			// tests: *IDN?,
-			case  '*':
-				if (!strcmp(word, _IDN))
-				{
-					QString version(qApp->applicationName() + "," + qApp->applicationVersion() + "\n");
-					std::cout.write(version.toLocal8Bit(), version.size());
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_QUERY);	// no match, error
-				}
-				break;
+			if (outputFormat.load() != FORMAT_TEXT)
+			{
+				// one record per response named by its keyword path, each
+				// dump row its own record
+				char name[64];
+				QByteArray recordName;
 
-			// A* queries
-			case  'A':
-				parse_query_A(word, outputBuffer);
-				break;
+				if (commandName(id, name, sizeof(name)))
+					recordName = name;
 
-			// F* queries
-			case  'F':
-				parse_query_F(word, outputBuffer);
-				break;
+				writeRecord(RECORD_RESPONSE, recordName, fields);
+				writeRows(recordName);
+				continue;
+			}
 
-			// P* queries
-			case  'P':
-				if (!strcmp(word, _PLANE))
-				{
-					double x, y, z;
+			if (numResponses++)
+				response.append(';');
 
-					source->get_plane(&x, &y, &z);
-					sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", x, y, z);
-					std::cout.write(outputBuffer, strlen(outputBuffer));
-				}
-				else if (strcmp(word, _PERS) == 0 || strcmp(word, _PERSISTENT) == 0)
-				{
-					sprintf(outputBuffer, "%d\n", source->isPersistent());
-					std::cout.write(outputBuffer, strlen(outputBuffer));
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_QUERY);	// no match, error
-				}
-				break;
+			if (!fields.isEmpty())
+			{
+				response.append(fields.toText());
+				responded = true;
+			}
+		}
+	}
 
-			// S* queries
-			case  'S':
-				if (!strcmp(word, _STATE))
-				{
-					sprintf(outputBuffer, "%d\n", source->get_state());
-					std::cout.write(outputBuffer, strlen(outputBuffer));
-				}
-				else if (strcmp(word, _SYST) == 0 || strcmp(word, _SYSTEM) == 0)
-				{
-					// get next token
-					word = strtok(NULL, SEPARATOR);
+	if (responded || numResponses > 1)
+	{
+		response.append('\n');
+		writeOutput(response);
 
-					if (word == NULL)
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_QUERY); // no match, error
-					}
-					else if (strcmp(word, _ERR) == 0 || strcmp(word, _ERROR) == 0)
-					{
-						// get next token
-						word = strtok(NULL, SEPARATOR);
+		// table dump lines follow the response line
+		writeRows(QByteArray());
+	}
 
-						if (word == NULL)
-						{
-							if (errorStack.count())
-								sprintf(outputBuffer, "%s\n", errorStack.pop().toLocal8Bit().constData());
-							else
-								sprintf(outputBuffer, "0,\"No error\"\n");
+	pendingRows.clear();
+}
 
-							std::cout.write(outputBuffer, strlen(outputBuffer));
-						}
-						else if (strcmp(word, _COUN) == 0 || strcmp(word, _COUNT) == 0)
-						{
-							// get next token
-							word = strtok(NULL, SEPARATOR);
+//---------------------------------------------------------------------------
+// Reads a further input line for a command that takes a block of lines,
+// returns false at end of input
+//---------------------------------------------------------------------------
+bool Parser::readInputLine(QByteArray *line)
+{
+	std::string input;
 
-							if (word == NULL)
-							{
-								sprintf(outputBuffer, "%d\n", errorStack.count());
-								std::cout.write(outputBuffer, strlen(outputBuffer));
-							}
-						}
-						else
-						{
-							addToErrorQueue(ERR_UNRECOGNIZED_QUERY); // no match, error
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_QUERY); //no match, error
-					}
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_QUERY);	// no match, error
-				}
-				break;
+	if (!std::getline(std::cin, input))
+	{
+		std::cin.clear();
+		return false;
+	}
 
-			// T* queries
-			case 'T':
-				parse_query_T(word, outputBuffer);
-				break;
+	*line = QByteArray(input.data(), (int)input.size());
 
-			// U* queries
-			case 'U':
-				if (!strcmp(word, _UNITS))
-				{
-					sprintf(outputBuffer, "%d\n", source->get_field_units());
-					std::cout.write(outputBuffer, strlen(outputBuffer));
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_QUERY);	// no match, error
-				}
-				break;
+	return true;
+}
 
-			// no match
-			default:
-				addToErrorQueue(ERR_UNRECOGNIZED_QUERY);
-				break;
-		}	// end switch on first word
+//---------------------------------------------------------------------------
+// Writes a response or event line to stdout (session thread only).
+// Sessions on other transports override this.
+//---------------------------------------------------------------------------
+void Parser::writeOutput(const QByteArray &data)
+{
+	QMutexLocker lock(&outputMutex);
+	std::cout.write(data.constData(), data.size());
+	std::cout.flush();	// needed on Linux
+}
 
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-		std::cout.flush();	// needed on Linux
-#endif
-	}
+//---------------------------------------------------------------------------
+// Frames one response, event or row in the session's output format,
+// returns the size of the record
+//---------------------------------------------------------------------------
+int Parser::writeRecord(RecordType type, const QByteArray &name, const RecordFields &fields)
+{
+	QMutexLocker lock(&recordMutex);
 
-	/************************************************************
-	The input is a command (no return data).
-	************************************************************/
-	else
-	{
-		// get first token
-		word = strtok(commbuf, SEPARATOR);
-		if (word == NULL)
-		{
-			return; // no match
-		}
+	QByteArray record = frameRecord((OutputFormat)outputFormat.load(), type, ++recordSequence,
+		QDateTime::currentMSecsSinceEpoch(), name, fields);
+
+	writeOutput(record);
+
+	return record.size();
+}
+
+//---------------------------------------------------------------------------
+// Writes the rows following the responses, as row records when framed.
+// Rows are formatted one at a time and output is flushed every
+// ROW_CHUNK_BYTES, so a dump of any size streams to the client without
+// being held in memory, and events only fall between whole rows.
+//---------------------------------------------------------------------------
+void Parser::writeRows(const QByteArray &name)
+{
+	bool framed = (outputFormat.load() != FORMAT_TEXT);
+	QByteArray chunk;
+	RecordFields row;
+	int unflushed = 0;
 
-		word = struprt(word);	// convert token to uppercase
+	while (!pendingRows.isEmpty())
+	{
+		PendingRows &rows = pendingRows.first();
 
-		// switch on first character
-		switch (*word)
+		while (!cancelled())
 		{
-			// tests *CLS
-			case '*':
-				if (!strcmp(word, _CLS))
-				{
-					errorStack.clear();
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
-				break;
+			row.clear();
 
-			// tests EXIT
-			case 'E':
-				if (strcmp(word, _EXIT) == 0)
-				{
-					emit exit_app();
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
+			if (!(this->*rows.reader)(&rows, &row))
 				break;
 
-			// tests all CONFigure commands
-			case  'C':
-				if (strcmp(word, _CONF) == 0 || strcmp(word, _CONFIGURE) == 0)
-				{
-					// get next token
-					word = strtok(NULL, SEPARATOR);
-					word = struprt(word);	// convert token to uppercase
+			if (framed)
+			{
+				unflushed += writeRecord(RECORD_ROW, name, row);
+			}
+			else
+			{
+				chunk.append(row.toText());
+				chunk.append('\n');
+				unflushed = chunk.size();
+			}
 
-					if (word == NULL)
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);
-					}
-					else
-					{
-						parse_configure(word, outputBuffer);
-					}
-				}
-				else
+			if (unflushed >= ROW_CHUNK_BYTES)
+			{
+				if (!framed)
 				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+					writeOutput(chunk);
+					chunk.clear();
 				}
-				break;
 
-			// tests LOAD:SETtings
-			case 'L':
-				if (strcmp(word, _LOAD) == 0)
-				{
-					word = strtok(NULL, SEPARATOR); // get next token
-					word = struprt(word);	// convert token to uppercase
-
-					if (word == NULL)
-					{
-						// no argument for LOAD, command error
-						addToErrorQueue(ERR_MISSING_PARAMETER);
-					}
+				flushOutput();
+				unflushed = 0;
+			}
+		}
 
-					// LOAD:SETtings
-					else if (strcmp(word, _SET) == 0 || strcmp(word, _SETTINGS) == 0)
-					{
-						word = strtok(NULL, EOL); // get next token
-						trimwhitespace(word);
+		pendingRows.removeFirst();
+	}
 
-						// case sensitive filenames on Unix systems!
-						if (word == NULL)
-						{
-							// no filename for LOAD:SETtings, command error
-							addToErrorQueue(ERR_MISSING_PARAMETER);
-						}
-						else
-						{
-							if (source->isConnected())
-							{
-								addToErrorQueue(ERR_CANNOT_LOAD);
-							}
-							else
-							{
-								FILE *file = fopen(word, "r");
+	if (!chunk.isEmpty())
+		writeOutput(chunk);
 
-								if (file == NULL)
-								{
-									// error in filename
-									addToErrorQueue(ERR_INVALID_ARGUMENT);
-								}
-								else
-								{
-									bool success;
-									emit load_settings(file, &success);
-								}
-							}
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-					}
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
-				break;
+	flushOutput();
+}
 
-			// tests RAMP
-			case  'R':
-				if (strcmp(word, _RAMP) == 0)
-				{
-					// get next token
-					word = strtok(NULL, SEPARATOR);
-					word = struprt(word);	// convert token to uppercase
+//---------------------------------------------------------------------------
+// Formats the next row of a table dump. Vector rows are "<c1>,<c2>,<c3>,
+// <hold>,<persist>,<Pass|Fail>,<x quench>,<y quench>,<z quench>" and polar
+// rows "<mag>,<angle>,<hold>,<persist>", values as the table shows them in
+// TEXT output and empty fields where not set.
+//---------------------------------------------------------------------------
+bool Parser::readTableRow(PendingRows *rows, RecordFields *row)
+{
+	const RemoteTableDump &dump = rows->table;
+	const TableContents &contents = dump.contents;
+	int numFields = (dump.table == POLAR_TABLE) ? 3 : 8;
+	int persistColumn = (dump.table == POLAR_TABLE) ? 2 : 3;
+	int i = rows->next;
 
-					// Check for the NULL condition here to make sure there are not additional args
-					if (word == NULL)
-					{
-						if (source->isConnected())
-						{
-							SystemState state = (SystemState)source->get_state();
-							if (state == SYSTEM_HEATING || state == SYSTEM_COOLING)
-							{
-								addToErrorQueue(ERR_SWITCH_TRANSITION);
-							}
-							else
-							{
-								if (source->isPersistent())
-								{
-									addToErrorQueue(ERR_IS_PERSISTENT);
-								}
-								else
-								{
-									emit ramp();
-								}
-							}
-						}
-						else
-						{
-							addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-					}
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
-				break;
+	if (i >= contents.rows)
+		return false;
 
-			// tests PERSistent 0|1,PAUSE
-			case  'P':
-				if (strcmp(word, _PERS) == 0 || strcmp(word, _PERSISTENT) == 0)
-				{
-					value = strtok(NULL, SPACE);		// look for value
+	for (int j = 0; j < numFields; j++)
+	{
+		CellState state = (j < contents.states.count()) ? (CellState)contents.states[j][i] : CELL_EMPTY;
 
-					if (isValue(value))
-					{
-						while (isspace(*value))
-							value++;
+		if (j == contents.resultColumn)
+		{
+			TableResult result = (TableResult)contents.results[i];
 
-						if (*value == '1' || *value == '0')
-						{
-							if (source->isConnected())
-							{
-								if (*value == '1')
-								{
-									SystemState state = (SystemState)source->get_state();
-									if (state == SYSTEM_HOLDING || state == SYSTEM_PAUSED)
-									{
-										if (source->hasSwitch())
-										{
-											emit set_persistence(true);
-										}
-										else
-										{
-											addToErrorQueue(ERR_NO_SWITCH);
-										}
-									}
-									else
-									{
-										addToErrorQueue(ERR_NO_PERSISTENCE); // cannot enter persistent mode, error
-									}
-								}
-								else if (*value == '0')
-								{
-									if (source->hasSwitch())
-									{
-										emit set_persistence(false);
-									}
-									else
-									{
-										addToErrorQueue(ERR_NO_SWITCH);
-									}
-								}
-							}
-							else
-							{
-								addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-							}
-						}
-						else
-						{
-							addToErrorQueue(ERR_NON_BOOLEAN_ARGUMENT); // invalid argument, error
-						}
-					}
-					else
-					{
-						if (value == NULL)
-							addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-						else
-							addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-					}
-				}
-				else if (strcmp(word, _PAUSE) == 0)
-				{
-					// get next token
-					word = strtok(NULL, SEPARATOR);
-					word = struprt(word);	// convert token to uppercase
-
-					// Check for the NULL condition here to make sure there are not additional args
-					if (word == NULL)
-					{
-						if (source->isConnected())
-						{
-							SystemState state = (SystemState)source->get_state();
-							if (state == SYSTEM_HEATING || state == SYSTEM_COOLING)
-							{
-								addToErrorQueue(ERR_SWITCH_TRANSITION);
-							}
-							else
-							{
-								if (source->isPersistent())
-								{
-									addToErrorQueue(ERR_IS_PERSISTENT);
-								}
-								else
-								{
-									emit pause();
-								}
-							}
-						}
-						else
-						{
-							addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-					}
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
-				break;
-
-			// tests SYSTem:CONNect,SYSTem:DISConnect,SAVE:SETtings
-			case 'S':
-				if (strcmp(word, _SYST) == 0 || strcmp(word, _SYSTEM) == 0)
-				{
-					word = strtok(NULL, SEPARATOR); // get next token
-					word = struprt(word);	// convert token to uppercase
-
-					if (word == NULL)
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no argument for SYSTem, command error
-					}
-
-					// SYSTem:CONNect
-					else if (strcmp(word, _CONN) == 0 || strcmp(word, _CONNECT) == 0)
-					{
-						emit system_connect();
-					}
-
-					// SYSTem:DISConnect
-					else if (strcmp(word, _DISC) == 0 || strcmp(word, _DISCONNECT) == 0)
-					{
-						emit system_disconnect();
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-					}
-				}
-				else if (strcmp(word, _SAVE))
-				{
-					word = strtok(NULL, SEPARATOR); // get next token
-					word = struprt(word);	// convert token to uppercase
+			row->addString((result == RESULT_PASS) ? "Pass" : (result == RESULT_FAIL) ? "Fail" : "");
+		}
+		else if (state == CELL_VALUE)
+		{
+			row->addReal(contents.values[j][i], contents.precisions.value(j, QLocale::FloatingPointShortest));
+		}
+		else if (state == CELL_TEXT)
+		{
+			row->addString(contents.texts.value(TableModel::textKey(i, j)).remove('\n'));
+		}
+		else
+		{
+			row->addString(QByteArray());
+		}
 
-					if (word == NULL)
-					{
-						// no argument for SAVE, command error
-						addToErrorQueue(ERR_MISSING_PARAMETER);
-					}
+		if (j == persistColumn)
+			row->addInteger(dump.checks.value(i) ? 1 : 0);
+	}
 
-					else if (strcmp(word, _SET) == 0 || strcmp(word, _SETTINGS) == 0)
-					{
-						word = strtok(NULL, EOL); // get next token
-						trimwhitespace(word);
+	rows->next++;
 
-						// case sensitive filenames on Unix systems!
-						if (word == NULL)
-						{
-							// no filename for SAVE:SETtings, command error
-							addToErrorQueue(ERR_MISSING_PARAMETER);
-						}
-						else
-						{
-							FILE *file = fopen(word, "w");
+	return true;
+}
 
-							if (file == NULL)
-							{
-								// error in filename
-								addToErrorQueue(ERR_INVALID_ARGUMENT);
-							}
-							else
-							{
-								bool success;
-								emit save_settings(file, &success);
-							}
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-					}
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
-				break;
+//---------------------------------------------------------------------------
+bool Parser::readStatsRow(PendingRows *rows, RecordFields *row)
+{
+	if (rows->next >= rows->stats.count())
+		return false;
 
-			// tests ZERO
-			case  'Z':
-				if (strcmp(word, _ZERO) == 0)
-				{
-					// get next token
-					word = strtok(NULL, SEPARATOR);
-					word = struprt(word);	// convert token to uppercase
+	const LatencyReport &entry = rows->stats[rows->next++];
 
-					// Check for the NULL condition here to make sure there are not additional args
-					if (word == NULL)
-					{
-						if (source->isConnected())
-						{
-							SystemState state = (SystemState)source->get_state();
-							if (state == SYSTEM_HEATING || state == SYSTEM_COOLING)
-							{
-								addToErrorQueue(ERR_SWITCH_TRANSITION);
-							}
-							else
-							{
-								if (source->isPersistent())
-								{
-									addToErrorQueue(ERR_IS_PERSISTENT);
-								}
-								else
-								{
-									emit zero();
-								}
-							}
-						}
-						else
-						{
-							addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-					}
-				}
-				else
-				{
-					addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-				}
-				break;
+	row->addString(entry.group);
+	row->addString(entry.name);
+	row->addInteger((qint64)entry.count);
+	row->addInteger(entry.p50);
+	row->addInteger(entry.p90);
+	row->addInteger(entry.p99);
+	row->addInteger(entry.p999);
+	row->addInteger(entry.max);
 
-			default:
-				addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);
-				break;
-		}
-	}
+	return true;
 }
 
 //---------------------------------------------------------------------------
-// tests  ALIGN1?, ALIGN1:CARTesian?, ALIGN2?, ALIGN2:CARTesian?
+// Formats the next HISTory? row, "<msec>,<x>,<y>,<z>,<magnitude>,<x current>,
+// <y current>,<z current>", requesting the next batch from the GUI thread
+// when the present one has been written. Exactly the row count of the
+// response is written: once a batch cannot be copied the remaining rows
+// have all fields empty, with the error queued.
 //---------------------------------------------------------------------------
-void Parser::parse_query_A(char* word, char* outputBuffer)
+bool Parser::readHistoryRow(PendingRows *rows, RecordFields *row)
 {
-	if (strcmp(word, _ALIGN1) == 0)
-	{
-		word = strtok(NULL, DELIMITER);		// get next token
+	RemoteHistoryBatch &batch = rows->history;
 
-		if (word == NULL)
-		{
-			 // return spherical coordinates
-			double mag, az, inc;
+	if (rows->next >= rows->total)
+		return false;
 
-			source->get_align1(&mag, &az, &inc);
-			sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", mag, az, inc);
-			std::cout.write(outputBuffer, strlen(outputBuffer));
-		}
+	if (!rows->historyLost && rows->batchNext >= batch.rows.count())
+	{
+		// samples are continued by time, as the oldest may have been dropped
+		qint64 from = batch.rows.isEmpty() ? rows->historyTo + 1 : batch.rows.last().time + 1;
 
-		// ALIGN1:CARTesian?
-		else if (strcmp(word, _CART) == 0 || strcmp(word, _CARTESIAN) == 0)
+		if (!fetchHistory(from, rows->historyTo, &batch))
 		{
-			double x, y, z;
-
-			source->get_align1_cartesian(&x, &y, &z);
-			sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", x, y, z);
-			std::cout.write(outputBuffer, strlen(outputBuffer));
+			rows->historyLost = true;	// ERR_HISTORY_TIMEOUT is queued
 		}
-		else
+		else if (batch.rows.isEmpty() || batch.start != rows->historyStart)
 		{
-			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+			// dropped from the history, or a reconnect started a new one
+			addToErrorQueue(ERR_HISTORY_INCOMPLETE);
+			rows->historyLost = true;
 		}
+
+		rows->batchNext = 0;
 	}
-	else if (strcmp(word, _ALIGN2) == 0)
+
+	rows->next++;
+
+	if (rows->historyLost)
 	{
-		word = strtok(NULL, DELIMITER);		// get next token
+		for (int i = 0; i < HISTORY_FIELDS; i++)
+			row->addString(QByteArray());
 
-		if (word == NULL)
-		{
-			// return spherical coordinates
-			double mag, az, inc;
+		return true;
+	}
 
-			source->get_align2(&mag, &az, &inc);
-			sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", mag, az, inc);
-			std::cout.write(outputBuffer, strlen(outputBuffer));
-		}
+	const RemoteHistoryRow &sample = batch.rows[rows->batchNext++];
 
-		// ALIGN2:CARTesian?
-		else if (strcmp(word, _CART) == 0 || strcmp(word, _CARTESIAN) == 0)
-		{
-			double x, y, z;
+	row->addInteger(sample.time);
 
-			source->get_align2_cartesian(&x, &y, &z);
-			sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", x, y, z);
-			std::cout.write(outputBuffer, strlen(outputBuffer));
-		}
-		else
+	for (int i = 0; i < 3; i++)
+		row->addReal(sample.field[i], HISTORY_PRECISION);
+
+	row->addReal(sample.magnitude, HISTORY_PRECISION);
+
+	for (int i = 0; i < 3; i++)
+		row->addReal(sample.current[i], HISTORY_PRECISION);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Copies the next batch of history samples in [from, to] on the GUI thread,
+// reports ERR_HISTORY_TIMEOUT and returns false if that does not happen
+// within HISTORY_TIMEOUT
+//---------------------------------------------------------------------------
+bool Parser::fetchHistory(qint64 from, qint64 to, RemoteHistoryBatch *batch)
+{
+	RemoteSnapshot latest = snapshot;
+	QDeadlineTimer deadline(HISTORY_TIMEOUT);
+	quint64 token = ++syncTokens;
+
+	emit history_range(from, to, token, LatencyStats::now());
+
+	while (!source->take_history_batch(token, batch))
+	{
+		if (cancelled() || deadline.hasExpired())
 		{
-			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+			source->discard_history_batch(token);
+			addToErrorQueue(ERR_HISTORY_TIMEOUT);
+			return false;
 		}
+
+		source->wait_snapshot(&latest, 1000);
 	}
-	else
-	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match
-	}
+
+	return true;
 }
 
 //---------------------------------------------------------------------------
-// tests FIELD?, FIELD:CARTesian?
+// Parses a single command or query, any response fields are added to
+// response and the command resolved is returned in command. Returns true
+// if the input has a response field (queries and WAIT).
 //---------------------------------------------------------------------------
-void Parser::parse_query_F(char* word, char* outputBuffer)
+bool Parser::parseInput(char *commbuf, RecordFields *response, CommandId *command)
 {
-	if (strcmp(word, _FIELD) == 0)
+	static_assert(sizeof(commandHandlers) / sizeof(commandHandlers[0]) == NUM_COMMAND_IDS,
+		"a handler is required for each CommandId");
+
+	char* args;    // start of arguments
+	char* pos;
+
+	pos = strchr(commbuf, '?');
+	*command = CMD_NONE;
+
+	// Quench condition is active, refuse all remote scripting
+	if (SYSTEM_QUENCH == (SystemState)snapshot.state)
 	{
-		word = strtok(NULL, DELIMITER);		// get next token
+		addToErrorQueue(ERR_QUENCH_CONDITION);
+		return pos != NULL;
+	}
 
-		if (word == NULL)
-		{
-			if (source->isConnected())
-			{
-				// return spherical coordinates
-				double mag, az, inc;
+	if (pos != NULL)
+	{
+		// the input is a query, terminate string at the question mark
+		*pos = '\0';
 
-				source->get_field(&mag, &az, &inc);
-				sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", mag, az, inc);
-				std::cout.write(outputBuffer, strlen(outputBuffer));
-			}
-			else
-			{
-				addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-			}
-		}
+		// no case-sensitive issues with queries, convert all to uppercase
+		commbuf = struprt(commbuf);
+	}
+	else
+	{
+		// the input is a command (no return data), skip empty lines
+		commbuf = trimwhitespace(commbuf);
 
-		// FIELD:CARTesian?
-		else if (strcmp(word, _CART) == 0 || strcmp(word, _CARTESIAN) == 0)
-		{
-			if (source->isConnected())
-			{
-				double x, y, z;
+		if (*commbuf == '\0')
+			return false;
+	}
 
-				source->get_field_cartesian(&x, &y, &z);
-				sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", x, y, z);
-				std::cout.write(outputBuffer, strlen(outputBuffer));
-			}
-			else
-			{
-				addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-			}
-		}
+	// walk the command tree, the handler parses any arguments (for a query
+	// the text after the question mark, e.g. "HISTORY? 0,60000")
+	CommandId id = resolveCommand(commbuf, pos != NULL, &args);
+
+	if (pos != NULL)
+		args = pos + 1;
 
+	*command = id;
+
+	if (id == CMD_NONE)
+	{
+		if (pos != NULL)
+			addToErrorQueue(ERR_UNRECOGNIZED_QUERY);	// no match, error
 		else
-		{
 			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-		}
 	}
 	else
 	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+		qint64 start = LatencyStats::now();
+		bool isWait = (id == CMD_WAIT_HOLDING || id == CMD_WAIT_PERSISTENT || id == CMD_WAIT_STEP);
+		bool isUpload = (id == CMD_TABLE_VECTOR || id == CMD_TABLE_POLAR || id == CMD_SEQUENCE_DEFINE);
+
+		if (pos != NULL || isWait || isUpload)
+		{
+			// queries read this session's snapshot, waits and uploads must
+			// not hold up other sessions (uploads lock when queuing the table)
+			(this->*commandHandlers[id])(args, response);
+		}
+		else
+		{
+			// mutating commands from all sessions are checked and queued
+			// to the GUI thread one at a time, in arrival order
+			QMutexLocker lock(&commandMutex);
+			(this->*commandHandlers[id])(args, response);
+		}
+
+		LatencyStats::recordCommand(id, LatencyStats::now() - start);
+
+		return pos != NULL || isWait;
 	}
+
+	return pos != NULL;
 }
 
 //---------------------------------------------------------------------------
-// tests TARGet?, TARGet:CARTesian?
+// Queues a subscribed event for the session thread. Connected directly to
+// MultiAxisOperation::remote_event(), so this runs on the GUI thread for
+// acquisition events and must not block on output. When the queue is full
+// the event replaces the fields of a queued event of the same kind, which
+// a client only needs the latest of, or else the oldest event is dropped.
 //---------------------------------------------------------------------------
-void Parser::parse_query_T(char* word, char* outputBuffer)
+void Parser::pushEvent(int event, QVariantList fields)
 {
-	if (strcmp(word, _TARG) == 0 || strcmp(word, _TARGET) == 0)
-	{
-		word = strtok(NULL, DELIMITER);		// get next token
-
-		if (word == NULL)
-		{
-			if (source->isConnected())
-			{
-				// return spherical coordinates
-				double mag, az, inc;
+	if ((subscriptions.load() & event) == 0)
+		return;
 
-				source->get_active(&mag, &az, &inc);
-				sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", mag, az, inc);
-				std::cout.write(outputBuffer, strlen(outputBuffer));
-			}
-			else
-			{
-				addToErrorQueue(ERR_NOT_CONNECTED);
-			}
-		}
+	QMutexLocker lock(&eventMutex);
 
-		// TARGet:CARTesian?
-		else if (strcmp(word, _CART) == 0 || strcmp(word, _CARTESIAN) == 0)
+	if (eventQueue.size() >= MAX_QUEUED_EVENTS)
+	{
+		for (int i = eventQueue.size() - 1; i >= 0; i--)
 		{
-			if (source->isConnected())
-			{
-				double x, y, z;
-
-				source->get_active_cartesian(&x, &y, &z);
-				sprintf(outputBuffer, "%0.10g,%0.10g,%0.10g\n", x, y, z);
-				std::cout.write(outputBuffer, strlen(outputBuffer));
-			}
-			else
+			if (eventQueue[i].event == event)
 			{
-				addToErrorQueue(ERR_NOT_CONNECTED);
+				eventQueue[i].fields = fields;
+				return;
 			}
 		}
-		else if (strcmp(word, _TIME) == 0)
-		{
-			sprintf(outputBuffer, "%d\n", source->get_remaining_time());
-			std::cout.write(outputBuffer, strlen(outputBuffer));
-		}
-		else
-		{
-			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
-		}
-	}
-	else
-	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+
+		eventQueue.removeFirst();
+		droppedEvents++;
 	}
+
+	eventQueue.append({ event, fields });
 }
 
 //---------------------------------------------------------------------------
-//	 Parses all CONFigure commands. These are broken out of
-//   parseInput() for easier reading.
+// Writes queued event lines, e.g. "!STATE,2" (session thread only). Called
+// from flushOutput(), so events fall between responses and between rows of
+// a dump. Integer, real and string fields keep their type in framed output.
 //---------------------------------------------------------------------------
-void Parser::parse_configure(char* word, char *outputBuffer)
+void Parser::writeEvents(void)
 {
-	if (word == NULL)
+	QList<QueuedEvent> events;
+	int dropped;
+
 	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);
+		QMutexLocker lock(&eventMutex);
+		events.swap(eventQueue);
+		dropped = droppedEvents;
+		droppedEvents = 0;
 	}
-	else
+
+	if (dropped)
+		qDebug() << "Remote session dropped" << dropped << "events, client is not keeping up";
+
+	for (const QueuedEvent &queued : events)
 	{
-		switch (*word)
+		for (int i = 0; i < NUM_EVENT_NAMES; i++)
 		{
-			// CONFigure:A* commands
-			case  'A':
-				parse_configure_A(word, outputBuffer);
-				break;
+			if (eventNames[i].event == queued.event)
+			{
+				RecordFields record;
 
-			// CONFigure:U* commands
-			case  'U':
-				parse_configure_U(word, outputBuffer);
-				break;
+				for (const QVariant &field : queued.fields)
+				{
+					int type = field.userType();
 
-			// CONFigure:T* commands
-			case  'T':
-				parse_configure_T(word, outputBuffer);
-				break;
+					if (type == QMetaType::Double)
+						record.addReal(field.toDouble());
+					else if (type == QMetaType::Int || type == QMetaType::LongLong)
+						record.addInteger(field.toLongLong());
+					else
+						record.addString(field.toString());
+				}
+
+				if (outputFormat.load() != FORMAT_TEXT)
+				{
+					writeRecord(RECORD_EVENT, eventNames[i].name, record);
+					break;
+				}
 
-			default:
-				addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+				QByteArray line = QByteArray("!") + eventNames[i].name;
+
+				if (!record.isEmpty())
+					line += "," + record.toText();
+
+				line += "\n";
+				writeOutput(line);
 				break;
-		}	// end switch(*word) for CONF
+			}
+		}
 	}
 }
 
 //---------------------------------------------------------------------------
-// tests CONFigure:UNITS
+// Parses a list of event names into a subscription mask, returns false
+// and reports the error on an unknown or missing name
 //---------------------------------------------------------------------------
-void Parser::parse_configure_U(char* word, char *outputBuffer)
+bool Parser::parseEventList(char *args, int *mask)
 {
-	// CONFigure:UNITS
-	if (strcmp(word, _UNITS) == 0)
+	char *word = strtok(args, LIST);
+
+	*mask = 0;
+
+	if (word == NULL)
+	{
+		addToErrorQueue(ERR_MISSING_PARAMETER);	// missing argument, error
+		return false;
+	}
+
+	while (word != NULL)
 	{
-		if (source->isConnected())
+		int i;
+
+		struprt(word);
+
+		if (strcmp(word, "ALL") == 0)
 		{
-			addToErrorQueue(ERR_NO_UNITS_CHANGE); // cannot change units after connect, error
+			for (i = 0; i < NUM_EVENT_NAMES; i++)
+				*mask |= eventNames[i].event;
 		}
 		else
 		{
-			char *value = strtok(NULL, SPACE);	// look for value
-
-			if (isValue(value))
+			for (i = 0; i < NUM_EVENT_NAMES; i++)
 			{
-				while (isspace(*value))
-					value++;
-
-				if (*value == '1')
+				if (strcmp(word, eventNames[i].name) == 0)
 				{
-					emit set_units(1);
-				}
-				else if (*value == '0')
-				{
-					emit set_units(0);
-				}
-				else
-				{
-					addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+					*mask |= eventNames[i].event;
+					break;
 				}
 			}
-			else
+
+			if (i == NUM_EVENT_NAMES)
 			{
-				if (value == NULL)
-					addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-				else
-					addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+				addToErrorQueue(ERR_INVALID_ARGUMENT);	// unknown event, error
+				return false;
 			}
 		}
+
+		word = strtok(NULL, LIST);
 	}
-	else
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Checks a table can be replaced, not while its auto-step is running or a
+// file is loading into it
+//---------------------------------------------------------------------------
+bool Parser::tableLoadAllowed(int table)
+{
+	bool loading = (table == POLAR_TABLE) ? snapshot.polarLoading : snapshot.vectorLoading;
+
+	if (snapshot.autostepActive || loading)
 	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, error
+		addToErrorQueue(ERR_TABLE_BUSY);
+		return false;
 	}
+
+	return true;
 }
 
 //---------------------------------------------------------------------------
-// tests CONFigure:ALIGN1, CONFigure:ALIGN2
+// Validates one table row and adds it to the batch. Vector rows are
+// <c1>,<c2>,<c3>,<hold> in the batch coordinates and polar rows are
+// <mag>,<angle>,<hold>, each optionally followed by <persist 0|1>. Any
+// further fields (results in a dump or a saved table) are ignored. After
+// an error the rest of the batch is only consumed.
 //---------------------------------------------------------------------------
-void Parser::parse_configure_A(char* word, char *outputBuffer)
+void Parser::addTableRow(TableBatch *batch, char *line)
 {
-	// tests CONFigure:ALIGN1 <>, CONFigure:ALIGN2 <>
-	if (strcmp(word, _ALIGN1) == 0 || strcmp(word, _ALIGN2) == 0)
-	{
-		int alignSelect = strcmp(word, _ALIGN1);
+	if (batch->error != ERR_NONE)
+		return;
 
-		word = strtok(NULL, COMMA);	// get next token
+	int numValues = (batch->table == POLAR_TABLE) ? 3 : 4;	// including hold time
+	double values[4];
+	const char *persist = "";
+	char *word = strtok(line, LIST);
 
-		if (isValue(word))
+	for (int i = 0; i < numValues; i++)
+	{
+		if (!isValue(word))
 		{
-			double mag = strtod(word, NULL);
-
-			if (mag >= 0.0)	// magnitude cannot be negative
-			{
-				word = strtok(NULL, COMMA);	// get next token
+			batch->error = (word == NULL) ? ERR_MISSING_PARAMETER : ERR_NON_NUMERICAL_ENTRY;
+			return;
+		}
 
-				if (isValue(word))
-				{
-					double azimuth = strtod(word, NULL);
+		values[i] = strtod(word, NULL);
+		word = strtok(NULL, LIST);
+	}
 
-					word = strtok(NULL, COMMA);	// get next token
+	if (word != NULL && (strcmp(word, "0") == 0 || strcmp(word, "1") == 0))
+		persist = word;
 
-					if (isValue(word))
-					{
-						double inclination = strtod(word, NULL);
+	if (values[numValues - 1] < 0.0)
+	{
+		batch->error = ERR_OUT_OF_RANGE;	// negative hold time
+		return;
+	}
 
-						if (inclination >= 0.0 && inclination <= 180.0)	// angle from Z-axis must be >= 0 and <= 180 degrees
-						{
-							// now check vector
-							double x, y, z;
-							sphericalToCartesian(mag, azimuth, inclination, &x, &y, &z);
+	VectorError error;
 
-							VectorError error = source->check_vector(x, y, z);
+	if (batch->table == POLAR_TABLE)
+	{
+		values[0] *= batch->unitScale;
 
-							if (error == NO_VECTOR_ERROR)
-							{
-								if (source->isConnected())
-								{
-									// good vector!!!
-									if (alignSelect)
-										emit set_align2(mag, azimuth, inclination);
-									else
-										emit set_align1(mag, azimuth, inclination);
-								}
-								else
-								{
-									addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-								}
-							}
-							else
-							{
-								int errorCode = -150 - (int)error;
-								addToErrorQueue((SystemError)errorCode); // report vector error
-							}
-						}
-						else
-						{
-							addToErrorQueue(ERR_INCLINATION_OUT_OF_RANGE); // inclination out of range, error
-						}
-					}
-					else
-					{
-						if (word == NULL)
-							addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-						else
-							addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-					}
-				}
-				else
-				{
-					if (word == NULL)
-						addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-					else
-						addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-				}
-			}
-			else
-			{
-				addToErrorQueue(ERR_NEGATIVE_MAGNITUDE); // negative magnitude, error
-			}
+		if (values[0] < 0.0)
+		{
+			error = NEGATIVE_MAGNITUDE;
 		}
 		else
 		{
-			if (word == NULL)
-				addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-			else
-				addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+			QVector3D vector;
+
+			source->polarToCartesian(values[0], values[1], &vector);
+			error = source->check_vector(vector.x(), vector.y(), vector.z());
 		}
+
+		batch->rows.append(QString("%1,%2,%3,%4").arg(values[0], 0, 'g', 10).arg(values[1], 0, 'g', 10)
+			.arg(values[2], 0, 'g', 10).arg(persist));
 	}
 	else
 	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, error
-	}
-}
-
-//---------------------------------------------------------------------------
-// tests CONFigure:TARGet:ALIGN1
-//		 CONFigure:TARGet:ALIGN2
-//		 CONFigure:TARGet:VECtor
-//		 CONFigure:TARGet:VECtor:CARTesian
-//		 CONFigure:TARGet:VECtor:TABle
-//		 CONFigure:TARGet:POLar
-//		 CONFigure:TARGet:POLar:TABle
-//---------------------------------------------------------------------------
-void Parser::parse_configure_T(char* word, char *outputBuffer)
-{
-	SystemState state = (SystemState)source->get_state();
-
-	if (strcmp(word, _TARG) == 0 || strcmp(word, _TARGET) == 0)
-	{
-		word = strtok(NULL, SEPARATOR);	// get next token
-		word = struprt(word);	// convert to uppercase
+		double x, y, z;
 
-		if (word == NULL)
+		if (batch->coordinates == CARTESIAN_COORDINATES)
 		{
-			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, error
-		}
-
-		else if (state == SYSTEM_HEATING || state == SYSTEM_COOLING)
-		{
-			addToErrorQueue(ERR_SWITCH_TRANSITION);
-		}
+			for (int i = 0; i < 3; i++)
+				values[i] *= batch->unitScale;
 
-		else if (source->isPersistent())
-		{
-			addToErrorQueue(ERR_IS_PERSISTENT);
+			x = values[0];
+			y = values[1];
+			z = values[2];
+			error = source->check_vector(x, y, z);
 		}
-
-		// tests CONFigure:TARGet:ALIGN1, CONFigure:TARGet:ALIGN2
-		else if (strcmp(word, _ALIGN1) == 0 || strcmp(word, _ALIGN2) == 0)
+		else
 		{
-			int alignSelect = strcmp(word, _ALIGN1);
-			word = strtok(NULL, SEPARATOR);	// get next token
+			values[0] *= batch->unitScale;
 
-			if (word == NULL)
+			if (values[0] < 0.0)
 			{
-				if (source->isConnected())
-				{
-					if (alignSelect)
-						emit set_align2_active();
-					else
-						emit set_align1_active();
-				}
-				else
-				{
-					addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-				}
+				error = NEGATIVE_MAGNITUDE;
+			}
+			else if (values[2] < 0.0 || values[2] > 180.0)
+			{
+				error = INCLINATION_OUT_OF_RANGE;
 			}
 			else
 			{
-				addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, extraneous args, error
+				sphericalToCartesian(values[0], values[1], values[2], &x, &y, &z);
+				error = source->check_vector(x, y, z);
 			}
 		}
 
-		// tests CONFigure:TARGet:VECtor, CONFigure:TARGet:VECtor:CARTesian
-		//		 CONFigure:TARGet:VECtor:TABle
-		else if (strcmp(word, _VEC) == 0 || strcmp(word, _VECTOR) == 0)
-		{
-			char args[256];
-			word = strtok(NULL, DELIMITER);	// get next token
-			strncpy(args, word, 255);		// make a copy
+		batch->rows.append(QString("%1,%2,%3,%4,%5").arg(values[0], 0, 'g', 10).arg(values[1], 0, 'g', 10)
+			.arg(values[2], 0, 'g', 10).arg(values[3], 0, 'g', 10).arg(persist));
+	}
 
-			word = strtok(word, SEPARATOR);	// get next command token
-			word = struprt(word);	// convert to uppercase
+	if (error != NO_VECTOR_ERROR)
+		batch->error = (SystemError)(-150 - (int)error);	// report vector error
+}
 
-			if (word == NULL)
-			{
-				addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);
-			}
+//---------------------------------------------------------------------------
+// Queues a complete batch to replace the table in one update, or reports
+// the first error and leaves the table unchanged
+//---------------------------------------------------------------------------
+void Parser::sendTableBatch(TableBatch *batch)
+{
+	if (batch->error != ERR_NONE)
+	{
+		addToErrorQueue(batch->error);
+		return;
+	}
 
-			// tests CONFigure:TARGet:VECtor:CARTesian
-			else if (strcmp(word, _CART) == 0 || strcmp(word, _CARTESIAN) == 0)
-			{
-				// check for value
-				word = strtok(NULL, COMMA);	// get next token
+	QMutexLocker lock(&commandMutex);
 
-				// check values for CONFigure:TARGet:VECtor:CARTesian
-				if (isValue(word))
-				{
-					double x = strtod(word, NULL);
+	if (batch->table == POLAR_TABLE)
+		emit set_polar_table(batch->rows, LatencyStats::now());
+	else
+		emit set_vector_table(batch->rows, batch->coordinates, LatencyStats::now());
+}
 
-					word = strtok(NULL, COMMA);	// get next token
+//---------------------------------------------------------------------------
+// Loads a table file in the format saved from the Vector or Polar tab.
+// Lines before the first row are the header: a CARTESIAN or SPHERICAL line
+// selects the vector coordinates and (T) or (kG) in the column titles the
+// field units, which are converted to the present units.
+//---------------------------------------------------------------------------
+void Parser::loadTableFile(int table, char *args)
+{
+	// case sensitive filenames on Unix systems!
+	char *filename = trimwhitespace(args);
 
-					if (isValue(word))
-					{
-						double y = strtod(word, NULL);
+	if (*filename == '\0')
+	{
+		addToErrorQueue(ERR_MISSING_PARAMETER);
+		return;
+	}
 
-						word = strtok(NULL, COMMA);	// get next token
+	if (!tableLoadAllowed(table))
+		return;
 
-						if (isValue(word))
-						{
-							double z = strtod(word, NULL);
+	FILE *file = fopen(filename, "r");
 
-							// now check vector
-							VectorError error = source->check_vector(x, y, z);
+	if (file == NULL)
+	{
+		// error in filename
+		addToErrorQueue(ERR_INVALID_ARGUMENT);
+		return;
+	}
 
-							if (error == NO_VECTOR_ERROR)
-							{
-								if (source->isConnected())
-								{
-									word = strtok(NULL, COMMA);	// get next token
+	TableBatch batch;
+	batch.table = table;
+	batch.coordinates = SPHERICAL_COORDINATES;	// without a coordinates line, as the Vector tab
+	batch.unitScale = 1.0;
+	batch.error = ERR_NONE;
 
-									// check time arg
-									if (isValue(word))
-									{
-										double time = strtod(word, NULL);
-
-										if (time >= 0)
-										{
-											// good vector!!!
-											emit set_vector_cartesian(x, y, z, (int)time);
-										}
-										else
-										{
-											addToErrorQueue(ERR_INVALID_ARGUMENT); // time can't be negative, error
-										}
-									}
-									else
-									{
-										if (word == NULL)
-										{
-											// good vector!!! assume zero time with no 4th arg
-											emit set_vector_cartesian(x, y, z, 0);
-										}
-										else
-											addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-									}
-								}
-								else
-								{
-									addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-								}
-							}
-							else
-							{
-								int errorCode = -150 - (int)error;
-								addToErrorQueue((SystemError)errorCode); // report vector error
-							}
-						}
-						else
-						{
-							if (word == NULL)
-								addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-							else
-								addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-						}
-					}
-					else
-					{
-						if (word == NULL)
-							addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-						else
-							addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-					}
-				}
-				else
-				{
-					if (word == NULL)
-						addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-					else
-						addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-				}
-			}
+	char line[4096];
+	bool inHeader = true;
 
-			// tests CONFigure:TARGet:VECtor:TABle
-			else if (strcmp(word, _TAB) == 0 || strcmp(word, _TABLE) == 0)
-			{
-				// check for value
-				word = strtok(NULL, SEPARATOR);	// get next token
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char *str = trimwhitespace(line);
 
-				if (isValue(word))
-				{
-					if (source->isConnected())
-					{
-						int tableRow = (int)strtod(word, NULL) - 1;	// table has programmatic index 0, while on-screen starts at 1
+		if (*str == '\0')
+			continue;
 
-						// check for valid table index
-						bool indexInRange = source->vec_table_row_in_range(tableRow);
+		if (inHeader && !startsWithValue(str))
+		{
+			struprt(str);
 
-						if (indexInRange)
-						{
-							// check range and vector value
-							VectorError error = source->check_vector_table(tableRow);
+			if (strstr(str, "CARTESIAN"))
+				batch.coordinates = CARTESIAN_COORDINATES;
 
-							if (error == NO_VECTOR_ERROR)
-							{
-								emit goto_vector(tableRow);
-							}
-							else
-							{
-								int errorCode = -150 - (int)error;
-								addToErrorQueue((SystemError)errorCode); // report vector error
-							}
-						}
-						else
-						{
-							// table index out of range
-							addToErrorQueue(ERR_OUT_OF_RANGE);
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-					}
-				}
-				else
-				{
-					if (word == NULL)
-						addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-					else
-						addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-				}
-			}
+			if (strstr(str, "(KG)") || strstr(str, "(KILOGAUSS)"))
+				batch.unitScale = (snapshot.fieldUnits == TESLA) ? 0.1 : 1.0;
+			else if (strstr(str, "(T)") || strstr(str, "(TESLA)"))
+				batch.unitScale = (snapshot.fieldUnits == KG) ? 10.0 : 1.0;
 
-			else // check string for values for CONFigure:TARGet:VECtor
-			{
-				// check for value
-				word = args;
-				word = strtok(word, COMMA);	// get next token
+			continue;
+		}
 
-				if (isValue(word))
-				{
-					double mag = strtod(word, NULL);
+		inHeader = false;
 
-					if (mag >= 0.0)	// magnitude cannot be negative
-					{
-						word = strtok(NULL, COMMA);	// get next token
+		if (batch.rows.count() >= MAX_TABLE_ROWS)
+		{
+			batch.error = ERR_OUT_OF_RANGE;
+			break;
+		}
 
-						if (isValue(word))
-						{
-							double azimuth = strtod(word, NULL);
+		addTableRow(&batch, str);
+	}
 
-							word = strtok(NULL, COMMA);	// get next token
+	fclose(file);
+	sendTableBatch(&batch);
+}
 
-							if (isValue(word))
-							{
-								double inclination = strtod(word, NULL);
+//---------------------------------------------------------------------------
+// Reads <count> rows following the command line, in the present vector
+// table coordinates and field units. All rows are read even after an error
+// so they are not parsed as commands.
+//---------------------------------------------------------------------------
+void Parser::uploadTable(int table, char *args)
+{
+	char *word = strtok(args, SPACE);
 
-								if (inclination >= 0.0 && inclination <= 180.0)	// angle from Z-axis must be >= 0 and <= 180 degrees
-								{
-									// now check vector
-									double x, y, z;
-									sphericalToCartesian(mag, azimuth, inclination, &x, &y, &z);
+	if (!isValue(word))
+	{
+		addArgumentError(word);
+		return;
+	}
 
-									VectorError error = source->check_vector(x, y, z);
+	int count = (int)strtod(word, NULL);
 
-									if (error == NO_VECTOR_ERROR)
-									{
-										if (source->isConnected())
-										{
-											word = strtok(NULL, COMMA);	// get next token
-
-											// check time arg
-											if (isValue(word))
-											{
-												double time = strtod(word, NULL);
-
-												if (time >= 0)
-												{
-													// good vector!!!
-													emit set_vector(mag, azimuth, inclination, (int)time);
-												}
-												else
-												{
-													addToErrorQueue(ERR_INVALID_ARGUMENT); // time can't be negative, error
-												}
-											}
-											else
-											{
-												if (word == NULL)
-												{
-													// good vector!!! zero time with no arg
-													emit set_vector(mag, azimuth, inclination, 0);
-												}
-												else
-													addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-											}
-										}
-										else
-										{
-											addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-										}
-									}
-									else
-									{
-										int errorCode = -150 - (int)error;
-										addToErrorQueue((SystemError)errorCode); // report vector error
-									}
-								}
-								else
-								{
-									addToErrorQueue(ERR_INCLINATION_OUT_OF_RANGE); // inclination out of range, error
-								}
-							}
-							else
-							{
-								if (word == NULL)
-									addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-								else
-									addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-							}
-						}
-						else
-						{
-							if (word == NULL)
-								addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-							else
-								addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_NEGATIVE_MAGNITUDE); // negative magnitude, error
+	if (count < 0 || count > MAX_TABLE_ROWS)
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);
+		return;
+	}
+
+	TableBatch batch;
+	batch.table = table;
+	batch.coordinates = snapshot.tableCoordinates;
+	batch.unitScale = 1.0;
+	batch.error = ERR_NONE;
+
+	QByteArray line;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (!readInputLine(&line))
+		{
+			addToErrorQueue(ERR_MISSING_PARAMETER);	// input ended within the block
+			return;
+		}
+
+		addTableRow(&batch, line.data());
+	}
+
+	if (tableLoadAllowed(table))
+		sendTableBatch(&batch);
+}
+
+//---------------------------------------------------------------------------
+// Validates and sends rows built by a sequence TABLE block as one upload,
+// in the given vector coordinates or the present ones if negative
+//---------------------------------------------------------------------------
+void Parser::uploadTableRows(int table, int coordinates, const QList<QByteArray> &rows)
+{
+	if (rows.count() > MAX_TABLE_ROWS)
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);
+		return;
+	}
+
+	TableBatch batch;
+	batch.table = table;
+	batch.coordinates = (coordinates < 0) ? snapshot.tableCoordinates : coordinates;
+	batch.unitScale = 1.0;
+	batch.error = ERR_NONE;
+
+	for (QByteArray row : rows)
+		addTableRow(&batch, row.data());	// parsed in place, so on a copy
+
+	if (tableLoadAllowed(table))
+		sendTableBatch(&batch);
+}
+
+//---------------------------------------------------------------------------
+// Responds with the table dump header: the row count, and for the vector
+// table the CoordinatesSelection. The rows follow the response line, see
+// readTableRow(). The table is copied on the GUI thread; if that does not
+// happen within TABLE_DUMP_TIMEOUT the query fails and the copy is
+// discarded whenever it is made.
+//---------------------------------------------------------------------------
+void Parser::dumpTable(int table, RecordFields *response)
+{
+	RemoteSnapshot latest = snapshot;
+	QDeadlineTimer deadline(TABLE_DUMP_TIMEOUT);
+	PendingRows rows;
+	quint64 token = ++syncTokens;
+
+	emit dump_table(table, token, LatencyStats::now());
+
+	while (!source->take_table_dump(token, &rows.table))
+	{
+		if (cancelled() || deadline.hasExpired())
+		{
+			source->discard_table_dump(token);
+			addToErrorQueue(ERR_TABLE_TIMEOUT);
+			return;
+		}
+
+		source->wait_snapshot(&latest, 1000);
+	}
+
+	response->addInteger(rows.table.contents.rows);
+
+	if (table != POLAR_TABLE)
+		response->addInteger(rows.table.coordinates);
+
+	rows.reader = &Parser::readTableRow;
+	pendingRows.append(rows);
+}
+
+//---------------------------------------------------------------------------
+// Makes a table row the target once the GUI thread has checked it, the
+// only thread that may read the tables while their rows can be replaced.
+// Reports ERR_OUT_OF_RANGE, ERR_TABLE_BUSY or the vector error of the row
+// it finds; if the check is not made within SYNC_TIMEOUT it is discarded
+// with the target left unchanged.
+//---------------------------------------------------------------------------
+void Parser::gotoTableRow(int table, int tableRow)
+{
+	RemoteSnapshot latest = snapshot;
+	QDeadlineTimer deadline(SYNC_TIMEOUT);
+	RemoteRowCheck check;
+	quint64 token = ++syncTokens;
+
+	if (table == POLAR_TABLE)
+		emit goto_polar(tableRow, token, LatencyStats::now());
+	else
+		emit goto_vector(tableRow, token, LatencyStats::now());
+
+	while (!source->take_row_check(token, &check))
+	{
+		if (cancelled() || deadline.hasExpired())
+		{
+			source->discard_row_check(token);
+			addToErrorQueue(ERR_ROW_CHECK_TIMEOUT);
+			return;
+		}
+
+		source->wait_snapshot(&latest, 1000);
+	}
+
+	if (check.loading)
+	{
+		addToErrorQueue(ERR_TABLE_BUSY);	// rows are being replaced by a file load
+	}
+	else if (!check.inRange)
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);	// table index out of range
+	}
+	else if (check.error != NO_VECTOR_ERROR)
+	{
+		int errorCode = -150 - (int)check.error;
+		addToErrorQueue((SystemError)errorCode); // report vector error
+	}
+}
+
+//---------------------------------------------------------------------------
+// Parses a WAIT timeout in seconds, returns false and reports the error if
+// missing or negative
+//---------------------------------------------------------------------------
+bool Parser::parseTimeout(char *word, double *timeout)
+{
+	if (!isValue(word))
+	{
+		addArgumentError(word);
+		return false;
+	}
+
+	*timeout = strtod(word, NULL);
+
+	if (*timeout < 0.0)
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Refreshes the snapshot once the GUI has executed the commands this client
+// sent so far, returns false if stopped or not done within SYNC_TIMEOUT
+//---------------------------------------------------------------------------
+bool Parser::syncSnapshot(void)
+{
+	QDeadlineTimer deadline(SYNC_TIMEOUT);
+	quint64 token = ++syncTokens;
+	quint64 queued = switchCommands.load();
+
+	emit sync(token, LatencyStats::now());
+
+	while (snapshot.syncToken < token)
+	{
+		if (cancelled() || deadline.hasExpired())
+			return false;
+
+		flushOutput();
+		source->wait_snapshot(&snapshot, 1000);
+	}
+
+	switchCommandsSeen = queued;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Blocks this client until the condition is met, can no longer be met
+// (quench, disconnect, auto-step ended, app failed) or the timeout in seconds expires;
+// a negative timeout waits indefinitely. Commands this client sent before
+// the wait are synchronized first, so the wait never acts on the state
+// from before them. The snapshot is left at the final state for the
+// response and any commands that follow in the same line.
+//---------------------------------------------------------------------------
+bool Parser::waitFor(WaitCondition condition, int row, double timeout)
+{
+	QDeadlineTimer deadline(QDeadlineTimer::Forever);
+	quint64 token = ++syncTokens;
+	quint64 queued = switchCommands.load();
+
+	if (timeout >= 0.0)
+		deadline.setRemainingTime((qint64)(timeout * 1000.0));
+
+	emit sync(token, LatencyStats::now());
+
+	while (!cancelled())
+	{
+		if (snapshot.syncToken >= token)
+		{
+			switchCommandsSeen = queued;
+
+			SystemState state = (SystemState)snapshot.state;
+
+			if (!snapshot.connected || state == SYSTEM_QUENCH)
+				return false;
+
+			// a target sent before the wait may still be waiting for a measurement
+			bool targetPending = (snapshot.pendingActions > 0);
+
+			if (condition == WAIT_HOLDING && state == SYSTEM_HOLDING && !targetPending)
+				return true;
+			else if (condition == WAIT_PERSISTENT && snapshot.persistent && state != SYSTEM_COOLING && !targetPending)
+				return true;
+			else if (condition == WAIT_STEP)
+			{
+				if (snapshot.stepRow >= row)
+					return true;
+				else if (!snapshot.autostepActive)
+					return false;
+			}
+			else if (condition == WAIT_APP && !snapshot.appRunning)
+			{
+				return snapshot.appExitCode == 0;
+			}
+		}
+
+		if (deadline.hasExpired())
+			return false;
+
+		// wake at least once a second to notice stop(), deliver any events meanwhile
+		flushOutput();
+
+		qint64 remaining = deadline.remainingTime();
+		source->wait_snapshot(&snapshot, (remaining < 0 || remaining > 1000) ? 1000 : (unsigned long)remaining);
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// Takes the most recent queued error code and clears the queue, returns
+// false if no error is queued
+//---------------------------------------------------------------------------
+bool Parser::takeError(int *code)
+{
+	if (errorStack.isEmpty())
+		return false;
+
+	*code = errorStack.top();
+	errorStack.clear();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Reports a missing or malformed argument
+//---------------------------------------------------------------------------
+void Parser::addArgumentError(const char *word)
+{
+	if (word == NULL)
+		addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
+	else
+		addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+}
+
+//---------------------------------------------------------------------------
+// Checks RAMP, PAUSE and ZERO are allowed in the present state
+//---------------------------------------------------------------------------
+bool Parser::rampCommandAllowed(char *args)
+{
+	// make sure there are not additional args
+	if (*args != '\0')
+	{
+		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+	}
+	else if (!snapshot.connected)
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+	}
+	else
+	{
+		SystemState state = (SystemState)snapshot.state;
+
+		if (state == SYSTEM_HEATING || state == SYSTEM_COOLING)
+			addToErrorQueue(ERR_SWITCH_TRANSITION);
+		else if (snapshot.persistent)
+			addToErrorQueue(ERR_IS_PERSISTENT);
+		else
+			return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// Checks CONFigure:TARGet commands are allowed in the present state
+//---------------------------------------------------------------------------
+bool Parser::targetCommandAllowed(void)
+{
+	// a PERSistent command from any session may not be in the snapshot yet,
+	// commandMutex is held so no other can be queued until this one is
+	if (switchCommands.load() != switchCommandsSeen)
+		syncSnapshot();
+
+	SystemState state = (SystemState)snapshot.state;
+
+	if (state == SYSTEM_HEATING || state == SYSTEM_COOLING)
+		addToErrorQueue(ERR_SWITCH_TRANSITION);
+	else if (snapshot.persistent)
+		addToErrorQueue(ERR_IS_PERSISTENT);
+	else
+		return true;
+
+	return false;
+}
+
+
+//---------------------------------------------------------------------------
+// Query handlers
+//---------------------------------------------------------------------------
+void Parser::query_idn(char *args, RecordFields *response)
+{
+	response->addString(qApp->applicationName());
+	response->addString(qApp->applicationVersion());
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_align1(char *args, RecordFields *response)
+{
+	// return spherical coordinates
+	response->addReal(snapshot.align1[0]);
+	response->addReal(snapshot.align1[1]);
+	response->addReal(snapshot.align1[2]);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_align1_cartesian(char *args, RecordFields *response)
+{
+	double x, y, z;
+
+	sphericalToCartesian(snapshot.align1[0], snapshot.align1[1], snapshot.align1[2], &x, &y, &z);
+	response->addReal(x);
+	response->addReal(y);
+	response->addReal(z);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_align2(char *args, RecordFields *response)
+{
+	// return spherical coordinates
+	response->addReal(snapshot.align2[0]);
+	response->addReal(snapshot.align2[1]);
+	response->addReal(snapshot.align2[2]);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_align2_cartesian(char *args, RecordFields *response)
+{
+	double x, y, z;
+
+	sphericalToCartesian(snapshot.align2[0], snapshot.align2[1], snapshot.align2[2], &x, &y, &z);
+	response->addReal(x);
+	response->addReal(y);
+	response->addReal(z);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_field(char *args, RecordFields *response)
+{
+	if (snapshot.connected)
+	{
+		// return spherical coordinates
+		response->addReal(snapshot.fieldSpherical[0]);
+		response->addReal(snapshot.fieldSpherical[1]);
+		response->addReal(snapshot.fieldSpherical[2]);
+	}
+	else
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+	}
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_field_cartesian(char *args, RecordFields *response)
+{
+	if (snapshot.connected)
+	{
+		response->addReal(snapshot.field[0]);
+		response->addReal(snapshot.field[1]);
+		response->addReal(snapshot.field[2]);
+	}
+	else
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+	}
+}
+
+//---------------------------------------------------------------------------
+// HISTory? <from>,<to>
+// Acquisition history samples with times in [from, to], in msec since the
+// history started (on connecting). Responds with the sample count, the
+// FieldUnits of the samples and the start of the history in msec since the
+// epoch; that many rows follow, see readHistoryRow(). The history is
+// copied a batch at a time, so a range of any length streams to the client.
+void Parser::query_history(char *args, RecordFields *response)
+{
+	char *word = strtok(args, LIST);
+	qint64 range[2];
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (!isValue(word))
+		{
+			addArgumentError(word);
+			return;
+		}
+
+		range[i] = (qint64)strtod(word, NULL);
+		word = strtok(NULL, LIST);
+	}
+
+	if (range[0] < 0 || range[1] < range[0])
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);
+		return;
+	}
+
+	PendingRows rows;
+
+	if (!fetchHistory(range[0], range[1], &rows.history))
+		return;
+
+	rows.reader = &Parser::readHistoryRow;
+	rows.total = rows.history.total;
+	rows.historyTo = range[1];
+	rows.historyStart = rows.history.start;
+	response->addInteger(rows.total);
+	response->addInteger(rows.history.units);
+	response->addInteger(rows.history.start);
+	pendingRows.append(rows);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_persistent(char *args, RecordFields *response)
+{
+	response->addInteger(snapshot.persistent ? 1 : 0);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_plane(char *args, RecordFields *response)
+{
+	response->addReal(snapshot.plane[0]);
+	response->addReal(snapshot.plane[1]);
+	response->addReal(snapshot.plane[2]);
+}
+
+//---------------------------------------------------------------------------
+// SEQuence:STATE? responds <state>,<line>,<error>, the script line running
+// or last run and the error code that ended the sequence (0 if none)
+void Parser::query_sequence_state(char *args, RecordFields *response)
+{
+	SequenceState state = SEQUENCE_EMPTY;
+	int line = 0;
+	int error = 0;
+
+	Sequencer::Instance sequencer;
+
+	if (sequencer)
+		sequencer->status(&state, &line, &error);
+
+	response->addString(sequenceStateName(state));
+	response->addInteger(line);
+	response->addInteger(error);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_state(char *args, RecordFields *response)
+{
+	response->addInteger(snapshot.state);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_system_error(char *args, RecordFields *response)
+{
+	if (errorStack.count())
+	{
+		SystemError error = errorStack.pop();
+
+		response->addInteger(error);
+		response->addString(errorText(error), true);
+	}
+	else
+	{
+		response->addInteger(0);
+		response->addString("No error", true);
+	}
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_system_error_count(char *args, RecordFields *response)
+{
+	response->addInteger(errorStack.count());
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_system_format(char *args, RecordFields *response)
+{
+	response->addString(outputFormatName((OutputFormat)outputFormat.load()));
+}
+
+//---------------------------------------------------------------------------
+// Responds with the number of latency histograms holding samples, which
+// follow one per line as <group>,<name>,<count>,<p50>,<p90>,<p99>,<p99.9>,<max>
+// in usec. Groups are CMD (parser time per command), STAGE (GUI thread)
+// and AXIS (Magnet-DAQ query round trips).
+//---------------------------------------------------------------------------
+void Parser::query_system_stats(char *args, RecordFields *response)
+{
+	PendingRows rows;
+
+	rows.reader = &Parser::readStatsRow;
+	rows.stats = LatencyStats::reportEntries();
+	response->addInteger(rows.stats.count());
+	pendingRows.append(rows);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_system_subscribe(char *args, RecordFields *response)
+{
+	int mask = subscriptions.load();
+
+	for (int i = 0; i < NUM_EVENT_NAMES; i++)
+	{
+		if (mask & eventNames[i].event)
+			response->addString(eventNames[i].name);
+	}
+
+	if (response->isEmpty())
+		response->addString("NONE");
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_table_vector(char *args, RecordFields *response)
+{
+	dumpTable(VECTOR_TABLE, response);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_table_polar(char *args, RecordFields *response)
+{
+	dumpTable(POLAR_TABLE, response);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_target(char *args, RecordFields *response)
+{
+	if (snapshot.connected)
+	{
+		// return spherical coordinates
+		response->addReal(snapshot.targetSpherical[0]);
+		response->addReal(snapshot.targetSpherical[1]);
+		response->addReal(snapshot.targetSpherical[2]);
+	}
+	else
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED);
+	}
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_target_cartesian(char *args, RecordFields *response)
+{
+	if (snapshot.connected)
+	{
+		response->addReal(snapshot.target[0]);
+		response->addReal(snapshot.target[1]);
+		response->addReal(snapshot.target[2]);
+	}
+	else
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED);
+	}
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_target_time(char *args, RecordFields *response)
+{
+	response->addInteger(snapshot.remainingTime);
+}
+
+//---------------------------------------------------------------------------
+void Parser::query_units(char *args, RecordFields *response)
+{
+	response->addInteger(snapshot.fieldUnits);
+}
+
+
+//---------------------------------------------------------------------------
+// Command handlers
+//---------------------------------------------------------------------------
+void Parser::command_cls(char *args, RecordFields *response)
+{
+	errorStack.clear();
+}
+
+//---------------------------------------------------------------------------
+void Parser::command_exit(char *args, RecordFields *response)
+{
+	emit exit_app(LatencyStats::now());
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:ALIGN1 <mag>,<az>,<inc>
+void Parser::command_conf_align1(char *args, RecordFields *response)
+{
+	configure_align(args, false);
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:ALIGN2 <mag>,<az>,<inc>
+void Parser::command_conf_align2(char *args, RecordFields *response)
+{
+	configure_align(args, true);
+}
+
+//---------------------------------------------------------------------------
+void Parser::configure_align(char *args, bool alignSelect)
+{
+	char *word = strtok(args, COMMA);	// get first token
+
+	if (isValue(word))
+	{
+		double mag = strtod(word, NULL);
+
+		if (mag >= 0.0)	// magnitude cannot be negative
+		{
+			word = strtok(NULL, COMMA);	// get next token
+
+			if (isValue(word))
+			{
+				double azimuth = strtod(word, NULL);
+
+				word = strtok(NULL, COMMA);	// get next token
+
+				if (isValue(word))
+				{
+					double inclination = strtod(word, NULL);
+
+					if (inclination >= 0.0 && inclination <= 180.0)	// angle from Z-axis must be >= 0 and <= 180 degrees
+					{
+						// now check vector
+						double x, y, z;
+						sphericalToCartesian(mag, azimuth, inclination, &x, &y, &z);
+
+						VectorError error = source->check_vector(x, y, z);
+
+						if (error == NO_VECTOR_ERROR)
+						{
+							if (snapshot.connected)
+							{
+								// good vector!!!
+								if (alignSelect)
+									emit set_align2(mag, azimuth, inclination, LatencyStats::now());
+								else
+									emit set_align1(mag, azimuth, inclination, LatencyStats::now());
+							}
+							else
+							{
+								addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+							}
+						}
+						else
+						{
+							int errorCode = -150 - (int)error;
+							addToErrorQueue((SystemError)errorCode); // report vector error
+						}
+					}
+					else
+					{
+						addToErrorQueue(ERR_INCLINATION_OUT_OF_RANGE); // inclination out of range, error
+					}
+				}
+				else
+				{
+					addArgumentError(word);
+				}
+			}
+			else
+			{
+				addArgumentError(word);
+			}
+		}
+		else
+		{
+			addToErrorQueue(ERR_NEGATIVE_MAGNITUDE); // negative magnitude, error
+		}
+	}
+	else
+	{
+		addArgumentError(word);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:ALIGN1
+void Parser::command_conf_target_align1(char *args, RecordFields *response)
+{
+	configure_target_align(args, false);
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:ALIGN2
+void Parser::command_conf_target_align2(char *args, RecordFields *response)
+{
+	configure_target_align(args, true);
+}
+
+//---------------------------------------------------------------------------
+void Parser::configure_target_align(char *args, bool alignSelect)
+{
+	if (targetCommandAllowed())
+	{
+		if (*args != '\0')
+		{
+			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, extraneous args, error
+		}
+		else if (snapshot.connected)
+		{
+			if (alignSelect)
+				emit set_align2_active(LatencyStats::now());
+			else
+				emit set_align1_active(LatencyStats::now());
+		}
+		else
+		{
+			addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:VECtor <mag>,<az>,<inc>[,<time>]
+void Parser::command_conf_target_vector(char *args, RecordFields *response)
+{
+	if (!targetCommandAllowed())
+		return;
+
+	char *word = strtok(args, COMMA);	// get first token
+
+	if (isValue(word))
+	{
+		double mag = strtod(word, NULL);
+
+		if (mag >= 0.0)	// magnitude cannot be negative
+		{
+			word = strtok(NULL, COMMA);	// get next token
+
+			if (isValue(word))
+			{
+				double azimuth = strtod(word, NULL);
+
+				word = strtok(NULL, COMMA);	// get next token
+
+				if (isValue(word))
+				{
+					double inclination = strtod(word, NULL);
+
+					if (inclination >= 0.0 && inclination <= 180.0)	// angle from Z-axis must be >= 0 and <= 180 degrees
+					{
+						// now check vector
+						double x, y, z;
+						sphericalToCartesian(mag, azimuth, inclination, &x, &y, &z);
+
+						VectorError error = source->check_vector(x, y, z);
+
+						if (error == NO_VECTOR_ERROR)
+						{
+							if (snapshot.connected)
+							{
+								word = strtok(NULL, COMMA);	// get next token
+
+								// check time arg
+								if (isValue(word))
+								{
+									double time = strtod(word, NULL);
+
+									if (time >= 0)
+									{
+										// good vector!!!
+										emit set_vector(mag, azimuth, inclination, (int)time, LatencyStats::now());
+									}
+									else
+									{
+										addToErrorQueue(ERR_INVALID_ARGUMENT); // time can't be negative, error
+									}
+								}
+								else
+								{
+									if (word == NULL)
+									{
+										// good vector!!! zero time with no arg
+										emit set_vector(mag, azimuth, inclination, 0, LatencyStats::now());
+									}
+									else
+										addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+								}
+							}
+							else
+							{
+								addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+							}
+						}
+						else
+						{
+							int errorCode = -150 - (int)error;
+							addToErrorQueue((SystemError)errorCode); // report vector error
+						}
+					}
+					else
+					{
+						addToErrorQueue(ERR_INCLINATION_OUT_OF_RANGE); // inclination out of range, error
+					}
+				}
+				else
+				{
+					addArgumentError(word);
+				}
+			}
+			else
+			{
+				addArgumentError(word);
+			}
+		}
+		else
+		{
+			addToErrorQueue(ERR_NEGATIVE_MAGNITUDE); // negative magnitude, error
+		}
+	}
+	else
+	{
+		addArgumentError(word);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:VECtor:CARTesian <x>,<y>,<z>[,<time>]
+void Parser::command_conf_target_vector_cartesian(char *args, RecordFields *response)
+{
+	if (!targetCommandAllowed())
+		return;
+
+	char *word = strtok(args, COMMA);	// get first token
+
+	if (isValue(word))
+	{
+		double x = strtod(word, NULL);
+
+		word = strtok(NULL, COMMA);	// get next token
+
+		if (isValue(word))
+		{
+			double y = strtod(word, NULL);
+
+			word = strtok(NULL, COMMA);	// get next token
+
+			if (isValue(word))
+			{
+				double z = strtod(word, NULL);
+
+				// now check vector
+				VectorError error = source->check_vector(x, y, z);
+
+				if (error == NO_VECTOR_ERROR)
+				{
+					if (snapshot.connected)
+					{
+						word = strtok(NULL, COMMA);	// get next token
+
+						// check time arg
+						if (isValue(word))
+						{
+							double time = strtod(word, NULL);
+
+							if (time >= 0)
+							{
+								// good vector!!!
+								emit set_vector_cartesian(x, y, z, (int)time, LatencyStats::now());
+							}
+							else
+							{
+								addToErrorQueue(ERR_INVALID_ARGUMENT); // time can't be negative, error
+							}
+						}
+						else
+						{
+							if (word == NULL)
+							{
+								// good vector!!! assume zero time with no 4th arg
+								emit set_vector_cartesian(x, y, z, 0, LatencyStats::now());
+							}
+							else
+								addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+						}
+					}
+					else
+					{
+						addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
 					}
 				}
 				else
 				{
-					if (word == NULL)
-						addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
+					int errorCode = -150 - (int)error;
+					addToErrorQueue((SystemError)errorCode); // report vector error
+				}
+			}
+			else
+			{
+				addArgumentError(word);
+			}
+		}
+		else
+		{
+			addArgumentError(word);
+		}
+	}
+	else
+	{
+		addArgumentError(word);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:VECtor:TABle <row>
+void Parser::command_conf_target_vector_table(char *args, RecordFields *response)
+{
+	if (!targetCommandAllowed())
+		return;
+
+	if (snapshot.vectorLoading)
+	{
+		addToErrorQueue(ERR_TABLE_BUSY);	// rows are being replaced by a file load
+		return;
+	}
+
+	char *word = strtok(args, SPACE);	// look for value
+
+	if (isValue(word))
+	{
+		if (snapshot.connected)
+		{
+			int tableRow = (int)strtod(word, NULL) - 1;	// table has programmatic index 0, while on-screen starts at 1
+
+			gotoTableRow(VECTOR_TABLE, tableRow);
+		}
+		else
+		{
+			addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+		}
+	}
+	else
+	{
+		addArgumentError(word);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:POLar <mag>,<angle>[,<time>]
+void Parser::command_conf_target_polar(char *args, RecordFields *response)
+{
+	if (!targetCommandAllowed())
+		return;
+
+	char *word = strtok(args, COMMA);	// get first token
+
+	if (isValue(word))
+	{
+		double mag = strtod(word, NULL);
+
+		if (mag >= 0.0)	// magnitude cannot be negative
+		{
+			word = strtok(NULL, COMMA);	// get next token
+
+			if (isValue(word))
+			{
+				double angle = strtod(word, NULL);
+
+				// now check vector
+				QVector3D vector;
+
+				source->polarToCartesian(mag, angle, &vector);
+
+				VectorError error = source->check_vector(vector.x(), vector.y(), vector.z());
+
+				if (error == NO_VECTOR_ERROR)
+				{
+					if (snapshot.connected)
+					{
+						word = strtok(NULL, COMMA);	// get next token
+
+						// check time arg
+						if (isValue(word))
+						{
+							double time = strtod(word, NULL);
+
+							if (time >= 0)
+							{
+								// good vector!!!
+								emit set_polar(mag, angle, (int)time, LatencyStats::now());
+							}
+							else
+							{
+								addToErrorQueue(ERR_INVALID_ARGUMENT); // time can't be negative, error
+							}
+						}
+						else
+						{
+							if (word == NULL)
+							{
+								// good vector!!! zero time with no arg
+								emit set_polar(mag, angle, 0, LatencyStats::now());
+							}
+							else
+								addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+						}
+					}
 					else
-						addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+					{
+						addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+					}
+				}
+				else
+				{
+					int errorCode = -150 - (int)error;
+					addToErrorQueue((SystemError)errorCode); // report vector error
 				}
 			}
+			else
+			{
+				addArgumentError(word);
+			}
+		}
+		else
+		{
+			addToErrorQueue(ERR_NEGATIVE_MAGNITUDE); // negative magnitude, error
+		}
+	}
+	else
+	{
+		addArgumentError(word);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:TARGet:POLar:TABle <row>
+void Parser::command_conf_target_polar_table(char *args, RecordFields *response)
+{
+	if (!targetCommandAllowed())
+		return;
+
+	if (snapshot.polarLoading)
+	{
+		addToErrorQueue(ERR_TABLE_BUSY);	// rows are being replaced by a file load
+		return;
+	}
+
+	char *word = strtok(args, SPACE);	// look for value
+
+	if (isValue(word))
+	{
+		if (snapshot.connected)
+		{
+			int tableRow = (int)strtod(word, NULL) - 1;	// table has programmatic index 0, while on-screen starts at 1
+
+			gotoTableRow(POLAR_TABLE, tableRow);
+		}
+		else
+		{
+			addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+		}
+	}
+	else
+	{
+		addArgumentError(word);
+	}
+}
+
+//---------------------------------------------------------------------------
+// CONFigure:UNITS 0|1
+void Parser::command_conf_units(char *args, RecordFields *response)
+{
+	if (snapshot.connected)
+	{
+		addToErrorQueue(ERR_NO_UNITS_CHANGE); // cannot change units after connect, error
+	}
+	else
+	{
+		char *value = strtok(args, SPACE);	// look for value
+
+		if (isValue(value))
+		{
+			while (isspace(*value))
+				value++;
+
+			if (*value == '1')
+			{
+				emit set_units(1, LatencyStats::now());
+			}
+			else if (*value == '0')
+			{
+				emit set_units(0, LatencyStats::now());
+			}
+			else
+			{
+				addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+			}
+		}
+		else
+		{
+			addArgumentError(value);
 		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// LOAD without a recognized argument
+void Parser::command_load(char *args, RecordFields *response)
+{
+	if (*args == '\0')
+		addToErrorQueue(ERR_MISSING_PARAMETER);	// no argument for LOAD, command error
+	else
+		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+}
+
+//---------------------------------------------------------------------------
+// LOAD:SETtings <filename>
+void Parser::command_load_settings(char *args, RecordFields *response)
+{
+	// case sensitive filenames on Unix systems!
+	char *filename = trimwhitespace(args);
+
+	if (*filename == '\0')
+	{
+		// no filename for LOAD:SETtings, command error
+		addToErrorQueue(ERR_MISSING_PARAMETER);
+	}
+	else if (snapshot.connected)
+	{
+		addToErrorQueue(ERR_CANNOT_LOAD);
+	}
+	else
+	{
+		FILE *file = fopen(filename, "r");
 
-		// tests CONFigure:TARGet:POLar, CONFigure:TARGet:POLar:TABle
-		else if (strcmp(word, _POL) == 0 || strcmp(word, _POLAR) == 0)
+		if (file == NULL)
+		{
+			// error in filename
+			addToErrorQueue(ERR_INVALID_ARGUMENT);
+		}
+		else
 		{
-			char args[256];
-			word = strtok(NULL, DELIMITER);	// get next token
-			strncpy(args, word, 255);		// make a copy
+			bool success;
+			emit load_settings(file, &success, LatencyStats::now());
+		}
+	}
+}
 
-			word = strtok(word, SEPARATOR);	// get next token
-			word = struprt(word);	// convert to uppercase
+//---------------------------------------------------------------------------
+// LOAD:VECtor <filename>
+void Parser::command_load_vector(char *args, RecordFields *response)
+{
+	loadTableFile(VECTOR_TABLE, args);
+}
 
-			if (word == NULL)
-			{
-				addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);
-			}
-			else if (strcmp(word, _TAB) == 0 || strcmp(word, _TABLE) == 0)
-			{
-				// check for value
-				word = strtok(NULL, SEPARATOR);	// get next token
+//---------------------------------------------------------------------------
+// LOAD:POLar <filename>
+void Parser::command_load_polar(char *args, RecordFields *response)
+{
+	loadTableFile(POLAR_TABLE, args);
+}
 
-				if (isValue(word))
-				{
-					if (source->isConnected())
-					{
-						int tableRow = (int)strtod(word, NULL) - 1;	// table has programmatic index 0, while on-screen starts at 1
+//---------------------------------------------------------------------------
+void Parser::command_pause(char *args, RecordFields *response)
+{
+	if (rampCommandAllowed(args))
+		emit pause(LatencyStats::now());
+}
 
-						// check for valid table index
-						bool indexInRange = source->polar_table_row_in_range(tableRow);
+//---------------------------------------------------------------------------
+// PERSistent 0|1
+void Parser::command_persistent(char *args, RecordFields *response)
+{
+	char *value = strtok(args, SPACE);		// look for value
 
-						if (indexInRange)
-						{
-							// check range and vector value
-							VectorError error = source->check_polar_table(tableRow);
+	if (isValue(value))
+	{
+		while (isspace(*value))
+			value++;
 
-							if (error == NO_VECTOR_ERROR)
-							{
-								emit goto_polar(tableRow);
-							}
-							else
-							{
-								int errorCode = -150 - (int)error;
-								addToErrorQueue((SystemError)errorCode); // report vector error
-							}
+		if (*value == '1' || *value == '0')
+		{
+			if (snapshot.connected)
+			{
+				if (*value == '1')
+				{
+					SystemState state = (SystemState)snapshot.state;
+					if (state == SYSTEM_HOLDING || state == SYSTEM_PAUSED)
+					{
+						if (snapshot.switchInstalled)
+						{
+							emit set_persistence(true, LatencyStats::now());
+							switchCommands++;
 						}
 						else
 						{
-							// table index out of range
-							addToErrorQueue(ERR_OUT_OF_RANGE);
+							addToErrorQueue(ERR_NO_SWITCH);
 						}
 					}
 					else
 					{
-						addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+						addToErrorQueue(ERR_NO_PERSISTENCE); // cannot enter persistent mode, error
 					}
 				}
 				else
 				{
-					if (word == NULL)
-						addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
+					if (snapshot.switchInstalled)
+					{
+						emit set_persistence(false, LatencyStats::now());
+						switchCommands++;
+					}
 					else
-						addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
+					{
+						addToErrorQueue(ERR_NO_SWITCH);
+					}
 				}
 			}
-
-			else // check string for values for CONFigure:TARGet:POLar
+			else
 			{
-				// check for value
-				word = args;
-				word = strtok(word, COMMA);	// get next token
+				addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+			}
+		}
+		else
+		{
+			addToErrorQueue(ERR_NON_BOOLEAN_ARGUMENT); // invalid argument, error
+		}
+	}
+	else
+	{
+		addArgumentError(value);
+	}
+}
 
-				if (isValue(word))
-				{
-					double mag = strtod(word, NULL);
+//---------------------------------------------------------------------------
+void Parser::command_ramp(char *args, RecordFields *response)
+{
+	if (rampCommandAllowed(args))
+		emit ramp(LatencyStats::now());
+}
 
-					if (mag >= 0.0)	// magnitude cannot be negative
-					{
-						word = strtok(NULL, COMMA);	// get next token
+//---------------------------------------------------------------------------
+// SAVE without a recognized argument
+void Parser::command_save(char *args, RecordFields *response)
+{
+	if (*args == '\0')
+		addToErrorQueue(ERR_MISSING_PARAMETER);	// no argument for SAVE, command error
+	else
+		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND);	// no match, error
+}
 
-						if (isValue(word))
-						{
-							double angle = strtod(word, NULL);
+//---------------------------------------------------------------------------
+// SAVE:SETtings <filename>
+void Parser::command_save_settings(char *args, RecordFields *response)
+{
+	// case sensitive filenames on Unix systems!
+	char *filename = trimwhitespace(args);
 
-							word = strtok(NULL, COMMA);	// get next token
+	if (*filename == '\0')
+	{
+		// no filename for SAVE:SETtings, command error
+		addToErrorQueue(ERR_MISSING_PARAMETER);
+	}
+	else
+	{
+		FILE *file = fopen(filename, "w");
 
-							// now check vector
-							QVector3D vector;
+		if (file == NULL)
+		{
+			// error in filename
+			addToErrorQueue(ERR_INVALID_ARGUMENT);
+		}
+		else
+		{
+			bool success;
+			emit save_settings(file, &success, LatencyStats::now());
+		}
+	}
+}
 
-							source->polarToCartesian(mag, angle, &vector);
+//---------------------------------------------------------------------------
+void Parser::command_sequence_abort(char *args, RecordFields *response)
+{
+	Sequencer::Instance sequencer;
 
-							VectorError error = source->check_vector(vector.x(), vector.y(), vector.z());
+	if (sequencer)
+		sequencer->abort();
+}
 
-							if (error == NO_VECTOR_ERROR)
-							{
-								if (source->isConnected())
-								{
-									word = strtok(NULL, COMMA);	// get next token
+//---------------------------------------------------------------------------
+// SEQuence:DEFine <count>, followed by <count> script lines
+void Parser::command_sequence_define(char *args, RecordFields *response)
+{
+	char *word = strtok(args, SPACE);
 
-									// check time arg
-									if (isValue(word))
-									{
-										double time = strtod(word, NULL);
-
-										if (time >= 0)
-										{
-											// good vector!!!
-											emit set_polar(mag, angle, (int)time);
-										}
-										else
-										{
-											addToErrorQueue(ERR_INVALID_ARGUMENT); // time can't be negative, error
-										}
-									}
-									else
-									{
-										if (word == NULL)
-										{
-											// good vector!!! zero time with no arg
-											emit set_polar(mag, angle, 0);
-										}
-										else
-											addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-									}
-								}
-								else
-								{
-									addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
-								}
-							}
-							else
-							{
-								int errorCode = -150 - (int)error;
-								addToErrorQueue((SystemError)errorCode); // report vector error
-							}
-						}
-						else
-						{
-							if (word == NULL)
-								addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-							else
-								addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-						}
-					}
-					else
-					{
-						addToErrorQueue(ERR_NEGATIVE_MAGNITUDE); // negative magnitude, error
-					}
-				}
-				else
-				{
-					if (word == NULL)
-						addToErrorQueue(ERR_MISSING_PARAMETER); // missing argument, error
-					else
-						addToErrorQueue(ERR_INVALID_ARGUMENT); // invalid argument, error
-				}
-			}
-		}
+	if (!isValue(word))
+	{
+		addArgumentError(word);
+		return;
+	}
 
-		else
+	int count = (int)strtod(word, NULL);
+
+	if (count < 0 || count > MAX_TABLE_ROWS)
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);
+		return;
+	}
+
+	QList<QByteArray> lines;
+	QByteArray line;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (!readInputLine(&line))
 		{
-			addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, error
+			addToErrorQueue(ERR_MISSING_PARAMETER);	// input ended within the block
+			return;
 		}
+
+		lines.append(line);
+	}
+
+	SystemError error;
+	Sequencer::Instance sequencer;
+
+	if (sequencer && !sequencer->define(lines, &error))
+		addToErrorQueue(error);
+}
+
+//---------------------------------------------------------------------------
+// SEQuence:LOAD <filename>, a text file of script lines
+void Parser::command_sequence_load(char *args, RecordFields *response)
+{
+	// case sensitive filenames on Unix systems!
+	char *filename = trimwhitespace(args);
+
+	if (*filename == '\0')
+	{
+		addToErrorQueue(ERR_MISSING_PARAMETER);
+		return;
+	}
+
+	QFile file(QString::fromLocal8Bit(filename));
+
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		// error in filename
+		addToErrorQueue(ERR_INVALID_ARGUMENT);
+		return;
+	}
+
+	QList<QByteArray> lines;
+
+	while (!file.atEnd())
+		lines.append(file.readLine());
+
+	SystemError error;
+	Sequencer::Instance sequencer;
+
+	if (sequencer && !sequencer->define(lines, &error))
+		addToErrorQueue(error);
+}
+
+//---------------------------------------------------------------------------
+void Parser::command_sequence_run(char *args, RecordFields *response)
+{
+	SystemError error;
+	Sequencer::Instance sequencer;
+
+	if (sequencer && !sequencer->run(&error))
+		addToErrorQueue(error);
+}
+
+//---------------------------------------------------------------------------
+void Parser::command_system_connect(char *args, RecordFields *response)
+{
+	emit system_connect(LatencyStats::now());
+}
+
+//---------------------------------------------------------------------------
+void Parser::command_system_disconnect(char *args, RecordFields *response)
+{
+	emit system_disconnect(LatencyStats::now());
+}
+
+//---------------------------------------------------------------------------
+// SYSTem:FORMat TEXT|JSON|BINARY, framing of all further output of this
+// session (see recordframing.h)
+void Parser::command_system_format(char *args, RecordFields *response)
+{
+	char *word = strtok(args, SPACE);
+
+	if (word == NULL)
+	{
+		addToErrorQueue(ERR_MISSING_PARAMETER);
+		return;
+	}
+
+	struprt(word);
+
+	if (strcmp(word, "TEXT") == 0)
+		outputFormat.store(FORMAT_TEXT);
+	else if (strcmp(word, "JSON") == 0)
+		outputFormat.store(FORMAT_JSON);
+	else if (strcmp(word, "BINARY") == 0)
+		outputFormat.store(FORMAT_BINARY);
+	else
+		addToErrorQueue(ERR_INVALID_ARGUMENT);
+}
+
+//---------------------------------------------------------------------------
+// SYSTem:SUBSCRIBE <event>[,<event>...], events are STATE, TARGET, STEP,
+// QUENCH, ACTION, SEQUENCE or ALL and are added to any present subscriptions
+void Parser::command_system_subscribe(char *args, RecordFields *response)
+{
+	int mask;
+
+	if (parseEventList(args, &mask))
+		subscriptions.fetch_or(mask);
+}
+
+//---------------------------------------------------------------------------
+// SYSTem:UNSubscribe [<event>[,<event>...]], all events if no list
+void Parser::command_system_unsubscribe(char *args, RecordFields *response)
+{
+	int mask;
+
+	if (*args == '\0')
+		subscriptions.store(0);
+	else if (parseEventList(args, &mask))
+		subscriptions.fetch_and(~mask);
+}
+
+//---------------------------------------------------------------------------
+// TABLE:VECtor <count>, followed by <count> lines of <c1>,<c2>,<c3>,<hold>[,<persist>]
+void Parser::command_table_vector(char *args, RecordFields *response)
+{
+	uploadTable(VECTOR_TABLE, args);
+}
+
+//---------------------------------------------------------------------------
+// TABLE:POLar <count>, followed by <count> lines of <mag>,<angle>,<hold>[,<persist>]
+void Parser::command_table_polar(char *args, RecordFields *response)
+{
+	uploadTable(POLAR_TABLE, args);
+}
+
+//---------------------------------------------------------------------------
+// WAIT:HOLDing <timeout>, responds <met 0|1>,<state>
+void Parser::command_wait_holding(char *args, RecordFields *response)
+{
+	double timeout;
+
+	if (!parseTimeout(strtok(args, SPACE), &timeout))
+		return;
+
+	if (!snapshot.connected)
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+		return;
+	}
+
+	bool met = waitFor(WAIT_HOLDING, 0, timeout);
+	response->addInteger(met ? 1 : 0);
+	response->addInteger(snapshot.state);
+}
+
+//---------------------------------------------------------------------------
+// WAIT:PERSistent <timeout>, responds <met 0|1>,<state>. Met once the
+// switch has finished cooling.
+void Parser::command_wait_persistent(char *args, RecordFields *response)
+{
+	double timeout;
+
+	if (!parseTimeout(strtok(args, SPACE), &timeout))
+		return;
+
+	if (!snapshot.connected)
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+	}
+	else if (!snapshot.switchInstalled)
+	{
+		addToErrorQueue(ERR_NO_SWITCH);
 	}
 	else
 	{
-		addToErrorQueue(ERR_UNRECOGNIZED_COMMAND); // no match, error
+		bool met = waitFor(WAIT_PERSISTENT, 0, timeout);
+		response->addInteger(met ? 1 : 0);
+		response->addInteger(snapshot.state);
 	}
 }
 
+//---------------------------------------------------------------------------
+// WAIT:STEP <row>[,<timeout>], responds <met 0|1>,<state>. Met once the
+// running vector or polar table auto-step has completed the row (1-based),
+// waits indefinitely without a timeout.
+void Parser::command_wait_step(char *args, RecordFields *response)
+{
+	char *word = strtok(args, LIST);
+	double timeout = -1.0;
+
+	if (!isValue(word))
+	{
+		addArgumentError(word);
+		return;
+	}
+
+	int row = (int)strtod(word, NULL);
+
+	if (row < 1)
+	{
+		addToErrorQueue(ERR_OUT_OF_RANGE);
+		return;
+	}
+
+	word = strtok(NULL, LIST);
+
+	if (word != NULL && !parseTimeout(word, &timeout))
+		return;
+
+	if (!snapshot.connected)
+	{
+		addToErrorQueue(ERR_NOT_CONNECTED); // not connected, error
+		return;
+	}
+
+	bool met = waitFor(WAIT_STEP, row, timeout);
+	response->addInteger(met ? 1 : 0);
+	response->addInteger(snapshot.state);
+}
 
 //---------------------------------------------------------------------------
+void Parser::command_zero(char *args, RecordFields *response)
+{
+	if (rampCommandAllowed(args))
+		emit zero(LatencyStats::now());
+}
 
 //---------------------------------------------------------------------------
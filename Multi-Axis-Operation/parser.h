@@ -3,7 +3,12 @@
 
 #include <QObject>
 #include <QStack>
+#include <QMutex>
+#include <atomic>
 #include "multiaxisoperation.h"
+#include "recordframing.h"
+#include "commandtree.h"
+#include "latencystats.h"
 
 //---------------------------------------------------------------------------
 // Type declarations
@@ -37,7 +42,16 @@ enum SystemError
 	ERR_NO_PERSISTENCE = -305,
 	ERR_IS_PERSISTENT = -306,
 	ERR_NO_SWITCH = -307,
-	ERR_CANNOT_LOAD = -308
+	ERR_CANNOT_LOAD = -308,
+	ERR_TABLE_BUSY = -309,
+	ERR_SEQUENCE_SYNTAX = -310,
+	ERR_SEQUENCE_BUSY = -311,
+	ERR_SEQUENCE_WAIT = -312,
+	ERR_APP_FAILED = -313,
+	ERR_TABLE_TIMEOUT = -314,
+	ERR_HISTORY_TIMEOUT = -315,
+	ERR_HISTORY_INCOMPLETE = -316,
+	ERR_ROW_CHECK_TIMEOUT = -317
 };
 
 
@@ -56,49 +70,208 @@ public:
 	void stop(void) { stopProcessing = true; }
 
 public slots:
-	void process(void);
+	virtual void process(void);
+	void pushEvent(int event, QVariantList fields);
 
 signals:
 	void finished();
 	void error_msg(QString err);
 
-	// action signals
-	void system_connect(void);
-	void system_disconnect(void);
-	void ramp(void);
-	void pause(void);
-	void zero(void);
-	void load_settings(FILE *file, bool *success);
-	void save_settings(FILE *file, bool *success);
-	void set_align1(double mag, double az, double inc);
-	void set_align2(double mag, double az, double inc);
-	void set_align1_active(void);
-	void set_align2_active(void);
-	void set_units(int value);
-	void set_vector(double mag, double az, double inc, int time);
-	void set_vector_cartesian(double x, double y, double z, int time);
-	void goto_vector(int tableRow);
-	void set_polar(double mag, double angle, int time);
-	void goto_polar(int tableRow);
-	void set_persistence(bool persistent);
-	void exit_app(void);
+	// action signals, sent is LatencyStats::now() when emitted
+	void system_connect(qint64 sent);
+	void system_disconnect(qint64 sent);
+	void ramp(qint64 sent);
+	void pause(qint64 sent);
+	void zero(qint64 sent);
+	void load_settings(FILE *file, bool *success, qint64 sent);
+	void save_settings(FILE *file, bool *success, qint64 sent);
+	void set_align1(double mag, double az, double inc, qint64 sent);
+	void set_align2(double mag, double az, double inc, qint64 sent);
+	void set_align1_active(qint64 sent);
+	void set_align2_active(qint64 sent);
+	void set_units(int value, qint64 sent);
+	void set_vector(double mag, double az, double inc, int time, qint64 sent);
+	void set_vector_cartesian(double x, double y, double z, int time, qint64 sent);
+	void goto_vector(int tableRow, quint64 token, qint64 sent);
+	void set_polar(double mag, double angle, int time, qint64 sent);
+	void goto_polar(int tableRow, quint64 token, qint64 sent);
+	void set_persistence(bool persistent, qint64 sent);
+	void exit_app(qint64 sent);
+	void sync(quint64 token, qint64 sent);
+	void set_vector_table(QStringList rows, int coordinates, qint64 sent);
+	void set_polar_table(QStringList rows, qint64 sent);
+	void dump_table(int table, quint64 token, qint64 sent);
+	void history_range(qint64 from, qint64 to, quint64 token, qint64 sent);
+	void execute_app(int table, qint64 sent);
 
-private:
-	// add your variables here
-	bool stopProcessing;
+protected:
+	enum WaitCondition
+	{
+		WAIT_HOLDING = 0,
+		WAIT_PERSISTENT,
+		WAIT_STEP,
+		WAIT_APP				// app started by execute_app() has exited
+	};
+
+	std::atomic<bool> stopProcessing;	// set by stop() and the GUI thread
 	MultiAxisOperation *source;
 	QString inputStr;
-	QStack<QString> errorStack;
+	QMutex outputMutex;			// responses and events share the output
+
+	void writeEvents(void);
+
+	void parseLine(char *line);
+	virtual bool readInputLine(QByteArray *line);
+	virtual void writeOutput(const QByteArray &data);
+	virtual void flushOutput(void) { writeEvents(); }
+	virtual bool cancelled(void) { return stopProcessing; }
+	bool syncSnapshot(void);
+	bool waitFor(WaitCondition condition, int row, double timeout);
+	bool takeError(int *code);
+	void uploadTableRows(int table, int coordinates, const QList<QByteArray> &rows);
+
+private:
+	QStack<SystemError> errorStack;
+	RemoteSnapshot snapshot;	// state seen by the present command line
+	std::atomic<int> subscriptions;	// RemoteEvent mask
+	std::atomic<int> outputFormat;	// OutputFormat
+	QMutex recordMutex;			// keeps record sequence numbers in output order
+	quint64 recordSequence;
+	static std::atomic<quint64> syncTokens;	// last token passed to sync(), shared by all sessions
+	static QMutex commandMutex;	// validates and queues one mutating command at a time
+	static std::atomic<quint64> switchCommands;	// PERSistent commands queued by all sessions
+	quint64 switchCommandsSeen;	// of those, how many the snapshot is known to reflect
+
+	// subscribed event waiting for the session thread to write it
+	struct QueuedEvent
+	{
+		int event;				// RemoteEvent
+		QVariantList fields;
+	};
+
+	QMutex eventMutex;
+	QList<QueuedEvent> eventQueue;	// at most MAX_QUEUED_EVENTS, oldest first
+	int droppedEvents;			// lost to a full queue since the last write
 
+	// rows of a vector or polar table upload, validated as they are read
+	struct TableBatch
+	{
+		int table;				// TargetSource
+		int coordinates;		// CoordinatesSelection of vector rows
+		double unitScale;		// converts field values to the present units
+		QStringList rows;
+		SystemError error;		// first error found
+	};
+
+	// rows following a response (table dumps, statistics), produced one at
+	// a time by a reader as they are written
+	struct PendingRows;
+	typedef bool (Parser::*RowReader)(PendingRows *rows, RecordFields *row);
+
+	struct PendingRows
+	{
+		RowReader reader;
+		int next = 0;			// index of the next row
+		RemoteTableDump table;	// TABLE:VECtor? and TABLE:POLar?
+		QVector<LatencyReport> stats;	// SYST:STATS?
+		RemoteHistoryBatch history;	// HISTory?, the batch being written
+		int total = 0;			// HISTory? rows, counted when the query ran
+		int batchNext = 0;		// index of the next row in the history batch
+		qint64 historyTo = 0;	// end of the HISTory? range
+		qint64 historyStart = 0;	// start of the history the rows come from
+		bool historyLost = false;	// remaining HISTory? rows could not be copied
+	};
+
+	QList<PendingRows> pendingRows;	// in the order of their responses
+
+	// remote command handlers, indexed by CommandId
+	typedef void (Parser::*CommandHandler)(char *args, RecordFields *response);
+	static const CommandHandler commandHandlers[];
+
+	int writeRecord(RecordType type, const QByteArray &name, const RecordFields &fields);
+	void writeRows(const QByteArray &name);
+	bool readTableRow(PendingRows *rows, RecordFields *row);
+	bool readStatsRow(PendingRows *rows, RecordFields *row);
+	bool readHistoryRow(PendingRows *rows, RecordFields *row);
+	bool fetchHistory(qint64 from, qint64 to, RemoteHistoryBatch *batch);
+	static const char *errorText(SystemError error);
 	void addToErrorQueue(SystemError error);
-	void parseInput(char *commbuf, char* outputBuffer);
-	void parse_query_A(char* word, char* outputBuffer);
-	void parse_query_F(char* word, char* outputBuffer);
-	void parse_query_T(char* word, char* outputBuffer);
-	void parse_configure(char* word, char *outputBuffer);
-	void parse_configure_A(char* word, char *outputBuffer);
-	void parse_configure_U(char* word, char *outputBuffer);
-	void parse_configure_T(char* word, char *outputBuffer);
+	void addArgumentError(const char *word);
+	bool parseInput(char *commbuf, RecordFields *response, CommandId *command);
+	bool rampCommandAllowed(char *args);
+	bool targetCommandAllowed(void);
+	void configure_align(char *args, bool alignSelect);
+	void configure_target_align(char *args, bool alignSelect);
+	bool parseEventList(char *args, int *mask);
+	bool parseTimeout(char *word, double *timeout);
+	bool tableLoadAllowed(int table);
+	void addTableRow(TableBatch *batch, char *line);
+	void sendTableBatch(TableBatch *batch);
+	void loadTableFile(int table, char *args);
+	void uploadTable(int table, char *args);
+	void dumpTable(int table, RecordFields *response);
+	void gotoTableRow(int table, int tableRow);
+
+	void query_idn(char *args, RecordFields *response);
+	void query_align1(char *args, RecordFields *response);
+	void query_align1_cartesian(char *args, RecordFields *response);
+	void query_align2(char *args, RecordFields *response);
+	void query_align2_cartesian(char *args, RecordFields *response);
+	void query_field(char *args, RecordFields *response);
+	void query_field_cartesian(char *args, RecordFields *response);
+	void query_history(char *args, RecordFields *response);
+	void query_persistent(char *args, RecordFields *response);
+	void query_plane(char *args, RecordFields *response);
+	void query_sequence_state(char *args, RecordFields *response);
+	void query_state(char *args, RecordFields *response);
+	void query_system_error(char *args, RecordFields *response);
+	void query_system_error_count(char *args, RecordFields *response);
+	void query_system_format(char *args, RecordFields *response);
+	void query_system_stats(char *args, RecordFields *response);
+	void query_system_subscribe(char *args, RecordFields *response);
+	void query_table_vector(char *args, RecordFields *response);
+	void query_table_polar(char *args, RecordFields *response);
+	void query_target(char *args, RecordFields *response);
+	void query_target_cartesian(char *args, RecordFields *response);
+	void query_target_time(char *args, RecordFields *response);
+	void query_units(char *args, RecordFields *response);
+
+	void command_cls(char *args, RecordFields *response);
+	void command_exit(char *args, RecordFields *response);
+	void command_conf_align1(char *args, RecordFields *response);
+	void command_conf_align2(char *args, RecordFields *response);
+	void command_conf_target_align1(char *args, RecordFields *response);
+	void command_conf_target_align2(char *args, RecordFields *response);
+	void command_conf_target_vector(char *args, RecordFields *response);
+	void command_conf_target_vector_cartesian(char *args, RecordFields *response);
+	void command_conf_target_vector_table(char *args, RecordFields *response);
+	void command_conf_target_polar(char *args, RecordFields *response);
+	void command_conf_target_polar_table(char *args, RecordFields *response);
+	void command_conf_units(char *args, RecordFields *response);
+	void command_load(char *args, RecordFields *response);
+	void command_load_settings(char *args, RecordFields *response);
+	void command_load_vector(char *args, RecordFields *response);
+	void command_load_polar(char *args, RecordFields *response);
+	void command_pause(char *args, RecordFields *response);
+	void command_persistent(char *args, RecordFields *response);
+	void command_ramp(char *args, RecordFields *response);
+	void command_save(char *args, RecordFields *response);
+	void command_save_settings(char *args, RecordFields *response);
+	void command_sequence_abort(char *args, RecordFields *response);
+	void command_sequence_define(char *args, RecordFields *response);
+	void command_sequence_load(char *args, RecordFields *response);
+	void command_sequence_run(char *args, RecordFields *response);
+	void command_system_connect(char *args, RecordFields *response);
+	void command_system_disconnect(char *args, RecordFields *response);
+	void command_system_format(char *args, RecordFields *response);
+	void command_system_subscribe(char *args, RecordFields *response);
+	void command_system_unsubscribe(char *args, RecordFields *response);
+	void command_table_vector(char *args, RecordFields *response);
+	void command_table_polar(char *args, RecordFields *response);
+	void command_wait_holding(char *args, RecordFields *response);
+	void command_wait_persistent(char *args, RecordFields *response);
+	void command_wait_step(char *args, RecordFields *response);
+	void command_zero(char *args, RecordFields *response);
 };
 
 #endif // PARSER_H
\ No newline at end of file
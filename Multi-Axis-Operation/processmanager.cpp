@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "processmanager.h"
+#include "latencystats.h"
 
 #if defined(Q_OS_LINUX)
 #include <unistd.h>
@@ -16,6 +17,7 @@ ProcessManager::ProcessManager(QObject *parent)
 	: QObject(parent)
 {
 	started = false;
+	lastRampRate = 0.0;
 	process = new QProcess(this);
 }
 
@@ -160,6 +162,19 @@ void ProcessManager::processStarted(void)
 	reply.clear();
 }
 
+//---------------------------------------------------------------------------
+// Sends a query and waits for the reply, recording the round trip time
+//---------------------------------------------------------------------------
+void ProcessManager::query(const QByteArray &cmd, AxisQuery which)
+{
+	qint64 sent = LatencyStats::now();
+
+	process->write(cmd);
+	process->waitForReadyRead(QUERY_TIMEOUT);
+
+	LatencyStats::recordAxisQuery(axis, which, LatencyStats::now() - sent);
+}
+
 //---------------------------------------------------------------------------
 void ProcessManager::readyReadStandardOutput(void)
 {
@@ -228,6 +243,7 @@ void ProcessManager::sendParams(AxesParams *params, FieldUnits units, bool testM
 	// always set max ramp rate
 	cmd = "CONF:RAMP:RATE:CURR 1," + QString::number(params->maxRampRate, 'f', 6) + "," + QString::number(params->currentLimit, 'f', 4) + "\n";
 	process->write(cmd.toLocal8Bit());
+	lastRampRate = params->maxRampRate;
 
 	if (readParams)
 	{
@@ -380,8 +396,7 @@ double ProcessManager::getMagnetCurrent(bool *error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "CURR:MAG?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_MAGNET_CURRENT);
 
 		if (reply.isEmpty())
 		{
@@ -412,8 +427,7 @@ double ProcessManager::getSupplyCurrent(bool *error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "CURR:SUPP?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_SUPPLY_CURRENT);
 
 		if (reply.isEmpty())
 		{
@@ -444,8 +458,7 @@ double ProcessManager::getField(bool *error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "FIELD:MAG?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_FIELD);
 
 		if (reply.isEmpty())
 		{
@@ -476,8 +489,7 @@ double ProcessManager::getQuenchCurrent(bool *error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "QU:CURR?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_QUENCH_CURRENT);
 
 		if (reply.isEmpty())
 		{
@@ -508,8 +520,7 @@ double ProcessManager::getCurrentLimit(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "CURR:LIM?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_CURRENT_LIMIT);
 
 		if (reply.isEmpty())
 		{
@@ -540,8 +551,7 @@ double ProcessManager::getVoltageLimit(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "VOLT:LIM?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_VOLTAGE_LIMIT);
 
 		if (reply.isEmpty())
 		{
@@ -572,8 +582,7 @@ double ProcessManager::getCoilConstant(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "COIL?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_COIL_CONSTANT);
 
 		if (reply.isEmpty())
 		{
@@ -604,8 +613,7 @@ double ProcessManager::getInductance(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "IND?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_INDUCTANCE);
 
 		if (reply.isEmpty())
 		{
@@ -635,8 +643,7 @@ bool ProcessManager::getSwitchInstallation(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "PS:INST?";
 #endif
-		process->write("PS:INST?\n");
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query("PS:INST?\n", AXIS_QUERY_SWITCH_INSTALLED);
 
 		if (reply.isEmpty())
 			return false;
@@ -663,8 +670,7 @@ double ProcessManager::getSwitchCurrent(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "PS:CURR?";
 #endif
-		process->write(cmd.toLocal8Bit());
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query(cmd.toLocal8Bit(), AXIS_QUERY_SWITCH_CURRENT);
 
 		if (reply.isEmpty())
 		{
@@ -694,8 +700,7 @@ int ProcessManager::getSwitchHeatingTime(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "PS:HTIME?";
 #endif
-		process->write("PS:HTIME?\n");
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query("PS:HTIME?\n", AXIS_QUERY_SWITCH_HEATING_TIME);
 
 		if (reply.isEmpty())
 		{
@@ -725,8 +730,7 @@ int ProcessManager::getSwitchCoolingTime(bool* error)
 #ifdef LOCAL_DEBUG
 		qDebug() << "PS:CTIME?";
 #endif
-		process->write("PS:CTIME?\n");
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query("PS:CTIME?\n", AXIS_QUERY_SWITCH_COOLING_TIME);
 
 		if (reply.isEmpty())
 		{
@@ -756,8 +760,7 @@ FieldUnits ProcessManager::getUnits(void)
 #ifdef LOCAL_DEBUG
 		qDebug() << "FIELD:UNITS?";
 #endif
-		process->write("FIELD:UNITS?\n");
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query("FIELD:UNITS?\n", AXIS_QUERY_UNITS);
 
 		if (reply.isEmpty())
 			return ERROR_UNITS;
@@ -789,8 +792,7 @@ State ProcessManager::getState(void)
 #ifdef LOCAL_DEBUG
 		qDebug() << "STATE?";
 #endif
-		process->write("STATE?\n");
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query("STATE?\n", AXIS_QUERY_STATE);
 
 		if (reply.isEmpty())
 			return ERROR_STATE;
@@ -816,8 +818,7 @@ bool ProcessManager::getPSwitchHeaterState(void)
 #ifdef LOCAL_DEBUG
 		qDebug() << "PS?";
 #endif
-		process->write("PS?\n");
-		process->waitForReadyRead(QUERY_TIMEOUT);
+		query("PS?\n", AXIS_QUERY_SWITCH_HEATER);
 
 		if (reply.isEmpty())
 			return false;
@@ -886,6 +887,7 @@ void ProcessManager::setRampRateCurr(AxesParams *params, double rate)
 	// send down single segment ramp rate
 	cmd = "CONF:RAMP:RATE:CURR 1," + QString::number(rate, 'f', 6) + "," + QString::number(params->currentLimit, 'f', 4) + "\n";
 	process->write(cmd.toLocal8Bit());
+	lastRampRate = rate;
 }
 
 //---------------------------------------------------------------------------
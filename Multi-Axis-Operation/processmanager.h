@@ -3,6 +3,7 @@
 #include <QObject>
 #include <QProcess>
 #include "magnetparams.h"
+#include "latencystats.h"
 
 class ProcessManager : public QObject
 {
@@ -33,6 +34,7 @@ public:
 	void sendRampToZero(void);
 	void setTargetCurr(AxesParams *params, double value, bool isFieldValue);
 	void setRampRateCurr(AxesParams *params, double rate);
+	double rampRate(void) { return lastRampRate; }	// A/s, last rate sent, 0 if none
 	void heatSwitch(void);
 	void coolSwitch(void);
 
@@ -51,4 +53,7 @@ private:
 	Axis axis;
 	bool started;
 	QString reply;
+	double lastRampRate;
+
+	void query(const QByteArray &cmd, AxisQuery which);
 };
@@ -0,0 +1,119 @@
+// QTableView with support for copy and paste added
+// Here copy and paste can copy/paste the entire grid of cells
+#include "stdafx.h"
+#include "qtableviewwithcopypaste.h"
+
+//---------------------------------------------------------------------------
+void QTableViewWithCopyPaste::copy()
+{
+	QItemSelectionModel * selection = selectionModel();
+	QModelIndexList indexes = selection->selectedIndexes();
+
+	if(indexes.size() < 1)
+		return;
+
+	// QModelIndex::operator < sorts first by row, then by column.
+	// this is what we need
+	std::sort(indexes.begin(), indexes.end());
+
+	// You need a pair of indexes to find the row changes
+	QModelIndex previous = indexes.first();
+	indexes.removeFirst();
+	QString selected_text;
+	QModelIndex current;
+
+	Q_FOREACH(current, indexes)
+	{
+		QVariant data = model()->data(previous);
+		QString text = data.toString();
+
+		// At this point "text" contains the text in one cell
+		selected_text.append(text);
+
+		// If you are at the start of the row the row number of the previous index
+		// isn't the same.  Text is followed by a row separator, which is a newline.
+		if (current.row() != previous.row())
+		{
+			selected_text.append(QLatin1Char('\n'));
+		}
+		// Otherwise it's the same row, so append a column separator, which is a comma.
+		else
+		{
+			selected_text.append(QLatin1Char(','));
+		}
+		previous = current;
+	}
+
+	// add last element
+	selected_text.append(model()->data(current).toString());
+	selected_text.append(QLatin1Char('\n'));
+	qApp->clipboard()->setText(selected_text);
+}
+
+//---------------------------------------------------------------------------
+void QTableViewWithCopyPaste::paste()
+{
+	// TO DO
+}
+
+//---------------------------------------------------------------------------
+void QTableViewWithCopyPaste::performDelete()
+{
+	QItemSelectionModel * selection = selectionModel();
+	QModelIndexList indexes = selection->selectedIndexes();
+
+	if(indexes.size() < 1)
+		return;
+
+	// QModelIndex::operator < sorts first by row, then by column.
+	// this is what we need
+	std::sort(indexes.begin(), indexes.end());
+
+	QModelIndex current;
+
+	Q_FOREACH(current, indexes)
+	{
+		model()->setData(current, QString(), Qt::EditRole);
+	}
+}
+
+//---------------------------------------------------------------------------
+void QTableViewWithCopyPaste::keyPressEvent(QKeyEvent * event)
+{
+	if(event->matches(QKeySequence::Copy))
+	{
+		copy();
+	}
+	else if(event->matches(QKeySequence::Paste))
+	{
+		paste();
+	}
+	else if(event->matches(QKeySequence::Delete))
+	{
+		performDelete();
+	}
+	else
+	{
+		QTableView::keyPressEvent(event);
+	}
+
+}
+
+//---------------------------------------------------------------------------
+// Returns the first selected row, or -1 if nothing is selected.
+int QTableViewWithCopyPaste::selectedRow(void)
+{
+	QItemSelectionModel *selection = selectionModel();
+
+	if (selection && selection->hasSelection())
+	{
+		QModelIndexList indexes = selection->selectedIndexes();
+
+		if (indexes.size())
+			return indexes.first().row();
+	}
+
+	return -1;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QtWidgets/QTableView>
+
+class QTableViewWithCopyPaste : public QTableView
+{
+public:
+	QTableViewWithCopyPaste(QWidget *parent) :
+	  QTableView(parent)
+	  {};
+
+	int selectedRow(void);
+
+private:
+	void copy();
+	void paste();
+	void performDelete();
+
+protected:
+	virtual void keyPressEvent(QKeyEvent * event);
+};
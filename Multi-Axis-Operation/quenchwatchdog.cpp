@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include "quenchwatchdog.h"
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+QuenchWatchdog::QuenchWatchdog(QObject *parent)
+	: QObject(parent)
+{
+	tripped = false;
+
+	for (int i = 0; i < 3; i++)
+	{
+		process[i] = nullptr;
+		params[i] = nullptr;
+		event.quenched[i] = false;
+		event.valid[i] = false;
+		event.current[i] = 0.0;
+	}
+
+	// precise timing so the poll rate holds under GUI load
+	pollTimer = new QTimer(this);
+	pollTimer->setTimerType(Qt::PreciseTimer);
+	pollTimer->setInterval(100);
+	connect(pollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+QuenchWatchdog::~QuenchWatchdog()
+{
+	pollTimer->stop();
+}
+
+//---------------------------------------------------------------------------
+void QuenchWatchdog::start(ProcessManager *xProcess, ProcessManager *yProcess, ProcessManager *zProcess, MagnetParams *magnetParams)
+{
+	process[X_AXIS] = xProcess;
+	params[X_AXIS] = magnetParams->GetXAxisParams();
+	process[Y_AXIS] = yProcess;
+	params[Y_AXIS] = magnetParams->GetYAxisParams();
+	process[Z_AXIS] = zProcess;
+	params[Z_AXIS] = magnetParams->GetZAxisParams();
+
+	tripped = false;
+	pollTimer->start();
+}
+
+//---------------------------------------------------------------------------
+void QuenchWatchdog::stop(void)
+{
+	pollTimer->stop();
+
+	// release references to the axis processes
+	for (int i = 0; i < 3; i++)
+		process[i] = nullptr;
+
+	tripped = false;
+}
+
+//---------------------------------------------------------------------------
+bool QuenchWatchdog::axisActive(int axis)
+{
+	if (process[axis] && params[axis])
+		return (params[axis]->activate && process[axis]->isActive());
+	else
+		return false;
+}
+
+//---------------------------------------------------------------------------
+void QuenchWatchdog::poll(void)
+{
+	bool quenched[3] = { false, false, false };
+	bool anyQuench = false;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (axisActive(i))
+		{
+			if (process[i]->getState() == QUENCH)
+			{
+				quenched[i] = true;
+				anyQuench = true;
+
+				if (!tripped)
+					break;	// react now, remaining axes are handled below
+			}
+		}
+	}
+
+	if (!anyQuench)
+	{
+		tripped = false;	// rearm for the next event
+		return;
+	}
+	else if (tripped)
+	{
+		return;	// already reported
+	}
+
+	tripped = true;
+	event.timestamp = QDateTime::currentDateTime();
+
+	// stop the remaining axes before anything else
+	for (int i = 0; i < 3; i++)
+	{
+		if (!quenched[i] && axisActive(i))
+			process[i]->sendPause();
+	}
+
+	// capture all axes together, checking for simultaneous quenches
+	for (int i = 0; i < 3; i++)
+	{
+		event.quenched[i] = false;
+		event.valid[i] = false;
+		event.current[i] = 0.0;
+
+		if (axisActive(i))
+		{
+			bool ok = false;
+
+			if (!quenched[i] && process[i]->getState() == QUENCH)
+				quenched[i] = true;
+
+			event.quenched[i] = quenched[i];
+
+			if (quenched[i])
+				event.current[i] = process[i]->getQuenchCurrent(&ok);
+			else
+				event.current[i] = process[i]->getMagnetCurrent(&ok);
+
+			event.valid[i] = ok;
+		}
+	}
+
+	emit quenchDetected();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QDateTime>
+#include "magnetparams.h"
+#include "processmanager.h"
+
+//---------------------------------------------------------------------------
+// Type declarations
+//---------------------------------------------------------------------------
+struct QuenchEvent
+{
+	QDateTime timestamp;	// time of detection
+	bool quenched[3];		// axes reporting QUENCH state
+	bool valid[3];			// current reading succeeded
+	double current[3];		// A, quench current for quenched axes, magnet current otherwise
+};
+
+//---------------------------------------------------------------------------
+// Polls only the STATE? of each active axis at a high rate, independent of
+// the 1 Hz data acquisition. On the first QUENCH report all other axes are
+// paused at once, the currents of every axis are captured, and the event
+// is timestamped and signaled.
+//---------------------------------------------------------------------------
+class QuenchWatchdog : public QObject
+{
+	Q_OBJECT
+
+public:
+	QuenchWatchdog(QObject *parent);
+	~QuenchWatchdog();
+	void start(ProcessManager *xProcess, ProcessManager *yProcess, ProcessManager *zProcess, MagnetParams *magnetParams);
+	void stop(void);
+	void setInterval(int msec) { pollTimer->setInterval(msec); }
+	bool isActive(void) { return pollTimer->isActive(); }
+	bool isTripped(void) { return tripped; }
+	const QuenchEvent &lastEvent(void) { return event; }
+
+signals:
+	void quenchDetected(void);
+
+public slots:
+	void poll(void);
+
+private:
+	QTimer *pollTimer;
+	ProcessManager *process[3];
+	AxesParams *params[3];
+	bool tripped;		// latched until no axis reports QUENCH
+	QuenchEvent event;
+
+	bool axisActive(int axis);
+};
@@ -0,0 +1,244 @@
+#include "stdafx.h"
+#include "recordframing.h"
+#include <QtEndian>
+#include <cmath>
+
+//---------------------------------------------------------------------------
+// Typed record fields and their TEXT, JSON and BINARY encodings
+//---------------------------------------------------------------------------
+
+static const char *recordTypeNames[] = { "response", "event", "row" };
+
+//---------------------------------------------------------------------------
+void RecordFields::addInteger(qint64 value)
+{
+	RecordField field;
+
+	field.type = FIELD_INTEGER;
+	field.integer = value;
+	field.real = 0.0;
+	field.precision = 0;
+	field.quoted = false;
+	fields.append(field);
+}
+
+//---------------------------------------------------------------------------
+// precision may be QLocale::FloatingPointShortest, as in table columns
+void RecordFields::addReal(double value, int precision)
+{
+	RecordField field;
+
+	field.type = FIELD_REAL;
+	field.integer = 0;
+	field.real = value;
+	field.precision = precision;
+	field.quoted = false;
+	fields.append(field);
+}
+
+//---------------------------------------------------------------------------
+void RecordFields::addString(const QByteArray &value, bool quoted)
+{
+	RecordField field;
+
+	field.type = FIELD_STRING;
+	field.integer = 0;
+	field.real = 0.0;
+	field.precision = 0;
+	field.text = value;
+	field.quoted = quoted;
+	fields.append(field);
+}
+
+//---------------------------------------------------------------------------
+QByteArray RecordFields::toText(void) const
+{
+	QByteArray text;
+
+	for (int i = 0; i < fields.count(); i++)
+	{
+		const RecordField &field = fields[i];
+
+		if (i)
+			text.append(',');
+
+		if (field.type == FIELD_INTEGER)
+		{
+			text.append(QByteArray::number(field.integer));
+		}
+		else if (field.type == FIELD_REAL)
+		{
+			if (field.precision < 0)
+			{
+				text.append(QString::number(field.real, 'g', field.precision).toLatin1());
+			}
+			else
+			{
+				char buffer[64];
+
+				qsnprintf(buffer, sizeof(buffer), "%0.*g", field.precision, field.real);
+				text.append(buffer);
+			}
+		}
+		else if (field.quoted)
+		{
+			text.append('"');
+			text.append(field.text);
+			text.append('"');
+		}
+		else
+		{
+			text.append(field.text);
+		}
+	}
+
+	return text;
+}
+
+//---------------------------------------------------------------------------
+static void appendJsonString(QByteArray *record, const char *text, int length)
+{
+	record->append('"');
+
+	for (int i = 0; i < length; i++)
+	{
+		unsigned char c = (unsigned char)text[i];
+
+		if (c == '"' || c == '\\')
+		{
+			record->append('\\');
+			record->append((char)c);
+		}
+		else if (c < 0x20)
+		{
+			char escape[8];
+			sprintf(escape, "\\u%04x", c);
+			record->append(escape);
+		}
+		else
+		{
+			record->append((char)c);
+		}
+	}
+
+	record->append('"');
+}
+
+//---------------------------------------------------------------------------
+static QByteArray jsonRecord(RecordType type, quint64 sequence, qint64 timestamp, const QByteArray &name, const RecordFields &fields)
+{
+	QByteArray record;
+
+	record.reserve(64 + name.size() + fields.count() * 16);
+	record.append("{\"seq\":");
+	record.append(QByteArray::number(sequence));
+	record.append(",\"ts\":");
+	record.append(QByteArray::number(timestamp));
+	record.append(",\"type\":\"");
+	record.append(recordTypeNames[type]);
+	record.append("\",\"name\":");
+	appendJsonString(&record, name.constData(), name.size());
+	record.append(",\"fields\":[");
+
+	for (int i = 0; i < fields.count(); i++)
+	{
+		const RecordField &field = fields.at(i);
+
+		if (i)
+			record.append(',');
+
+		if (field.type == FIELD_STRING)
+			appendJsonString(&record, field.text.constData(), field.text.size());
+		else if (field.type == FIELD_INTEGER)
+			record.append(QByteArray::number(field.integer));
+		else if (std::isfinite(field.real))
+			record.append(QString::number(field.real, 'g', QLocale::FloatingPointShortest).toLatin1());	// round trips
+		else
+			record.append("null");	// JSON has no inf or nan
+	}
+
+	record.append("]}\n");
+
+	return record;
+}
+
+//---------------------------------------------------------------------------
+template <typename T>
+static void appendLittleEndian(QByteArray *record, T value)
+{
+	char bytes[sizeof(T)];
+
+	qToLittleEndian(value, bytes);
+	record->append(bytes, sizeof(T));
+}
+
+//---------------------------------------------------------------------------
+static QByteArray binaryRecord(RecordType type, quint64 sequence, qint64 timestamp, const QByteArray &name, const RecordFields &fields)
+{
+	QByteArray record;
+
+	record.reserve(32 + name.size() + fields.count() * 16);
+	appendLittleEndian<quint32>(&record, 0);	// length, filled in below
+	appendLittleEndian<quint8>(&record, (quint8)type);
+	appendLittleEndian<quint64>(&record, sequence);
+	appendLittleEndian<qint64>(&record, timestamp);
+	QByteArray recordName = name.left(0xFFFF);
+
+	appendLittleEndian<quint16>(&record, (quint16)recordName.size());
+	record.append(recordName);
+	appendLittleEndian<quint16>(&record, (quint16)fields.count());
+
+	for (int i = 0; i < fields.count(); i++)
+	{
+		const RecordField &field = fields.at(i);
+
+		appendLittleEndian<quint8>(&record, (quint8)field.type);
+
+		if (field.type == FIELD_INTEGER)
+		{
+			appendLittleEndian<qint64>(&record, field.integer);
+		}
+		else if (field.type == FIELD_REAL)
+		{
+			quint64 bits;
+
+			memcpy(&bits, &field.real, sizeof(bits));
+			appendLittleEndian<quint64>(&record, bits);
+		}
+		else
+		{
+			appendLittleEndian<quint32>(&record, (quint32)field.text.size());
+			record.append(field.text);
+		}
+	}
+
+	qToLittleEndian((quint32)(record.size() - sizeof(quint32)), record.data());
+
+	return record;
+}
+
+//---------------------------------------------------------------------------
+const char *outputFormatName(OutputFormat format)
+{
+	switch (format)
+	{
+	case FORMAT_JSON:
+		return "JSON";
+	case FORMAT_BINARY:
+		return "BINARY";
+	default:
+		return "TEXT";
+	}
+}
+
+//---------------------------------------------------------------------------
+// Frames one response, event or row as a JSON or BINARY record
+//---------------------------------------------------------------------------
+QByteArray frameRecord(OutputFormat format, RecordType type, quint64 sequence, qint64 timestamp,
+	const QByteArray &name, const RecordFields &fields)
+{
+	if (format == FORMAT_BINARY)
+		return binaryRecord(type, sequence, timestamp, name, fields);
+	else
+		return jsonRecord(type, sequence, timestamp, name, fields);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+//---------------------------------------------------------------------------
+// Output framing for the scripting interface, selected per session with
+// SYST:FORMAT. TEXT is the original comma-separated line format. In the
+// JSON and BINARY formats each response, event and table dump row is one
+// record carrying a sequence number, a timestamp and typed fields, so a
+// client decodes values without parsing text and a record has no length
+// limit. Handlers add typed RecordFields; text is only formatted from them
+// for a TEXT session, and reals keep their full precision in JSON and
+// BINARY records.
+//
+// JSON records are one object per line, name being the command keyword
+// path (e.g. "TARG?") or event name:
+//   {"seq":<n>,"ts":<msec>,"type":"response|event|row","name":"<command or event>","fields":[...]}
+//
+// BINARY records are little-endian and length-prefixed:
+//   uint32 length of the rest of the record
+//   uint8 RecordType
+//   uint64 sequence
+//   int64 timestamp (msec since epoch)
+//   uint16 name length, name bytes
+//   uint16 field count, then per field a uint8 FieldType followed by
+//   int64 (FIELD_INTEGER), double (FIELD_REAL) or uint32 length and
+//   UTF-8 bytes (FIELD_STRING)
+//---------------------------------------------------------------------------
+
+enum OutputFormat
+{
+	FORMAT_TEXT = 0,
+	FORMAT_JSON,
+	FORMAT_BINARY
+};
+
+enum RecordType
+{
+	RECORD_RESPONSE = 0,		// response to a query or WAIT
+	RECORD_EVENT,				// subscribed event
+	RECORD_ROW					// a row following a response (table dumps)
+};
+
+enum FieldType
+{
+	FIELD_INTEGER = 0,
+	FIELD_REAL,
+	FIELD_STRING
+};
+
+//---------------------------------------------------------------------------
+// Fields of one response, event or row
+//---------------------------------------------------------------------------
+struct RecordField
+{
+	FieldType type;
+	qint64 integer;
+	double real;
+	int precision;			// significant digits of a real in TEXT output
+	QByteArray text;		// FIELD_STRING, UTF-8
+	bool quoted;			// string is enclosed in double quotes in TEXT output
+};
+
+class RecordFields
+{
+public:
+	static const int TEXT_PRECISION = 10;	// as the original %0.10g responses
+
+	void clear(void) { fields.clear(); }
+	bool isEmpty(void) const { return fields.isEmpty(); }
+	int count(void) const { return fields.count(); }
+	const RecordField &at(int i) const { return fields[i]; }
+
+	void addInteger(qint64 value);
+	void addReal(double value, int precision = TEXT_PRECISION);
+	void addString(const QByteArray &value, bool quoted = false);
+	void addString(const QString &value, bool quoted = false) { addString(value.toUtf8(), quoted); }
+	void addString(const char *value, bool quoted = false) { addString(QByteArray(value), quoted); }
+
+	QByteArray toText(void) const;	// comma-separated TEXT line, without a line ending
+
+private:
+	QVector<RecordField> fields;
+};
+
+extern const char *outputFormatName(OutputFormat format);
+extern QByteArray frameRecord(OutputFormat format, RecordType type, quint64 sequence, qint64 timestamp,
+	const QByteArray &name, const RecordFields &fields);
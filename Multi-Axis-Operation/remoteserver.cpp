@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "remoteserver.h"
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QDeadlineTimer>
+
+const int POLL_MSEC = 50;					// event delivery latency while a client is idle
+const int WRITE_TIMEOUT_MSEC = 1000;
+const int BLOCK_LINE_TIMEOUT_MSEC = 10000;	// for each line of a block (e.g. a table upload)
+const int MAX_PENDING_OUTPUT = 1048576;		// drop a client that stops reading
+const int MAX_INPUT_LINE = 1048576;			// longer input is split into lines of this size
+
+//---------------------------------------------------------------------------
+// Constructor, the session takes ownership of the socket
+//---------------------------------------------------------------------------
+RemoteSession::RemoteSession(QIODevice *socket)
+	: Parser(nullptr)
+{
+	device = socket;
+	device->setParent(this);
+}
+
+//---------------------------------------------------------------------------
+// --- SESSION THREAD ---
+// Reads and parses command lines until the client disconnects or stop()
+void RemoteSession::process(void)
+{
+	if (source == NULL)
+	{
+		qDebug("Multi-Axis Operation remote session aborted; no data source specified");
+	}
+	else
+	{
+		stopProcessing = false;
+
+		qDebug("Multi-Axis Operation remote session Start");
+		QByteArray input;
+
+		while (!stopProcessing && (isConnected() || device->canReadLine()))
+		{
+			if (!lineAvailable())
+			{
+				device->waitForReadyRead(POLL_MSEC);
+				flushOutput();
+				continue;
+			}
+
+			input = readLine();
+
+			// save original string
+			inputStr = QString(input);
+
+			parseLine(input.data());
+			flushOutput();
+		}
+
+		flushOutput();
+		device->close();
+	}
+
+	emit finished();
+}
+
+//---------------------------------------------------------------------------
+// Reads a further line for a command that takes a block of lines, returns
+// false if the client stops sending
+//---------------------------------------------------------------------------
+bool RemoteSession::readInputLine(QByteArray *line)
+{
+	QDeadlineTimer deadline(BLOCK_LINE_TIMEOUT_MSEC);
+
+	while (!lineAvailable())
+	{
+		if (stopProcessing || !isConnected() || deadline.hasExpired())
+			return false;
+
+		device->waitForReadyRead(POLL_MSEC);
+		flushOutput();
+	}
+
+	*line = readLine();
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// A complete line, or MAX_INPUT_LINE bytes of an overlong one, is available
+bool RemoteSession::lineAvailable(void)
+{
+	return device->canReadLine() || device->bytesAvailable() >= MAX_INPUT_LINE;
+}
+
+//---------------------------------------------------------------------------
+// Reads an available line without its line ending
+QByteArray RemoteSession::readLine(void)
+{
+	QByteArray line = device->readLine(MAX_INPUT_LINE + 1);
+	int length = line.size();
+
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+		length--;
+
+	line.truncate(length);
+
+	return line;
+}
+
+//---------------------------------------------------------------------------
+// Queues a response or event line until flushOutput() writes it to the
+// socket
+//---------------------------------------------------------------------------
+void RemoteSession::writeOutput(const QByteArray &data)
+{
+	QMutexLocker lock(&outputMutex);
+
+	if (pendingOutput.size() + data.size() > MAX_PENDING_OUTPUT)
+	{
+		stopProcessing = true;	// client is not reading
+		return;
+	}
+
+	pendingOutput.append(data);
+}
+
+//---------------------------------------------------------------------------
+// Writes queued output to the socket (session thread only)
+//---------------------------------------------------------------------------
+void RemoteSession::flushOutput(void)
+{
+	QByteArray data;
+
+	writeEvents();
+
+	{
+		QMutexLocker lock(&outputMutex);
+		data.swap(pendingOutput);
+	}
+
+	if (data.isEmpty() || !isConnected())
+		return;
+
+	device->write(data);
+
+	while (device->bytesToWrite() > 0)
+	{
+		if (!device->waitForBytesWritten(WRITE_TIMEOUT_MSEC))
+			break;
+	}
+}
+
+//---------------------------------------------------------------------------
+bool RemoteSession::isConnected(void)
+{
+	if (QAbstractSocket *socket = qobject_cast<QAbstractSocket *>(device))
+		return socket->state() == QAbstractSocket::ConnectedState;
+	else if (QLocalSocket *socket = qobject_cast<QLocalSocket *>(device))
+		return socket->state() == QLocalSocket::ConnectedState;
+	else
+		return device->isOpen();
+}
+
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+RemoteServer::RemoteServer(MultiAxisOperation *parent)
+	: QObject(parent)
+{
+	source = parent;
+	tcpServer = nullptr;
+	localServer = nullptr;
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+RemoteServer::~RemoteServer()
+{
+	if (tcpServer)
+		tcpServer->close();
+
+	if (localServer)
+		localServer->close();
+
+	// stop and destroy all sessions and their threads
+	while (!sessions.isEmpty())
+		endSession(0);
+}
+
+//---------------------------------------------------------------------------
+// Listens on the loopback interface only, the interface is not
+// authenticated
+bool RemoteServer::listenTcp(quint16 port)
+{
+	if (tcpServer == nullptr)
+	{
+		tcpServer = new QTcpServer(this);
+		connect(tcpServer, SIGNAL(newConnection()), this, SLOT(newTcpConnection()));
+	}
+
+	if (!tcpServer->listen(QHostAddress::LocalHost, port))
+	{
+		qDebug() << "Unable to listen on TCP port" << port << tcpServer->errorString();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+bool RemoteServer::listenLocal(QString name)
+{
+	if (localServer == nullptr)
+	{
+		localServer = new QLocalServer(this);
+		connect(localServer, SIGNAL(newConnection()), this, SLOT(newLocalConnection()));
+	}
+
+	// remove a stale socket file left by a crash (Unix)
+	QLocalServer::removeServer(name);
+
+	if (!localServer->listen(name))
+	{
+		qDebug() << "Unable to listen on local socket" << name << localServer->errorString();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+void RemoteServer::newTcpConnection(void)
+{
+	while (tcpServer->hasPendingConnections())
+		startSession(tcpServer->nextPendingConnection());
+}
+
+//---------------------------------------------------------------------------
+void RemoteServer::newLocalConnection(void)
+{
+	while (localServer->hasPendingConnections())
+		startSession(localServer->nextPendingConnection());
+}
+
+//---------------------------------------------------------------------------
+// Moves the socket with a new session to its own thread and starts it
+void RemoteServer::startSession(QIODevice *socket)
+{
+	QThread *thread = new QThread;
+	RemoteSession *session = new RemoteSession(socket);
+
+	session->setDataSource(source);
+	session->moveToThread(thread);
+	connect(thread, SIGNAL(started()), session, SLOT(process()));
+	connect(session, SIGNAL(finished()), this, SLOT(sessionFinished()));
+	source->attachParser(session);
+
+	SessionThread entry = { session, thread };
+	sessions.append(entry);
+
+	thread->start();
+}
+
+//---------------------------------------------------------------------------
+// A client disconnected
+void RemoteServer::sessionFinished(void)
+{
+	for (int i = 0; i < sessions.count(); i++)
+	{
+		if (sessions[i].session == sender())
+		{
+			endSession(i);
+			break;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+void RemoteServer::endSession(int index)
+{
+	SessionThread entry = sessions.takeAt(index);
+
+	entry.session->stop();
+	entry.thread->quit();
+	entry.thread->wait();
+
+	delete entry.session;
+	delete entry.thread;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include <QTcpServer>
+#include <QLocalServer>
+#include "parser.h"
+
+//---------------------------------------------------------------------------
+// Scripting session for one socket client. Runs the same command set as
+// the stdin parser in its own thread with its own error queue and event
+// subscriptions, reading the socket with the blocking QIODevice calls.
+//---------------------------------------------------------------------------
+class RemoteSession : public Parser
+{
+	Q_OBJECT
+
+public:
+	RemoteSession(QIODevice *socket);
+
+public slots:
+	void process(void);
+
+protected:
+	bool readInputLine(QByteArray *line);
+	void writeOutput(const QByteArray &data);
+	void flushOutput(void);
+
+private:
+	QIODevice *device;
+	QByteArray pendingOutput;	// responses and events not yet written to the socket
+
+	bool isConnected(void);
+	bool lineAvailable(void);
+	QByteArray readLine(void);
+};
+
+//---------------------------------------------------------------------------
+// Accepts scripting clients on a localhost TCP port and/or a local socket
+// (a Unix domain socket, or a named pipe on Windows). Each client gets a
+// RemoteSession thread.
+//---------------------------------------------------------------------------
+class RemoteServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	RemoteServer(MultiAxisOperation *parent);
+	~RemoteServer();
+	bool listenTcp(quint16 port);
+	bool listenLocal(QString name);
+
+private slots:
+	void newTcpConnection(void);
+	void newLocalConnection(void);
+	void sessionFinished(void);
+
+private:
+	struct SessionThread
+	{
+		RemoteSession *session;
+		QThread *thread;
+	};
+
+	MultiAxisOperation *source;
+	QTcpServer *tcpServer;
+	QLocalServer *localServer;
+	QList<SessionThread> sessions;
+
+	void startSession(QIODevice *socket);
+	void endSession(int index);
+};
@@ -0,0 +1,343 @@
+#include "stdafx.h"
+#include "reportwriter.h"
+#include "resultsjournal.h"
+#include <QtConcurrent>
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+// on Linux and macOS we include the Qxlsx source in the ./header and ./source folders
+#include "header/xlsxdocument.h"
+#else
+// right now keep using the library form of QtXlsxWriter on Windows due to issues with
+// linking Qxlsx to private API, and using pre-compiled headers in VS2017
+#include <xlsxdocument.h>
+#endif
+
+const int JOURNAL_COLUMN = 8;	// zero-based, first column after the quench currents
+
+//---------------------------------------------------------------------------
+// Row of a table snapshot in the form steps are read back from a journal
+//---------------------------------------------------------------------------
+static JournalStep stepFromContents(const TableContents &contents, const QVector<bool> &checks, int row)
+{
+	JournalStep step;
+	int numColumns = contents.values.count();
+
+	step.row = row;
+	step.result = contents.results[row];
+	step.checked = checks.value(row);
+
+	for (int i = 0; i < numColumns; i++)
+	{
+		step.states.append(contents.states[i][row]);
+		step.values.append(contents.values[i][row]);
+		step.texts.append(contents.states[i][row] == CELL_TEXT ? contents.texts.value(TableModel::textKey(row, i)) : QString());
+	}
+
+	return step;
+}
+
+//---------------------------------------------------------------------------
+static CellState cellState(const JournalStep &step, int column, int resultColumn)
+{
+	if (column == resultColumn)
+		return step.result == RESULT_NONE ? CELL_EMPTY : CELL_TEXT;
+
+	return static_cast<CellState>(step.states.value(column, CELL_EMPTY));
+}
+
+//---------------------------------------------------------------------------
+// Cell text as TableModel::text() shows it
+//---------------------------------------------------------------------------
+static QString cellText(const JournalStep &step, int column, const TableContents &layout)
+{
+	if (column == layout.resultColumn)
+	{
+		if (step.result == RESULT_PASS)
+			return "Pass";
+		else if (step.result == RESULT_FAIL)
+			return "Fail";
+		else
+			return QString();
+	}
+
+	switch (cellState(step, column, layout.resultColumn))
+	{
+	case CELL_VALUE:
+		return QString::number(step.values[column], 'g', layout.precisions.value(column, QLocale::FloatingPointShortest));
+
+	case CELL_TEXT:
+		return step.texts.value(column);
+
+	default:
+		return QString();
+	}
+}
+
+//---------------------------------------------------------------------------
+static QString stepTime(qint64 msecs)
+{
+	if (msecs == 0)
+		return QString();
+
+	return QDateTime::fromMSecsSinceEpoch(msecs).toString("yyyy-MM-dd hh:mm:ss");
+}
+
+//---------------------------------------------------------------------------
+ReportWriter::ReportWriter(QObject *parent)
+	: QObject(parent)
+{
+	compressionLevel = -1;
+
+	connect(&watcher, SIGNAL(finished()), this, SIGNAL(finished()));
+}
+
+//---------------------------------------------------------------------------
+ReportWriter::~ReportWriter()
+{
+	watcher.waitForFinished();
+}
+
+//---------------------------------------------------------------------------
+// Saves the report in the background from a snapshot taken by the caller.
+void ReportWriter::start(const QString &filename, const ReportData &data)
+{
+	if (watcher.isRunning())
+		return;
+
+	outputFileName = filename;
+	journalFileName.clear();
+	report = data;
+	error.clear();
+
+	watcher.setFuture(QtConcurrent::run([this]() { write(); }));
+}
+
+//---------------------------------------------------------------------------
+// Materializes the report from a results journal, one row per step with
+// its times and any external app result. The journal may still be open
+// for appending; steps written after the save starts are not included.
+void ReportWriter::start(const QString &filename, const QString &journal)
+{
+	if (watcher.isRunning())
+		return;
+
+	outputFileName = filename;
+	journalFileName = journal;
+	report = ReportData();
+	error.clear();
+
+	watcher.setFuture(QtConcurrent::run([this]() { write(); }));
+}
+
+//---------------------------------------------------------------------------
+void ReportWriter::write(void)
+{
+	QString tempStr;
+	QXlsx::Document xlsx;
+	ResultsJournalReader journal;
+	bool fromJournal = !journalFileName.isEmpty();
+
+	if (fromJournal)
+	{
+		if (!journal.open(journalFileName))
+		{
+			error = journal.errorString();
+			return;
+		}
+
+		report = journal.run();
+	}
+
+	const TableContents &contents = report.results;
+
+	// set document properties
+	xlsx.setDocumentProperty("title", "Multi-Axis Magnet " + report.magnetID + " Test Report");
+	xlsx.setDocumentProperty("subject", "Magnet ID " + report.magnetID);
+	xlsx.setDocumentProperty("company", "American Magnetics, Inc.");
+	xlsx.setDocumentProperty("description", "Test Results");
+
+	QXlsx::Format alignRightFormat;
+	QXlsx::Format alignCenterFormat;
+	QXlsx::Format boldAlignRightFormat;
+	QXlsx::Format boldAlignCenterFormat;
+	alignRightFormat.setHorizontalAlignment(QXlsx::Format::AlignRight);
+	alignCenterFormat.setHorizontalAlignment(QXlsx::Format::AlignHCenter);
+	boldAlignRightFormat.setFontBold(true);
+	boldAlignRightFormat.setHorizontalAlignment(QXlsx::Format::AlignRight);
+	boldAlignCenterFormat.setFontBold(true);
+	boldAlignCenterFormat.setHorizontalAlignment(QXlsx::Format::AlignHCenter);
+
+	xlsx.deleteSheet("Sheet1");
+	xlsx.addSheet("Parameters and Limits");
+	xlsx.setColumnWidth(1, 30);
+	xlsx.setColumnWidth(2, 4, 15);
+
+	// write magnet ID
+	xlsx.write("A1", "Magnet ID", boldAlignRightFormat);
+	xlsx.write("B1", report.magnetID, alignRightFormat);
+
+	// write magnitude limit
+	tempStr = "Magnitude Limit (";
+	if (report.fieldUnits == KG)
+		tempStr += "kG)";
+	else
+		tempStr += "T)";
+	xlsx.write("A2", tempStr, boldAlignRightFormat);
+	xlsx.write("B2", report.magnitudeLimit);
+
+	// write magnet axes settings
+
+	// write header
+	xlsx.write("A4", "Parameter", boldAlignCenterFormat);
+	xlsx.write("B4", "X-Axis", boldAlignCenterFormat);
+	xlsx.write("C4", "Y-Axis", boldAlignCenterFormat);
+	xlsx.write("D4", "Z-Axis", boldAlignCenterFormat);
+
+	// write first column labels
+	xlsx.write("A5", "IP Addr", alignCenterFormat);
+	xlsx.write("A6", "Current Limit (A)", alignCenterFormat);
+	xlsx.write("A7", "Voltage Limit (A)", alignCenterFormat);
+	xlsx.write("A8", "Max Ramp Rate (A/s)", alignCenterFormat);
+	tempStr = "Coil Constant (";
+	if (report.fieldUnits == KG)
+		tempStr += "kG/A)";
+	else
+		tempStr += "T/A)";
+	xlsx.write("A9", tempStr, alignCenterFormat);
+	xlsx.write("A10", "Inductance (H)", alignCenterFormat);
+	xlsx.write("A11", "Switch Installed", alignCenterFormat);
+	xlsx.write("A12", "Switch Heater Current (mA)", alignCenterFormat);
+	xlsx.write("A13", "Switch Cooling Time (s)", alignCenterFormat);
+	xlsx.write("A14", "Switch Heating Time (s)", alignCenterFormat);
+
+	// write X, Y and Z parameters in columns B, C and D
+	for (int i = 0; i < 3; i++)
+	{
+		const AxesParams &axis = report.axes[i];
+		int column = i + 2;
+
+		if (axis.activate)
+		{
+			xlsx.write(5, column, axis.ipAddress, alignCenterFormat);
+			xlsx.write(6, column, axis.currentLimit, alignRightFormat);
+			xlsx.write(7, column, axis.voltageLimit, alignRightFormat);
+			xlsx.write(8, column, axis.maxRampRate, alignRightFormat);
+			xlsx.write(9, column, axis.coilConst, alignRightFormat);
+			xlsx.write(10, column, axis.inductance, alignRightFormat);
+			xlsx.write(11, column, axis.switchInstalled, alignRightFormat);
+
+			if (axis.switchInstalled)
+			{
+				xlsx.write(12, column, axis.switchHeaterCurrent, alignRightFormat);
+				xlsx.write(13, column, axis.switchCoolingTime, alignRightFormat);
+				xlsx.write(14, column, axis.switchHeatingTime, alignRightFormat);
+			}
+		}
+		else
+			xlsx.write(5, column, "N/A", alignCenterFormat);
+	}
+
+	// create vector table output sheet
+	xlsx.addSheet("Vector Table Results");
+	xlsx.setColumnWidth(1, 8, 15);
+
+	// output date/time of the snapshot
+	xlsx.write("A1", "Date", boldAlignRightFormat);
+	xlsx.write("B1", report.timestamp.date().toString());
+	xlsx.write("A2", "Time", boldAlignRightFormat);
+	xlsx.write("B2", report.timestamp.time().toString());
+
+	// output headers
+	xlsx.write("F3", "Quench");
+	xlsx.mergeCells("F3:H3", boldAlignCenterFormat);
+
+	int numColumns = contents.headers.count();
+
+	for (int i = 0; i < numColumns; i++)
+	{
+		xlsx.write(4, i + 1, contents.headers.value(i), boldAlignCenterFormat);
+	}
+
+	xlsx.write("F4", "X-Axis", boldAlignCenterFormat);
+	xlsx.write("G4", "Y-Axis", boldAlignCenterFormat);
+	xlsx.write("H4", "Z-Axis", boldAlignCenterFormat);
+
+	// quench columns may have been added during a run, and steps from a
+	// journal are followed by their times and external app result
+	if (fromJournal)
+	{
+		numColumns = JOURNAL_COLUMN;
+		xlsx.setColumnWidth(JOURNAL_COLUMN + 1, JOURNAL_COLUMN + 4, 20);
+		xlsx.write(4, JOURNAL_COLUMN + 1, "Started", boldAlignCenterFormat);
+		xlsx.write(4, JOURNAL_COLUMN + 2, "Completed", boldAlignCenterFormat);
+		xlsx.write(4, JOURNAL_COLUMN + 3, "App Exit Code", boldAlignCenterFormat);
+		xlsx.write(4, JOURNAL_COLUMN + 4, "App Output", boldAlignCenterFormat);
+	}
+
+	// output vector data, appended as streamed rows (starting at row 5)
+	// so memory use does not grow with the size of the table
+	QXlsx::Worksheet *resultsSheet = xlsx.currentWorksheet();
+	QList<QVariant> values;
+	QList<QXlsx::Format> formats;
+	JournalStep step;
+	int row = 0;
+
+	while (fromJournal ? journal.readStep(&step) : row < contents.rows)
+	{
+		if (!fromJournal)
+			step = stepFromContents(contents, report.checks, row++);
+
+		values.clear();
+		formats.clear();
+
+		for (int j = 0; j < numColumns; j++)
+		{
+			CellState state = cellState(step, j, contents.resultColumn);
+
+			if (j == 4 || state == CELL_EMPTY)
+			{
+				values.append(cellText(step, j, contents));
+				formats.append(alignCenterFormat);
+			}
+			else
+			{
+				if (report.switchInstalled && j == 3)
+				{
+					if (step.checked)
+						values.append("Yes / " + cellText(step, j, contents));
+					else
+						values.append("No / " + cellText(step, j, contents));
+				}
+				else if (state == CELL_VALUE)
+					values.append(step.values[j]);
+				else
+					values.append(cellText(step, j, contents));
+
+				formats.append(alignRightFormat);
+			}
+		}
+
+		if (fromJournal)
+		{
+			values.append(stepTime(step.started));
+			formats.append(alignCenterFormat);
+			values.append(stepTime(step.completed));
+			formats.append(alignCenterFormat);
+			values.append(step.appFinished ? QVariant(step.appExitCode) : QVariant());
+			formats.append(alignCenterFormat);
+			values.append(step.appOutput);
+			formats.append(QXlsx::Format());
+		}
+
+		resultsSheet->appendRow(values, formats);
+	}
+
+	xlsx.setCompressionLevel(compressionLevel);
+
+	if (!xlsx.saveAs(outputFileName))
+		error = "Unable to save report " + QDir::toNativeSeparators(outputFileName);
+
+	report = ReportData();
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QDateTime>
+#include "magnetparams.h"
+#include "tablemodel.h"
+
+//---------------------------------------------------------------------------
+// Everything an Excel report needs, copied on the GUI thread so the
+// workbook can be built while acquisition and auto-stepping carry on.
+//---------------------------------------------------------------------------
+struct ReportData
+{
+	QString magnetID;
+	double magnitudeLimit = 0.0;
+	FieldUnits fieldUnits = TESLA;
+	AxesParams axes[3];
+	bool switchInstalled = false;	// any active axis has a persistent switch
+	TableContents results;			// vector table snapshot
+	QVector<bool> checks;			// persistence check state of each row
+	QDateTime timestamp;
+};
+
+//---------------------------------------------------------------------------
+// Builds and saves the Excel test report on a worker thread, either from
+// a snapshot of the vector table or from a ResultsJournal of a run.
+//---------------------------------------------------------------------------
+class ReportWriter : public QObject
+{
+	Q_OBJECT
+
+public:
+	ReportWriter(QObject *parent = Q_NULLPTR);
+	~ReportWriter();
+
+	bool isRunning(void) { return watcher.isRunning(); }
+	void start(const QString &filename, const ReportData &data);
+	void start(const QString &filename, const QString &journal);
+	void setCompressionLevel(int level) { if (!watcher.isRunning()) compressionLevel = level; }
+	QString fileName(void) { return outputFileName; }
+	QString errorString(void) { return error; }
+
+signals:
+	void finished(void);
+
+private:
+	QFutureWatcher<void> watcher;
+	QString outputFileName;
+	QString journalFileName;	// materialize from this journal if set
+	ReportData report;
+	int compressionLevel;		// of the xlsx package, 0 stores it uncompressed
+	QString error;
+
+	void write(void);
+};
@@ -0,0 +1,425 @@
+#include "stdafx.h"
+#include "resultsjournal.h"
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <io.h>
+#endif
+
+const quint32 MAX_RECORD_LENGTH = 16 << 20;		// anything larger is corrupt
+
+//---------------------------------------------------------------------------
+// Payload streams share one encoding so journals read back on any platform
+//---------------------------------------------------------------------------
+static void setupStream(QDataStream &stream)
+{
+	stream.setVersion(QDataStream::Qt_5_12);
+	stream.setByteOrder(QDataStream::LittleEndian);
+}
+
+//---------------------------------------------------------------------------
+static void writeAxis(QDataStream &stream, const AxesParams &axis)
+{
+	stream << axis.activate << axis.ipAddress << axis.currentLimit << axis.voltageLimit
+		<< axis.maxRampRate << axis.coilConst << axis.inductance << axis.switchInstalled
+		<< axis.switchHeaterCurrent << qint32(axis.switchCoolingTime) << qint32(axis.switchHeatingTime);
+}
+
+//---------------------------------------------------------------------------
+static void readAxis(QDataStream &stream, AxesParams &axis)
+{
+	qint32 coolingTime, heatingTime;
+
+	stream >> axis.activate >> axis.ipAddress >> axis.currentLimit >> axis.voltageLimit
+		>> axis.maxRampRate >> axis.coilConst >> axis.inductance >> axis.switchInstalled
+		>> axis.switchHeaterCurrent >> coolingTime >> heatingTime;
+
+	axis.switchCoolingTime = coolingTime;
+	axis.switchHeatingTime = heatingTime;
+}
+
+//---------------------------------------------------------------------------
+// Cells of a table row: count, then per column a CellState followed by a
+// double (CELL_VALUE) or a string (CELL_TEXT)
+//---------------------------------------------------------------------------
+static void writeCells(QDataStream &stream, const TableModel *table, int row)
+{
+	int numColumns = table->columnCount();
+
+	stream << quint16(numColumns);
+
+	for (int i = 0; i < numColumns; i++)
+	{
+		CellState state = table->state(row, i);
+
+		stream << quint8(state);
+
+		if (state == CELL_VALUE)
+			stream << table->value(row, i);
+		else if (state == CELL_TEXT)
+			stream << table->text(row, i);
+	}
+}
+
+//---------------------------------------------------------------------------
+static void readCells(QDataStream &stream, JournalStep *step)
+{
+	quint16 numColumns;
+
+	stream >> numColumns;
+
+	step->states.fill(CELL_EMPTY, numColumns);
+	step->values.fill(0.0, numColumns);
+	step->texts.clear();
+
+	for (int i = 0; i < numColumns; i++)
+	{
+		quint8 state;
+
+		stream >> state;
+		step->states[i] = state;
+		step->texts.append(QString());
+
+		if (state == CELL_VALUE)
+			stream >> step->values[i];
+		else if (state == CELL_TEXT)
+			stream >> step->texts[i];
+	}
+}
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+ResultsJournal::ResultsJournal()
+{
+	currentRow = -1;
+	currentResult = RESULT_NONE;
+	appRow = -1;
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+ResultsJournal::~ResultsJournal()
+{
+	close();
+}
+
+//---------------------------------------------------------------------------
+// Starts a new journal for a run, the table rows of run are not used
+bool ResultsJournal::open(const QString &filename, const ReportData &run)
+{
+	close();
+
+	QFileInfo info(filename);
+	QDir().mkpath(info.absolutePath());
+
+	file.setFileName(filename);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qDebug() << "Unable to create results journal" << filename;
+		return false;
+	}
+
+	QByteArray header(RESULTS_JOURNAL_MAGIC, sizeof(RESULTS_JOURNAL_MAGIC));
+	quint32 version = qToLittleEndian(RESULTS_JOURNAL_VERSION);
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+
+	header.append(reinterpret_cast<const char *>(&version), sizeof(version));
+	setupStream(stream);
+
+	stream << run.timestamp.toMSecsSinceEpoch() << run.magnetID << run.magnitudeLimit << qint32(run.fieldUnits);
+
+	for (int i = 0; i < 3; i++)
+		writeAxis(stream, run.axes[i]);
+
+	stream << run.switchInstalled << run.results.headers << run.results.precisions << qint32(run.results.resultColumn);
+
+	if (file.write(header) != header.size() || !writeRecord(JOURNAL_RUN, payload))
+	{
+		file.close();
+		return false;
+	}
+
+	sync();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+void ResultsJournal::close(void)
+{
+	if (file.isOpen())
+		file.close();
+
+	currentRow = -1;
+	currentResult = RESULT_NONE;
+	appRow = -1;
+}
+
+//---------------------------------------------------------------------------
+// Writes and flushes one record, the journal is closed if the disk fails
+bool ResultsJournal::writeRecord(JournalRecordType type, const QByteArray &payload)
+{
+	QByteArray record;
+	QDataStream stream(&record, QIODevice::WriteOnly);
+
+	setupStream(stream);
+	stream << quint32(payload.size() + 1) << quint8(type);
+	record.append(payload);
+
+	if (file.write(record) != record.size() || !file.flush())
+	{
+		qDebug() << "Results journal stopped, unable to write" << file.fileName();
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Waits for the journal to reach the disk, flush() only hands the records
+// to the operating system
+void ResultsJournal::sync(void)
+{
+	if (!file.isOpen())
+		return;
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+	fsync(file.handle());
+#elif defined(Q_OS_WIN)
+	FlushFileBuffers((HANDLE)_get_osfhandle(file.handle()));
+#endif
+}
+
+//---------------------------------------------------------------------------
+void ResultsJournal::stepStarted(int row, const TableModel *table)
+{
+	if (!isOpen())
+		return;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+
+	currentRow = row;
+	currentResult = RESULT_NONE;
+
+	setupStream(stream);
+	stream << QDateTime::currentMSecsSinceEpoch() << qint32(row) << table->isChecked(row);
+	writeCells(stream, table, row);
+	writeRecord(JOURNAL_STEP_START, payload);
+}
+
+//---------------------------------------------------------------------------
+// Only a change of result is written, a Pass is set on every HOLDING sample
+void ResultsJournal::stepResult(int row, const TableModel *table)
+{
+	if (!isOpen() || row != currentRow || table->result(row) == currentResult)
+		return;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+
+	currentResult = table->result(row);
+
+	setupStream(stream);
+	stream << QDateTime::currentMSecsSinceEpoch() << qint32(row) << currentResult;
+	writeCells(stream, table, row);
+	writeRecord(JOURNAL_STEP_RESULT, payload);
+}
+
+//---------------------------------------------------------------------------
+// Attaches the exit code and captured output to the step that launched
+// the app with appStarted(), apps run outside a step are not journaled
+void ResultsJournal::appFinished(int exitCode, const QString &output)
+{
+	if (!isOpen() || appRow < 0)
+		return;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+
+	setupStream(stream);
+	stream << QDateTime::currentMSecsSinceEpoch() << qint32(appRow) << qint32(exitCode) << output;
+	appRow = -1;
+	writeRecord(JOURNAL_APP_EXIT, payload);
+}
+
+//---------------------------------------------------------------------------
+void ResultsJournal::stepEnded(int row)
+{
+	if (!isOpen() || row != currentRow)
+		return;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+
+	setupStream(stream);
+	stream << QDateTime::currentMSecsSinceEpoch() << qint32(row);
+
+	if (writeRecord(JOURNAL_STEP_END, payload))
+		sync();
+}
+
+//---------------------------------------------------------------------------
+// Removes all but the newest keep journals from directory, their names
+// carry the start time of the run so they list oldest first
+void ResultsJournal::removeOld(const QString &directory, int keep)
+{
+	QDir dir(directory);
+	QStringList names = dir.entryList(QStringList() << "Results-*.maxres", QDir::Files, QDir::Name);
+
+	for (int i = 0; i < names.count() - keep; i++)
+	{
+		if (!dir.remove(names[i]))
+			qDebug() << "Unable to remove results journal" << dir.filePath(names[i]);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Reads the header and run record
+bool ResultsJournalReader::open(const QString &filename)
+{
+	file.setFileName(filename);
+	havePending = false;
+	runData = ReportData();
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		error = "Unable to open results journal " + QDir::toNativeSeparators(filename) + ": " + file.errorString();
+		return false;
+	}
+
+	QByteArray header = file.read(sizeof(RESULTS_JOURNAL_MAGIC) + sizeof(quint32));
+	quint8 type;
+	QByteArray payload;
+
+	if (header.size() != sizeof(RESULTS_JOURNAL_MAGIC) + sizeof(quint32) ||
+		memcmp(header.constData(), RESULTS_JOURNAL_MAGIC, sizeof(RESULTS_JOURNAL_MAGIC)) != 0 ||
+		qFromLittleEndian<quint32>(header.constData() + sizeof(RESULTS_JOURNAL_MAGIC)) > RESULTS_JOURNAL_VERSION ||
+		!readRecord(&type, &payload) || type != JOURNAL_RUN)
+	{
+		error = QDir::toNativeSeparators(filename) + " is not a results journal";
+		file.close();
+		return false;
+	}
+
+	QDataStream stream(payload);
+	qint64 timestamp;
+	qint32 fieldUnits, resultColumn;
+
+	setupStream(stream);
+	stream >> timestamp >> runData.magnetID >> runData.magnitudeLimit >> fieldUnits;
+
+	for (int i = 0; i < 3; i++)
+		readAxis(stream, runData.axes[i]);
+
+	stream >> runData.switchInstalled >> runData.results.headers >> runData.results.precisions >> resultColumn;
+
+	runData.timestamp = QDateTime::fromMSecsSinceEpoch(timestamp);
+	runData.fieldUnits = static_cast<FieldUnits>(fieldUnits);
+	runData.results.resultColumn = resultColumn;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// A record cut short by a crash reads as the end of the journal
+bool ResultsJournalReader::readRecord(quint8 *type, QByteArray *payload)
+{
+	quint32 length;
+
+	if (file.read(reinterpret_cast<char *>(&length), sizeof(length)) != sizeof(length))
+		return false;
+
+	length = qFromLittleEndian(length);
+
+	if (length == 0 || length > MAX_RECORD_LENGTH)
+		return false;
+
+	QByteArray record = file.read(length);
+
+	if (record.size() != static_cast<int>(length))
+		return false;
+
+	*type = static_cast<quint8>(record.at(0));
+	*payload = record.mid(1);
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Returns the next step once all of its records have been read, false at
+// the end of the journal
+bool ResultsJournalReader::readStep(JournalStep *step)
+{
+	quint8 type;
+	QByteArray payload;
+
+	while (readRecord(&type, &payload))
+	{
+		QDataStream stream(payload);
+		qint64 timestamp;
+		qint32 row;
+
+		setupStream(stream);
+		stream >> timestamp >> row;
+
+		if (type == JOURNAL_STEP_START)
+		{
+			JournalStep next;
+
+			next.row = row;
+			next.started = timestamp;
+			stream >> next.checked;
+			readCells(stream, &next);
+
+			if (havePending)
+			{
+				*step = pending;
+				pending = next;
+				return true;
+			}
+
+			pending = next;
+			havePending = true;
+		}
+		else if (!havePending || row != pending.row)
+		{
+			continue;	// belongs to no step, skip it
+		}
+		else if (type == JOURNAL_STEP_RESULT)
+		{
+			pending.completed = timestamp;
+			stream >> pending.result;
+			readCells(stream, &pending);
+		}
+		else if (type == JOURNAL_APP_EXIT)
+		{
+			qint32 exitCode;
+
+			stream >> exitCode >> pending.appOutput;
+			pending.appExitCode = exitCode;
+			pending.appFinished = true;
+		}
+		else if (type == JOURNAL_STEP_END)
+		{
+			pending.completed = timestamp;
+		}
+	}
+
+	if (!havePending)
+		return false;
+
+	*step = pending;
+	havePending = false;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
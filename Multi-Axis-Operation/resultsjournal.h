@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QFile>
+#include <QDataStream>
+#include "reportwriter.h"
+
+//---------------------------------------------------------------------------
+// Append-only journal of an auto-step run (*.maxres). Each step is written
+// and flushed as it happens, and synced to disk when it ends, so the results
+// up to the last completed step survive an application crash or power loss,
+// and the Excel report is materialized from the journal one step at a time
+// instead of from the table. Only the newest RESULTS_JOURNALS_KEPT journals
+// are kept, older ones are removed as a run starts.
+//
+// The file is an 8 byte magic and uint32 version followed by records, each
+// a uint32 length of the rest of the record, a uint8 JournalRecordType and
+// a QDataStream payload in little-endian byte order. A reader stops at the
+// first incomplete record, which is where a crash interrupted the writer.
+//
+// A run record (magnet parameters and table layout) comes first. Every step
+// then has a start record and optional result, app exit and end records,
+// all carrying the zero-based table row. Start and result records hold the
+// cells of the row at that time, so quench currents are included. An app
+// still running when the next step starts is not attributed to its step.
+//---------------------------------------------------------------------------
+
+const char RESULTS_JOURNAL_MAGIC[8] = { 'A', 'M', 'I', 'M', 'X', 'R', 'E', 'S' };
+const quint32 RESULTS_JOURNAL_VERSION = 1;
+const int RESULTS_JOURNALS_KEPT = 100;
+
+enum JournalRecordType
+{
+	JOURNAL_RUN = 1,			// ReportData without table rows
+	JOURNAL_STEP_START,			// ramping to the vector of a row
+	JOURNAL_STEP_RESULT,		// Pass/Fail of the row changed
+	JOURNAL_APP_EXIT,			// external app/script finished during the step
+	JOURNAL_STEP_END			// dwell complete, moving on
+};
+
+//---------------------------------------------------------------------------
+// One step as read back from the journal. Times are msec since the epoch.
+//---------------------------------------------------------------------------
+struct JournalStep
+{
+	int row = -1;
+	qint64 started = 0;
+	qint64 completed = 0;		// result or end time, zero if neither was written
+	quint8 result = RESULT_NONE;
+	bool checked = false;
+	QVector<quint8> states;		// CellState of each column
+	QVector<double> values;
+	QStringList texts;			// CELL_TEXT entries, empty otherwise
+	bool appFinished = false;
+	int appExitCode = 0;
+	QString appOutput;
+};
+
+//---------------------------------------------------------------------------
+// Journal writer, used on the GUI thread. A record costs one small write
+// and a flush, so it can be written as soon as a step changes; the sync to
+// disk is left to the end of the step.
+//---------------------------------------------------------------------------
+class ResultsJournal
+{
+public:
+	ResultsJournal();
+	~ResultsJournal();
+
+	bool open(const QString &filename, const ReportData &run);
+	void close(void);
+	bool isOpen(void) { return file.isOpen(); }
+	QString fileName(void) { return file.fileName(); }
+
+	void stepStarted(int row, const TableModel *table);
+	void stepResult(int row, const TableModel *table);
+	void appStarted(void) { appRow = currentRow; }
+	void appFinished(int exitCode, const QString &output);
+	void stepEnded(int row);
+
+	static void removeOld(const QString &directory, int keep);
+
+private:
+	QFile file;
+	int currentRow;			// row of the step in progress, -1 if none
+	quint8 currentResult;	// last result written for the step
+	int appRow;				// row of the step that launched the external app
+
+	bool writeRecord(JournalRecordType type, const QByteArray &payload);
+	void sync(void);
+};
+
+//---------------------------------------------------------------------------
+// Journal reader, merges the records of each step so a report can be built
+// while holding a single step in memory. Safe to use on a worker thread
+// while the journal is still being appended to.
+//---------------------------------------------------------------------------
+class ResultsJournalReader
+{
+public:
+	bool open(const QString &filename);
+	const ReportData &run(void) { return runData; }
+	bool readStep(JournalStep *step);
+	QString errorString(void) { return error; }
+
+private:
+	QFile file;
+	ReportData runData;
+	JournalStep pending;		// step started by the last record read
+	bool havePending = false;
+	QString error;
+
+	bool readRecord(quint8 *type, QByteArray *payload);
+};
@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "samplehistory.h"
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+SampleHistory::SampleHistory(int capacity)
+{
+	maxCount = (capacity > 0 ? capacity : DEFAULT_CAPACITY);
+	head = 0;
+	count = 0;
+	appended = 0;
+	fieldUnits = KG;
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+SampleHistory::~SampleHistory()
+{
+}
+
+//---------------------------------------------------------------------------
+// Discards all samples and restarts the time base; the columns are sized to
+// full capacity on first use so that append() never allocates
+void SampleHistory::reset(FieldUnits units)
+{
+	if (timeCol.size() != maxCount)
+	{
+		timeCol.resize(maxCount);
+		magnitudeCol.resize(maxCount);
+		polarMagnitudeCol.resize(maxCount);
+		polarAngleCol.resize(maxCount);
+		switchCol.resize(maxCount);
+
+		for (int i = 0; i < 3; i++)
+		{
+			fieldCol[i].resize(maxCount);
+			targetCol[i].resize(maxCount);
+			currentCol[i].resize(maxCount);
+			stateCol[i].resize(maxCount);
+		}
+	}
+
+	head = 0;
+	count = 0;
+	appended = 0;
+	fieldUnits = units;
+	start = QDateTime::currentDateTime();
+	clock.start();
+}
+
+//---------------------------------------------------------------------------
+void SampleHistory::append(const HistorySample &sample)
+{
+	if (timeCol.isEmpty())
+		return;	// not reset yet
+
+	int p;
+
+	if (count < maxCount)
+	{
+		p = physical(count);
+		count++;
+	}
+	else
+	{
+		// full, overwrite oldest
+		p = head;
+		head++;
+		if (head >= maxCount)
+			head = 0;
+	}
+
+	timeCol[p] = clock.elapsed();
+
+	quint8 switches = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		fieldCol[i][p] = (float)sample.field[i];
+		targetCol[i][p] = (float)sample.target[i];
+		currentCol[i][p] = (float)sample.current[i];
+		stateCol[i][p] = (quint8)sample.state[i];
+
+		if (sample.switchHeated[i])
+			switches |= (1 << i);
+	}
+
+	switchCol[p] = switches;
+	magnitudeCol[p] = (float)sqrt(sample.field[0] * sample.field[0] + sample.field[1] * sample.field[1] + sample.field[2] * sample.field[2]);
+	polarMagnitudeCol[p] = (float)sample.polarMagnitude;
+	polarAngleCol[p] = (float)sample.polarAngle;
+
+	appended++;
+}
+
+//---------------------------------------------------------------------------
+int SampleHistory::lowerBound(qint64 msec) const
+{
+	int low = 0;
+	int high = count;
+
+	// timestamps are monotonic in logical order
+	while (low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if (time(mid) < msec)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+//---------------------------------------------------------------------------
+// Returns the logical index range [first, last) of samples within the times
+void SampleHistory::range(qint64 fromMsec, qint64 toMsec, int *first, int *last) const
+{
+	*first = lowerBound(fromMsec);
+	*last = lowerBound(toMsec + 1);
+}
+
+//---------------------------------------------------------------------------
+// Splits logical range [first, last) into at most two physical spans of the
+// column arrays; returns the number of spans
+int SampleHistory::segments(int first, int last, int *offsets, int *lengths) const
+{
+	if (first < 0)
+		first = 0;
+	if (last > count)
+		last = count;
+	if (first >= last)
+		return 0;
+
+	int p = physical(first);
+	int n = last - first;
+
+	if (p + n <= maxCount)
+	{
+		offsets[0] = p;
+		lengths[0] = n;
+		return 1;
+	}
+	else
+	{
+		offsets[0] = p;
+		lengths[0] = maxCount - p;
+		offsets[1] = 0;
+		lengths[1] = n - lengths[0];
+		return 2;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QVector>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include "magnetparams.h"
+
+//---------------------------------------------------------------------------
+// Type declarations
+//---------------------------------------------------------------------------
+struct HistorySample
+{
+	double field[3];		// present field units
+	double target[3];		// present field units
+	double polarMagnitude;	// present field units
+	double polarAngle;		// degrees
+	double current[3];		// A
+	State state[3];
+	bool switchHeated[3];
+};
+
+//---------------------------------------------------------------------------
+// Fixed-capacity ring buffer of acquisition samples stored as one array per
+// quantity (struct-of-arrays), so scans over a single column stay in cache.
+// Memory is allocated once by reset() and never grows; when full the oldest
+// sample is overwritten. Samples are addressed by logical index, 0 being the
+// oldest sample retained, and timestamps are msec since reset().
+//---------------------------------------------------------------------------
+class SampleHistory
+{
+public:
+	static const int DEFAULT_CAPACITY = 24 * 3600 * 10;	// 24 hours at 10 Hz
+
+	SampleHistory(int capacity = DEFAULT_CAPACITY);
+	~SampleHistory();
+
+	void reset(FieldUnits units);
+	void append(const HistorySample &sample);
+
+	int size(void) const { return count; }
+	int capacity(void) const { return maxCount; }
+	bool isEmpty(void) const { return (count == 0); }
+	FieldUnits units(void) const { return fieldUnits; }
+	QDateTime startTime(void) const { return start; }
+	quint64 totalAppended(void) const { return appended; }	// includes overwritten samples
+
+	// O(log n) range lookup, returns logical index of first sample with time >= msec
+	int lowerBound(qint64 msec) const;
+	void range(qint64 fromMsec, qint64 toMsec, int *first, int *last) const;
+
+	// O(1) column accessors by logical index
+	qint64 time(int i) const { return timeCol[physical(i)]; }
+	float field(Axis axis, int i) const { return fieldCol[axis][physical(i)]; }
+	float target(Axis axis, int i) const { return targetCol[axis][physical(i)]; }
+	float current(Axis axis, int i) const { return currentCol[axis][physical(i)]; }
+	float magnitude(int i) const { return magnitudeCol[physical(i)]; }
+	float polarMagnitude(int i) const { return polarMagnitudeCol[physical(i)]; }
+	float polarAngle(int i) const { return polarAngleCol[physical(i)]; }
+	State state(Axis axis, int i) const { return (State)stateCol[axis][physical(i)]; }
+	bool switchHeated(Axis axis, int i) const { return (switchCol[physical(i)] & (1 << axis)) != 0; }
+
+	// direct column access for bulk scans without copying; a logical range
+	// maps to at most two contiguous physical spans, see segments()
+	const qint64 *timeData(void) const { return timeCol.constData(); }
+	const float *fieldData(Axis axis) const { return fieldCol[axis].constData(); }
+	const float *magnitudeData(void) const { return magnitudeCol.constData(); }
+	const float *polarMagnitudeData(void) const { return polarMagnitudeCol.constData(); }
+	const float *polarAngleData(void) const { return polarAngleCol.constData(); }
+	int segments(int first, int last, int *offsets, int *lengths) const;
+
+private:
+	int maxCount;
+	int head;	// physical index of oldest sample
+	int count;
+	quint64 appended;
+	FieldUnits fieldUnits;
+	QDateTime start;
+	QElapsedTimer clock;
+
+	QVector<qint64> timeCol;
+	QVector<float> fieldCol[3];
+	QVector<float> targetCol[3];
+	QVector<float> currentCol[3];
+	QVector<float> magnitudeCol;
+	QVector<float> polarMagnitudeCol;
+	QVector<float> polarAngleCol;
+	QVector<quint8> stateCol[3];
+	QVector<quint8> switchCol;	// bit per axis
+
+	int physical(int i) const { int p = head + i; return (p >= maxCount ? p - maxCount : p); }
+};
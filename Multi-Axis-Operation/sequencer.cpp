@@ -0,0 +1,659 @@
+#include "stdafx.h"
+#include "sequencer.h"
+#include <QDeadlineTimer>
+
+QMutex Sequencer::instanceMutex;
+Sequencer *Sequencer::sequencer = nullptr;
+
+//---------------------------------------------------------------------------
+const char *sequenceStateName(SequenceState state)
+{
+	static const char *names[] = { "EMPTY", "READY", "RUNNING", "DONE", "ABORTED", "FAILED" };
+
+	return names[state];
+}
+
+//---------------------------------------------------------------------------
+// Tests for a FOR variable name, letters, digits and '_'
+static bool isVariableName(const QByteArray &name)
+{
+	if (name.isEmpty() || isdigit((unsigned char)name[0]))
+		return false;
+
+	for (int i = 0; i < name.size(); i++)
+	{
+		if (!isalnum((unsigned char)name[i]) && name[i] != '_')
+			return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Length of the variable name following a '$' at text[start]
+static int variableLength(const QByteArray &text, int start)
+{
+	int end = start + 1;
+
+	while (end < text.size() && (isalnum((unsigned char)text[end]) || text[end] == '_'))
+		end++;
+
+	return end - start - 1;
+}
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+Sequencer::Sequencer()
+	: Parser(nullptr)
+{
+	state = SEQUENCE_EMPTY;
+	currentLine = 0;
+	lastError = 0;
+	runRequested = false;
+	abortRequested.store(false);
+
+	QMutexLocker lock(&instanceMutex);
+	sequencer = this;
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+Sequencer::~Sequencer()
+{
+	// waits for any session still calling in
+	QMutexLocker lock(&instanceMutex);
+
+	if (sequencer == this)
+		sequencer = nullptr;
+}
+
+//---------------------------------------------------------------------------
+// Aborts any running sequence and ends the sequencer thread
+//---------------------------------------------------------------------------
+void Sequencer::shutdown(void)
+{
+	{
+		QMutexLocker lock(&instanceMutex);
+
+		if (sequencer == this)
+			sequencer = nullptr;
+	}
+
+	QMutexLocker lock(&stateMutex);
+
+	abortRequested.store(true);
+	stopProcessing = true;
+	stateChanged.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+// --- SEQUENCER THREAD ---
+// Waits for SEQ:RUN and executes the sequence
+void Sequencer::process(void)
+{
+	if (source == NULL)
+	{
+		qDebug("Multi-Axis Operation sequencer aborted; no data source specified");
+	}
+	else
+	{
+		qDebug("Multi-Axis Operation sequencer Start");
+
+		forever
+		{
+			{
+				QMutexLocker lock(&stateMutex);
+
+				while (!runRequested && !stopProcessing)
+					stateChanged.wait(&stateMutex);
+
+				if (stopProcessing)
+					break;
+
+				runRequested = false;
+			}
+
+			execute();
+		}
+	}
+
+	emit finished();
+}
+
+//---------------------------------------------------------------------------
+// Compiles and stores a script, replacing any previous one. A syntax error
+// leaves no script, with the error and its line reported by status().
+//---------------------------------------------------------------------------
+bool Sequencer::define(const QList<QByteArray> &lines, SystemError *error)
+{
+	QVector<Step> compiled;
+	int errorLine;
+	bool ok = compile(lines, &compiled, &errorLine);
+
+	QMutexLocker lock(&stateMutex);
+
+	if (state == SEQUENCE_RUNNING || runRequested)
+	{
+		*error = ERR_SEQUENCE_BUSY;
+		return false;
+	}
+
+	steps = ok ? compiled : QVector<Step>();
+	state = steps.isEmpty() ? SEQUENCE_EMPTY : SEQUENCE_READY;
+	currentLine = ok ? 0 : errorLine;
+	lastError = ok ? 0 : ERR_SEQUENCE_SYNTAX;
+
+	if (!ok)
+		*error = ERR_SEQUENCE_SYNTAX;
+
+	return ok;
+}
+
+//---------------------------------------------------------------------------
+// Starts the defined script on the sequencer thread
+//---------------------------------------------------------------------------
+bool Sequencer::run(SystemError *error)
+{
+	QMutexLocker lock(&stateMutex);
+
+	if (state == SEQUENCE_RUNNING || runRequested)
+	{
+		*error = ERR_SEQUENCE_BUSY;
+		return false;
+	}
+
+	if (steps.isEmpty())
+	{
+		*error = ERR_SEQUENCE_SYNTAX;	// nothing defined
+		return false;
+	}
+
+	// reported as running from now, the RUNNING event follows from the thread
+	state = SEQUENCE_RUNNING;
+	currentLine = 0;
+	lastError = 0;
+	runRequested = true;
+	abortRequested.store(false);
+	stateChanged.wakeAll();
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Stops a running sequence after the present step, a WAIT or DELAY in
+// progress ends early
+//---------------------------------------------------------------------------
+void Sequencer::abort(void)
+{
+	QMutexLocker lock(&stateMutex);
+
+	if (state == SEQUENCE_RUNNING)
+	{
+		abortRequested.store(true);
+		stateChanged.wakeAll();
+	}
+}
+
+//---------------------------------------------------------------------------
+void Sequencer::status(SequenceState *state, int *line, int *error)
+{
+	QMutexLocker lock(&stateMutex);
+
+	*state = this->state;
+	*line = currentLine;
+	*error = lastError;
+}
+
+//---------------------------------------------------------------------------
+bool Sequencer::cancelled(void)
+{
+	return stopProcessing || abortRequested.load();
+}
+
+//---------------------------------------------------------------------------
+// Commands that read a block of lines (TABLE:VECtor <count> etc.) are not
+// available in a script, a TABLE ... END block builds a table instead
+//---------------------------------------------------------------------------
+bool Sequencer::readInputLine(QByteArray *line)
+{
+	return false;
+}
+
+//---------------------------------------------------------------------------
+// Keeps the response to the last command line, for the WAIT result
+//---------------------------------------------------------------------------
+void Sequencer::writeOutput(const QByteArray &data)
+{
+	QMutexLocker lock(&outputMutex);
+
+	if (!data.startsWith('!'))	// not an event
+		lastResponse = data;
+}
+
+//---------------------------------------------------------------------------
+void Sequencer::setState(SequenceState newState, int line, int error)
+{
+	{
+		QMutexLocker lock(&stateMutex);
+
+		state = newState;
+		currentLine = line;
+		lastError = error;
+
+		// no events once the application is closing
+		if (stopProcessing)
+			return;
+	}
+
+	emit sequence_event(EVENT_SEQUENCE, QVariantList() << QString(sequenceStateName(newState)) << line << error);
+}
+
+//---------------------------------------------------------------------------
+// Compiles the script lines into steps with their blocks matched. Returns
+// false with the 1-based line of the first error.
+//---------------------------------------------------------------------------
+bool Sequencer::compile(const QList<QByteArray> &lines, QVector<Step> *compiled, int *errorLine)
+{
+	QVector<int> blocks;			// open FOR, REPEAT and TABLE steps
+	QList<QByteArray> variables;	// FOR variables in scope
+	int tableBlock = -1;			// open TABLE step
+
+	for (int i = 0; i < lines.count(); i++)
+	{
+		QByteArray text = lines[i].trimmed();
+
+		*errorLine = i + 1;
+
+		if (text.isEmpty() || text.startsWith('#'))
+			continue;
+
+		QList<QByteArray> words = text.simplified().split(' ');
+		QByteArray directive = words[0].toUpper();
+		bool ok = true;
+
+		Step step;
+		step.type = STEP_COMMAND;
+		step.line = i + 1;
+		step.text = text;
+		step.first = 0.0;
+		step.last = 0.0;
+		step.increment = 0.0;
+		step.table = NO_SOURCE;
+		step.coordinates = -1;
+		step.match = -1;
+		step.wait = false;
+
+		if (directive == "FOR")
+		{
+			// FOR <var> <first> <last> [<step>]
+			if (words.count() < 4 || words.count() > 5)
+				return false;
+
+			bool ok1, ok2, ok3 = true;
+
+			step.type = STEP_FOR;
+			step.variable = words[1].toUpper();
+			step.first = words[2].toDouble(&ok1);
+			step.last = words[3].toDouble(&ok2);
+			step.increment = (words.count() == 5) ? words[4].toDouble(&ok3) : 1.0;
+
+			if (!ok1 || !ok2 || !ok3 || step.increment == 0.0 ||
+				!isVariableName(step.variable) || variables.contains(step.variable))
+				return false;
+
+			variables.append(step.variable);
+		}
+		else if (directive == "REPEAT")
+		{
+			// REPEAT <count>
+			if (words.count() != 2)
+				return false;
+
+			step.type = STEP_REPEAT;
+			step.first = words[1].toInt(&ok);
+
+			if (!ok || step.first < 0)
+				return false;
+		}
+		else if (directive == "TABLE")
+		{
+			// TABLE VECTOR [SPHERICAL|CARTESIAN] or TABLE POLAR
+			if (tableBlock >= 0 || words.count() < 2 || words.count() > 3)
+				return false;
+
+			QByteArray table = words[1].toUpper();
+
+			step.type = STEP_TABLE;
+
+			if (table == "VEC" || table == "VECTOR")
+				step.table = VECTOR_TABLE;
+			else if (table == "POL" || table == "POLAR")
+				step.table = POLAR_TABLE;
+			else
+				return false;
+
+			if (words.count() == 3)
+			{
+				QByteArray coordinates = words[2].toUpper();
+
+				if (step.table != VECTOR_TABLE)
+					return false;
+				else if (coordinates == "SPHERICAL")
+					step.coordinates = SPHERICAL_COORDINATES;
+				else if (coordinates == "CARTESIAN")
+					step.coordinates = CARTESIAN_COORDINATES;
+				else
+					return false;
+			}
+
+			tableBlock = compiled->count();
+		}
+		else if (directive == "END")
+		{
+			if (words.count() != 1 || blocks.isEmpty())
+				return false;
+
+			step.type = STEP_END;
+			step.match = blocks.takeLast();
+			(*compiled)[step.match].match = compiled->count();
+
+			if ((*compiled)[step.match].type == STEP_FOR)
+				variables.removeLast();
+			else if ((*compiled)[step.match].type == STEP_TABLE)
+				tableBlock = -1;
+		}
+		else if (directive == "DELAY")
+		{
+			// DELAY <sec>
+			if (tableBlock >= 0 || words.count() != 2)
+				return false;
+
+			step.type = STEP_DELAY;
+			step.first = words[1].toDouble(&ok);
+
+			if (!ok || step.first < 0.0)
+				return false;
+		}
+		else if (directive == "EXEC")
+		{
+			// EXEC VECTOR|POLAR [<timeout sec>]
+			if (tableBlock >= 0 || words.count() < 2 || words.count() > 3)
+				return false;
+
+			QByteArray table = words[1].toUpper();
+
+			step.type = STEP_EXEC;
+			step.first = -1.0;	// no timeout
+
+			if (table == "VEC" || table == "VECTOR")
+				step.table = VECTOR_TABLE;
+			else if (table == "POL" || table == "POLAR")
+				step.table = POLAR_TABLE;
+			else
+				return false;
+
+			if (words.count() == 3)
+			{
+				step.first = words[2].toDouble(&ok);
+
+				if (!ok || step.first < 0.0)
+					return false;
+			}
+		}
+		else
+		{
+			// a remote command line, or a row within a TABLE block
+			step.type = (tableBlock >= 0) ? STEP_ROW : STEP_COMMAND;
+			step.wait = (step.type == STEP_COMMAND && directive.startsWith("WAIT") && !text.contains(';'));
+
+			// only FOR variables in scope may be substituted
+			for (int pos = text.indexOf('$'); pos >= 0; pos = text.indexOf('$', pos + 1))
+			{
+				QByteArray name = text.mid(pos + 1, variableLength(text, pos)).toUpper();
+
+				if (!variables.contains(name))
+					return false;
+			}
+		}
+
+		if (step.type == STEP_FOR || step.type == STEP_REPEAT || step.type == STEP_TABLE)
+			blocks.append(compiled->count());
+
+		compiled->append(step);
+	}
+
+	if (!blocks.isEmpty())
+	{
+		// block without an END
+		*errorLine = (*compiled)[blocks.last()].line;
+		return false;
+	}
+
+	*errorLine = 0;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+// Replaces $<var> with the present FOR value
+//---------------------------------------------------------------------------
+QByteArray Sequencer::substitute(const QByteArray &text, const QHash<QByteArray, double> &values)
+{
+	int pos = text.indexOf('$');
+
+	if (pos < 0)
+		return text;
+
+	QByteArray result;
+	int start = 0;
+
+	for (; pos >= 0; pos = text.indexOf('$', start))
+	{
+		int length = variableLength(text, pos);
+		QByteArray name = text.mid(pos + 1, length).toUpper();
+
+		result.append(text.mid(start, pos - start));
+		result.append(QByteArray::number(values.value(name), 'g', 10));
+		start = pos + 1 + length;
+	}
+
+	result.append(text.mid(start));
+
+	return result;
+}
+
+//---------------------------------------------------------------------------
+// Executes one command line, returns the error code it queued, or
+// ERR_SEQUENCE_WAIT for a WAIT that was not met (0 if all good)
+//---------------------------------------------------------------------------
+int Sequencer::executeCommand(QByteArray line, bool isWait)
+{
+	int code;
+
+	{
+		QMutexLocker lock(&outputMutex);
+		lastResponse.clear();
+	}
+
+	inputStr = QString(line);
+	parseLine(line.data());
+
+	if (takeError(&code))
+		return code;
+
+	if (isWait)
+	{
+		QMutexLocker lock(&outputMutex);
+
+		// response is <met>,<state>, not met when aborted is not an error
+		if (!lastResponse.startsWith('1') && !cancelled())
+			return ERR_SEQUENCE_WAIT;
+	}
+
+	return 0;
+}
+
+//---------------------------------------------------------------------------
+// Pauses for a DELAY, returns false if aborted
+//---------------------------------------------------------------------------
+bool Sequencer::delay(double seconds)
+{
+	QDeadlineTimer deadline((qint64)(seconds * 1000.0));
+	QMutexLocker lock(&stateMutex);
+
+	while (!cancelled() && !deadline.hasExpired())
+		stateChanged.wait(&stateMutex, (unsigned long)deadline.remainingTime());
+
+	return !cancelled();
+}
+
+//---------------------------------------------------------------------------
+// Runs the script from the top until done, aborted or failed
+//---------------------------------------------------------------------------
+void Sequencer::execute(void)
+{
+	QVector<Step> program;
+	QVector<Block> blocks;
+	QHash<QByteArray, double> values;	// FOR variables
+	QList<QByteArray> tableRows;
+	int line = 0;
+	int error = 0;
+	int pc = 0;
+
+	{
+		QMutexLocker lock(&stateMutex);
+		program = steps;
+	}
+
+	// discard errors left from a previous run
+	takeError(&error);
+	error = 0;
+
+	setState(SEQUENCE_RUNNING, 0, 0);
+
+	while (pc < program.count() && error == 0 && !cancelled())
+	{
+		const Step &step = program[pc];
+
+		line = step.line;
+
+		{
+			QMutexLocker lock(&stateMutex);
+			currentLine = line;
+		}
+
+		switch (step.type)
+		{
+		case STEP_COMMAND:
+			error = executeCommand(substitute(step.text, values), step.wait);
+			pc++;
+			break;
+
+		case STEP_ROW:
+			tableRows.append(substitute(step.text, values));
+			pc++;
+			break;
+
+		case STEP_FOR:
+			if (step.increment > 0.0 ? step.first > step.last : step.first < step.last)
+			{
+				pc = step.match + 1;	// empty range
+			}
+			else
+			{
+				Block block = { pc, 0 };
+				blocks.append(block);
+				values[step.variable] = step.first;
+				pc++;
+			}
+			break;
+
+		case STEP_REPEAT:
+			if (step.first < 1.0)
+			{
+				pc = step.match + 1;
+			}
+			else
+			{
+				Block block = { pc, (int)step.first };
+				blocks.append(block);
+				pc++;
+			}
+			break;
+
+		case STEP_TABLE:
+			{
+				Block block = { pc, 0 };
+				blocks.append(block);
+				tableRows.clear();
+				pc++;
+			}
+			break;
+
+		case STEP_END:
+			{
+				Block &block = blocks.last();
+				const Step &begin = program[block.begin];
+				bool again = false;
+
+				if (begin.type == STEP_FOR)
+				{
+					// computed from the count so steps do not accumulate rounding
+					double value = begin.first + (++block.count) * begin.increment;
+					double limit = begin.last + 1e-9 * begin.increment;
+
+					again = (begin.increment > 0.0) ? (value <= limit) : (value >= limit);
+
+					if (again)
+						values[begin.variable] = value;
+				}
+				else if (begin.type == STEP_REPEAT)
+				{
+					again = (--block.count > 0);
+				}
+				else if (begin.type == STEP_TABLE)
+				{
+					uploadTableRows(begin.table, begin.coordinates, tableRows);
+					tableRows.clear();
+
+					if (takeError(&error))
+						line = begin.line;
+				}
+
+				if (again)
+				{
+					pc = block.begin + 1;
+				}
+				else
+				{
+					blocks.removeLast();
+					pc++;
+				}
+			}
+			break;
+
+		case STEP_DELAY:
+			delay(step.first);
+			pc++;
+			break;
+
+		case STEP_EXEC:
+			emit execute_app(step.table, LatencyStats::now());
+
+			if (!waitFor(WAIT_APP, 0, step.first) && !cancelled())
+				error = ERR_APP_FAILED;
+
+			pc++;
+			break;
+		}
+	}
+
+	if (error)
+		setState(SEQUENCE_FAILED, line, error);
+	else if (cancelled())
+		setState(SEQUENCE_ABORTED, line, 0);
+	else
+		setState(SEQUENCE_DONE, line, 0);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include "parser.h"
+
+//---------------------------------------------------------------------------
+// Runs a sequence script inside the application, so an experiment loop
+// does not need a client round trip for every step. A script is defined
+// over the scripting interface (SEQ:DEFine or SEQ:LOAD), started with
+// SEQ:RUN and monitored with SEQ:STATE? or the SEQUENCE event.
+//
+// Each script line is a remote command line, executed exactly as if a
+// client had sent it, or one of these directives (not case sensitive):
+//
+//   FOR <var> <first> <last> [<step>] ... END   numeric loop, $<var> in the
+//                                               enclosed lines is replaced
+//                                               by the present value
+//   REPEAT <count> ... END                      repeats the enclosed lines
+//   DELAY <sec>                                 pauses the sequence
+//   TABLE VECTOR [SPHERICAL|CARTESIAN] ... END  replaces a table with the
+//   TABLE POLAR ... END                         rows between TABLE and END,
+//                                               which may use FOR/REPEAT
+//   EXEC VECTOR|POLAR [<timeout sec>]           runs the app configured on
+//                                               the vector or polar tab and
+//                                               waits for it to exit
+//
+// Blank lines and lines starting with '#' are ignored. The sequence fails
+// at the first command that queues an error, a WAIT that is not met, or
+// an app that does not run or exits with an error.
+//---------------------------------------------------------------------------
+
+enum SequenceState
+{
+	SEQUENCE_EMPTY = 0,			// nothing defined, or the definition failed
+	SEQUENCE_READY,
+	SEQUENCE_RUNNING,
+	SEQUENCE_DONE,
+	SEQUENCE_ABORTED,
+	SEQUENCE_FAILED
+};
+
+extern const char *sequenceStateName(SequenceState state);
+
+class Sequencer : public Parser
+{
+	Q_OBJECT
+
+public:
+	Sequencer();
+	~Sequencer();
+	void shutdown(void);
+
+	// The sequencer of the application as seen by a scripting session,
+	// null once shut down. It is not shut down or destroyed while a
+	// session holds an Instance, so hold one only for a short call.
+	class Instance
+	{
+	public:
+		Instance() { instanceMutex.lock(); }
+		~Instance() { instanceMutex.unlock(); }
+		Sequencer *operator->() const { return sequencer; }
+		explicit operator bool() const { return sequencer != nullptr; }
+
+	private:
+		Q_DISABLE_COPY(Instance)
+	};
+
+	// called from the scripting sessions
+	bool define(const QList<QByteArray> &lines, SystemError *error);
+	bool run(SystemError *error);
+	void abort(void);
+	void status(SequenceState *state, int *line, int *error);
+
+public slots:
+	void process(void);
+
+signals:
+	void sequence_event(int event, QVariantList fields);
+
+protected:
+	bool cancelled(void);
+	bool readInputLine(QByteArray *line);
+	void writeOutput(const QByteArray &data);
+
+private:
+	enum StepType
+	{
+		STEP_COMMAND = 0,
+		STEP_ROW,				// table row within TABLE ... END
+		STEP_FOR,
+		STEP_REPEAT,
+		STEP_TABLE,
+		STEP_END,
+		STEP_DELAY,
+		STEP_EXEC
+	};
+
+	struct Step
+	{
+		StepType type;
+		int line;				// 1-based script line
+		QByteArray text;		// command line or row, before substitution
+		QByteArray variable;	// FOR variable
+		double first;			// FOR range, REPEAT count or DELAY/EXEC time
+		double last;
+		double increment;
+		int table;				// TABLE and EXEC target (TargetSource)
+		int coordinates;		// TABLE VECTOR coordinates, -1 for the present ones
+		int match;				// index of the matching END, or of the block for END
+		bool wait;				// WAIT command, fails the sequence if not met
+	};
+
+	struct Block
+	{
+		int begin;				// index of the FOR, REPEAT or TABLE step
+		int count;				// FOR iterations done or REPEAT iterations left
+	};
+
+	static QMutex instanceMutex;	// guards sequencer, taken before stateMutex
+	static Sequencer *sequencer;
+
+	QMutex stateMutex;
+	QWaitCondition stateChanged;
+	QVector<Step> steps;		// guarded by stateMutex while not running
+	SequenceState state;
+	int currentLine;
+	int lastError;
+	bool runRequested;
+	std::atomic<bool> abortRequested;
+	QByteArray lastResponse;	// response of the last command line
+
+	bool compile(const QList<QByteArray> &lines, QVector<Step> *compiled, int *errorLine);
+	void execute(void);
+	int executeCommand(QByteArray line, bool isWait);
+	bool delay(double seconds);
+	QByteArray substitute(const QByteArray &text, const QHash<QByteArray, double> &values);
+	void setState(SequenceState newState, int line, int error);
+};
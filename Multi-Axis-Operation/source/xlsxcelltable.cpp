@@ -0,0 +1,241 @@
+// xlsxcelltable.cpp
+
+#include <QtGlobal>
+
+#include <algorithm>
+
+#include "xlsxcelltable_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworkbook.h"
+#include "xlsxstyles_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+int columnIndex(const QVector<CellTable::Record> &cells, int column)
+{
+    // cells are mostly added left to right, try the end first
+    if (cells.isEmpty() || cells.last().column < column)
+        return cells.size();
+
+    auto it = std::lower_bound(cells.constBegin(), cells.constEnd(), column,
+                               [](const CellTable::Record &record, int value) { return record.column < value; });
+    return int(it - cells.constBegin());
+}
+
+} // namespace
+
+/*!
+ * \internal
+ * Index of \a row in rows(), or of the first row after it when the row
+ * holds no cells.
+ */
+int CellTable::rowIndex(int row) const
+{
+    // rows are mostly added top to bottom, try the end first
+    if (m_rows.isEmpty() || m_rows.last().row < row)
+        return m_rows.size();
+
+    auto it = std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), row,
+                               [](const Row &entry, int value) { return entry.row < value; });
+    return int(it - m_rows.constBegin());
+}
+
+const CellTable::Row *CellTable::findRow(int row) const
+{
+    const int index = rowIndex(row);
+    if (index == m_rows.size() || m_rows[index].row != row)
+        return nullptr;
+
+    return &m_rows[index];
+}
+
+/*!
+ * \internal
+ * Returns the record at \a row and \a column, or null when the cell is
+ * empty. The pointer is only valid until the next insert().
+ */
+const CellTable::Record *CellTable::find(int row, int column) const
+{
+    const Row *entry = findRow(row);
+    if (!entry)
+        return nullptr;
+
+    const int index = columnIndex(entry->cells, column);
+    if (index == entry->cells.size() || entry->cells[index].column != column)
+        return nullptr;
+
+    return &entry->cells[index];
+}
+
+CellTable::Record &CellTable::recordAt(int row, int column)
+{
+    const int index = rowIndex(row);
+    if (index == m_rows.size() || m_rows[index].row != row) {
+        Row entry;
+        entry.row = row;
+        m_rows.insert(index, entry);
+    }
+
+    QVector<Record> &cells = m_rows[index].cells;
+    const int cellIndex = columnIndex(cells, column);
+    if (cellIndex == cells.size() || cells[cellIndex].column != column) {
+        Record record;
+        record.column = column;
+        cells.insert(cellIndex, record);
+    }
+
+    return cells[cellIndex];
+}
+
+void CellTable::clear()
+{
+    m_rows.clear();
+    m_strings.clear();
+    m_cells.clear();
+}
+
+/*!
+ * \internal
+ * Stores a plain cell without creating a Cell object for it. \a value
+ * may be invalid (blank), a bool, a string or anything convertible to a
+ * number; \a xfIndex is the index of its format in the workbook styles.
+ */
+void CellTable::insert(int row, int column, const QVariant &value, Cell::CellType type, qint32 xfIndex, qint32 styleNumber)
+{
+    Record &record = recordAt(row, column);
+    const int pooled = record.kind == TextValue ? record.text : -1;
+
+    //Keep the slot of a replaced Cell object for cellOf()
+    if (record.cell >= 0)
+        m_cells[record.cell].reset();
+
+    record.type = quint8(type);
+    record.xfIndex = xfIndex;
+    record.styleNumber = styleNumber;
+
+    if (value.userType() == QMetaType::QString) {
+        record.kind = TextValue;
+        if (pooled >= 0) {
+            m_strings[pooled] = value.toString();
+            record.text = pooled;
+        } else {
+            record.text = m_strings.size();
+            m_strings.append(value.toString());
+        }
+        return;
+    }
+
+    if (pooled >= 0)
+        m_strings[pooled].clear();
+
+    if (!value.isValid()) {
+        record.kind = NoValue;
+        record.number = 0.0;
+    } else if (value.userType() == QMetaType::Bool) {
+        record.kind = BoolValue;
+        record.number = value.toBool() ? 1.0 : 0.0;
+    } else {
+        record.kind = NumberValue;
+        record.number = value.toDouble();
+    }
+}
+
+void CellTable::insert(int row, int column, const QSharedPointer<Cell> &cell)
+{
+    Record &record = recordAt(row, column);
+    if (record.kind == TextValue)
+        m_strings[record.text].clear();
+
+    record.type = quint8(cell->cellType());
+    record.xfIndex = -1;
+    record.styleNumber = -1;
+    record.kind = NoValue;
+    record.number = 0.0;
+
+    if (record.cell >= 0) {
+        m_cells[record.cell] = cell;
+    } else {
+        record.cell = m_cells.size();
+        m_cells.append(cell);
+    }
+}
+
+/*!
+ * \internal
+ * Returns the Cell object of \a record, or null for a plain record.
+ */
+Cell *CellTable::cell(const Record &record) const
+{
+    if (record.cell < 0)
+        return nullptr;
+
+    return m_cells.at(record.cell).data();
+}
+
+/*!
+ * \internal
+ * Returns the plain value of \a record as the writer passed it in.
+ */
+QVariant CellTable::value(const Record &record) const
+{
+    switch (record.kind) {
+    case NumberValue:
+        return record.number;
+    case BoolValue:
+        return record.number != 0.0;
+    case TextValue:
+        return m_strings.at(record.text);
+    default:
+        return QVariant();
+    }
+}
+
+Cell::CellType CellTable::cellType(const Record &record) const
+{
+    const Cell *object = cell(record);
+    return object ? object->cellType() : record.plainType();
+}
+
+QVariant CellTable::cellValue(const Record &record) const
+{
+    const Cell *object = cell(record);
+    return object ? object->value() : value(record);
+}
+
+qint32 CellTable::cellXfIndex(const Record &record) const
+{
+    const Cell *object = cell(record);
+    return object ? xfIndexOf(object->format()) : record.xfIndex;
+}
+
+Format CellTable::cellFormat(const Record &record, Styles *styles) const
+{
+    const Cell *object = cell(record);
+    return object ? object->format() : styles->xfFormat(record.xfIndex);
+}
+
+/*!
+ * \internal
+ * Returns the Cell object of \a record, creating it the first time.
+ */
+QSharedPointer<Cell> CellTable::cellOf(const Record &record, Worksheet *sheet) const
+{
+    if (cell(record))
+        return m_cells.at(record.cell);
+
+    const Format format = sheet->workbook()->styles()->xfFormat(record.xfIndex);
+    QSharedPointer<Cell> created(new Cell(value(record), record.plainType(), format, sheet, record.styleNumber));
+
+    if (record.cell >= 0) {
+        m_cells[record.cell] = created;
+    } else {
+        record.cell = m_cells.size();
+        m_cells.append(created);
+    }
+
+    return created;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -156,7 +156,7 @@ namespace xlsxDocumentCpp {
 
 DocumentPrivate::DocumentPrivate(Document *p) :
 	q_ptr(p), defaultPackageName(QStringLiteral("Book1.xlsx")),
-	isLoad(false)
+	isLoad(false), compressionLevel(-1), concurrentCompression(true)
 {
 }
 
@@ -327,6 +327,9 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
 	if (zipWriter.error())
 		return false;
 
+	zipWriter.setCompressionLevel(compressionLevel);
+	zipWriter.setConcurrent(concurrentCompression);
+
 	contentTypes->clearOverrides();
 
 	DocPropsApp docPropsApp(DocPropsApp::F_NewFromScratch);
@@ -343,7 +346,17 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i+1));
 		docPropsApp.addPartTitle(sheet->sheetName());
 
-        zipWriter.addFile(QStringLiteral("xl/worksheets/sheet%1.xml").arg(i+1), sheet->saveToXmlData());
+        const QString sheetPath = QStringLiteral("xl/worksheets/sheet%1.xml").arg(i+1);
+        if (static_cast<Worksheet *>(sheet.data())->isStreaming())
+        {
+            // appended rows can be any number, write them straight into the
+            // archive instead of collecting the whole sheet in memory first
+            if (QIODevice *entry = zipWriter.beginFile(sheetPath))
+                sheet->saveToXmlFile(entry);
+            zipWriter.endFile();
+        }
+        else
+            zipWriter.addFile(sheetPath, sheet->saveToXmlData());
 
 		Relationships *rel = sheet->relationships();
 		if (!rel->isEmpty())
@@ -452,7 +465,7 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
 	zipWriter.addFile(QStringLiteral("[Content_Types].xml"), contentTypes->saveToXmlData());
 
 	zipWriter.close();
-	return true;
+	return !zipWriter.error();
 }
 
 bool DocumentPrivate::copyStyle(const QString &from, const QString &to)
@@ -1250,6 +1263,41 @@ bool Document::saveAs(QIODevice *device) const
 	return d->savePackage(device);
 }
 
+/*!
+ * Sets the zlib compression \a level (1 to 9) used for the parts of the
+ * package when it is saved. Level 0 stores the parts uncompressed, which
+ * is the fastest way to save at the cost of a larger file, and -1 (the
+ * default) selects the zlib default level.
+ */
+void Document::setCompressionLevel(int level)
+{
+	Q_D(Document);
+	d->compressionLevel = qBound(-1, level, 9);
+}
+
+int Document::compressionLevel() const
+{
+	Q_D(const Document);
+	return d->compressionLevel;
+}
+
+/*!
+ * When \a enable is true (the default) the parts of the package are
+ * compressed concurrently on the global thread pool while saving. They
+ * are still written to the package in the same order.
+ */
+void Document::setConcurrentCompression(bool enable)
+{
+	Q_D(Document);
+	d->concurrentCompression = enable;
+}
+
+bool Document::concurrentCompression() const
+{
+	Q_D(const Document);
+	return d->concurrentCompression;
+}
+
 bool Document::isLoadPackage() const
 {
 	Q_D(const Document);
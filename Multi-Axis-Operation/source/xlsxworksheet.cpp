@@ -58,6 +58,9 @@ WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
 {
 	previous_row = 0;
 
+	streamFirstRow = 0;
+	streamLastRow = 0;
+
 	outline_row_level = 0;
 	outline_col_level = 0;
 
@@ -78,50 +81,60 @@ WorksheetPrivate::~WorksheetPrivate()
 void WorksheetPrivate::calculateSpans() const
 {
 	row_spans.clear();
+	const int lastRow = lastCellTableRow();
+	const int firstColumn = dimension.firstColumn();
+	const int lastColumn = dimension.lastColumn();
+
+	//Widen the span of the block holding row_num to the given columns
+	auto addColumns = [this](int row_num, int span_min, int span_max) {
+		const int span_index = (row_num - 1) / 16;
+		auto it = row_spans.find(span_index);
+		if (it == row_spans.end()) {
+			row_spans.insert(span_index, QStringLiteral("%1:%2").arg(span_min).arg(span_max));
+			return;
+		}
+		const int colon = it->indexOf(QLatin1Char(':'));
+		span_min = qMin(span_min, it->left(colon).toInt());
+		span_max = qMax(span_max, it->mid(colon + 1).toInt());
+		*it = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
+	};
+
+	const QVector<CellTable::Row> &rows = cellTable.rows();
+	int span_index = -1;
 	int span_min = XLSX_COLUMN_MAX+1;
 	int span_max = -1;
+	for (int i = cellTable.rowIndex(dimension.firstRow()); i < rows.size() && rows[i].row <= lastRow; ++i) {
+		const QVector<CellTable::Record> &cells = rows[i].cells;
+		int first = 0;
+		int last = cells.size() - 1;
+		while (first <= last && cells[first].column < firstColumn)
+			++first;
+		while (last >= first && cells[last].column > lastColumn)
+			--last;
+		if (first > last)
+			continue;
 
-	for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        auto it = cellTable.constFind(row_num);
-        if (it != cellTable.constEnd()) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-                if (it->contains(col_num)) {
-					if (span_max == -1) {
-						span_min = col_num;
-						span_max = col_num;
-					} else {
-						if (col_num < span_min)
-							span_min = col_num;
-						else if (col_num > span_max)
-							span_max = col_num;
-					}
-				}
-			}
-		}
-        auto cIt = comments.constFind(row_num);
-        if (cIt != comments.constEnd()) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-                if (cIt->contains(col_num)) {
-					if (span_max == -1) {
-						span_min = col_num;
-						span_max = col_num;
-					} else {
-						if (col_num < span_min)
-							span_min = col_num;
-						else if (col_num > span_max)
-							span_max = col_num;
-					}
-				}
-			}
+		//Rows are in order, so a block is complete once the next one starts
+		if ((rows[i].row - 1) / 16 != span_index) {
+			if (span_max != -1)
+				addColumns(span_index * 16 + 1, span_min, span_max);
+			span_index = (rows[i].row - 1) / 16;
+			span_min = XLSX_COLUMN_MAX+1;
+			span_max = -1;
 		}
+		span_min = qMin(span_min, cells[first].column);
+		span_max = qMax(span_max, cells[last].column);
+	}
+	if (span_max != -1)
+		addColumns(span_index * 16 + 1, span_min, span_max);
 
-		if (row_num%16 == 0 || row_num == dimension.lastRow()) {
-			if (span_max != -1) {
-                row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-				span_min = XLSX_COLUMN_MAX+1;
-				span_max = -1;
-			}
-		}
+	for (auto cIt = comments.lowerBound(dimension.firstRow()); cIt != comments.constEnd() && cIt.key() <= lastRow; ++cIt) {
+		auto first = cIt->lowerBound(firstColumn);
+		auto last = cIt->upperBound(lastColumn);
+		if (first == last)
+			continue;
+		--last;
+		addColumns(cIt.key(), first.key(), last.key());
 	}
 }
 
@@ -134,6 +147,17 @@ QString WorksheetPrivate::generateDimensionString() const
 		return dimension.toString();
 }
 
+/*
+  Last row held in the cell table. Rows from streamFirstRow on were
+  appended with Worksheet::appendRow() and only exist in the stream.
+ */
+int WorksheetPrivate::lastCellTableRow() const
+{
+	if (streamWriter)
+		return qMin(dimension.lastRow(), streamFirstRow - 1);
+	return dimension.lastRow();
+}
+
 /*
   Check that row and col are valid and store the max and min
   values for use in other methods/elements. The ignore_row /
@@ -191,24 +215,30 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
 
 	sheet_d->dimension = d->dimension;
 
-	QMapIterator<int, QMap<int, QSharedPointer<Cell> > > it(d->cellTable);
-    while (it.hasNext())
+	const QVector<CellTable::Row> &rows = d->cellTable.rows();
+    for (const CellTable::Row &entry : rows)
     {
-		it.next();
-		int row = it.key();
-		QMapIterator<int, QSharedPointer<Cell> > it2(it.value());
-        while (it2.hasNext())
+        for (const CellTable::Record &record : entry.cells)
         {
-			it2.next();
-			int col = it2.key();
+            const Cell *source = d->cellTable.cell(record);
+            if (!source)
+            {
+                //Same workbook, so the style index stays valid
+                const QVariant value = d->cellTable.value(record);
+                if (record.plainType() == Cell::SharedStringType)
+                    d->workbook->sharedStrings()->addSharedString(value.toString());
+
+                sheet_d->cellTable.insert(entry.row, record.column, value, record.plainType(), record.xfIndex, record.styleNumber);
+                continue;
+            }
 
-			QSharedPointer<Cell> cell(new Cell(it2.value().data()));
+			QSharedPointer<Cell> cell(new Cell(source));
 			cell->d_ptr->parent = sheet;
 
 			if (cell->cellType() == Cell::SharedStringType)
 				d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
 
-			sheet_d->cellTable[row][col] = cell;
+			sheet_d->cellTable.insert(entry.row, record.column, cell);
 		}
 	}
 
@@ -537,10 +567,23 @@ QVariant Worksheet::read(int row, int column) const
 {
 	Q_D(const Worksheet);
 
-	Cell *cell = cellAt(row, column);
-	if (!cell)
+	const CellTable::Record *record = d->cellTable.find(row, column);
+	if (!record)
 		return QVariant();
 
+	Cell *cell = d->cellTable.cell(*record);
+    if (!cell)
+    {
+        //Plain value, read it through a temporary cell rather than keeping one
+        const QVariant value = d->cellTable.value(*record);
+        if (record->xfIndex < 0)
+            return value;
+        Cell temp(value, record->plainType(), d->workbook->styles()->xfFormat(record->xfIndex), const_cast<Worksheet *>(this), record->styleNumber);
+        if (temp.isDateTime())
+            return temp.dateTime();
+        return value;
+    }
+
     if (cell->hasFormula())
     {
         if (cell->formula().formulaType() == CellFormula::NormalType)
@@ -593,23 +636,19 @@ Cell *Worksheet::cellAt(const CellReference &row_column) const
 Cell *Worksheet::cellAt(int row, int col) const
 {
 	Q_D(const Worksheet);
-    auto it = d->cellTable.constFind(row);
-    if (it == d->cellTable.constEnd())
-		return 0;
-    if (!it->contains(col))
+    const CellTable::Record *record = d->cellTable.find(row, col);
+    if (!record)
 		return 0;
 
-    return (*it)[col].data();
+    return d->cellTable.cellOf(*record, const_cast<Worksheet *>(this)).data();
 }
 
 Format WorksheetPrivate::cellFormat(int row, int col) const
 {
-    auto it = cellTable.constFind(row);
-    if (it == cellTable.constEnd())
+    const CellTable::Record *record = cellTable.find(row, col);
+    if (!record)
 		return Format();
-    if (!it->contains(col))
-		return Format();
-    return (*it)[col]->format();
+    return cellTable.cellFormat(*record, workbook->styles());
 }
 
 /*!
@@ -647,9 +686,15 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
 	if (value.fragmentCount() == 1 && value.fragmentFormat(0).isValid())
 		fmt.mergeFormat(value.fragmentFormat(0));
 	d->workbook->styles()->addXfFormat(fmt);
+    if (!value.isRichString())
+    {
+        //Plain text needs no Cell object of its own
+        d->cellTable.insert(row, column, value.toPlainString(), Cell::SharedStringType, CellTable::xfIndexOf(fmt));
+        return true;
+    }
 	QSharedPointer<Cell> cell = QSharedPointer<Cell>(new Cell(value.toPlainString(), Cell::SharedStringType, fmt, this));
 	cell->d_ptr->richString = value;
-	d->cellTable[row][column] = cell;
+	d->cellTable.insert(row, column, cell);
 	return true;
 }
 
@@ -717,7 +762,7 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::InlineStringType, fmt, this));
+	d->cellTable.insert(row, column, value, Cell::InlineStringType, CellTable::xfIndexOf(fmt));
 	return true;
 }
 
@@ -746,7 +791,7 @@ bool Worksheet::writeNumeric(int row, int column, double value, const Format &fo
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+	d->cellTable.insert(row, column, value, Cell::NumberType, CellTable::xfIndexOf(fmt));
 	return true;
 }
 
@@ -794,7 +839,7 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
 
 	QSharedPointer<Cell> data = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
 	data->d_ptr->formula = formula;
-	d->cellTable[row][column] = data;
+	d->cellTable.insert(row, column, data);
 
 	CellRange range = formula.reference();
 	if (formula.formulaType() == CellFormula::SharedType) {
@@ -808,7 +853,7 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
 					} else {
 						QSharedPointer<Cell> newCell = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
 						newCell->d_ptr->formula = sf;
-						d->cellTable[r][c] = newCell;
+						d->cellTable.insert(r, c, newCell);
 					}
 				}
 			}
@@ -847,7 +892,7 @@ bool Worksheet::writeBlank(int row, int column, const Format &format)
 	d->workbook->styles()->addXfFormat(fmt);
 
 	//Note: NumberType with an invalid QVariant value means blank.
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(QVariant(), Cell::NumberType, fmt, this));
+	d->cellTable.insert(row, column, QVariant(), Cell::NumberType, CellTable::xfIndexOf(fmt));
 
 	return true;
 }
@@ -876,7 +921,7 @@ bool Worksheet::writeBool(int row, int column, bool value, const Format &format)
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::BooleanType, fmt, this));
+	d->cellTable.insert(row, column, value, Cell::BooleanType, CellTable::xfIndexOf(fmt));
 
 	return true;
 }
@@ -910,7 +955,7 @@ bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Fo
 
 	double value = datetimeToNumber(dt, d->workbook->isDate1904());
 
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+	d->cellTable.insert(row, column, value, Cell::NumberType, CellTable::xfIndexOf(fmt));
 
 	return true;
 }
@@ -940,7 +985,7 @@ bool Worksheet::writeDate(int row, int column, const QDate &dt, const Format &fo
 
     double value = datetimeToNumber(QDateTime(dt, QTime(0,0,0)), d->workbook->isDate1904());
 
-    d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+    d->cellTable.insert(row, column, value, Cell::NumberType, CellTable::xfIndexOf(fmt));
 
     return true;
 }
@@ -973,7 +1018,7 @@ bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &for
 		fmt.setNumberFormat(QStringLiteral("hh:mm:ss"));
 	d->workbook->styles()->addXfFormat(fmt);
 
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(timeToNumber(t), Cell::NumberType, fmt, this));
+	d->cellTable.insert(row, column, timeToNumber(t), Cell::NumberType, CellTable::xfIndexOf(fmt));
 
 	return true;
 }
@@ -1039,7 +1084,7 @@ bool Worksheet::writeHyperlink(int row, int column, const QUrl &url, const Forma
 
 	//Write the hyperlink string as normal string.
 	d->sharedStrings()->addSharedString(displayString);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(displayString, Cell::SharedStringType, fmt, this));
+	d->cellTable.insert(row, column, displayString, Cell::SharedStringType, CellTable::xfIndexOf(fmt));
 
 	//Store the hyperlink data in a separate table
 	d->urlTable[row][column] = QSharedPointer<XlsxHyperlinkData>(new XlsxHyperlinkData(XlsxHyperlinkData::External, urlString, locationString, QString(), tip));
@@ -1047,6 +1092,62 @@ bool Worksheet::writeHyperlink(int row, int column, const QUrl &url, const Forma
 	return true;
 }
 
+/*!
+ * Append a row holding \a values, one per column starting at column A,
+ * below every row written so far. \a formats gives the format of each
+ * cell, missing entries leave the cell unformatted. Numbers and booleans
+ * are written as such, null values as blank cells and anything else as
+ * inline strings.
+ *
+ * Unlike write(), the row is serialized immediately instead of being kept
+ * in the cell table, so memory use does not grow with the number of rows.
+ * Appended rows cannot be read back or modified, and cells written with
+ * write() afterwards must lie above the first appended row.
+ * Returns true on success.
+ */
+bool Worksheet::appendRow(const QList<QVariant> &values, const QList<Format> &formats)
+{
+	Q_D(Worksheet);
+
+	if (values.size() > XLSX_COLUMN_MAX)
+		return false;
+
+	if (!d->streamWriter)
+	{
+		QScopedPointer<QTemporaryFile> file(new QTemporaryFile);
+		if (!file->open())
+			return false;
+
+		d->streamWriter.reset(new QXmlStreamWriter(file.data()));
+		d->streamFile.swap(file);
+		d->streamFirstRow = qMax(d->dimension.lastRow(), 0) + 1;
+		d->streamLastRow = d->streamFirstRow - 1;
+	}
+
+	const int row = d->streamLastRow + 1;
+	if (d->checkDimensions(row, qMax(values.size(), 1)) || d->checkDimensions(row, 1))
+		return false;
+
+	QXmlStreamWriter &writer = *d->streamWriter;
+	writer.writeStartElement(QStringLiteral("row"));
+	writer.writeAttribute(QStringLiteral("r"), QString::number(row));
+	for (int i = 0; i < values.size(); ++i)
+		d->saveXmlStreamedCell(writer, row, i + 1, values[i], i < formats.size() ? formats[i] : Format());
+	writer.writeEndElement(); //row
+
+	d->streamLastRow = row;
+	return !writer.hasError();
+}
+
+/*!
+ * Returns true once rows have been added to the sheet with appendRow().
+ */
+bool Worksheet::isStreaming() const
+{
+	Q_D(const Worksheet);
+	return !d->streamWriter.isNull();
+}
+
 /*!
  * Add one DataValidation \a validation to the sheet.
  * Returns true on success.
@@ -1399,6 +1500,8 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
 	writer.writeStartElement(QStringLiteral("sheetData"));
 	if (d->dimension.isValid())
 		d->saveXmlSheetData(writer);
+	if (d->streamWriter)
+		d->saveXmlStreamedRows(writer, device);
 	writer.writeEndElement();//sheetData
 
 	d->saveXmlMergeCells(writer);
@@ -1530,15 +1633,35 @@ bool Worksheet::setStartPage(int spagen)
 void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 {
 	calculateSpans();
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++)
+	const int lastRow = lastCellTableRow();
+
+	//Only rows with cell data / comments / formatting are written, visit
+	//them in order by walking the three tables side by side
+	const QVector<CellTable::Row> &rows = cellTable.rows();
+	int rowIndex = cellTable.rowIndex(dimension.firstRow());
+	auto riIt = rowsInfo.lowerBound(dimension.firstRow());
+	auto cmIt = comments.lowerBound(dimension.firstRow());
+
+    for (;;)
     {
-        auto ctIt = cellTable.constFind(row_num);
-        auto riIt = rowsInfo.constFind(row_num);
-        if (ctIt == cellTable.constEnd() && riIt == rowsInfo.constEnd() && !comments.contains(row_num))
-        {
-			//Only process rows with cell data / comments / formatting
-			continue;
-		}
+		int row_num = lastRow + 1;
+		if (rowIndex < rows.size())
+			row_num = qMin(row_num, rows[rowIndex].row);
+		if (riIt != rowsInfo.constEnd())
+			row_num = qMin(row_num, riIt.key());
+		if (cmIt != comments.constEnd())
+			row_num = qMin(row_num, cmIt.key());
+		if (row_num > lastRow)
+			break;
+
+		const CellTable::Row *cells = nullptr;
+		if (rowIndex < rows.size() && rows[rowIndex].row == row_num)
+			cells = &rows[rowIndex++];
+		QSharedPointer<XlsxRowInfo> rowInfo;
+		if (riIt != rowsInfo.constEnd() && riIt.key() == row_num)
+			rowInfo = *riIt++;
+		if (cmIt != comments.constEnd() && cmIt.key() == row_num)
+			++cmIt;
 
 		int span_index = (row_num-1) / 16;
 		QString span;
@@ -1552,9 +1675,8 @@ void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 		if (!span.isEmpty())
 			writer.writeAttribute(QStringLiteral("spans"), span);
 
-        if (riIt != rowsInfo.constEnd())
+        if (rowInfo)
         {
-            QSharedPointer<XlsxRowInfo> rowInfo = riIt.value();
             if (!rowInfo->format.isEmpty())
             {
 				writer.writeAttribute(QStringLiteral("s"), QString::number(rowInfo->format.xfIndex()));
@@ -1579,13 +1701,13 @@ void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 		}
 
 		//Write cell data if row contains filled cells
-        if (ctIt != cellTable.constEnd())
+        if (cells)
         {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++)
+            for (const CellTable::Record &record : cells->cells)
             {
-                if (ctIt->contains(col_num))
+                if (record.column >= dimension.firstColumn() && record.column <= dimension.lastColumn())
                 {
-                    saveXmlCellData(writer, row_num, col_num, (*ctIt)[col_num]);
+                    saveXmlCellData(writer, row_num, record.column, record);
 				}
 			}
 		}
@@ -1593,13 +1715,94 @@ void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 	}
 }
 
-void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int col, QSharedPointer<Cell> cell) const
+void WorksheetPrivate::saveXmlStreamedCell(QXmlStreamWriter &writer, int row, int col, const QVariant &value, Format format)
+{
+	if (value.isNull() && format.isEmpty())
+		return;
+
+	writer.writeStartElement(QStringLiteral("c"));
+	writer.writeAttribute(QStringLiteral("r"), CellReference(row, col).toString());
+
+	if (!format.isEmpty())
+	{
+		workbook->styles()->addXfFormat(format);
+		writer.writeAttribute(QStringLiteral("s"), QString::number(format.xfIndex()));
+	}
+
+	const int type = value.userType();
+	if (value.isNull())
+	{
+		//Blank cell, only carries the style
+	}
+	else if (type == QMetaType::Int || type == QMetaType::UInt
+			 || type == QMetaType::LongLong || type == QMetaType::ULongLong
+			 || type == QMetaType::Double || type == QMetaType::Float)
+	{
+		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("n"));
+		writer.writeTextElement(QStringLiteral("v"), QString::number(value.toDouble(), 'g', 15));
+	}
+	else if (type == QMetaType::Bool)
+	{
+		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("b"));
+		writer.writeTextElement(QStringLiteral("v"), value.toBool() ? QStringLiteral("1") : QStringLiteral("0"));
+	}
+	else
+	{
+		//Inline strings keep the shared strings table from growing with the rows
+		const QString string = value.toString();
+		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("inlineStr"));
+		writer.writeStartElement(QStringLiteral("is"));
+		writer.writeStartElement(QStringLiteral("t"));
+		if (isSpaceReserveNeeded(string))
+			writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
+		writer.writeCharacters(string);
+		writer.writeEndElement(); // t
+		writer.writeEndElement(); // is
+	}
+
+	writer.writeEndElement(); // c
+}
+
+void WorksheetPrivate::saveXmlStreamedRows(QXmlStreamWriter &writer, QIODevice *device) const
+{
+	//Finish the pending <sheetData> start tag, then copy the appended rows
+	//into the sheet in chunks exactly as they were serialized.
+	writer.writeCharacters(QString());
+
+	streamFile->flush();
+	const qint64 end = streamFile->pos();
+	if (!streamFile->seek(0))
+		return;
+
+	QByteArray buffer(64 * 1024, Qt::Uninitialized);
+	qint64 remaining = end;
+	while (remaining > 0)
+	{
+		const qint64 count = streamFile->read(buffer.data(), qMin<qint64>(buffer.size(), remaining));
+		if (count <= 0 || device->write(buffer.constData(), count) != count)
+			break;
+		remaining -= count;
+	}
+
+	//More rows may still be appended after saving
+	streamFile->seek(end);
+}
+
+void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int col, const CellTable::Record &record) const
 {
     Q_Q(const Worksheet);
 
 	//This is the innermost loop so efficiency is important.
 	QString cell_pos = CellReference(row, col).toString();
 
+	//Plain records have no Cell object, formulas and rich text always do
+	const Cell *cell = cellTable.cell(record);
+	const qint32 xfIndex = cellTable.cellXfIndex(record);
+	const Cell::CellType cellType = cellTable.cellType(record);
+	const QVariant cellValue = cellTable.cellValue(record);
+	const bool hasFormula = cell && cell->hasFormula();
+	const bool isRichString = cell && cell->isRichString();
+
 	writer.writeStartElement(QStringLiteral("c"));
 	writer.writeAttribute(QStringLiteral("r"), cell_pos);
 
@@ -1607,29 +1810,29 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
     QMap<int, QSharedPointer<XlsxColumnInfo> >::ConstIterator cIt;
 
 	//Style used by the cell, row or col
-	if (!cell->format().isEmpty())
-		writer.writeAttribute(QStringLiteral("s"), QString::number(cell->format().xfIndex()));
+	if (xfIndex >= 0)
+		writer.writeAttribute(QStringLiteral("s"), QString::number(xfIndex));
     else if ((rIt = rowsInfo.constFind(row)) != rowsInfo.constEnd() && !(*rIt)->format.isEmpty())
         writer.writeAttribute(QStringLiteral("s"), QString::number((*rIt)->format.xfIndex()));
     else if ((cIt = colsInfoHelper.constFind(col)) != colsInfoHelper.constEnd() && !(*cIt)->format.isEmpty())
         writer.writeAttribute(QStringLiteral("s"), QString::number((*cIt)->format.xfIndex()));
 
-    if (cell->cellType() == Cell::SharedStringType) // 's'
+    if (cellType == Cell::SharedStringType) // 's'
     {
 		int sst_idx;
-		if (cell->isRichString())
+		if (isRichString)
 			sst_idx = sharedStrings()->getSharedStringIndex(cell->d_ptr->richString);
 		else
-			sst_idx = sharedStrings()->getSharedStringIndex(cell->value().toString());
+			sst_idx = sharedStrings()->getSharedStringIndex(cellValue.toString());
 
 		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("s"));
 		writer.writeTextElement(QStringLiteral("v"), QString::number(sst_idx));
     }
-    else if (cell->cellType() == Cell::InlineStringType) // 'inlineStr'
+    else if (cellType == Cell::InlineStringType) // 'inlineStr'
     {
 		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("inlineStr"));
 		writer.writeStartElement(QStringLiteral("is"));
-        if (cell->isRichString())
+        if (isRichString)
         {
 			//Rich text string
 			RichString string = cell->d_ptr->richString;
@@ -1653,7 +1856,7 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
         else
         {
 			writer.writeStartElement(QStringLiteral("t"));
-			QString string = cell->value().toString();
+			QString string = cellValue.toString();
 			if (isSpaceReserveNeeded(string))
 				writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
 			writer.writeCharacters(string);
@@ -1661,51 +1864,51 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
 		}
 		writer.writeEndElement();//is
     }
-    else if (cell->cellType() == Cell::NumberType) // 'n'
+    else if (cellType == Cell::NumberType) // 'n'
     {
         writer.writeAttribute(QStringLiteral("t"), QStringLiteral("n")); // dev67
 
-        if (cell->hasFormula())
+        if (hasFormula)
         {
             QString strFormula = cell->formula().d->formula;
             Q_UNUSED(strFormula);
             cell->formula().saveToXml(writer);
         }
 
-        if (cell->value().isValid())
+        if (cellValue.isValid())
         {   //note that, invalid value means 'v' is blank
-			double value = cell->value().toDouble();
+			double value = cellValue.toDouble();
 			writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
 		}
     }
-    else if (cell->cellType() == Cell::StringType) // 'str'
+    else if (cellType == Cell::StringType) // 'str'
     {
 		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("str"));
-		if (cell->hasFormula())
+		if (hasFormula)
 			cell->formula().saveToXml(writer);
 
-		writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
+		writer.writeTextElement(QStringLiteral("v"), cellValue.toString());
     }
-    else if (cell->cellType() == Cell::BooleanType) // 'b'
+    else if (cellType == Cell::BooleanType) // 'b'
     {
 		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("b"));
 
         // dev34
 
-        if (cell->hasFormula())
+        if (hasFormula)
         {
             QString strFormula = cell->formula().d->formula;
             Q_UNUSED(strFormula);
             cell->formula().saveToXml(writer);
         }
 
-		writer.writeTextElement(QStringLiteral("v"), cell->value().toBool() ? QStringLiteral("1") : QStringLiteral("0"));
+		writer.writeTextElement(QStringLiteral("v"), cellValue.toBool() ? QStringLiteral("1") : QStringLiteral("0"));
 	}
-    else if (cell->cellType() == Cell::DateType) // 'd'
+    else if (cellType == Cell::DateType) // 'd'
     {
         // dev67
 
-         double num = cell->value().toDouble();
+         double num = cellValue.toDouble();
          bool is1904 = q->workbook()->isDate1904();
          if (!is1904 && num > 60) // for mac os excel
          {
@@ -1714,28 +1917,28 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
 
          // number type. see for 18.18.11 ST_CellType (Cell Type) more information.
          writer.writeAttribute(QStringLiteral("t"), QStringLiteral("n"));
-         writer.writeTextElement(QStringLiteral("v"), cell->value().toString() );
+         writer.writeTextElement(QStringLiteral("v"), cellValue.toString() );
 
     }
-    else if (cell->cellType() == Cell::ErrorType) // 'e'
+    else if (cellType == Cell::ErrorType) // 'e'
     {
         writer.writeAttribute(QStringLiteral("t"), QStringLiteral("e"));
-        writer.writeTextElement(QStringLiteral("v"), cell->value().toString() );
+        writer.writeTextElement(QStringLiteral("v"), cellValue.toString() );
     }
-    else // if (cell->cellType() == Cell::CustomType)
+    else // if (cellType == Cell::CustomType)
     {
         // custom type
 
-        if (cell->hasFormula())
+        if (hasFormula)
         {
             QString strFormula = cell->formula().d->formula;
             Q_UNUSED(strFormula);
             cell->formula().saveToXml(writer);
         }
 
-        if (cell->value().isValid())
+        if (cellValue.isValid())
         {   //note that, invalid value means 'v' is blank
-            double value = cell->value().toDouble();
+            double value = cellValue.toDouble();
             writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
         }
     }
@@ -2448,15 +2651,22 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 					}
 				}
 
-                // [dev54] temp cell for checking datetype
-                Cell tempCell(QVariant(), cellType, format, q, styleIndex);
-                if ( tempCell.isDateTime() )
+                // [dev54] check for datetype, as Cell::isDateTime() would for
+                // a cell without a value, without allocating a temp cell
+                if ( (cellType == Cell::NumberType ||
+                      cellType == Cell::DateType ||
+                      cellType == Cell::CustomType) &&
+                     format.isValid() &&
+                     format.isDateTimeFormat() )
                 {
                     cellType = Cell::DateType;
                 }
 
-				// create a heap of new cell
-				QSharedPointer<Cell> cell(new Cell(QVariant(), cellType, format, q, styleIndex));
+				// plain values go straight into the cell table, a heap cell is
+				// only created for formulas and rich text
+				QVariant cellValue;
+				CellFormula cellFormula;
+				QVariant richString;
 
                 while (!reader.atEnd() &&
                        !(reader.name() == QLatin1String("c") &&
@@ -2466,7 +2676,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 					{
                         if (reader.name() == QLatin1String("f")) // formula
 						{
-							CellFormula &formula = cell->d_func()->formula;
+							CellFormula &formula = cellFormula;
 							formula.loadFromXml(reader);
                             if (formula.formulaType() == CellFormula::SharedType &&
                                     !formula.formulaText().isEmpty())
@@ -2484,17 +2694,17 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 								sharedStrings()->incRefByStringIndex(sst_idx);
 								RichString rs = sharedStrings()->getSharedString(sst_idx);
 								QString strPlainString = rs.toPlainString();
-								cell->d_func()->value = strPlainString; 
+								cellValue = strPlainString; 
 								if (rs.isRichString())
-									cell->d_func()->richString = rs;
+									richString = QVariant::fromValue(rs);
 							} 
 							else if (cellType == Cell::NumberType) 
 							{
-								cell->d_func()->value = value.toDouble();
+								cellValue = value.toDouble();
 							} 
 							else if (cellType == Cell::BooleanType) 
 							{
-								cell->d_func()->value = value.toInt() ? true : false;
+								cellValue = value.toInt() ? true : false;
 							} 
                             else  if (cellType == Cell::DateType)
                             {
@@ -2505,13 +2715,13 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 
                                 QVariant vDatetimeValue = datetimeFromNumber( dValue, bIsDate1904 );
                                 Q_UNUSED(vDatetimeValue);
-                                // cell->d_func()->value = vDatetimeValue;
-                                cell->d_func()->value = dValue; // dev67
+                                // cellValue = vDatetimeValue;
+                                cellValue = dValue; // dev67
                             }
 							else 
                             {
                                 // ELSE type
-								cell->d_func()->value = value;
+								cellValue = value;
 							} 
 
                         }
@@ -2526,7 +2736,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 									//:Todo, add rich text read support
                                     if (reader.name() == QLatin1String("t"))
                                     {
-										cell->d_func()->value = reader.readElementText();
+										cellValue = reader.readElementText();
 									}
 								}
 							}
@@ -2544,7 +2754,18 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 					}
 				}
 
-                cellTable[ pos.row() ][ pos.column() ] = cell;
+                if (!cellFormula.isValid() && !richString.isValid())
+                {
+                    cellTable.insert(pos.row(), pos.column(), cellValue, cellType, CellTable::xfIndexOf(format), styleIndex);
+                }
+                else
+                {
+                    QSharedPointer<Cell> cell(new Cell(cellValue, cellType, format, q, styleIndex));
+                    cell->d_func()->formula = cellFormula;
+                    if (richString.isValid())
+                        cell->d_func()->richString = richString.value<RichString>();
+                    cellTable.insert(pos.row(), pos.column(), cell);
+                }
 
 			}
 		}
@@ -2983,25 +3204,24 @@ void WorksheetPrivate::validateDimension()
 	if (dimension.isValid() || cellTable.isEmpty())
 		return;
 
-	const auto firstRow = cellTable.constBegin().key();
+	const QVector<CellTable::Row> &rows = cellTable.rows();
+	const auto firstRow = rows.first().row;
 
-    const auto lastRow = (--cellTable.constEnd()).key();
+    const auto lastRow = rows.last().row;
 
 	int firstColumn = -1;
 	int lastColumn = -1;
 
-    for ( auto&& it = cellTable.constBegin()
-            ; it != cellTable.constEnd()
-            ; ++it )
+    for (const CellTable::Row &entry : rows)
     {
-        Q_ASSERT(!it.value().isEmpty());
+        Q_ASSERT(!entry.cells.isEmpty());
 
-        if (firstColumn == -1 || it.value().constBegin().key() < firstColumn)
-            firstColumn = it.value().constBegin().key();
+        if (firstColumn == -1 || entry.cells.first().column < firstColumn)
+            firstColumn = entry.cells.first().column;
 
-        if (lastColumn == -1 || (--it.value().constEnd()).key() > lastColumn)
+        if (lastColumn == -1 || entry.cells.last().column > lastColumn)
         {
-            lastColumn = (--it.value().constEnd()).key();
+            lastColumn = entry.cells.last().column;
         }
 
     }
@@ -3048,21 +3268,18 @@ QVector<CellLocation> Worksheet::getFullCells(int* maxRow, int* maxCol)
         return ret;
     }
 
-    QMapIterator< int, QMap< int, QSharedPointer<Cell> > > _it( d->cellTable );
+    const QVector<CellTable::Row> &rows = d->cellTable.rows();
 
-    while ( _it.hasNext() )
+    for ( const CellTable::Row &entry : rows )
     {
-        _it.next();
-
-        int keyI = _it.key(); // key (cell row)
-        QMapIterator<int, QSharedPointer<Cell> > _iit( _it.value() ); // value
+        int keyI = entry.row; // cell row
 
-        while ( _iit.hasNext() )
+        for ( const CellTable::Record &record : entry.cells )
         {
-            _iit.next();
+            int keyII = record.column; // cell column
 
-            int keyII = _iit.key(); // key (cell column)
-            QSharedPointer<Cell> ptrCell = _iit.value(); // value
+            // callers get Cell objects, create them for plain records
+            QSharedPointer<Cell> ptrCell = d->cellTable.cellOf( record, this );
 
             CellLocation cl;
 
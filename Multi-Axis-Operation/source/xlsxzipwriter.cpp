@@ -3,46 +3,515 @@
 #include "xlsxzipwriter_p.h"
 
 #include <QtGlobal>
+#include <QtEndian>
+#include <QDateTime>
+#include <QFile>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 #include <QDebug>
-#include <private/qzipwriter_p.h>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+namespace {
+
+const quint32 LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const quint32 DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+const quint32 CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const quint32 END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+
+const quint16 ZIP_VERSION = 20;                 // 2.0, needed for deflate
+const quint16 FLAG_DATA_DESCRIPTOR = 0x0008;    // crc and sizes follow the data
+const quint16 METHOD_STORED = 0;
+const quint16 METHOD_DEFLATED = 8;
+
+const qint64 LOCAL_HEADER_CRC_OFFSET = 14;
+const quint64 MAX_ZIP32_SIZE = 0xFFFFFFFFu;
+const int MAX_DEFLATED_STREAM_SIZE = 128 << 20;  // larger streamed entries are stored
+
+void appendUInt16(QByteArray &data, quint16 value)
+{
+    value = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendUInt32(QByteArray &data, quint32 value)
+{
+    value = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+struct Crc32Table
+{
+    quint32 entries[256];
+
+    Crc32Table()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : (crc >> 1);
+            entries[i] = crc;
+        }
+    }
+};
+
+quint32 updateCrc32(quint32 crc, const char *data, qint64 length)
+{
+    static const Crc32Table table;
+
+    crc = ~crc;
+    for (qint64 i = 0; i < length; ++i)
+        crc = table.entries[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Fills in the crc, sizes and method of an entry holding data and returns
+// the bytes to store for it
+QByteArray compressData(const QByteArray &data, int level, quint32 *crc, quint32 *size,
+                        quint32 *compressedSize, quint16 *method)
+{
+    *crc = updateCrc32(0, data.constData(), data.size());
+    *size = quint32(data.size());
+
+    // qCompress() prefixes the length and wraps the deflate data in a zlib
+    // header and checksum, strip those to get the raw stream zip expects
+    QByteArray compressed;
+    if (!data.isEmpty() && level != 0) {
+        compressed = qCompress(data, level);
+        if (compressed.size() > 10)
+            compressed = compressed.mid(6, compressed.size() - 10);
+        else
+            compressed.clear();
+    }
+
+    if (!compressed.isEmpty() && compressed.size() < data.size()) {
+        *method = METHOD_DEFLATED;
+        *compressedSize = quint32(compressed.size());
+        return compressed;
+    }
+
+    *method = METHOD_STORED;
+    *compressedSize = *size;
+    return data;
+}
+
+} // namespace
+
+/*
+  Deflates one addFile() entry on the thread pool. The semaphore is
+  released once the payload is ready to be written.
+ */
+class ZipWriter::CompressJob : public QRunnable
+{
+public:
+    CompressJob(const QString &filePath, const QByteArray &data, int level)
+        : input(data), level(level)
+    {
+        setAutoDelete(false);
+        entry.name = filePath.toUtf8();
+        entry.flags = 0;
+    }
+
+    void run() override
+    {
+        payload = compressData(input, level, &entry.crc, &entry.size, &entry.compressedSize, &entry.method);
+        input = QByteArray();
+        done.release();
+    }
+
+    QByteArray input;
+    int level;
+    Entry entry;
+    QByteArray payload;
+    QSemaphore done;
+};
+
+/*
+  Write-only device handed out by beginFile(). Data to deflate is collected
+  for endFile(); stored data goes straight to the archive while its CRC-32
+  and size are accumulated for endFile().
+ */
+class ZipWriter::EntryDevice : public QIODevice
+{
+public:
+    EntryDevice(ZipWriter *writer, const QString &filePath, bool deflate)
+        : zip(writer), path(filePath), collecting(deflate), crc(0), size(0)
+    {
+        open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const override { return true; }
+
+    ZipWriter *zip;
+    QString path;
+    bool collecting;        // data is deflated once complete
+    QByteArray collected;
+    quint32 crc;
+    quint64 size;
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+
+    qint64 writeData(const char *data, qint64 length) override
+    {
+        if (zip->m_error)
+            return -1;
+
+        if (collecting) {
+            if (collected.size() + length <= MAX_DEFLATED_STREAM_SIZE) {
+                collected.append(data, int(length));
+                return length;
+            }
+
+            // too large to deflate in one piece, store what has come so far
+            collecting = false;
+            const QByteArray head = collected;
+            collected = QByteArray();
+            if (!zip->beginStoredEntry(path) || !store(head.constData(), head.size()))
+                return -1;
+        }
+
+        return store(data, length) ? length : -1;
+    }
+
+private:
+    bool store(const char *data, qint64 length)
+    {
+        if (zip->m_device->write(data, length) != length) {
+            zip->m_error = true;
+            return false;
+        }
+
+        crc = updateCrc32(crc, data, length);
+        size += length;
+        zip->m_offset += length;
+        return true;
+    }
+};
+
 ZipWriter::ZipWriter(const QString &filePath)
 {
-    m_writer = new QZipWriter(filePath, QIODevice::WriteOnly);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    init();
+    m_device = new QFile(filePath);
+    m_ownsDevice = true;
+    if (!m_device->open(QIODevice::WriteOnly))
+        m_error = true;
 }
 
 ZipWriter::ZipWriter(QIODevice *device)
 {
-    m_writer = new QZipWriter(device);
-    m_writer->setCompressionPolicy(QZipWriter::AutoCompress);
+    init();
+    m_device = device;
+    if (!m_device->isWritable())
+        m_error = true;
 }
 
 ZipWriter::~ZipWriter()
 {
-    delete m_writer;
+    close();
+    if (m_ownsDevice)
+        delete m_device;
+}
+
+void ZipWriter::init()
+{
+    m_device = nullptr;
+    m_ownsDevice = false;
+    m_error = false;
+    m_closed = false;
+    m_offset = 0;
+    m_entryDevice = nullptr;
+    m_level = -1;
+    m_concurrent = false;
+
+    // MS-DOS time stamp shared by every entry
+    const QDateTime now = QDateTime::currentDateTime();
+    m_time = quint16((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+    m_date = quint16(((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day());
+}
+
+void ZipWriter::setCompressionLevel(int level)
+{
+    m_level = qBound(-1, level, 9);
+}
+
+void ZipWriter::setConcurrent(bool enable)
+{
+    if (!enable)
+        writePending(true);
+    m_concurrent = enable;
 }
 
 bool ZipWriter::error() const
 {
-    return m_writer->status() != QZipWriter::NoError;
+    return m_error;
+}
+
+bool ZipWriter::writeRaw(const QByteArray &data)
+{
+    if (m_error)
+        return false;
+
+    if (m_device->write(data) != data.size()) {
+        m_error = true;
+        return false;
+    }
+
+    m_offset += data.size();
+    return true;
+}
+
+void ZipWriter::writeLocalHeader(const Entry &entry)
+{
+    QByteArray header;
+    header.reserve(30 + entry.name.size());
+    appendUInt32(header, LOCAL_HEADER_SIGNATURE);
+    appendUInt16(header, ZIP_VERSION);
+    appendUInt16(header, entry.flags);
+    appendUInt16(header, entry.method);
+    appendUInt16(header, m_time);
+    appendUInt16(header, m_date);
+    appendUInt32(header, entry.crc);
+    appendUInt32(header, entry.compressedSize);
+    appendUInt32(header, entry.size);
+    appendUInt16(header, quint16(entry.name.size()));
+    appendUInt16(header, 0);    // extra field length
+    header.append(entry.name);
+
+    writeRaw(header);
 }
 
 void ZipWriter::addFile(const QString &filePath, QIODevice *device)
 {
-    m_writer->addFile(filePath, device);
+    bool opened = false;
+    if (!device->isOpen()) {
+        if (!device->open(QIODevice::ReadOnly)) {
+            m_error = true;
+            return;
+        }
+        opened = true;
+    }
+
+    addFile(filePath, device->readAll());
+
+    if (opened)
+        device->close();
 }
 
 void ZipWriter::addFile(const QString &filePath, const QByteArray &data)
 {
-    m_writer->addFile(filePath, data);
+    Q_ASSERT(!m_entryDevice);
+    if (m_error || m_closed || m_entryDevice)
+        return;
+
+    if (m_concurrent) {
+        QSharedPointer<CompressJob> job(new CompressJob(filePath, data, m_level));
+        m_pending.append(job);
+        QThreadPool::globalInstance()->start(job.data());
+
+        // write whatever is already done so finished payloads are released
+        writePending(false);
+        return;
+    }
+
+    Entry entry;
+    entry.name = filePath.toUtf8();
+    entry.flags = 0;
+    const QByteArray payload = compressData(data, m_level, &entry.crc, &entry.size, &entry.compressedSize, &entry.method);
+    writeEntry(entry, payload);
+}
+
+void ZipWriter::writeEntry(Entry &entry, const QByteArray &payload)
+{
+    if (m_error)
+        return;
+
+    if (m_offset > MAX_ZIP32_SIZE) {
+        m_error = true;
+        return;
+    }
+
+    entry.offset = quint32(m_offset);
+    writeLocalHeader(entry);
+    writeRaw(payload);
+    m_entries.append(entry);
+}
+
+/*
+  Writes the finished entries at the front of the queue, or every queued
+  entry when \a wait is set. A job that no pool thread has picked up yet is
+  run here instead, so waiting cannot stall when the writer itself runs on
+  the last free pool thread.
+ */
+void ZipWriter::writePending(bool wait)
+{
+    while (!m_pending.isEmpty()) {
+        QSharedPointer<CompressJob> job = m_pending.first();
+        if (!job->done.tryAcquire()) {
+            if (!wait)
+                return;
+            if (QThreadPool::globalInstance()->tryTake(job.data()))
+                job->run();
+            job->done.acquire();
+        }
+
+        m_pending.removeFirst();
+        writeEntry(job->entry, job->payload);
+    }
+}
+
+QIODevice *ZipWriter::beginFile(const QString &filePath)
+{
+    Q_ASSERT(!m_entryDevice);
+    if (m_error || m_closed || m_entryDevice)
+        return nullptr;
+
+    m_entryDevice = new EntryDevice(this, filePath, m_level != 0);
+    if (m_level == 0 && !beginStoredEntry(filePath)) {
+        delete m_entryDevice;
+        m_entryDevice = nullptr;
+        return nullptr;
+    }
+
+    return m_entryDevice;
+}
+
+/*
+  Writes the local header of the streamed entry once it is known to be
+  stored. The entry is left last in m_entries for endFile().
+ */
+bool ZipWriter::beginStoredEntry(const QString &filePath)
+{
+    // queued entries come first in the archive
+    writePending(true);
+    if (m_error)
+        return false;
+
+    if (m_offset > MAX_ZIP32_SIZE) {
+        m_error = true;
+        return false;
+    }
+
+    // crc and sizes are patched into the local header once known, or follow
+    // the data in a descriptor when the device cannot seek back
+    Entry entry;
+    entry.name = filePath.toUtf8();
+    entry.flags = m_device->isSequential() ? FLAG_DATA_DESCRIPTOR : 0;
+    entry.method = METHOD_STORED;
+    entry.crc = 0;
+    entry.compressedSize = 0;
+    entry.size = 0;
+    entry.offset = quint32(m_offset);
+
+    writeLocalHeader(entry);
+    m_entries.append(entry);
+
+    return !m_error;
+}
+
+void ZipWriter::endFile()
+{
+    if (!m_entryDevice)
+        return;
+
+    // collected entries are deflated, on the thread pool in concurrent mode
+    if (m_entryDevice->collecting) {
+        const QString filePath = m_entryDevice->path;
+        const QByteArray data = m_entryDevice->collected;
+        delete m_entryDevice;
+        m_entryDevice = nullptr;
+        addFile(filePath, data);
+        return;
+    }
+
+    Entry &entry = m_entries.last();
+    if (m_entryDevice->size > MAX_ZIP32_SIZE)
+        m_error = true;
+    entry.crc = m_entryDevice->crc;
+    entry.size = quint32(m_entryDevice->size);
+    entry.compressedSize = entry.size;
+
+    delete m_entryDevice;
+    m_entryDevice = nullptr;
+
+    if (m_error)
+        return;
+
+    QByteArray fields;
+    appendUInt32(fields, entry.crc);
+    appendUInt32(fields, entry.compressedSize);
+    appendUInt32(fields, entry.size);
+
+    if (entry.flags & FLAG_DATA_DESCRIPTOR) {
+        QByteArray descriptor;
+        appendUInt32(descriptor, DATA_DESCRIPTOR_SIGNATURE);
+        descriptor.append(fields);
+        writeRaw(descriptor);
+    } else {
+        const qint64 end = m_device->pos();
+        const qint64 header = end - qint64(m_offset - entry.offset);
+        if (!m_device->seek(header + LOCAL_HEADER_CRC_OFFSET)
+                || m_device->write(fields) != fields.size()
+                || !m_device->seek(end))
+            m_error = true;
+    }
 }
 
 void ZipWriter::close()
 {
-    m_writer->close();
+    if (m_closed)
+        return;
+
+    endFile();
+    writePending(true);
+    m_closed = true;
+
+    if (!m_error) {
+        const quint64 directoryOffset = m_offset;
+
+        const QList<Entry> &entries = m_entries;
+        QByteArray directory;
+        for (const Entry &entry : entries) {
+            appendUInt32(directory, CENTRAL_HEADER_SIGNATURE);
+            appendUInt16(directory, ZIP_VERSION);   // made by
+            appendUInt16(directory, ZIP_VERSION);   // needed to extract
+            appendUInt16(directory, entry.flags);
+            appendUInt16(directory, entry.method);
+            appendUInt16(directory, m_time);
+            appendUInt16(directory, m_date);
+            appendUInt32(directory, entry.crc);
+            appendUInt32(directory, entry.compressedSize);
+            appendUInt32(directory, entry.size);
+            appendUInt16(directory, quint16(entry.name.size()));
+            appendUInt16(directory, 0);     // extra field length
+            appendUInt16(directory, 0);     // comment length
+            appendUInt16(directory, 0);     // disk number start
+            appendUInt16(directory, 0);     // internal attributes
+            appendUInt32(directory, 0);     // external attributes
+            appendUInt32(directory, entry.offset);
+            directory.append(entry.name);
+        }
+
+        if (directoryOffset > MAX_ZIP32_SIZE || m_entries.size() > 0xFFFF)
+            m_error = true;
+
+        if (writeRaw(directory)) {
+            QByteArray end;
+            appendUInt32(end, END_OF_CENTRAL_DIRECTORY_SIGNATURE);
+            appendUInt16(end, 0);   // this disk
+            appendUInt16(end, 0);   // disk with the central directory
+            appendUInt16(end, quint16(m_entries.size()));
+            appendUInt16(end, quint16(m_entries.size()));
+            appendUInt32(end, quint32(directory.size()));
+            appendUInt32(end, quint32(directoryOffset));
+            appendUInt16(end, 0);   // comment length
+            writeRaw(end);
+        }
+    }
+
+    if (m_ownsDevice)
+        m_device->close();
 }
 
 QT_END_NAMESPACE_XLSX
@@ -0,0 +1,367 @@
+#include "stdafx.h"
+#include "stripchart.h"
+
+const qint64 BASE_BLOCK_SIZE = 8;	// samples per block at the finest level
+const int LEVEL_FACTOR = 4;			// block size ratio between levels
+const int MIN_BLOCKS_PER_COLUMN = 4;	// keeps block misalignment within a fraction of a pixel
+
+const int windowSeconds[] = { 60, 600, 3600, 6 * 3600, 24 * 3600 };
+const char *windowLabels[] = { "1 min", "10 min", "1 hour", "6 hours", "24 hours" };
+
+//---------------------------------------------------------------------------
+// Constructor
+//---------------------------------------------------------------------------
+StripChart::StripChart(QWidget *parent)
+	: QWidget(parent)
+{
+	history = nullptr;
+	ingested = 0;
+	pyramidStart = 0;
+
+	windowComboBox = new QComboBox(this);
+	for (int i = 0; i < (int)(sizeof(windowSeconds) / sizeof(windowSeconds[0])); i++)
+		windowComboBox->addItem(windowLabels[i]);
+
+	QHBoxLayout *topLayout = new QHBoxLayout;
+	topLayout->addStretch();
+	topLayout->addWidget(new QLabel("Window :", this));
+	topLayout->addWidget(windowComboBox);
+
+	QVBoxLayout *layout = new QVBoxLayout(this);
+	layout->addLayout(topLayout);
+	layout->addStretch();
+
+	windowComboBox->setCurrentIndex(1);
+	windowMsec = (qint64)windowSeconds[1] * 1000;
+	connect(windowComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(windowSelectionChanged(int)));
+
+	setMinimumHeight(200);
+}
+
+//---------------------------------------------------------------------------
+// Destructor
+//---------------------------------------------------------------------------
+StripChart::~StripChart()
+{
+}
+
+//---------------------------------------------------------------------------
+void StripChart::setHistory(const SampleHistory *source)
+{
+	history = source;
+	resetPyramid();
+	samplesAppended();
+}
+
+//---------------------------------------------------------------------------
+void StripChart::windowSelectionChanged(int index)
+{
+	if (index >= 0 && index < (int)(sizeof(windowSeconds) / sizeof(windowSeconds[0])))
+	{
+		windowMsec = (qint64)windowSeconds[index] * 1000;
+		update();
+	}
+}
+
+//---------------------------------------------------------------------------
+// Sizes the pyramid levels to cover the full history capacity
+void StripChart::resetPyramid(void)
+{
+	levels.clear();
+	ingested = 0;
+	pyramidStart = 0;
+
+	if (history == nullptr)
+		return;
+
+	for (qint64 blockSize = BASE_BLOCK_SIZE; blockSize * LEVEL_FACTOR <= history->capacity(); blockSize *= LEVEL_FACTOR)
+	{
+		Level level;
+
+		level.blockSize = blockSize;
+		level.slots = (int)(history->capacity() / blockSize) + 2;
+
+		for (int s = 0; s < NUM_SERIES; s++)
+		{
+			level.minVal[s].fill(NAN, level.slots);
+			level.maxVal[s].fill(NAN, level.slots);
+		}
+
+		levels.append(level);
+	}
+
+	historyStart = history->startTime();
+	ingested = history->totalAppended() - history->size();
+	pyramidStart = ingested;
+}
+
+//---------------------------------------------------------------------------
+// Adds any new history samples to the pyramid, O(levels) per sample, and
+// schedules a repaint; called after each acquisition
+void StripChart::samplesAppended(void)
+{
+	if (history == nullptr)
+		return;
+
+	if (history->startTime() != historyStart || history->totalAppended() < ingested)
+		resetPyramid();
+
+	quint64 total = history->totalAppended();
+	quint64 oldest = total - history->size();
+
+	if (ingested < oldest)
+		ingested = oldest;	// overwritten before it was seen
+
+	while (ingested < total)
+	{
+		int i = (int)(ingested - oldest);
+
+		for (int l = 0; l < levels.size(); l++)
+		{
+			Level &level = levels[l];
+			int slot = (int)((ingested / level.blockSize) % level.slots);
+			bool blockStart = ((ingested % level.blockSize) == 0 || ingested == pyramidStart);
+
+			for (int s = 0; s < NUM_SERIES; s++)
+			{
+				float value = sampleValue(s, i);
+
+				if (blockStart)
+				{
+					level.minVal[s][slot] = value;
+					level.maxVal[s][slot] = value;
+				}
+				else if (!qIsNaN(value))
+				{
+					if (qIsNaN(level.minVal[s][slot]) || value < level.minVal[s][slot])
+						level.minVal[s][slot] = value;
+					if (qIsNaN(level.maxVal[s][slot]) || value > level.maxVal[s][slot])
+						level.maxVal[s][slot] = value;
+				}
+			}
+		}
+
+		ingested++;
+	}
+
+	update();	// deferred, coalesced repaint
+}
+
+//---------------------------------------------------------------------------
+float StripChart::sampleValue(int series, int i) const
+{
+	switch (series)
+	{
+		case X_SERIES:
+			return history->field(X_AXIS, i);
+		case Y_SERIES:
+			return history->field(Y_AXIS, i);
+		case Z_SERIES:
+			return history->field(Z_AXIS, i);
+		case MAGNITUDE_SERIES:
+			return history->magnitude(i);
+		default:
+			return history->polarAngle(i);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Min/max of one series over logical range [first, last), from raw samples
+// if level < 0 or else from the blocks of that level overlapping the range
+bool StripChart::columnRange(int series, int first, int last, int level, float *minOut, float *maxOut) const
+{
+	bool found = false;
+	float minVal = 0, maxVal = 0;
+
+	if (level < 0)
+	{
+		for (int i = first; i < last; i++)
+		{
+			float value = sampleValue(series, i);
+
+			if (!qIsNaN(value))
+			{
+				if (!found || value < minVal)
+					minVal = value;
+				if (!found || value > maxVal)
+					maxVal = value;
+				found = true;
+			}
+		}
+	}
+	else
+	{
+		const Level &lod = levels[level];
+		quint64 oldest = history->totalAppended() - history->size();
+		quint64 firstBlock = (oldest + first) / lod.blockSize;
+		quint64 lastBlock = (oldest + last - 1) / lod.blockSize;
+
+		for (quint64 b = firstBlock; b <= lastBlock; b++)
+		{
+			int slot = (int)(b % lod.slots);
+			float low = lod.minVal[series][slot];
+			float high = lod.maxVal[series][slot];
+
+			if (!qIsNaN(low) && !qIsNaN(high))
+			{
+				if (!found || low < minVal)
+					minVal = low;
+				if (!found || high > maxVal)
+					maxVal = high;
+				found = true;
+			}
+		}
+	}
+
+	*minOut = minVal;
+	*maxOut = maxVal;
+	return found;
+}
+
+//---------------------------------------------------------------------------
+void StripChart::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event);
+
+	const QColor seriesColors[NUM_SERIES] = { Qt::red, QColor(0, 160, 0), Qt::blue, Qt::black, Qt::magenta };
+	const char *seriesNames[NUM_SERIES] = { "X", "Y", "Z", "Magnitude", "Polar Angle" };
+
+	QPainter painter(this);
+	int top = windowComboBox->geometry().bottom() + 10;
+	QRect plotArea = rect().adjusted(70, top, -70, -30);
+
+	painter.fillRect(rect(), palette().window());
+	painter.fillRect(plotArea, Qt::white);
+	painter.setPen(Qt::gray);
+	painter.drawRect(plotArea);
+
+	// legend
+	int legendX = 10;
+	for (int s = 0; s < NUM_SERIES; s++)
+	{
+		painter.setPen(seriesColors[s]);
+		painter.drawText(legendX, windowComboBox->geometry().center().y() + 5, seriesNames[s]);
+		legendX += painter.fontMetrics().horizontalAdvance(seriesNames[s]) + 15;
+	}
+
+	if (history == nullptr || history->isEmpty() || plotArea.width() < 2 || plotArea.height() < 2)
+	{
+		painter.setPen(Qt::gray);
+		painter.drawText(plotArea, Qt::AlignCenter, "No data");
+		return;
+	}
+
+	int columns = plotArea.width();
+	qint64 endTime = history->time(history->size() - 1);
+	qint64 startTime = endTime - windowMsec;
+
+	// logical sample range of each pixel column
+	QVector<int> columnIndex(columns + 1);
+	for (int c = 0; c < columns; c++)
+		columnIndex[c] = history->lowerBound(startTime + (windowMsec * c) / columns);
+	columnIndex[columns] = history->size();
+
+	// choose the coarsest level that still has several blocks per column
+	int level = -1;
+	double samplesPerColumn = (double)(columnIndex[columns] - columnIndex[0]) / columns;
+
+	for (int l = 0; l < levels.size(); l++)
+	{
+		if (levels[l].blockSize * MIN_BLOCKS_PER_COLUMN <= samplesPerColumn)
+			level = l;
+	}
+
+	// reduce to per-column min/max, bounded by columns * levels work
+	QVector<float> colMin[NUM_SERIES], colMax[NUM_SERIES];
+	QVector<bool> colValid[NUM_SERIES];
+	float fieldLow = 0, fieldHigh = 0, angleLow = 0, angleHigh = 0;
+	bool haveField = false, haveAngle = false;
+
+	for (int s = 0; s < NUM_SERIES; s++)
+	{
+		colMin[s].resize(columns);
+		colMax[s].resize(columns);
+		colValid[s].fill(false, columns);
+
+		for (int c = 0; c < columns; c++)
+		{
+			if (columnIndex[c] >= columnIndex[c + 1])
+				continue;
+
+			if (columnRange(s, columnIndex[c], columnIndex[c + 1], level, &colMin[s][c], &colMax[s][c]))
+			{
+				colValid[s][c] = true;
+
+				if (s == ANGLE_SERIES)
+				{
+					if (!haveAngle || colMin[s][c] < angleLow)
+						angleLow = colMin[s][c];
+					if (!haveAngle || colMax[s][c] > angleHigh)
+						angleHigh = colMax[s][c];
+					haveAngle = true;
+				}
+				else
+				{
+					if (!haveField || colMin[s][c] < fieldLow)
+						fieldLow = colMin[s][c];
+					if (!haveField || colMax[s][c] > fieldHigh)
+						fieldHigh = colMax[s][c];
+					haveField = true;
+				}
+			}
+		}
+	}
+
+	// pad flat scales
+	if (fieldHigh - fieldLow < 1e-6f)
+	{
+		fieldLow -= 0.5f;
+		fieldHigh += 0.5f;
+	}
+
+	if (angleHigh - angleLow < 1e-6f)
+	{
+		angleLow -= 1.0f;
+		angleHigh += 1.0f;
+	}
+
+	// axis labels
+	QString units = (history->units() == TESLA) ? "T" : "kG";
+	painter.setPen(Qt::black);
+	painter.drawText(QRect(0, plotArea.top() - 8, plotArea.left() - 5, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(fieldHigh, 'g', 4) + " " + units);
+	painter.drawText(QRect(0, plotArea.bottom() - 8, plotArea.left() - 5, 16), Qt::AlignRight | Qt::AlignVCenter, QString::number(fieldLow, 'g', 4) + " " + units);
+	painter.setPen(seriesColors[ANGLE_SERIES]);
+	painter.drawText(QRect(plotArea.right() + 5, plotArea.top() - 8, 65, 16), Qt::AlignLeft | Qt::AlignVCenter, QString::number(angleHigh, 'f', 1) + QChar(0x00B0));
+	painter.drawText(QRect(plotArea.right() + 5, plotArea.bottom() - 8, 65, 16), Qt::AlignLeft | Qt::AlignVCenter, QString::number(angleLow, 'f', 1) + QChar(0x00B0));
+	painter.setPen(Qt::black);
+	painter.drawText(QRect(plotArea.left(), plotArea.bottom() + 5, plotArea.width(), 20), Qt::AlignLeft | Qt::AlignTop, "-" + windowComboBox->currentText());
+	painter.drawText(QRect(plotArea.left(), plotArea.bottom() + 5, plotArea.width(), 20), Qt::AlignRight | Qt::AlignTop, "now");
+
+	// series traces, each column drawn as its min to max extent
+	painter.setClipRect(plotArea);
+
+	for (int s = 0; s < NUM_SERIES; s++)
+	{
+		float low = (s == ANGLE_SERIES) ? angleLow : fieldLow;
+		float high = (s == ANGLE_SERIES) ? angleHigh : fieldHigh;
+		double scale = plotArea.height() / (double)(high - low);
+		QPolygonF trace;
+
+		for (int c = 0; c < columns; c++)
+		{
+			if (!colValid[s][c])
+				continue;
+
+			double x = plotArea.left() + c;
+			trace.append(QPointF(x, plotArea.bottom() - (colMin[s][c] - low) * scale));
+			if (colMax[s][c] != colMin[s][c])
+				trace.append(QPointF(x, plotArea.bottom() - (colMax[s][c] - low) * scale));
+		}
+
+		QPen pen(seriesColors[s]);
+		if (s == ANGLE_SERIES)
+			pen.setStyle(Qt::DashLine);
+		painter.setPen(pen);
+		painter.drawPolyline(trace);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QWidget>
+#include <QComboBox>
+#include <QVector>
+#include "samplehistory.h"
+
+//---------------------------------------------------------------------------
+// Strip-chart of X/Y/Z field, magnitude and polar angle read from the
+// acquisition history. A min/max level-of-detail pyramid is maintained as
+// samples arrive, so a repaint touches a bounded number of blocks per
+// pixel column regardless of how many samples the window spans.
+//---------------------------------------------------------------------------
+class StripChart : public QWidget
+{
+	Q_OBJECT
+
+public:
+	StripChart(QWidget *parent = Q_NULLPTR);
+	~StripChart();
+	void setHistory(const SampleHistory *source);
+
+public slots:
+	void samplesAppended(void);
+	void windowSelectionChanged(int index);
+
+protected:
+	void paintEvent(QPaintEvent *event);
+
+private:
+	enum Series
+	{
+		X_SERIES = 0,
+		Y_SERIES,
+		Z_SERIES,
+		MAGNITUDE_SERIES,
+		ANGLE_SERIES,
+		NUM_SERIES
+	};
+
+	struct Level
+	{
+		qint64 blockSize;		// samples per block
+		int slots;				// ring size in blocks
+		QVector<float> minVal[NUM_SERIES];
+		QVector<float> maxVal[NUM_SERIES];
+	};
+
+	const SampleHistory *history;
+	QComboBox *windowComboBox;
+	qint64 windowMsec;
+
+	QVector<Level> levels;
+	quint64 ingested;		// absolute count of samples added to the pyramid
+	quint64 pyramidStart;	// absolute index of first sample in the pyramid
+	QDateTime historyStart;	// detects history reset
+
+	void resetPyramid(void);
+	float sampleValue(int series, int i) const;
+	bool columnRange(int series, int first, int last, int level, float *minOut, float *maxOut) const;
+};
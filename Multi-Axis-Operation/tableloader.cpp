@@ -0,0 +1,370 @@
+#include "stdafx.h"
+#include "tableloader.h"
+#include "binarytable.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+const int CHUNK_ROWS = 8192;		// rows parsed per task
+const int PROGRESS_ROWS = 1024;		// rows between progress updates
+
+//---------------------------------------------------------------------------
+// Parses a number the same way QString::toDouble() does, without the
+// allocation: surrounding blanks and a leading '+' are allowed.
+//---------------------------------------------------------------------------
+static bool parseNumber(const char *begin, const char *end, double *value)
+{
+	if (begin < end && *begin == '+')
+		begin++;
+
+	if (begin == end)
+		return false;
+
+#if defined(__cpp_lib_to_chars)
+	std::from_chars_result result = std::from_chars(begin, end, *value);
+
+	return result.ec == std::errc() && result.ptr == end;
+#else
+	bool ok;
+
+	*value = QByteArray::fromRawData(begin, static_cast<int>(end - begin)).toDouble(&ok);
+
+	return ok;
+#endif
+}
+
+//---------------------------------------------------------------------------
+static bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+//---------------------------------------------------------------------------
+TableLoader::TableLoader(QObject *parent)
+	: QObject(parent)
+{
+	skipRows = 0;
+	minimumNumCols = 1;
+	resultCol = -1;
+	firstErrorLine = 0;
+	rowsParsed = 0;
+	lastPercent = 0;
+
+	connect(&watcher, SIGNAL(finished()), this, SIGNAL(finished()));
+}
+
+//---------------------------------------------------------------------------
+TableLoader::~TableLoader()
+{
+	watcher.waitForFinished();
+}
+
+//---------------------------------------------------------------------------
+// Starts loading in the background, finished() is emitted on the GUI
+// thread when the contents are ready to take.
+void TableLoader::start(const QString &filename, int skipRowsCnt, int minimumColumns, int resultColumn)
+{
+	if (watcher.isRunning())
+		return;
+
+	fileName = filename;
+	skipRows = skipRowsCnt;
+	minimumNumCols = minimumColumns;
+	resultCol = resultColumn;
+	contents = TableContents();
+	error.clear();
+	firstErrorLine = 0;
+	rowsParsed = 0;
+	lastPercent = 0;
+
+	watcher.setFuture(QtConcurrent::run([this]() { parse(); }));
+}
+
+//---------------------------------------------------------------------------
+void TableLoader::takeContents(TableContents *tableContents)
+{
+	*tableContents = std::move(contents);
+	contents = TableContents();
+}
+
+//---------------------------------------------------------------------------
+// Called from the worker threads, emits at most once per percent.
+void TableLoader::reportProgress(int count)
+{
+	int rows = contents.rows;
+
+	if (rows)
+	{
+		int percent = static_cast<int>((rowsParsed += count) * 100LL / rows);
+		int last = lastPercent;
+
+		if (percent > last && lastPercent.compare_exchange_strong(last, percent))
+			emit progress(percent);
+	}
+}
+
+//---------------------------------------------------------------------------
+void TableLoader::parse(void)
+{
+	TableFileInfo info;
+
+	if (BinaryTable::readInfo(fileName, &info, &error))
+	{
+		if (error.isEmpty())
+			readBinary();
+
+		return;
+	}
+
+	QFile file(fileName);
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		error = "Unable to open " + QDir::toNativeSeparators(fileName);
+		return;
+	}
+
+	qint64 size = file.size();
+
+	if (size == 0)
+		return;		// empty table
+
+	// map the file, or read it if it cannot be mapped (e.g. some network shares)
+	QByteArray buffer;
+	const char *data = reinterpret_cast<const char *>(file.map(0, size));
+
+	if (data == nullptr)
+	{
+		buffer = file.readAll();
+		data = buffer.constData();
+		size = buffer.size();
+	}
+
+	const char *end = data + size;
+
+	// index the rows, skipping the header lines and any blank lines
+	QVector<const char *> starts;
+	QVector<int> lengths;
+	QVector<int> lineNumbers;
+	int headerColumns = 0;
+	int lineNumber = 0;
+
+	starts.reserve(static_cast<int>(size / 16));
+	lengths.reserve(static_cast<int>(size / 16));
+	lineNumbers.reserve(static_cast<int>(size / 16));
+
+	for (const char *p = data; p < end; )
+	{
+		const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+
+		if (eol == nullptr)
+			eol = end;
+
+		int length = static_cast<int>(eol - p);
+
+		if (length && p[length - 1] == '\r')
+			length--;
+
+		lineNumber++;
+
+		if (lineNumber == skipRows)
+		{
+			headerColumns = static_cast<int>(std::count(p, p + length, ',')) + 1;
+		}
+		else if (lineNumber > skipRows && length > 0)
+		{
+			starts.append(p);
+			lengths.append(length);
+			lineNumbers.append(lineNumber);
+		}
+
+		p = eol + 1;
+	}
+
+	// column count from the header or first row, whichever is wider
+	int numColumns = qMax(headerColumns, minimumNumCols);
+
+	if (starts.count())
+		numColumns = qMax(numColumns, static_cast<int>(std::count(starts[0], starts[0] + lengths[0], ',')) + 1);
+
+	int numRows = starts.count();
+
+	contents.rows = numRows;
+	contents.values.resize(numColumns);
+	contents.states.resize(numColumns);
+
+	for (int i = 0; i < numColumns; i++)
+	{
+		contents.values[i].resize(numRows);
+		contents.states[i].fill(CELL_EMPTY, numRows);
+	}
+
+	contents.results.fill(RESULT_NONE, numRows);
+
+	// parse the rows in parallel chunks, each writes its own rows only
+	QVector<Chunk> chunks;
+
+	for (int first = 0; first < numRows; first += CHUNK_ROWS)
+	{
+		Chunk chunk;
+
+		chunk.first = first;
+		chunk.last = qMin(first + CHUNK_ROWS, numRows);
+		chunk.errorLine = 0;
+		chunk.errorCount = 0;
+		chunks.append(chunk);
+	}
+
+	QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) { parseChunk(chunk, starts, lengths, lineNumbers, numColumns); });
+
+	// merge text entries and report the first line with an error
+	int errorCount = 0;
+
+	for (int i = 0; i < chunks.count(); i++)
+	{
+		for (auto it = chunks[i].texts.constBegin(); it != chunks[i].texts.constEnd(); ++it)
+			contents.texts.insert(it.key(), it.value());
+
+		if (chunks[i].errorCount)
+		{
+			if (firstErrorLine == 0)
+			{
+				firstErrorLine = chunks[i].errorLine;
+				error = chunks[i].error;
+			}
+
+			errorCount += chunks[i].errorCount;
+		}
+	}
+
+	if (errorCount > 1)
+		error += QString(" (%1 lines with errors)").arg(errorCount);
+
+	file.close();
+}
+
+//---------------------------------------------------------------------------
+// Binary tables need no parsing, the column arrays are copied as stored
+void TableLoader::readBinary(void)
+{
+	BinaryTable table;
+
+	if (!table.open(fileName))
+	{
+		error = table.errorString();
+	}
+	else if (!table.readRows(0, table.info().rows, &contents))
+	{
+		error = QDir::toNativeSeparators(fileName) + ": the file is truncated or corrupt";
+		contents = TableContents();
+	}
+	else
+	{
+		emit progress(100);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Parses rows first to last - 1 into the preallocated contents. Text
+// entries are collected per chunk and merged afterwards.
+void TableLoader::parseChunk(Chunk &chunk, const QVector<const char *> &starts, const QVector<int> &lengths, const QVector<int> &lineNumbers, int numColumns)
+{
+	for (int row = chunk.first; row < chunk.last; row++)
+	{
+		const char *p = starts[row];
+		const char *lineEnd = p + lengths[row];
+		int missingColumn = -1;
+		int badColumn = -1;
+		QString badText;
+
+		for (int column = 0; column < numColumns; column++)
+		{
+			if (p > lineEnd)
+			{
+				// row is short, remaining fields are empty
+				if (column < minimumNumCols && column != resultCol && missingColumn < 0)
+					missingColumn = column;
+
+				continue;
+			}
+
+			const char *fieldEnd = static_cast<const char *>(memchr(p, ',', lineEnd - p));
+
+			if (fieldEnd == nullptr)
+				fieldEnd = lineEnd;
+
+			const char *begin = p;
+			const char *end = fieldEnd;
+
+			while (begin < end && isBlank(*begin))
+				begin++;
+
+			while (end > begin && isBlank(end[-1]))
+				end--;
+
+			if (begin == end)
+			{
+				if (column < minimumNumCols && column != resultCol && missingColumn < 0)
+					missingColumn = column;
+			}
+			else if (column == resultCol)
+			{
+				int length = static_cast<int>(end - begin);
+
+				if (length == 4 && qstrnicmp(begin, "pass", 4) == 0)
+					contents.results[row] = RESULT_PASS;
+				else if (length == 4 && qstrnicmp(begin, "fail", 4) == 0)
+					contents.results[row] = RESULT_FAIL;
+			}
+			else
+			{
+				double value;
+
+				if (parseNumber(begin, end, &value))
+				{
+					contents.values[column][row] = value;
+					contents.states[column][row] = CELL_VALUE;
+				}
+				else
+				{
+					// keep the entry as typed
+					QString text = QString::fromUtf8(p, static_cast<int>(fieldEnd - p));
+
+					contents.states[column][row] = CELL_TEXT;
+					chunk.texts.insert(TableModel::textKey(row, column), text);
+
+					if (badColumn < 0)
+					{
+						badColumn = column;
+						badText = text.trimmed();
+					}
+				}
+			}
+
+			p = fieldEnd + 1;
+		}
+
+		if (badColumn >= 0 || missingColumn >= 0)
+		{
+			if (chunk.errorCount++ == 0)
+			{
+				chunk.errorLine = lineNumbers[row];
+
+				if (badColumn >= 0)
+					chunk.error = QString("Line %1: \"%2\" in column %3 is not a number").arg(lineNumbers[row]).arg(badText).arg(badColumn + 1);
+				else
+					chunk.error = QString("Line %1: missing value in column %2").arg(lineNumbers[row]).arg(missingColumn + 1);
+			}
+		}
+
+		if ((row - chunk.first + 1) % PROGRESS_ROWS == 0)
+			reportProgress(PROGRESS_ROWS);
+	}
+
+	reportProgress((chunk.last - chunk.first) % PROGRESS_ROWS);
+}
+
+//---------------------------------------------------------------------------
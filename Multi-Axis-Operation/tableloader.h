@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <atomic>
+#include "tablemodel.h"
+
+//---------------------------------------------------------------------------
+// Loads a comma separated vector or polar table on a worker thread. The
+// file is memory mapped and its rows parsed in parallel chunks straight
+// into TableContents, which the GUI thread then hands to the model in one
+// batch. Entries that are not numbers are kept as text, and the first
+// such line is reported by errorString(). Binary tables (see BinaryTable)
+// are recognized by their header and copied without parsing.
+//---------------------------------------------------------------------------
+class TableLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	TableLoader(QObject *parent = Q_NULLPTR);
+	~TableLoader();
+
+	bool isRunning(void) { return watcher.isRunning(); }
+	void start(const QString &filename, int skipRowsCnt, int minimumColumns, int resultColumn = -1);
+	void takeContents(TableContents *tableContents);
+	int errorLine(void) { return firstErrorLine; }
+	QString errorString(void) { return error; }
+
+signals:
+	void progress(int percent);
+	void finished(void);
+
+private:
+	struct Chunk
+	{
+		int first;
+		int last;
+		QHash<quint64, QString> texts;
+		int errorLine;
+		int errorCount;
+		QString error;
+	};
+
+	QFutureWatcher<void> watcher;
+	QString fileName;
+	int skipRows;
+	int minimumNumCols;
+	int resultCol;
+	TableContents contents;
+	QString error;
+	int firstErrorLine;
+	std::atomic<int> rowsParsed;
+	std::atomic<int> lastPercent;
+
+	void parse(void);
+	void readBinary(void);
+	void parseChunk(Chunk &chunk, const QVector<const char *> &starts, const QVector<int> &lengths, const QVector<int> &lineNumbers, int numColumns);
+	void reportProgress(int count);
+};
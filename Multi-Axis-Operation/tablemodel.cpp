@@ -0,0 +1,653 @@
+#include "stdafx.h"
+#include "tablemodel.h"
+
+//---------------------------------------------------------------------------
+TableModel::TableModel(int minimumColumns, QObject *parent)
+	: QAbstractTableModel(parent)
+{
+	rows = 0;
+	minimumNumCols = minimumColumns;
+	checkColumn = -1;
+	resultColumn = -1;
+	checkable = false;
+	bulkDepth = 0;
+
+	setColumnCount(minimumNumCols);
+}
+
+//---------------------------------------------------------------------------
+TableModel::~TableModel()
+{
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setColumnCount(int numColumns)
+{
+	int oldCount = columns.count();
+
+	if (numColumns < minimumNumCols)
+		numColumns = minimumNumCols;
+
+	if (numColumns > oldCount)
+	{
+		if (!bulkDepth)
+			beginInsertColumns(QModelIndex(), oldCount, numColumns - 1);
+
+		columns.resize(numColumns);
+
+		for (int i = oldCount; i < numColumns; i++)
+		{
+			columns[i].values.fill(0.0, rows);
+			columns[i].states.fill(CELL_EMPTY, rows);
+			columns[i].precision = QLocale::FloatingPointShortest;
+		}
+
+		if (!bulkDepth)
+			endInsertColumns();
+	}
+	else if (numColumns < oldCount)
+	{
+		if (!bulkDepth)
+			beginRemoveColumns(QModelIndex(), numColumns, oldCount - 1);
+
+		columns.resize(numColumns);
+
+		// drop any text held for the removed columns
+		for (auto it = texts.begin(); it != texts.end(); )
+		{
+			if (static_cast<int>(it.key() >> 32) >= numColumns)
+				it = texts.erase(it);
+			else
+				++it;
+		}
+
+		if (!bulkDepth)
+			endRemoveColumns();
+	}
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setHeader(int column, const QString &text)
+{
+	if (column >= 0 && column < columns.count())
+	{
+		columns[column].header = text;
+		emit headerDataChanged(Qt::Horizontal, column, column);
+	}
+}
+
+//---------------------------------------------------------------------------
+QString TableModel::header(int column) const
+{
+	if (column >= 0 && column < columns.count())
+		return columns[column].header;
+	else
+		return QString();
+}
+
+//---------------------------------------------------------------------------
+// Check boxes are only shown when a persistent switch is installed.
+void TableModel::setCheckable(bool state)
+{
+	if (checkable != state)
+	{
+		checkable = state;
+
+		if (rows && checkColumn >= 0 && checkColumn < columns.count() && !bulkDepth)
+			emit dataChanged(index(0, checkColumn), index(rows - 1, checkColumn), { Qt::CheckStateRole });
+	}
+}
+
+//---------------------------------------------------------------------------
+// Significant digits used to display a column, e.g. quench currents.
+void TableModel::setPrecision(int column, int digits)
+{
+	if (column >= 0 && column < columns.count())
+		columns[column].precision = digits;
+}
+
+//---------------------------------------------------------------------------
+void TableModel::resizeRows(int numRows)
+{
+	rowErrors.clear();
+
+	for (int i = 0; i < columns.count(); i++)
+	{
+		columns[i].values.resize(numRows);
+		columns[i].states.resize(numRows);
+	}
+
+	checks.resize(numRows);
+	results.resize(numRows);
+
+	// new rows are empty
+	for (int i = rows; i < numRows; i++)
+	{
+		for (int j = 0; j < columns.count(); j++)
+		{
+			columns[j].values[i] = 0.0;
+			columns[j].states[i] = CELL_EMPTY;
+		}
+
+		checks[i] = false;
+		results[i] = RESULT_NONE;
+	}
+
+	// drop any text held for removed rows
+	if (numRows < rows)
+	{
+		for (auto it = texts.begin(); it != texts.end(); )
+		{
+			if (static_cast<int>(it.key() & 0xFFFFFFFF) >= numRows)
+				it = texts.erase(it);
+			else
+				++it;
+		}
+	}
+
+	rows = numRows;
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setRowCount(int numRows)
+{
+	if (numRows < 0)
+		numRows = 0;
+
+	if (numRows > rows)
+	{
+		if (!bulkDepth)
+			beginInsertRows(QModelIndex(), rows, numRows - 1);
+		resizeRows(numRows);
+		if (!bulkDepth)
+			endInsertRows();
+	}
+	else if (numRows < rows)
+	{
+		if (!bulkDepth)
+			beginRemoveRows(QModelIndex(), numRows, rows - 1);
+		resizeRows(numRows);
+		if (!bulkDepth)
+			endRemoveRows();
+	}
+}
+
+//---------------------------------------------------------------------------
+// Moves the text entries at or below row by delta rows.
+void TableModel::shiftTexts(int row, int delta)
+{
+	if (texts.isEmpty())
+		return;
+
+	QHash<quint64, QString> shifted;
+
+	for (auto it = texts.constBegin(); it != texts.constEnd(); ++it)
+	{
+		int textRow = static_cast<int>(it.key() & 0xFFFFFFFF);
+		int textColumn = static_cast<int>(it.key() >> 32);
+
+		if (textRow >= row)
+			textRow += delta;
+
+		shifted.insert(textKey(textRow, textColumn), it.value());
+	}
+
+	texts.swap(shifted);
+}
+
+//---------------------------------------------------------------------------
+void TableModel::insertRow(int row)
+{
+	if (row < 0 || row > rows)
+		return;
+
+	if (!bulkDepth)
+		beginInsertRows(QModelIndex(), row, row);
+
+	for (int i = 0; i < columns.count(); i++)
+	{
+		columns[i].values.insert(row, 0.0);
+		columns[i].states.insert(row, CELL_EMPTY);
+	}
+
+	checks.insert(row, false);
+	results.insert(row, RESULT_NONE);
+	shiftTexts(row, 1);
+	rowErrors.clear();
+	rows++;
+
+	if (!bulkDepth)
+		endInsertRows();
+}
+
+//---------------------------------------------------------------------------
+void TableModel::removeRow(int row)
+{
+	if (row < 0 || row >= rows)
+		return;
+
+	if (!bulkDepth)
+		beginRemoveRows(QModelIndex(), row, row);
+
+	for (int i = 0; i < columns.count(); i++)
+	{
+		columns[i].values.remove(row);
+		columns[i].states.remove(row);
+		texts.remove(textKey(row, i));
+	}
+
+	checks.remove(row);
+	results.remove(row);
+	shiftTexts(row + 1, -1);
+	rowErrors.clear();
+	rows--;
+
+	if (!bulkDepth)
+		endRemoveRows();
+}
+
+//---------------------------------------------------------------------------
+// Removes all rows, the columns and headers are kept.
+void TableModel::clear(void)
+{
+	if (rows)
+	{
+		beginBulkUpdate();
+		resizeRows(0);
+		texts.clear();
+		endBulkUpdate();
+	}
+}
+
+//---------------------------------------------------------------------------
+// Defers change notifications while a table is rebuilt, the views are
+// reset once when the outermost update ends.
+void TableModel::beginBulkUpdate(void)
+{
+	if (bulkDepth++ == 0)
+		beginResetModel();
+}
+
+//---------------------------------------------------------------------------
+void TableModel::endBulkUpdate(void)
+{
+	if (bulkDepth > 0 && --bulkDepth == 0)
+		endResetModel();
+}
+
+//---------------------------------------------------------------------------
+// Takes over parsed contents, leaving contents empty. Persistence checks
+// are cleared.
+void TableModel::setContents(TableContents &contents)
+{
+	beginBulkUpdate();
+
+	resizeRows(0);
+	texts.clear();
+	setColumnCount(contents.values.count());
+
+	for (int i = 0; i < columns.count(); i++)
+	{
+		if (i < contents.values.count())
+		{
+			columns[i].values.swap(contents.values[i]);
+			columns[i].states.swap(contents.states[i]);
+		}
+		else
+		{
+			columns[i].values.fill(0.0, contents.rows);
+			columns[i].states.fill(CELL_EMPTY, contents.rows);
+		}
+	}
+
+	results.swap(contents.results);
+	results.resize(contents.rows);
+	checks.fill(false, contents.rows);
+	texts.swap(contents.texts);
+	rows = contents.rows;
+
+	contents = TableContents();
+
+	endBulkUpdate();
+}
+
+//---------------------------------------------------------------------------
+// Snapshot of the contents for a worker thread, see TableWriter.
+void TableModel::getContents(TableContents *contents) const
+{
+	*contents = TableContents();
+	contents->rows = rows;
+	contents->results = results;
+	contents->texts = texts;
+	contents->resultColumn = resultColumn;
+
+	for (int i = 0; i < columns.count(); i++)
+	{
+		contents->values.append(columns[i].values);
+		contents->states.append(columns[i].states);
+		contents->headers.append(columns[i].header);
+		contents->precisions.append(columns[i].precision);
+	}
+}
+
+//---------------------------------------------------------------------------
+CellState TableModel::state(int row, int column) const
+{
+	if (row < 0 || row >= rows || column < 0 || column >= columns.count())
+		return CELL_EMPTY;
+
+	if (column == resultColumn)
+		return results[row] == RESULT_NONE ? CELL_EMPTY : CELL_TEXT;
+
+	return static_cast<CellState>(columns[column].states[row]);
+}
+
+//---------------------------------------------------------------------------
+double TableModel::value(int row, int column, bool *ok) const
+{
+	bool isValue = (state(row, column) == CELL_VALUE);
+
+	if (ok)
+		*ok = isValue;
+
+	return isValue ? columns[column].values[row] : 0.0;
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setValue(int row, int column, double value)
+{
+	if (row < 0 || row >= rows || column < 0 || column >= columns.count() || column == resultColumn)
+		return;
+
+	texts.remove(textKey(row, column));
+	columns[column].values[row] = value;
+	columns[column].states[row] = CELL_VALUE;
+	cellChanged(row, column);
+}
+
+//---------------------------------------------------------------------------
+// Multiplies every numeric entry in a column, e.g. for a units change.
+void TableModel::scaleColumn(int column, double multiplier, double divisor)
+{
+	if (column < 0 || column >= columns.count() || column == resultColumn)
+		return;
+
+	double *values = columns[column].values.data();
+	const quint8 *states = columns[column].states.constData();
+
+	for (int i = 0; i < rows; i++)
+	{
+		if (states[i] == CELL_VALUE)
+			values[i] = values[i] * multiplier / divisor;
+	}
+
+	if (rows && !bulkDepth)
+		emit dataChanged(index(0, column), index(rows - 1, column), { Qt::DisplayRole });
+}
+
+//---------------------------------------------------------------------------
+QString TableModel::text(int row, int column) const
+{
+	if (column == resultColumn && row >= 0 && row < rows)
+	{
+		if (results[row] == RESULT_PASS)
+			return "Pass";
+		else if (results[row] == RESULT_FAIL)
+			return "Fail";
+		else
+			return QString();
+	}
+
+	switch (state(row, column))
+	{
+	case CELL_VALUE:
+		return QString::number(columns[column].values[row], 'g', columns[column].precision);
+
+	case CELL_TEXT:
+		return texts.value(textKey(row, column));
+
+	default:
+		return QString();
+	}
+}
+
+//---------------------------------------------------------------------------
+// Stores text without notifying views; numbers are converted once here.
+void TableModel::storeText(int row, int column, const QString &text)
+{
+	if (column == resultColumn)
+	{
+		if (text.trimmed().compare("Pass", Qt::CaseInsensitive) == 0)
+			results[row] = RESULT_PASS;
+		else if (text.trimmed().compare("Fail", Qt::CaseInsensitive) == 0)
+			results[row] = RESULT_FAIL;
+		else
+			results[row] = RESULT_NONE;
+
+		return;
+	}
+
+	bool ok;
+	double value = text.toDouble(&ok);
+
+	if (ok)
+	{
+		texts.remove(textKey(row, column));
+		columns[column].values[row] = value;
+		columns[column].states[row] = CELL_VALUE;
+	}
+	else if (text.trimmed().isEmpty())
+	{
+		texts.remove(textKey(row, column));
+		columns[column].states[row] = CELL_EMPTY;
+	}
+	else
+	{
+		texts.insert(textKey(row, column), text);
+		columns[column].states[row] = CELL_TEXT;
+	}
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setText(int row, int column, const QString &text)
+{
+	if (row < 0 || row >= rows || column < 0 || column >= columns.count())
+		return;
+
+	storeText(row, column, text);
+	cellChanged(row, column);
+}
+
+//---------------------------------------------------------------------------
+bool TableModel::isChecked(int row) const
+{
+	if (row >= 0 && row < rows)
+		return checks[row];
+	else
+		return false;
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setChecked(int row, bool state)
+{
+	if (row >= 0 && row < rows)
+	{
+		checks[row] = state;
+
+		if (checkColumn >= 0)
+			cellChanged(row, checkColumn, Qt::CheckStateRole);
+	}
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setAllChecked(bool state)
+{
+	checks.fill(state, rows);
+
+	if (rows && checkColumn >= 0 && !bulkDepth)
+		emit dataChanged(index(0, checkColumn), index(rows - 1, checkColumn), { Qt::CheckStateRole });
+}
+
+//---------------------------------------------------------------------------
+void TableModel::toggleAllChecked(void)
+{
+	for (int i = 0; i < rows; i++)
+		checks[i] = !checks[i];
+
+	if (rows && checkColumn >= 0 && !bulkDepth)
+		emit dataChanged(index(0, checkColumn), index(rows - 1, checkColumn), { Qt::CheckStateRole });
+}
+
+//---------------------------------------------------------------------------
+TableResult TableModel::result(int row) const
+{
+	if (row >= 0 && row < rows)
+		return static_cast<TableResult>(results[row]);
+	else
+		return RESULT_NONE;
+}
+
+//---------------------------------------------------------------------------
+void TableModel::setResult(int row, TableResult result)
+{
+	if (row >= 0 && row < rows)
+	{
+		results[row] = result;
+
+		if (resultColumn >= 0)
+			cellChanged(row, resultColumn);
+	}
+}
+
+//---------------------------------------------------------------------------
+void TableModel::cellChanged(int row, int column, int role)
+{
+	if (!bulkDepth)
+	{
+		QModelIndex cell = index(row, column);
+
+		emit dataChanged(cell, cell, { role });
+	}
+}
+
+//---------------------------------------------------------------------------
+// Highlights a row with message as its tool tip, an empty message clears it
+void TableModel::setRowError(int row, const QString &message)
+{
+	if (row < 0 || row >= rows || rowErrors.value(row) == message)
+		return;
+
+	if (message.isEmpty())
+		rowErrors.remove(row);
+	else
+		rowErrors.insert(row, message);
+
+	if (!bulkDepth && columns.count())
+		emit dataChanged(index(row, 0), index(row, columns.count() - 1), { Qt::BackgroundRole, Qt::ToolTipRole });
+}
+
+//---------------------------------------------------------------------------
+int TableModel::rowCount(const QModelIndex &parent) const
+{
+	return parent.isValid() ? 0 : rows;
+}
+
+//---------------------------------------------------------------------------
+int TableModel::columnCount(const QModelIndex &parent) const
+{
+	return parent.isValid() ? 0 : columns.count();
+}
+
+//---------------------------------------------------------------------------
+QVariant TableModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid())
+		return QVariant();
+
+	switch (role)
+	{
+	case Qt::DisplayRole:
+	case Qt::EditRole:
+		return text(index.row(), index.column());
+
+	case Qt::CheckStateRole:
+		if (checkable && index.column() == checkColumn)
+			return static_cast<int>(isChecked(index.row()) ? Qt::Checked : Qt::Unchecked);
+		break;
+
+	case Qt::TextAlignmentRole:
+		if (index.column() == resultColumn)
+			return static_cast<int>(Qt::AlignCenter);
+		else
+			return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+
+	case Qt::BackgroundRole:
+		if (rowErrors.contains(index.row()))
+			return QColor(255, 210, 210);
+		break;
+
+	case Qt::ToolTipRole:
+		if (rowErrors.contains(index.row()))
+			return rowErrors.value(index.row());
+		break;
+
+	default:
+		break;
+	}
+
+	return QVariant();
+}
+
+//---------------------------------------------------------------------------
+bool TableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+	if (!index.isValid())
+		return false;
+
+	if (role == Qt::EditRole)
+	{
+		setText(index.row(), index.column(), value.toString());
+		return true;
+	}
+	else if (role == Qt::CheckStateRole && index.column() == checkColumn)
+	{
+		setChecked(index.row(), value.toInt() == Qt::Checked);
+		return true;
+	}
+
+	return false;
+}
+
+//---------------------------------------------------------------------------
+Qt::ItemFlags TableModel::flags(const QModelIndex &index) const
+{
+	if (!index.isValid())
+		return Qt::NoItemFlags;
+
+	Qt::ItemFlags itemFlags = Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+
+	// results are set by the autostep engine only
+	if (index.column() != resultColumn)
+		itemFlags |= Qt::ItemIsEditable;
+
+	if (checkable && index.column() == checkColumn)
+		itemFlags |= Qt::ItemIsUserCheckable;
+
+	return itemFlags;
+}
+
+//---------------------------------------------------------------------------
+QVariant TableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (role == Qt::DisplayRole)
+	{
+		if (orientation == Qt::Horizontal && section < columns.count() && !columns[section].header.isEmpty())
+			return columns[section].header;
+		else
+			return section + 1;
+	}
+
+	return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+enum CellState
+{
+	CELL_EMPTY = 0,
+	CELL_VALUE,			// numeric entry held as a double
+	CELL_TEXT			// non-numeric entry, kept verbatim
+};
+
+enum TableResult
+{
+	RESULT_NONE = 0,
+	RESULT_PASS,
+	RESULT_FAIL
+};
+
+//---------------------------------------------------------------------------
+// Table contents moved between a model and the worker threads that load
+// and save it. The arrays are implicitly shared, so a snapshot taken with
+// TableModel::getContents() costs nothing until the model is next edited.
+//---------------------------------------------------------------------------
+struct TableContents
+{
+	int rows = 0;
+	QVector<QVector<double>> values;	// one array per column
+	QVector<QVector<quint8>> states;	// CellState of each value
+	QVector<quint8> results;			// TableResult of each row
+	QHash<quint64, QString> texts;		// CELL_TEXT entries keyed by TableModel::textKey()
+
+	// filled in by getContents() only
+	QStringList headers;
+	QVector<int> precisions;
+	int resultColumn = -1;
+};
+
+//---------------------------------------------------------------------------
+// Vector and polar table contents stored by column. Numeric cells live in
+// a double array per column, so the autostep engine reads values without
+// parsing text; text is only formatted for display and for file output.
+// The persistence check boxes and the Pass/Fail results are kept in their
+// own per-row arrays.
+//---------------------------------------------------------------------------
+class TableModel : public QAbstractTableModel
+{
+	Q_OBJECT
+
+public:
+	TableModel(int minimumColumns, QObject *parent = Q_NULLPTR);
+	~TableModel();
+
+	// layout
+	int getMinimumNumCols(void) { return minimumNumCols; }
+	void setColumnCount(int numColumns);
+	void setHeader(int column, const QString &text);
+	QString header(int column) const;
+	void setCheckColumn(int column) { checkColumn = column; }
+	void setCheckable(bool state);
+	void setResultColumn(int column) { resultColumn = column; }
+	int getResultColumn(void) { return resultColumn; }
+	void setPrecision(int column, int digits);
+
+	// rows
+	void setRowCount(int numRows);
+	void insertRow(int row);
+	void removeRow(int row);
+	void clear(void);
+	void beginBulkUpdate(void);
+	void endBulkUpdate(void);
+	void setContents(TableContents &contents);
+	void getContents(TableContents *contents) const;
+
+	// typed cell access
+	CellState state(int row, int column) const;
+	bool isEmpty(int row, int column) const { return state(row, column) == CELL_EMPTY; }
+	double value(int row, int column, bool *ok = nullptr) const;
+	void setValue(int row, int column, double value);
+	void scaleColumn(int column, double multiplier, double divisor = 1.0);
+	QString text(int row, int column) const;
+	void setText(int row, int column, const QString &text);
+	bool isChecked(int row) const;
+	void setChecked(int row, bool state);
+	void setAllChecked(bool state);
+	void toggleAllChecked(void);
+	TableResult result(int row) const;
+	void setResult(int row, TableResult result);
+
+	// rows that fail validation are highlighted, see TableValidator
+	void setRowError(int row, const QString &message);
+	QString rowError(int row) const { return rowErrors.value(row); }
+
+	static quint64 textKey(int row, int column) { return (static_cast<quint64>(column) << 32) | static_cast<quint32>(row); }
+
+	// QAbstractTableModel
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+	bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+	Qt::ItemFlags flags(const QModelIndex &index) const;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+private:
+	struct Column
+	{
+		QVector<double> values;
+		QVector<quint8> states;
+		QString header;
+		int precision;
+	};
+
+	QVector<Column> columns;
+	QVector<quint8> checks;
+	QVector<quint8> results;
+	QHash<quint64, QString> texts;	// CELL_TEXT entries keyed by textKey()
+	QHash<int, QString> rowErrors;	// cleared whenever rows are added or removed
+	int rows;
+	int minimumNumCols;
+	int checkColumn;
+	int resultColumn;
+	bool checkable;
+	int bulkDepth;		// > 0 while notifications are deferred to a reset
+
+	void storeText(int row, int column, const QString &text);
+	void shiftTexts(int row, int delta);
+	void resizeRows(int numRows);
+	void cellChanged(int row, int column, int role = Qt::DisplayRole);
+};
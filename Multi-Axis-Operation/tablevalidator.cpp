@@ -0,0 +1,525 @@
+#include "stdafx.h"
+#include "tablevalidator.h"
+#include "conversions.h"
+#include <QtConcurrent>
+
+//---------------------------------------------------------------------------
+bool ValidationContext::sameConversion(const ValidationContext &other) const
+{
+	return cartesian == other.cartesian && normal == other.normal && reference == other.reference;
+}
+
+//---------------------------------------------------------------------------
+bool ValidationContext::sameLimits(const ValidationContext &other) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (axes[i].activate != other.axes[i].activate || axes[i].coilConst != other.axes[i].coilConst ||
+			axes[i].currentLimit != other.axes[i].currentLimit)
+			return false;
+	}
+
+	return magnitudeLimit == other.magnitudeLimit;
+}
+
+//---------------------------------------------------------------------------
+bool ValidationContext::sameRampRates(const ValidationContext &other) const
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (axes[i].activate != other.axes[i].activate || axes[i].coilConst != other.axes[i].coilConst ||
+			axes[i].maxRampRate != other.axes[i].maxRampRate)
+			return false;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+TableValidator::TableValidator(TableModel *model, TableKind kind, const QString &rowLabel, QObject *parent)
+	: QObject(parent)
+{
+	this->model = model;
+	tableKind = kind;
+	label = rowLabel;
+	numCoords = (kind == VECTOR_ROWS) ? 3 : 2;
+	job = nullptr;
+	running = false;
+	pending = false;
+	generation = 0;
+
+	resetCache();
+
+	connect(model, &QAbstractItemModel::dataChanged, this, &TableValidator::modelDataChanged);
+	connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(modelLayoutChanged()));
+	connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(modelLayoutChanged()));
+	connect(model, SIGNAL(modelReset()), this, SLOT(modelLayoutChanged()));
+	connect(&watcher, SIGNAL(finished()), this, SLOT(jobFinished()));
+}
+
+//---------------------------------------------------------------------------
+TableValidator::~TableValidator()
+{
+	watcher.waitForFinished();
+	delete job;
+}
+
+//---------------------------------------------------------------------------
+// Empties the cache after rows are added or removed, everything is
+// revalidated and every row's highlight refreshed.
+void TableValidator::resetCache(void)
+{
+	int rows = model->rowCount();
+
+	keys.fill(0, rows);
+	vectors.fill(RowVector(), rows);
+	conversionErrors.fill(NO_VECTOR_ERROR, rows);
+	errors.fill(NO_VECTOR_ERROR, rows);
+	rampTimes.fill(0, rows);
+	isDirty.fill(false, rows);
+	dirtyRows.clear();
+	convertAll = checkAll = rampAll = true;
+	refreshAll = true;
+}
+
+//---------------------------------------------------------------------------
+// Revalidates whatever depends on the parts of context that changed
+void TableValidator::setContext(const ValidationContext &newContext)
+{
+	if (!newContext.sameConversion(context))
+		convertAll = true;
+
+	if (!newContext.sameLimits(context))
+		checkAll = true;
+
+	if (!newContext.sameRampRates(context))
+		rampAll = true;
+
+	context = newContext;
+
+	if (convertAll || checkAll || rampAll)
+		schedule();
+}
+
+//---------------------------------------------------------------------------
+void TableValidator::modelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+	// highlighting changes come from here, not from edits
+	if (!roles.isEmpty() && !roles.contains(Qt::DisplayRole) && !roles.contains(Qt::EditRole) && !roles.contains(Qt::CheckStateRole))
+		return;
+
+	// only the coordinates affect validity; hold times and switch
+	// transitions are read from the model when times are summed
+	if (topLeft.column() < numCoords && !convertAll)
+	{
+		int first = topLeft.row();
+		int last = qMin(bottomRight.row(), isDirty.count() - 1);
+
+		if (last - first + 1 > isDirty.count() / 2)
+		{
+			convertAll = true;
+		}
+		else
+		{
+			for (int i = first; i <= last; i++)
+			{
+				if (!isDirty[i])
+				{
+					isDirty[i] = true;
+					dirtyRows.append(i);
+				}
+			}
+		}
+	}
+
+	schedule();
+}
+
+//---------------------------------------------------------------------------
+void TableValidator::modelLayoutChanged(void)
+{
+	generation++;
+	resetCache();
+	schedule();
+}
+
+//---------------------------------------------------------------------------
+void TableValidator::schedule(void)
+{
+	if (running)
+		pending = true;
+	else
+		startJob();
+}
+
+//---------------------------------------------------------------------------
+// Hands the dirty rows and a copy of the cache to a worker thread
+void TableValidator::startJob(void)
+{
+	job = new Job;
+	job->context = context;
+	job->generation = generation;
+	model->getContents(&job->contents);
+	job->rows = dirtyRows;
+	job->convertAll = convertAll;
+	job->checkAll = checkAll;
+	job->rampAll = rampAll;
+	job->refreshAll = refreshAll;
+	job->keys = keys;
+	job->vectors = vectors;
+	job->conversionErrors = conversionErrors;
+	job->errors = errors;
+	job->rampTimes = rampTimes;
+
+	for (int i = 0; i < dirtyRows.count(); i++)
+		isDirty[dirtyRows[i]] = false;
+
+	dirtyRows.clear();
+	convertAll = checkAll = rampAll = refreshAll = false;
+	pending = false;
+	running = true;
+
+	Job *work = job;
+	TableKind kind = tableKind;
+	int coords = numCoords;
+
+	watcher.setFuture(QtConcurrent::run([work, kind, coords]() { validateRows(work, kind, coords); }));
+}
+
+//---------------------------------------------------------------------------
+// Takes the results of a finished job, returns false if there was none.
+// Results for a table that has since gained or lost rows are dropped,
+// the reset already queued a full revalidation.
+bool TableValidator::applyJob(void)
+{
+	if (job == nullptr || watcher.isRunning())
+		return false;
+
+	Job *done = job;
+
+	job = nullptr;
+	running = false;
+
+	if (done->generation == generation)
+	{
+		keys.swap(done->keys);
+		vectors.swap(done->vectors);
+		conversionErrors.swap(done->conversionErrors);
+		errors.swap(done->errors);
+		rampTimes.swap(done->rampTimes);
+
+		// done->errors now holds the previous results
+		for (int i = 0; i < errors.count(); i++)
+		{
+			if (done->refreshAll || errors[i] != done->errors[i])
+				model->setRowError(i, errorMessage(i));
+		}
+	}
+
+	delete done;
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+void TableValidator::jobFinished(void)
+{
+	if (!applyJob())
+		return;
+
+	if (pending || !dirtyRows.isEmpty() || convertAll || checkAll || rampAll)
+		startJob();
+	else
+		emit validated();
+}
+
+//---------------------------------------------------------------------------
+// Brings the cache up to date before returning, for callers that need
+// results now rather than on validated()
+void TableValidator::waitForCurrent(void)
+{
+	while (!isCurrent())
+	{
+		if (running)
+		{
+			watcher.waitForFinished();
+			applyJob();
+		}
+		else
+		{
+			startJob();
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// Worker thread: converts the changed rows, then checks limits and ramping
+// times of those rows and of any row whose inputs changed with them.
+void TableValidator::validateRows(Job *job, TableKind kind, int numCoords)
+{
+	int rows = job->contents.rows;
+	QVector<quint8> changed(rows, false);
+
+	// sizes follow the model if a job was started before a reset arrived
+	job->keys.resize(rows);
+	job->vectors.resize(rows);
+	job->conversionErrors.resize(rows);
+	job->errors.resize(rows);
+	job->rampTimes.resize(rows);
+
+	// conversion to magnet axes
+	int count = job->convertAll ? rows : job->rows.count();
+
+	for (int i = 0; i < count; i++)
+	{
+		int row = job->convertAll ? i : job->rows[i];
+
+		if (row >= rows)
+			continue;
+
+		quint64 key = rowKey(job->contents, row, numCoords);
+
+		if (!job->convertAll && key == job->keys[row])
+			continue;	// same coordinates as last time
+
+		job->keys[row] = key;
+		job->conversionErrors[row] = convertRow(job->context, kind, job->contents, row, &job->vectors[row]);
+		changed[row] = true;
+	}
+
+	// limits and ramping times
+	for (int i = 0; i < rows; i++)
+	{
+		if (job->checkAll || changed[i])
+		{
+			if (job->conversionErrors[i] != NO_VECTOR_ERROR)
+				job->errors[i] = job->conversionErrors[i];
+			else
+				job->errors[i] = checkLimits(job->context, job->vectors[i]);
+		}
+
+		if (i > 0 && (job->rampAll || changed[i] || changed[i - 1]))
+		{
+			const RowVector &from = job->vectors[i - 1];
+			const RowVector &to = job->vectors[i];
+
+			job->rampTimes[i] = rampTime(job->context, from.x, from.y, from.z, to.x, to.y, to.z);
+		}
+	}
+
+	// release the snapshot before the GUI thread edits the model again
+	job->contents = TableContents();
+}
+
+//---------------------------------------------------------------------------
+quint64 TableValidator::rowKey(const TableContents &contents, int row, int numCoords)
+{
+	double values[3] = { 0.0, 0.0, 0.0 };
+	quint8 states[3] = { CELL_EMPTY, CELL_EMPTY, CELL_EMPTY };
+
+	for (int i = 0; i < numCoords && i < contents.values.count(); i++)
+	{
+		values[i] = contents.values[i][row];
+		states[i] = contents.states[i][row];
+	}
+
+	return (static_cast<quint64>(qHashBits(values, sizeof(values))) << 32) ^ qHashBits(states, sizeof(states), 0x9e3779b9);
+}
+
+//---------------------------------------------------------------------------
+// Converts a row the way goToVector() and goToPolarVector() do
+VectorError TableValidator::convertRow(const ValidationContext &context, TableKind kind, const TableContents &contents, int row, RowVector *vector)
+{
+	int numCoords = (kind == VECTOR_ROWS) ? 3 : 2;
+	double coords[3];
+	bool numeric = true;
+
+	*vector = RowVector();
+
+	for (int i = 0; i < numCoords; i++)
+	{
+		if (i < contents.values.count() && contents.states[i][row] == CELL_VALUE)
+			coords[i] = contents.values[i][row];
+		else
+			numeric = false;
+	}
+
+	if (kind == POLAR_ROWS)
+	{
+		// a negative magnitude is reported ahead of a non-numerical angle
+		if (contents.values.count() && contents.states[0][row] == CELL_VALUE && coords[0] < 0.0)
+			return NEGATIVE_MAGNITUDE;
+
+		if (!numeric)
+			return NON_NUMERICAL_ENTRY;
+
+		QVector3D conversion;
+
+		rotateInPlane(coords[0], coords[1], context.normal, context.reference, &conversion);
+		vector->x = conversion.x();
+		vector->y = conversion.y();
+		vector->z = conversion.z();
+	}
+	else
+	{
+		if (!numeric)
+			return NON_NUMERICAL_ENTRY;
+
+		if (context.cartesian)
+		{
+			vector->x = coords[0];
+			vector->y = coords[1];
+			vector->z = coords[2];
+		}
+		else
+		{
+			if (coords[0] < 0.0)	// magnitude cannot be negative
+				return NEGATIVE_MAGNITUDE;
+
+			if (coords[2] < 0.0 || coords[2] > 180.0)	// angle from Z-axis must be >= 0 and <= 180 degrees
+				return INCLINATION_OUT_OF_RANGE;
+
+			sphericalToCartesian(coords[0], coords[1], coords[2], &vector->x, &vector->y, &vector->z);
+		}
+	}
+
+	return NO_VECTOR_ERROR;
+}
+
+//---------------------------------------------------------------------------
+// Same checks, in the same order, as MultiAxisOperation::checkNextVector()
+VectorError TableValidator::checkLimits(const ValidationContext &context, const RowVector &vector)
+{
+	const double components[3] = { vector.x, vector.y, vector.z };
+	const VectorError exceeds[3] = { EXCEEDS_X_RANGE, EXCEEDS_Y_RANGE, EXCEEDS_Z_RANGE };
+	const VectorError inactive[3] = { INACTIVE_X_AXIS, INACTIVE_Y_AXIS, INACTIVE_Z_AXIS };
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (context.axes[i].activate)
+		{
+			if (fabs(components[i] / context.axes[i].coilConst) > context.axes[i].currentLimit)
+				return exceeds[i];
+		}
+		else if (fabs(components[i]) > 1e-12)
+		{
+			return inactive[i];
+		}
+	}
+
+	if (sqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z) > context.magnitudeLimit)
+		return EXCEEDS_MAGNITUDE_LIMIT;
+
+	return NO_VECTOR_ERROR;
+}
+
+//---------------------------------------------------------------------------
+// Ramping time in seconds as MultiAxisOperation::calculateRampingTime()
+// finds it: the slowest active axis sets the pace.
+int TableValidator::rampTime(const ValidationContext &context, double fromX, double fromY, double fromZ, double x, double y, double z)
+{
+	const double deltas[3] = { fabs(fromX - x), fabs(fromY - y), fabs(fromZ - z) };
+	double longest = 0.0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (context.axes[i].activate)
+			longest = qMax(longest, deltas[i] / (context.axes[i].maxRampRate * context.axes[i].coilConst));
+	}
+
+	return static_cast<int>(round(longest));
+}
+
+//---------------------------------------------------------------------------
+VectorError TableValidator::rowError(int row) const
+{
+	if (row >= 0 && row < errors.count())
+		return static_cast<VectorError>(errors[row]);
+	else
+		return NON_NUMERICAL_ENTRY;
+}
+
+//---------------------------------------------------------------------------
+// Returns the first row from first to last - 1 that fails, or -1
+int TableValidator::firstError(int first, int last) const
+{
+	first = qMax(first, 0);
+	last = qMin(last, errors.count());
+
+	for (int i = first; i < last; i++)
+	{
+		if (errors[i] != NO_VECTOR_ERROR)
+			return i;
+	}
+
+	return -1;
+}
+
+//---------------------------------------------------------------------------
+// The annunciation goToVector() or checkNextVector() would show for a row
+QString TableValidator::errorMessage(int row) const
+{
+	QString rowLabel = label + QString::number(row + 1);
+
+	switch (rowError(row))
+	{
+	case NON_NUMERICAL_ENTRY:
+		return rowLabel + " has non-numerical entry";
+
+	case NEGATIVE_MAGNITUDE:
+		return rowLabel + " : Magnitude of vector cannot be a negative value";
+
+	case INCLINATION_OUT_OF_RANGE:
+		return rowLabel + " : Angle from Z-axis must be from 0 to 180 degrees";
+
+	case EXCEEDS_X_RANGE:
+		return rowLabel + " exceeds X-axis Current Limit!";
+
+	case INACTIVE_X_AXIS:
+		return rowLabel + " requires an active X-axis field component!";
+
+	case EXCEEDS_Y_RANGE:
+		return rowLabel + " exceeds Y-axis Current Limit!";
+
+	case INACTIVE_Y_AXIS:
+		return rowLabel + " requires an active Y-axis field component!";
+
+	case EXCEEDS_Z_RANGE:
+		return rowLabel + " exceeds Z-axis Current Limit!";
+
+	case INACTIVE_Z_AXIS:
+		return rowLabel + " requires an active Z-axis field component!";
+
+	case EXCEEDS_MAGNITUDE_LIMIT:
+		return rowLabel + " exceeds Magnitude Limit of Magnet!";
+
+	default:
+		return QString();
+	}
+}
+
+//---------------------------------------------------------------------------
+void TableValidator::vector(int row, double *x, double *y, double *z) const
+{
+	if (row >= 0 && row < vectors.count())
+	{
+		*x = vectors[row].x;
+		*y = vectors[row].y;
+		*z = vectors[row].z;
+	}
+	else
+	{
+		*x = *y = *z = 0.0;
+	}
+}
+
+//---------------------------------------------------------------------------
+int TableValidator::rampTime(int row) const
+{
+	if (row > 0 && row < rampTimes.count())
+		return rampTimes[row];
+	else
+		return 0;
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QQuaternion>
+#include <QVector3D>
+#include "tablemodel.h"
+
+enum VectorError
+{
+	NO_VECTOR_ERROR = 0,		// no error
+
+	NON_NUMERICAL_ENTRY,		// non-numerical parameter
+	EXCEEDS_MAGNITUDE_LIMIT,	// vector magnitude exceeds magnet limit
+	NEGATIVE_MAGNITUDE,			// magnitude cannot be negative
+	INCLINATION_OUT_OF_RANGE,	// inclination angle must be >=0 and <= 180
+	EXCEEDS_X_RANGE,			// vector exceeds x-axis current limit
+	INACTIVE_X_AXIS,			// vector requires x-axis field component which is inactive
+	EXCEEDS_Y_RANGE,			// vector exceeds y-axis current limit
+	INACTIVE_Y_AXIS,			// vector requires y-axis field component which is inactive
+	EXCEEDS_Z_RANGE,			// vector exceeds z-axis current limit
+	INACTIVE_Z_AXIS				// vector requires z-axis field component which is inactive
+};
+
+struct AxisLimits
+{
+	bool activate = false;
+	double coilConst = 1.0;
+	double currentLimit = 0.0;
+	double maxRampRate = 0.0;
+};
+
+//---------------------------------------------------------------------------
+// Everything a row's validity and ramping time depend on besides the row
+// itself. The parts are compared separately so a change only revalidates
+// what depends on it.
+//---------------------------------------------------------------------------
+struct ValidationContext
+{
+	// conversion of a row to magnet axes
+	bool cartesian = false;		// vector table coordinates
+	QVector3D normal;			// polar table alignment plane normal
+	QQuaternion reference;		// polar table alignment vector #1
+
+	// limits the converted vector is checked against
+	AxisLimits axes[3];
+	double magnitudeLimit = 0.0;
+
+	bool sameConversion(const ValidationContext &other) const;
+	bool sameLimits(const ValidationContext &other) const;
+	bool sameRampRates(const ValidationContext &other) const;
+};
+
+//---------------------------------------------------------------------------
+// Caches the magnet axes vector, validity and ramping time of each vector
+// or polar table row. Edited rows are marked dirty and revalidated on a
+// worker thread; a row whose coordinates hash the same as when it was last
+// converted is not converted again. Rows that fail are highlighted in the
+// model with the error as their tool tip. validated() is emitted once the
+// cache is current again.
+//---------------------------------------------------------------------------
+class TableValidator : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum TableKind
+	{
+		VECTOR_ROWS = 0,	// x, y, z or magnitude, azimuth, inclination
+		POLAR_ROWS			// magnitude, angle in the alignment plane
+	};
+
+	TableValidator(TableModel *model, TableKind kind, const QString &rowLabel, QObject *parent = Q_NULLPTR);
+	~TableValidator();
+
+	void setContext(const ValidationContext &context);
+	bool isCurrent(void) const { return !running && !pending && dirtyRows.isEmpty() && !convertAll && !checkAll && !rampAll; }
+	void waitForCurrent(void);
+
+	// valid while isCurrent()
+	VectorError rowError(int row) const;
+	int firstError(int first, int last) const;
+	QString errorMessage(int row) const;
+	void vector(int row, double *x, double *y, double *z) const;
+	int rampTime(int row) const;	// from the previous row
+	static int rampTime(const ValidationContext &context, double fromX, double fromY, double fromZ, double x, double y, double z);
+
+signals:
+	void validated(void);
+
+private slots:
+	void modelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+	void modelLayoutChanged(void);
+	void jobFinished(void);
+
+private:
+	struct RowVector
+	{
+		double x, y, z;
+	};
+
+	struct Job
+	{
+		ValidationContext context;
+		int generation;
+		TableContents contents;		// implicitly shared snapshot of the model
+		QVector<int> rows;			// rows whose coordinates changed
+		bool convertAll;
+		bool checkAll;
+		bool rampAll;
+		bool refreshAll;
+
+		// cache, updated in place and swapped back on completion
+		QVector<quint64> keys;
+		QVector<RowVector> vectors;
+		QVector<quint8> conversionErrors;
+		QVector<quint8> errors;
+		QVector<int> rampTimes;
+	};
+
+	TableModel *model;
+	TableKind tableKind;
+	QString label;
+	int numCoords;
+	QFutureWatcher<void> watcher;
+	Job *job;
+	bool running;
+	bool pending;		// changes arrived while a job was running
+	int generation;		// incremented when rows are added or removed
+
+	ValidationContext context;
+	bool convertAll;	// conversion changed, every row is dirty
+	bool checkAll;		// limits changed
+	bool rampAll;		// ramp rates changed
+	bool refreshAll;	// every row's highlight needs setting
+	QVector<int> dirtyRows;
+	QVector<quint8> isDirty;
+
+	QVector<quint64> keys;
+	QVector<RowVector> vectors;
+	QVector<quint8> conversionErrors;
+	QVector<quint8> errors;
+	QVector<int> rampTimes;
+
+	void resetCache(void);
+	void schedule(void);
+	void startJob(void);
+	bool applyJob(void);
+	static void validateRows(Job *job, TableKind kind, int numCoords);
+	static quint64 rowKey(const TableContents &contents, int row, int numCoords);
+	static VectorError convertRow(const ValidationContext &context, TableKind kind, const TableContents &contents, int row, RowVector *vector);
+	static VectorError checkLimits(const ValidationContext &context, const RowVector &vector);
+};
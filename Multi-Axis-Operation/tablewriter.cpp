@@ -0,0 +1,186 @@
+#include "stdafx.h"
+#include "tablewriter.h"
+#include <QtConcurrent>
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+const int BUFFER_SIZE = 1 << 20;	// bytes formatted between writes
+
+//---------------------------------------------------------------------------
+// Appends a value formatted as QString::number(value, 'g', precision)
+// would, without the intermediate string.
+//---------------------------------------------------------------------------
+static void appendNumber(QByteArray &buffer, double value, int precision)
+{
+#if defined(__cpp_lib_to_chars)
+	char digits[32];
+	std::to_chars_result result;
+
+	if (precision == QLocale::FloatingPointShortest)
+		result = std::to_chars(digits, digits + sizeof(digits), value);
+	else
+		result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, precision);
+
+	buffer.append(digits, static_cast<int>(result.ptr - digits));
+#else
+	buffer.append(QByteArray::number(value, 'g', precision));
+#endif
+}
+
+//---------------------------------------------------------------------------
+// Appends text with any hard line feeds stripped
+//---------------------------------------------------------------------------
+static void appendText(QByteArray &buffer, const QString &text)
+{
+	QByteArray utf8 = text.toUtf8();
+
+	utf8.replace('\n', "");
+	buffer.append(utf8);
+}
+
+//---------------------------------------------------------------------------
+TableWriter::TableWriter(QObject *parent)
+	: QObject(parent)
+{
+	binary = false;
+
+	connect(&watcher, SIGNAL(finished()), this, SIGNAL(finished()));
+}
+
+//---------------------------------------------------------------------------
+TableWriter::~TableWriter()
+{
+	watcher.waitForFinished();
+}
+
+//---------------------------------------------------------------------------
+// Takes a snapshot of the model and saves it in the background, the model
+// may be edited while the save runs. An optional first line is written
+// ahead of the header (e.g. the vector table coordinate system).
+void TableWriter::start(const QString &filename, const TableModel *model, const QString &firstLine)
+{
+	if (watcher.isRunning())
+		return;
+
+	binary = false;
+	preamble = firstLine;
+	startWrite(filename, model);
+}
+
+//---------------------------------------------------------------------------
+// Saves in the binary table format, info describes the table
+void TableWriter::start(const QString &filename, const TableModel *model, const TableFileInfo &info)
+{
+	if (watcher.isRunning())
+		return;
+
+	binary = true;
+	binaryInfo = info;
+	startWrite(filename, model);
+}
+
+//---------------------------------------------------------------------------
+void TableWriter::startWrite(const QString &filename, const TableModel *model)
+{
+	outputFileName = filename;
+	error.clear();
+	model->getContents(&contents);
+
+	watcher.setFuture(QtConcurrent::run([this]() { write(); }));
+}
+
+//---------------------------------------------------------------------------
+void TableWriter::write(void)
+{
+	QSaveFile file(outputFileName);
+
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		error = "Unable to save " + QDir::toNativeSeparators(outputFileName) + ": " + file.errorString();
+		contents = TableContents();
+		return;
+	}
+
+	bool ok;
+
+	if (binary)
+		ok = BinaryTable::write(&file, contents, binaryInfo);
+	else
+		ok = writeText(&file);
+
+	// the previous file is only replaced once everything is written
+	if (!ok || !file.commit())
+	{
+		error = "Unable to save " + QDir::toNativeSeparators(outputFileName) + ": " + file.errorString();
+		file.cancelWriting();
+	}
+
+	contents = TableContents();
+}
+
+//---------------------------------------------------------------------------
+bool TableWriter::writeText(QSaveFile *file)
+{
+	QByteArray buffer;
+	int numColumns = contents.values.count();
+
+	buffer.reserve(BUFFER_SIZE + 4096);
+
+	if (!preamble.isEmpty())
+	{
+		appendText(buffer, preamble);
+		buffer.append('\n');
+	}
+
+	// output horizontal header titles
+	for (int i = 0; i < numColumns; i++)
+	{
+		if (i > 0)
+			buffer.append(',');
+
+		appendText(buffer, contents.headers.value(i));
+	}
+	buffer.append('\n');
+
+	// output table data
+	for (int i = 0; i < contents.rows; i++)
+	{
+		if (i > 0)
+			buffer.append('\n');
+
+		for (int j = 0; j < numColumns; j++)
+		{
+			if (j > 0)
+				buffer.append(',');
+
+			if (j == contents.resultColumn)
+			{
+				if (contents.results[i] == RESULT_PASS)
+					buffer.append("Pass");
+				else if (contents.results[i] == RESULT_FAIL)
+					buffer.append("Fail");
+			}
+			else if (contents.states[j][i] == CELL_VALUE)
+			{
+				appendNumber(buffer, contents.values[j][i], contents.precisions[j]);
+			}
+			else if (contents.states[j][i] == CELL_TEXT)
+			{
+				appendText(buffer, contents.texts.value(TableModel::textKey(i, j)));
+			}
+		}
+
+		if (buffer.size() >= BUFFER_SIZE)
+		{
+			if (file->write(buffer) != buffer.size())
+				return false;
+
+			buffer.resize(0);
+		}
+	}
+
+	return file->write(buffer) == buffer.size();
+}
+
+//---------------------------------------------------------------------------
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QSaveFile>
+#include "binarytable.h"
+
+//---------------------------------------------------------------------------
+// Saves a vector or polar table on a worker thread. A snapshot of the
+// model is formatted into a buffer, numbers in shortest round-trip form,
+// and written through QSaveFile so an interrupted save leaves any previous
+// file untouched. Tables may also be saved in the BinaryTable format.
+//---------------------------------------------------------------------------
+class TableWriter : public QObject
+{
+	Q_OBJECT
+
+public:
+	TableWriter(QObject *parent = Q_NULLPTR);
+	~TableWriter();
+
+	bool isRunning(void) { return watcher.isRunning(); }
+	void start(const QString &filename, const TableModel *model, const QString &firstLine = QString());
+	void start(const QString &filename, const TableModel *model, const TableFileInfo &info);
+	QString fileName(void) { return outputFileName; }
+	QString errorString(void) { return error; }
+
+signals:
+	void finished(void);
+
+private:
+	QFutureWatcher<void> watcher;
+	QString outputFileName;
+	QString preamble;
+	bool binary;
+	TableFileInfo binaryInfo;
+	TableContents contents;
+	QString error;
+
+	void startWrite(const QString &filename, const TableModel *model);
+	void write(void);
+	bool writeText(QSaveFile *file);
+};
@@ -0,0 +1,13 @@
+# ----------------------------------------------------
+# acqlog2csv: converts Multi-Axis Operation binary
+# acquisition logs (*.maxlog) to CSV
+# ------------------------------------------------------
+
+TEMPLATE = app
+TARGET = acqlog2csv
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += ../..
+HEADERS += ../../acquisitionlogformat.h
+SOURCES += main.cpp
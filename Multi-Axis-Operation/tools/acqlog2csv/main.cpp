@@ -0,0 +1,202 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <climits>
+#include "acquisitionlogformat.h"
+
+//---------------------------------------------------------------------------
+// Converts a range of a Multi-Axis Operation binary acquisition log to CSV.
+// The log is read through a read-only memory map, so multi-day logs are
+// converted without loading them into memory. Logs that were not closed
+// cleanly (e.g. after a crash) are read up to the last complete record.
+//---------------------------------------------------------------------------
+
+static const char *recordTypeStr(quint16 type)
+{
+	switch (type)
+	{
+		case ACQ_RECORD_SAMPLE:
+			return "SAMPLE";
+		case ACQ_RECORD_TRANSITION:
+			return "TRANSITION";
+		case ACQ_RECORD_QUENCH:
+			return "QUENCH";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+//---------------------------------------------------------------------------
+static bool parseTime(QString str, qint64 *msec)
+{
+	QDateTime time = QDateTime::fromString(str, Qt::ISODateWithMs);
+
+	if (!time.isValid())
+		time = QDateTime::fromString(str, Qt::ISODate);
+
+	if (!time.isValid())
+		return false;
+
+	*msec = time.toMSecsSinceEpoch();
+	return true;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("acqlog2csv");
+
+	QCommandLineParser cmdLineParse;
+	cmdLineParse.setApplicationDescription("Converts a Multi-Axis Operation binary acquisition log (*.maxlog) to CSV.");
+	cmdLineParse.addHelpOption();
+	cmdLineParse.addPositionalArgument("log", "Binary acquisition log file.");
+	cmdLineParse.addPositionalArgument("csv", "Output CSV file (default is stdout).", "[csv]");
+
+	QCommandLineOption fromOption(QStringList() << "f" << "from", "First time to include, ISO 8601 local time.", "time");
+	cmdLineParse.addOption(fromOption);
+	QCommandLineOption toOption(QStringList() << "t" << "to", "Last time to include, ISO 8601 local time.", "time");
+	cmdLineParse.addOption(toOption);
+	QCommandLineOption eventsOption(QStringList() << "e" << "events", "Output state transition and quench records only.");
+	cmdLineParse.addOption(eventsOption);
+
+	cmdLineParse.process(app);
+
+	QStringList args = cmdLineParse.positionalArguments();
+	QTextStream err(stderr);
+
+	if (args.isEmpty())
+		cmdLineParse.showHelp(1);
+
+	qint64 fromTime = LLONG_MIN, toTime = LLONG_MAX;
+
+	if (cmdLineParse.isSet(fromOption) && !parseTime(cmdLineParse.value(fromOption), &fromTime))
+	{
+		err << "Invalid --from time: " << cmdLineParse.value(fromOption) << Qt::endl;
+		return 1;
+	}
+
+	if (cmdLineParse.isSet(toOption) && !parseTime(cmdLineParse.value(toOption), &toTime))
+	{
+		err << "Invalid --to time: " << cmdLineParse.value(toOption) << Qt::endl;
+		return 1;
+	}
+
+	// map the log
+	QFile logFile(args[0]);
+
+	if (!logFile.open(QIODevice::ReadOnly))
+	{
+		err << "Unable to open " << args[0] << Qt::endl;
+		return 1;
+	}
+
+	qint64 fileSize = logFile.size();
+	const uchar *data = (fileSize >= (qint64)sizeof(AcqLogHeader)) ? logFile.map(0, fileSize) : nullptr;
+
+	if (data == nullptr)
+	{
+		err << "Unable to read " << args[0] << Qt::endl;
+		return 1;
+	}
+
+	AcqLogHeader header;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, ACQ_LOG_MAGIC, sizeof(header.magic)) != 0)
+	{
+		err << args[0] << " is not an acquisition log" << Qt::endl;
+		return 1;
+	}
+
+	if (header.version > ACQ_LOG_VERSION || header.recordSize < sizeof(AcqLogRecord) || header.headerSize < sizeof(AcqLogHeader))
+	{
+		err << "Unsupported acquisition log version " << header.version << Qt::endl;
+		return 1;
+	}
+
+	quint64 available = (quint64)(fileSize - header.headerSize) / header.recordSize;
+
+	if (header.cleanClose && header.recordCount < available)
+		available = header.recordCount;
+
+	// open output
+	QFile csvFile;
+
+	if (args.count() > 1)
+	{
+		csvFile.setFileName(args[1]);
+
+		if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+		{
+			err << "Unable to create " << args[1] << Qt::endl;
+			return 1;
+		}
+	}
+	else
+	{
+		csvFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+	}
+
+	QTextStream out(&csvFile);
+	QString units = (header.fieldUnits == 1) ? "T" : "kG";
+
+	out << "Time,Type,Sequence,"
+		<< "X Field (" << units << "),Y Field (" << units << "),Z Field (" << units << "),"
+		<< "X Current (A),Y Current (A),Z Current (A),"
+		<< "X Target (" << units << "),Y Target (" << units << "),Z Target (" << units << "),"
+		<< "Polar Magnitude (" << units << "),Polar Angle (deg),"
+		<< "X State,Y State,Z State,Switches,System State\n";
+
+	quint64 written = 0;
+
+	for (quint64 i = 0; i < available; i++)
+	{
+		AcqLogRecord record;
+		memcpy(&record, data + header.headerSize + i * header.recordSize, sizeof(record));
+
+		// end of valid data in a log that was not closed cleanly
+		if (record.type == ACQ_RECORD_EMPTY || record.sequence != (quint32)i)
+			break;
+
+		qint64 msec = header.startTime + record.timestamp;
+
+		if (msec < fromTime)
+			continue;
+		if (msec > toTime)
+			break;
+		if (cmdLineParse.isSet(eventsOption) && record.type == ACQ_RECORD_SAMPLE)
+			continue;
+
+		out << QDateTime::fromMSecsSinceEpoch(msec).toString("yyyy-MM-dd hh:mm:ss.zzz") << ","
+			<< recordTypeStr(record.type) << ","
+			<< record.sequence;
+
+		for (int j = 0; j < 3; j++)
+			out << "," << QString::number(record.field[j], 'g', 7);
+		for (int j = 0; j < 3; j++)
+			out << "," << QString::number(record.current[j], 'g', 7);
+		for (int j = 0; j < 3; j++)
+			out << "," << QString::number(record.target[j], 'g', 7);
+
+		out << "," << QString::number(record.polarMagnitude, 'g', 7)
+			<< "," << QString::number(record.polarAngle, 'g', 7);
+
+		for (int j = 0; j < 3; j++)
+			out << "," << (int)record.state[j];
+
+		out << "," << record.switches << "," << (int)record.systemState << "\n";
+		written++;
+	}
+
+	out.flush();
+
+	if (!header.cleanClose)
+		err << "Log was not closed cleanly, read up to the last complete record" << Qt::endl;
+
+	err << written << " records written" << Qt::endl;
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QBuffer>
+#include "header/xlsxdocument.h"
+#include "header/xlsxworksheet.h"
+
+using namespace QXlsx;
+
+//---------------------------------------------------------------------------
+// Benchmark of saving a workbook of several streamed sheets, like a report
+// with one sheet of appended rows per table. The same workbook is saved
+// stored (the autosave setting), deflated one part after another, and
+// deflated on the thread pool, and the time and package size of each are
+// reported. Every package is loaded back and the last row of the last
+// sheet checked, so a setting that writes a broken package fails the run.
+//---------------------------------------------------------------------------
+
+struct BenchSetting
+{
+	const char *name;
+	int level;			// Document::setCompressionLevel()
+	bool concurrent;	// Document::setConcurrentCompression()
+};
+
+static const BenchSetting benchSettings[] =
+{
+	{ "stored", 0, false },
+	{ "deflate", -1, false },
+	{ "deflate-concurrent", -1, true },
+	{ "fastest-concurrent", 1, true }
+};
+
+//---------------------------------------------------------------------------
+// Row laid out like a report row: table columns, times, exit code, output
+//---------------------------------------------------------------------------
+static QList<QVariant> rowValues(int row)
+{
+	QList<QVariant> values;
+	QString time = QString("2026-10-19 12:%1:%2").arg((row / 60) % 60, 2, 10, QChar('0')).arg(row % 60, 2, 10, QChar('0'));
+
+	for (int j = 1; j <= 8; j++)
+		values.append(row * 0.001 * j);
+
+	values.append(time);
+	values.append(time);
+	values.append(row % 3);
+	values.append(QString("row %1").arg(row));
+
+	return values;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("packagebench");
+
+	QCommandLineParser cmdLineParse;
+	cmdLineParse.setApplicationDescription("Times saving a multi-sheet workbook of streamed rows at each compression setting.");
+	cmdLineParse.addHelpOption();
+
+	QCommandLineOption sheetsOption(QStringList() << "s" << "sheets", "Streamed sheets in the workbook (default 4).", "count", "4");
+	cmdLineParse.addOption(sheetsOption);
+	QCommandLineOption rowsOption(QStringList() << "r" << "rows", "Rows in each sheet (default 20000).", "count", "20000");
+	cmdLineParse.addOption(rowsOption);
+
+	cmdLineParse.process(app);
+
+	QTextStream out(stdout);
+	int sheets = cmdLineParse.value(sheetsOption).toInt();
+	int rows = cmdLineParse.value(rowsOption).toInt();
+
+	if (sheets <= 0)
+		sheets = 4;
+	if (rows <= 0)
+		rows = 20000;
+
+	Document xlsx;
+	Format alignRightFormat;
+	QList<Format> formats;
+	alignRightFormat.setHorizontalAlignment(Format::AlignRight);
+
+	for (int j = 0; j < 12; j++)
+		formats.append(alignRightFormat);
+
+	xlsx.deleteSheet("Sheet1");
+
+	for (int i = 1; i <= sheets; i++)
+	{
+		xlsx.addSheet(QString("Results %1").arg(i));
+
+		for (int j = 1; j <= rows; j++)
+			xlsx.currentWorksheet()->appendRow(rowValues(j), formats);
+	}
+
+	const int numSettings = sizeof(benchSettings) / sizeof(benchSettings[0]);
+	const QString lastSheet = QString("Results %1").arg(sheets);
+	const QVariant lastValue = rowValues(rows).last();
+	int failures = 0;
+	QElapsedTimer timer;
+
+	out << "Setting,msec,bytes\n";
+
+	for (int i = 0; i < numSettings; i++)
+	{
+		const BenchSetting &setting = benchSettings[i];
+		QBuffer package;
+
+		xlsx.setCompressionLevel(setting.level);
+		xlsx.setConcurrentCompression(setting.concurrent);
+
+		package.open(QIODevice::WriteOnly);
+		timer.start();
+		bool saved = xlsx.saveAs(&package);
+		qint64 nsec = timer.nsecsElapsed();
+		package.close();
+
+		package.open(QIODevice::ReadOnly);
+		Document loaded(&package);
+
+		if (!saved || !loaded.load() || !loaded.selectSheet(lastSheet) || loaded.read(rows, 12) != lastValue)
+		{
+			out << setting.name << ",FAILED\n";
+			failures++;
+			continue;
+		}
+
+		out << setting.name << "," << QString::number(nsec / 1.0e6, 'f', 1) << "," << package.size() << "\n";
+	}
+
+	out.flush();
+
+	if (failures)
+	{
+		QTextStream(stderr) << failures << " settings did not save a readable package" << Qt::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+# ----------------------------------------------------
+# packagebench: times saving a multi-sheet workbook of
+# streamed rows at each package compression setting
+# ------------------------------------------------------
+
+TEMPLATE = app
+TARGET = packagebench
+QT = core gui
+CONFIG += console c++17
+CONFIG -= app_bundle
+INCLUDEPATH += ../.. ../../header
+QXLSX_PARENTPATH = ../../
+QXLSX_HEADERPATH = ../../header/
+QXLSX_SOURCEPATH = ../../source/
+include(../../QXlsx.pri)
+SOURCES += main.cpp
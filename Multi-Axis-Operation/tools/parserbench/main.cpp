@@ -0,0 +1,167 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cstring>
+#include "commandtree.h"
+
+//---------------------------------------------------------------------------
+// Microbenchmark of the remote command tree. Every command and query the
+// parser accepts is resolved repeatedly, in both short and long forms, and
+// the average cost per resolution is reported. Each input is also checked
+// against the CommandId it must resolve to, so a change to the tree that
+// breaks the grammar fails the run.
+//---------------------------------------------------------------------------
+
+struct BenchCommand
+{
+	const char *input;		// query inputs are the text before the '?'
+	bool isQuery;
+	CommandId expected;
+};
+
+static const BenchCommand benchCommands[] =
+{
+	// queries
+	{ "*IDN", true, QRY_IDN },
+	{ "ALIGN1", true, QRY_ALIGN1 },
+	{ "ALIGN1:CART", true, QRY_ALIGN1_CARTESIAN },
+	{ "ALIGN1:CARTESIAN", true, QRY_ALIGN1_CARTESIAN },
+	{ "ALIGN2", true, QRY_ALIGN2 },
+	{ "ALIGN2:CART", true, QRY_ALIGN2_CARTESIAN },
+	{ "FIELD", true, QRY_FIELD },
+	{ "FIELD:CART", true, QRY_FIELD_CARTESIAN },
+	{ "HIST", true, QRY_HISTORY },
+	{ "PERS", true, QRY_PERSISTENT },
+	{ "PERSISTENT", true, QRY_PERSISTENT },
+	{ "PLANE", true, QRY_PLANE },
+	{ "SEQ:STATE", true, QRY_SEQUENCE_STATE },
+	{ "STATE", true, QRY_STATE },
+	{ "SYST:ERR", true, QRY_SYSTEM_ERROR },
+	{ "SYSTEM:ERROR", true, QRY_SYSTEM_ERROR },
+	{ "SYST:ERR:COUN", true, QRY_SYSTEM_ERROR_COUNT },
+	{ "SYSTEM:ERROR:COUNT", true, QRY_SYSTEM_ERROR_COUNT },
+	{ "SYST:SUBS", true, QRY_SYSTEM_SUBSCRIBE },
+	{ "SYSTEM:FORMAT", true, QRY_SYSTEM_FORMAT },
+	{ "SYST:STAT", true, QRY_SYSTEM_STATS },
+	{ "TABLE:VEC", true, QRY_TABLE_VECTOR },
+	{ "TABLE:POLAR", true, QRY_TABLE_POLAR },
+	{ "TARG", true, QRY_TARGET },
+	{ "TARGET:CARTESIAN", true, QRY_TARGET_CARTESIAN },
+	{ "TARG:TIME", true, QRY_TARGET_TIME },
+	{ "UNITS", true, QRY_UNITS },
+
+	// commands
+	{ "*CLS", false, CMD_CLS },
+	{ "EXIT", false, CMD_EXIT },
+	{ "CONF:ALIGN1 1.0,45.0,90.0", false, CMD_CONF_ALIGN1 },
+	{ "CONFIGURE:ALIGN2 1.0,45.0,90.0", false, CMD_CONF_ALIGN2 },
+	{ "CONF:TARG:ALIGN1", false, CMD_CONF_TARGET_ALIGN1 },
+	{ "CONF:TARG:ALIGN2", false, CMD_CONF_TARGET_ALIGN2 },
+	{ "CONF:TARG:VEC 1.0,45.0,90.0,10", false, CMD_CONF_TARGET_VECTOR },
+	{ "configure:target:vector 1.0,45.0,90.0", false, CMD_CONF_TARGET_VECTOR },
+	{ "CONF:TARG:VEC:CART 0.1,0.2,0.3,10", false, CMD_CONF_TARGET_VECTOR_CARTESIAN },
+	{ "CONF:TARG:VEC:TAB 3", false, CMD_CONF_TARGET_VECTOR_TABLE },
+	{ "CONF:TARG:POL 1.0,30.0,10", false, CMD_CONF_TARGET_POLAR },
+	{ "CONF:TARGET:POLAR:TABLE 2", false, CMD_CONF_TARGET_POLAR_TABLE },
+	{ "CONF:UNITS 1", false, CMD_CONF_UNITS },
+	{ "LOAD", false, CMD_LOAD },
+	{ "LOAD:SET /home/user/Settings.sav", false, CMD_LOAD_SETTINGS },
+	{ "LOAD:VECTOR /home/user/map.csv", false, CMD_LOAD_VECTOR },
+	{ "LOAD:POL /home/user/polar.csv", false, CMD_LOAD_POLAR },
+	{ "PAUSE", false, CMD_PAUSE },
+	{ "PERS 1", false, CMD_PERSISTENT },
+	{ "RAMP", false, CMD_RAMP },
+	{ "SAVE", false, CMD_SAVE },
+	{ "SAVE:SETTINGS /home/user/Settings.sav", false, CMD_SAVE_SETTINGS },
+	{ "SEQ:ABOR", false, CMD_SEQUENCE_ABORT },
+	{ "SEQUENCE:DEFINE 24", false, CMD_SEQUENCE_DEFINE },
+	{ "SEQ:LOAD /home/user/rotation.seq", false, CMD_SEQUENCE_LOAD },
+	{ "SEQ:RUN", false, CMD_SEQUENCE_RUN },
+	{ "SYST:CONN", false, CMD_SYSTEM_CONNECT },
+	{ "SYSTEM:DISCONNECT", false, CMD_SYSTEM_DISCONNECT },
+	{ "SYST:SUBSCRIBE STATE,TARGET,STEP,QUENCH", false, CMD_SYSTEM_SUBSCRIBE },
+	{ "SYST:UNS QUENCH", false, CMD_SYSTEM_UNSUBSCRIBE },
+	{ "SYST:FORM JSON", false, CMD_SYSTEM_FORMAT },
+	{ "TABLE:VECTOR 10000", false, CMD_TABLE_VECTOR },
+	{ "TABLE:POL 360", false, CMD_TABLE_POLAR },
+	{ "WAIT:HOLD 60", false, CMD_WAIT_HOLDING },
+	{ "WAIT:PERSISTENT 120", false, CMD_WAIT_PERSISTENT },
+	{ "wait:step 3,600", false, CMD_WAIT_STEP },
+	{ "ZERO", false, CMD_ZERO },
+
+	// no match
+	{ "FIELD:POLAR", true, CMD_NONE },
+	{ "CONF:TARG", false, CMD_NONE },
+	{ "SYST:RESET", false, CMD_NONE },
+	{ "BOGUS", false, CMD_NONE }
+};
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("parserbench");
+
+	QCommandLineParser cmdLineParse;
+	cmdLineParse.setApplicationDescription("Times resolution of the Multi-Axis Operation remote command set.");
+	cmdLineParse.addHelpOption();
+
+	QCommandLineOption iterationsOption(QStringList() << "n" << "iterations", "Resolutions per command (default 1000000).", "count", "1000000");
+	cmdLineParse.addOption(iterationsOption);
+
+	cmdLineParse.process(app);
+
+	QTextStream out(stdout);
+	int iterations = cmdLineParse.value(iterationsOption).toInt();
+
+	if (iterations <= 0)
+		iterations = 1000000;
+
+	const int numCommands = sizeof(benchCommands) / sizeof(benchCommands[0]);
+	char buffer[256];
+	char *args;
+	int failures = 0;
+	quint64 sink = 0;	// keeps the resolutions from being optimized away
+	qint64 totalNsec = 0;
+	QElapsedTimer timer;
+
+	out << "Command,ns/resolve\n";
+
+	for (int i = 0; i < numCommands; i++)
+	{
+		const BenchCommand &command = benchCommands[i];
+
+		strncpy(buffer, command.input, sizeof(buffer) - 1);
+		buffer[sizeof(buffer) - 1] = '\0';
+
+		if (resolveCommand(buffer, command.isQuery, &args) != command.expected)
+		{
+			out << command.input << (command.isQuery ? "?" : "") << ",FAILED\n";
+			failures++;
+			continue;
+		}
+
+		timer.start();
+
+		for (int j = 0; j < iterations; j++)
+			sink += resolveCommand(buffer, command.isQuery, &args);
+
+		qint64 nsec = timer.nsecsElapsed();
+		totalNsec += nsec;
+
+		out << "\"" << command.input << (command.isQuery ? "?" : "") << "\","
+			<< QString::number((double)nsec / iterations, 'f', 1) << "\n";
+	}
+
+	out << "Average," << QString::number((double)totalNsec / ((qint64)iterations * (numCommands - failures)), 'f', 1) << "\n";
+	out.flush();
+
+	if (failures)
+	{
+		QTextStream(stderr) << failures << " commands did not resolve as expected (" << sink << ")" << Qt::endl;
+		return 1;
+	}
+
+	return 0;
+}
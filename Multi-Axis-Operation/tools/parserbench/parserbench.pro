@@ -0,0 +1,13 @@
+# ----------------------------------------------------
+# parserbench: times resolution of the full remote
+# command set through the parser command tree
+# ------------------------------------------------------
+
+TEMPLATE = app
+TARGET = parserbench
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+INCLUDEPATH += ../..
+HEADERS += ../../commandtree.h
+SOURCES += main.cpp
@@ -0,0 +1,421 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <cstring>
+#include "commandtree.h"
+#include "recordframing.h"
+#include "binarytable.h"
+#include "resultsjournal.h"
+
+//---------------------------------------------------------------------------
+// Unit tests of the file and wire formats that are read outside the
+// application: scripting interface records, binary table files and
+// results journals, plus the command tree the parser resolves with.
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Decoded BINARY record, see recordframing.h for the layout
+//---------------------------------------------------------------------------
+struct DecodedRecord
+{
+	quint32 length = 0;
+	quint8 type = 0;
+	quint64 sequence = 0;
+	qint64 timestamp = 0;
+	QByteArray name;
+	QList<QVariant> fields;
+};
+
+static bool decodeBinaryRecord(const QByteArray &record, DecodedRecord *decoded)
+{
+	QDataStream stream(record);
+	quint16 nameLength, numFields;
+
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream >> decoded->length >> decoded->type >> decoded->sequence >> decoded->timestamp >> nameLength;
+
+	decoded->name.resize(nameLength);
+	stream.readRawData(decoded->name.data(), nameLength);
+	stream >> numFields;
+
+	for (int i = 0; i < numFields; i++)
+	{
+		quint8 type;
+
+		stream >> type;
+
+		if (type == FIELD_INTEGER)
+		{
+			qint64 value;
+
+			stream >> value;
+			decoded->fields.append(value);
+		}
+		else if (type == FIELD_REAL)
+		{
+			quint64 bits;
+			double value;
+
+			stream >> bits;
+			memcpy(&value, &bits, sizeof(value));
+			decoded->fields.append(value);
+		}
+		else
+		{
+			quint32 length;
+			QByteArray text;
+
+			stream >> length;
+			text.resize(length);
+			stream.readRawData(text.data(), length);
+			decoded->fields.append(QString::fromUtf8(text));
+		}
+	}
+
+	return stream.status() == QDataStream::Ok && stream.atEnd();
+}
+
+//---------------------------------------------------------------------------
+// Three row table: a numeric row, a row with a text cell and a Pass result
+// column, as the vector table is laid out
+//---------------------------------------------------------------------------
+static void fillTable(TableModel *table)
+{
+	table->setResultColumn(3);
+	table->setRowCount(3);
+	table->setValue(0, 0, 1.5);
+	table->setValue(0, 1, 45.0);
+	table->setValue(0, 2, 90.0);
+	table->setValue(1, 0, 0.1);
+	table->setText(1, 1, "hold");
+	table->setChecked(1, true);
+	table->setText(2, 2, "-2.25");
+}
+
+//---------------------------------------------------------------------------
+static ReportData journalRun(void)
+{
+	ReportData run;
+
+	run.magnetID = "MAG-1234";
+	run.magnitudeLimit = 3.0;
+	run.fieldUnits = TESLA;
+	run.timestamp = QDateTime::fromMSecsSinceEpoch(1760000000000);
+	run.axes[0].activate = true;
+	run.axes[0].ipAddress = "192.168.1.10";
+	run.results.headers << "Magnitude" << "Azimuth" << "Inclination" << "Pass/Fail";
+	run.results.resultColumn = 3;
+
+	return run;
+}
+
+//---------------------------------------------------------------------------
+class UnitTests : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void commandTree(void);
+	void recordText(void);
+	void recordJson(void);
+	void recordBinary(void);
+	void binaryTableRoundTrip(void);
+	void binaryTableRejectsHeaders(void);
+	void resultsJournalRoundTrip(void);
+	void resultsJournalTruncatedRecord(void);
+};
+
+//---------------------------------------------------------------------------
+void UnitTests::commandTree(void)
+{
+	char command[] = "conf:targ:vec 1.0,45.0,90.0";
+	char query[] = "SYST:ERR:COUN";
+	char extraQuery[] = "FIELD:CART 1";
+	char *args;
+
+	QCOMPARE(resolveCommand(command, false, &args), CMD_CONF_TARGET_VECTOR);
+	QCOMPARE(QByteArray(args), QByteArray("1.0,45.0,90.0"));
+	QCOMPARE(resolveCommand(query, true, &args), QRY_SYSTEM_ERROR_COUNT);
+	QCOMPARE(resolveCommand(extraQuery, true, &args), CMD_NONE);	// a query takes no arguments
+}
+
+//---------------------------------------------------------------------------
+void UnitTests::recordText(void)
+{
+	RecordFields fields;
+
+	fields.addInteger(-42);
+	fields.addReal(0.1);
+	fields.addReal(2.5, 3);
+	fields.addString("RAMPING");
+	fields.addString("a,b", true);
+
+	QCOMPARE(fields.toText(), QByteArray("-42,0.1,2.5,RAMPING,\"a,b\""));
+}
+
+//---------------------------------------------------------------------------
+void UnitTests::recordJson(void)
+{
+	RecordFields fields;
+
+	fields.addInteger(7);
+	fields.addReal(0.1);
+	fields.addString("say \"hi\"\n");
+
+	QByteArray record = frameRecord(FORMAT_JSON, RECORD_RESPONSE, 12, 1760000000123, "TARG?", fields);
+	QJsonParseError error;
+	QJsonObject object = QJsonDocument::fromJson(record, &error).object();
+
+	QVERIFY(record.endsWith('\n'));
+	QCOMPARE(int(record.count('\n')), 1);		// one record per line
+	QCOMPARE(error.error, QJsonParseError::NoError);
+	QCOMPARE(object.value("seq").toDouble(), 12.0);
+	QCOMPARE(object.value("ts").toDouble(), 1760000000123.0);
+	QCOMPARE(object.value("type").toString(), QString("response"));
+	QCOMPARE(object.value("name").toString(), QString("TARG?"));
+
+	QJsonArray values = object.value("fields").toArray();
+
+	QCOMPARE(int(values.count()), 3);
+	QCOMPARE(values[0].toDouble(), 7.0);
+	QCOMPARE(values[1].toDouble(), 0.1);	// shortest form round trips
+	QCOMPARE(values[2].toString(), QString("say \"hi\"\n"));
+}
+
+//---------------------------------------------------------------------------
+void UnitTests::recordBinary(void)
+{
+	RecordFields fields;
+	DecodedRecord decoded;
+
+	fields.addInteger(Q_INT64_C(-9000000000));
+	fields.addReal(1.0 / 3.0, 4);
+	fields.addString(QString::fromUtf8("\xc2\xb0" "C"));
+
+	QByteArray record = frameRecord(FORMAT_BINARY, RECORD_EVENT, 99, -1, "QUENCH", fields);
+
+	QVERIFY(decodeBinaryRecord(record, &decoded));
+	QCOMPARE(decoded.length, static_cast<quint32>(record.size() - sizeof(quint32)));
+	QCOMPARE(decoded.type, static_cast<quint8>(RECORD_EVENT));
+	QCOMPARE(decoded.sequence, static_cast<quint64>(99));
+	QCOMPARE(decoded.timestamp, static_cast<qint64>(-1));
+	QCOMPARE(decoded.name, QByteArray("QUENCH"));
+	QCOMPARE(int(decoded.fields.count()), 3);
+	QCOMPARE(decoded.fields[0].toLongLong(), Q_INT64_C(-9000000000));
+	QCOMPARE(decoded.fields[1].toDouble(), 1.0 / 3.0);		// full precision, not the TEXT digits
+	QCOMPARE(decoded.fields[2].toString(), QString::fromUtf8("\xc2\xb0" "C"));
+}
+
+//---------------------------------------------------------------------------
+void UnitTests::binaryTableRoundTrip(void)
+{
+	QTemporaryDir dir;
+	QString filename = dir.filePath("table.vtb");
+	TableModel table(4);
+	TableContents contents;
+	TableFileInfo info;
+	QFile out(filename);
+
+	fillTable(&table);
+	table.setResult(0, RESULT_PASS);
+	table.getContents(&contents);
+	info.fieldUnits = TESLA;
+
+	QVERIFY(out.open(QIODevice::WriteOnly));
+	QVERIFY(BinaryTable::write(&out, contents, info));
+	out.close();
+
+	BinaryTable in;
+	TableContents rows;
+
+	QVERIFY2(in.open(filename), qPrintable(in.errorString()));
+	QCOMPARE(in.info().columns, 4);
+	QCOMPARE(in.info().rows, 3);
+	QCOMPARE(in.info().fieldUnits, static_cast<qint32>(TESLA));
+	QCOMPARE(in.value(0, 1), 45.0);
+	QCOMPARE(in.state(1, 1), CELL_TEXT);
+	QCOMPARE(in.state(2, 2), CELL_VALUE);
+	QCOMPARE(in.value(2, 2), -2.25);
+	QCOMPARE(in.result(0), RESULT_PASS);
+
+	QVERIFY(in.readRows(1, 2, &rows));
+	QCOMPARE(rows.rows, 2);
+	QCOMPARE(rows.values[0][0], 0.1);
+	QCOMPARE(rows.texts.value(TableModel::textKey(0, 1)), QString("hold"));
+	QVERIFY(!in.readRows(2, 2, &rows));
+}
+
+//---------------------------------------------------------------------------
+void UnitTests::binaryTableRejectsHeaders(void)
+{
+	QTemporaryDir dir;
+	TableModel table(4);
+	TableContents contents;
+	QBuffer buffer;
+	TableFileInfo info;
+	QString errorString;
+	BinaryTable in;
+
+	fillTable(&table);
+	table.getContents(&contents);
+	buffer.open(QIODevice::WriteOnly);
+	QVERIFY(BinaryTable::write(&buffer, contents, info));
+
+	const QByteArray valid = buffer.data();
+
+	auto writeFile = [&dir](const QString &name, const QByteArray &data)
+	{
+		QString filename = dir.filePath(name);
+		QFile file(filename);
+
+		file.open(QIODevice::WriteOnly);
+		file.write(data);
+
+		return filename;
+	};
+
+	// not a binary table at all, so the text loaders get it
+	QString text = writeFile("text.vtb", "Magnitude,Azimuth\n1,2\n");
+
+	QVERIFY(!BinaryTable::readInfo(text, &info, &errorString));
+	QVERIFY(!in.open(text));
+	QVERIFY(in.errorString().contains("is not a binary table file"));
+
+	// header shorter than version 1
+	QString shortHeader = writeFile("short.vtb", valid.left(40));
+
+	QVERIFY(BinaryTable::readInfo(shortHeader, &info, &errorString));
+	QVERIFY(errorString.contains("header is truncated"));
+	QVERIFY(!in.open(shortHeader));
+
+	// a later, unknown version
+	QByteArray future = valid;
+	quint32 version = qToLittleEndian<quint32>(2);
+
+	memcpy(future.data() + 8, &version, sizeof(version));
+	QString futureVersion = writeFile("future.vtb", future);
+
+	QVERIFY(BinaryTable::readInfo(futureVersion, &info, &errorString));
+	QVERIFY(errorString.contains("unsupported table file version 2"));
+	QVERIFY(!in.open(futureVersion));
+
+	// sections cut off after the header
+	QString truncated = writeFile("truncated.vtb", valid.left(valid.size() - 1));
+
+	QVERIFY(BinaryTable::readInfo(truncated, &info, &errorString));
+	QVERIFY(errorString.contains("truncated or corrupt"));
+	QVERIFY(!in.open(truncated));
+
+	// a row count the sections cannot hold
+	QByteArray oversized = valid;
+	quint32 rows = qToLittleEndian<quint32>(1000000);
+
+	memcpy(oversized.data() + 36, &rows, sizeof(rows));
+	QString tooManyRows = writeFile("rows.vtb", oversized);
+
+	QVERIFY(!in.open(tooManyRows));
+	QVERIFY(in.errorString().contains("truncated or corrupt"));
+}
+
+//---------------------------------------------------------------------------
+void UnitTests::resultsJournalRoundTrip(void)
+{
+	QTemporaryDir dir;
+	QString filename = dir.filePath("Results/Results-run.maxres");
+	TableModel table(4);
+	ResultsJournal journal;
+
+	fillTable(&table);
+	QVERIFY(journal.open(filename, journalRun()));
+
+	journal.stepStarted(0, &table);
+	table.setResult(0, RESULT_PASS);
+	journal.stepResult(0, &table);
+	journal.stepResult(0, &table);		// unchanged result, not written again
+	journal.appStarted();
+	journal.appFinished(3, "app output");
+	journal.stepEnded(0);
+	journal.stepStarted(1, &table);
+	journal.stepEnded(1);
+	journal.close();
+
+	ResultsJournalReader reader;
+	JournalStep step;
+
+	QVERIFY2(reader.open(filename), qPrintable(reader.errorString()));
+	QCOMPARE(reader.run().magnetID, QString("MAG-1234"));
+	QCOMPARE(reader.run().magnitudeLimit, 3.0);
+	QCOMPARE(reader.run().timestamp.toMSecsSinceEpoch(), Q_INT64_C(1760000000000));
+	QCOMPARE(reader.run().axes[0].ipAddress, QString("192.168.1.10"));
+	QCOMPARE(int(reader.run().results.headers.count()), 4);
+	QCOMPARE(reader.run().results.resultColumn, 3);
+
+	QVERIFY(reader.readStep(&step));
+	QCOMPARE(step.row, 0);
+	QCOMPARE(step.result, static_cast<quint8>(RESULT_PASS));
+	QVERIFY(step.started > 0);
+	QVERIFY(step.completed >= step.started);
+	QCOMPARE(step.values.value(1), 45.0);
+	QVERIFY(step.appFinished);
+	QCOMPARE(step.appExitCode, 3);
+	QCOMPARE(step.appOutput, QString("app output"));
+
+	QVERIFY(reader.readStep(&step));
+	QCOMPARE(step.row, 1);
+	QVERIFY(step.checked);
+	QCOMPARE(step.states.value(1), static_cast<quint8>(CELL_TEXT));
+	QCOMPARE(step.texts.value(1), QString("hold"));
+	QVERIFY(!step.appFinished);
+
+	QVERIFY(!reader.readStep(&step));
+}
+
+//---------------------------------------------------------------------------
+// A crash while a record is written leaves it incomplete; the reader stops
+// before it and keeps every step that was started
+//---------------------------------------------------------------------------
+void UnitTests::resultsJournalTruncatedRecord(void)
+{
+	QTemporaryDir dir;
+	QString filename = dir.filePath("Results-crash.maxres");
+	TableModel table(4);
+	ResultsJournal journal;
+
+	fillTable(&table);
+	QVERIFY(journal.open(filename, journalRun()));
+	journal.stepStarted(0, &table);
+	journal.stepEnded(0);
+	journal.stepStarted(1, &table);
+	journal.stepEnded(1);
+	journal.close();
+
+	QFile file(filename);
+
+	QVERIFY(file.resize(file.size() - 3));	// cuts into the last step end record
+
+	ResultsJournalReader reader;
+	JournalStep step;
+
+	QVERIFY(reader.open(filename));
+
+	QVERIFY(reader.readStep(&step));
+	QCOMPARE(step.row, 0);
+	QVERIFY(step.completed > 0);
+
+	QVERIFY(reader.readStep(&step));
+	QCOMPARE(step.row, 1);
+	QCOMPARE(step.completed, Q_INT64_C(0));	// its end record was lost
+
+	QVERIFY(!reader.readStep(&step));
+
+	// a journal cut inside its run record is not a journal
+	QVERIFY(file.resize(20));
+	QVERIFY(!reader.open(filename));
+	QVERIFY(reader.errorString().contains("is not a results journal"));
+}
+
+QTEST_GUILESS_MAIN(UnitTests)
+
+#include "main.moc"
@@ -0,0 +1,24 @@
+# ----------------------------------------------------
+# unittests: Qt Test cases for the remote command tree,
+# record framing, binary table and results journal
+# formats; run with "make check"
+# ------------------------------------------------------
+
+TEMPLATE = app
+TARGET = unittests
+QT = core gui widgets testlib
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+INCLUDEPATH += ../..
+HEADERS += ../../commandtree.h \
+    ../../recordframing.h \
+    ../../binarytable.h \
+    ../../tablemodel.h
+SOURCES += main.cpp \
+    ../../recordframing.cpp \
+    ../../binarytable.cpp \
+    ../../tablemodel.cpp \
+    ../../resultsjournal.cpp
+# resultsjournal.h reaches the magnet parameter types through
+# reportwriter.h and magnetparams.h, which includes the generated form
+FORMS += ../../magnetparams.ui
@@ -0,0 +1,376 @@
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QBuffer>
+#include <QMap>
+#include <QSharedPointer>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include "header/xlsxdocument.h"
+#include "header/xlsxcell.h"
+#include "header/xlsxcellreference.h"
+#include "header/xlsxcelltable_p.h"
+#include "header/xlsxstyles_p.h"
+
+using namespace QXlsx;
+
+//---------------------------------------------------------------------------
+// Benchmark of worksheet cell storage. A report sized sheet is filled,
+// saved as sheet XML and loaded back, once into the map of maps of Cell
+// objects QXlsx used to keep per worksheet and once into the dense
+// CellTable it keeps now, with the time and heap allocations of each
+// phase reported. Both stores must save byte-identical XML. The current
+// Document is then timed end to end on the same rows.
+//
+// With glibc every malloc, calloc and realloc is counted, which includes
+// operator new and the Qt containers. Elsewhere only operator new is.
+//---------------------------------------------------------------------------
+
+const int BENCH_COLUMNS = 12;		// report row: 8 table columns, times, exit code, output
+
+static std::atomic<quint64> allocations(0);
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+extern "C" void *malloc(size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, size);
+}
+#else
+void *operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void *ptr = std::malloc(size ? size : 1))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+// worksheet storage before the cell table, one heap Cell per cell
+typedef QMap<int, QMap<int, QSharedPointer<Cell> > > CellMap;
+
+//---------------------------------------------------------------------------
+// Times a phase and counts the allocations made during it
+//---------------------------------------------------------------------------
+class PhaseTimer
+{
+public:
+	PhaseTimer() { start(); }
+	void start(void) { first = allocations.load(); timer.start(); }
+	double msec(void) { return timer.nsecsElapsed() / 1.0e6; }
+	quint64 count(void) { return allocations.load() - first; }
+
+private:
+	QElapsedTimer timer;
+	quint64 first;
+};
+
+//---------------------------------------------------------------------------
+// Cell (row, column) of the generated sheet, laid out like a report row
+//---------------------------------------------------------------------------
+static QVariant cellValue(int row, int column, Cell::CellType *type, int *style)
+{
+	if (column <= 8)
+	{
+		*type = Cell::NumberType;
+		*style = 1;
+		return row * 0.001 * column;
+	}
+	else if (column <= 10)
+	{
+		*type = Cell::StringType;
+		*style = 2;
+		return QString("2026-10-19 12:%1:%2").arg((row / 60) % 60, 2, 10, QChar('0')).arg(row % 60, 2, 10, QChar('0'));
+	}
+	else if (column == 11)
+	{
+		*type = Cell::NumberType;
+		*style = 2;
+		return double(row % 3);
+	}
+
+	*type = Cell::StringType;
+	*style = -1;
+	return QString("ok");
+}
+
+//---------------------------------------------------------------------------
+static void writeCell(QXmlStreamWriter &writer, int row, int column, Cell::CellType type, qint32 xfIndex, const QVariant &value)
+{
+	writer.writeStartElement(QStringLiteral("c"));
+	writer.writeAttribute(QStringLiteral("r"), CellReference(row, column).toString());
+
+	if (xfIndex >= 0)
+		writer.writeAttribute(QStringLiteral("s"), QString::number(xfIndex));
+
+	if (type == Cell::StringType)
+	{
+		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("str"));
+		writer.writeTextElement(QStringLiteral("v"), value.toString());
+	}
+	else
+	{
+		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("n"));
+
+		if (value.isValid())
+			writer.writeTextElement(QStringLiteral("v"), QString::number(value.toDouble(), 'g', 15));
+	}
+
+	writer.writeEndElement(); // c
+}
+
+//---------------------------------------------------------------------------
+static QByteArray saveMap(const CellMap &cells)
+{
+	QByteArray xml;
+	QXmlStreamWriter writer(&xml);
+
+	writer.writeStartElement(QStringLiteral("sheetData"));
+
+	for (auto row = cells.constBegin(); row != cells.constEnd(); ++row)
+	{
+		writer.writeStartElement(QStringLiteral("row"));
+		writer.writeAttribute(QStringLiteral("r"), QString::number(row.key()));
+
+		for (auto cell = row->constBegin(); cell != row->constEnd(); ++cell)
+		{
+			const Format format = cell.value()->format();
+			writeCell(writer, row.key(), cell.key(), cell.value()->cellType(), format.isEmpty() ? -1 : format.xfIndex(), cell.value()->value());
+		}
+
+		writer.writeEndElement(); // row
+	}
+
+	writer.writeEndElement(); // sheetData
+
+	return xml;
+}
+
+//---------------------------------------------------------------------------
+static QByteArray saveTable(const CellTable &cells)
+{
+	QByteArray xml;
+	QXmlStreamWriter writer(&xml);
+
+	writer.writeStartElement(QStringLiteral("sheetData"));
+
+	for (const CellTable::Row &row : cells.rows())
+	{
+		writer.writeStartElement(QStringLiteral("row"));
+		writer.writeAttribute(QStringLiteral("r"), QString::number(row.row));
+
+		for (const CellTable::Record &record : row.cells)
+			writeCell(writer, row.row, record.column, cells.cellType(record), cells.cellXfIndex(record), cells.cellValue(record));
+
+		writer.writeEndElement(); // row
+	}
+
+	writer.writeEndElement(); // sheetData
+
+	return xml;
+}
+
+//---------------------------------------------------------------------------
+// Parses sheet XML as Worksheet does and hands each cell to insert
+//---------------------------------------------------------------------------
+template <typename Insert>
+static void loadSheet(const QByteArray &xml, Insert insert)
+{
+	QXmlStreamReader reader(xml);
+
+	while (!reader.atEnd())
+	{
+		if (reader.readNextStartElement() && reader.name() == QLatin1String("c"))
+		{
+			QXmlStreamAttributes attributes = reader.attributes();
+			CellReference pos(attributes.value(QLatin1String("r")).toString());
+			qint32 style = attributes.hasAttribute(QLatin1String("s")) ? attributes.value(QLatin1String("s")).toString().toInt() : -1;
+			bool isString = attributes.value(QLatin1String("t")) == QLatin1String("str");
+			QVariant value;
+
+			while (reader.readNextStartElement())
+			{
+				if (reader.name() == QLatin1String("v"))
+				{
+					QString text = reader.readElementText();
+					value = isString ? QVariant(text) : QVariant(text.toDouble());
+				}
+				else
+					reader.skipCurrentElement();
+			}
+
+			insert(pos.row(), pos.column(), isString ? Cell::StringType : Cell::NumberType, style, value);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+static void report(QTextStream &out, const char *storage, const char *phase, PhaseTimer &timer)
+{
+	double msec = timer.msec();
+	quint64 count = timer.count();
+
+	out << storage << "," << phase << "," << QString::number(msec, 'f', 2) << "," << count << "\n";
+	out.flush();
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("xlsxbench");
+
+	QCommandLineParser cmdLineParse;
+	cmdLineParse.setApplicationDescription("Compares QXlsx worksheet cell storage for load time, save time and allocations.");
+	cmdLineParse.addHelpOption();
+
+	QCommandLineOption rowsOption(QStringList() << "r" << "rows", "Rows in the sheet (default 20000).", "count", "20000");
+	cmdLineParse.addOption(rowsOption);
+
+	cmdLineParse.process(app);
+
+	QTextStream out(stdout);
+	int rows = cmdLineParse.value(rowsOption).toInt();
+
+	if (rows <= 0)
+		rows = 20000;
+
+	// report formats, registered so they carry their style index
+	Styles styles(Styles::F_NewFromScratch);
+	Format alignRightFormat;
+	Format alignCenterFormat;
+	alignRightFormat.setHorizontalAlignment(Format::AlignRight);
+	alignCenterFormat.setHorizontalAlignment(Format::AlignHCenter);
+	styles.addXfFormat(alignRightFormat);
+	styles.addXfFormat(alignCenterFormat);
+
+	const Format formats[3] = { Format(), alignRightFormat, alignCenterFormat };
+	Cell::CellType type;
+	int style;
+	PhaseTimer timer;
+
+	out << "Storage,Phase,msec,allocations\n";
+
+	// map of Cell objects
+	CellMap cellMap;
+
+	timer.start();
+	for (int i = 1; i <= rows; i++)
+	{
+		for (int j = 1; j <= BENCH_COLUMNS; j++)
+		{
+			QVariant value = cellValue(i, j, &type, &style);
+			cellMap[i][j] = QSharedPointer<Cell>(new Cell(value, type, formats[qMax(style, 0)]));
+		}
+	}
+	report(out, "CellMap", "fill", timer);
+
+	timer.start();
+	QByteArray mapXml = saveMap(cellMap);
+	report(out, "CellMap", "save", timer);
+
+	cellMap.clear();
+
+	timer.start();
+	loadSheet(mapXml, [&](int row, int column, Cell::CellType cellType, qint32 styleIndex, const QVariant &value)
+	{
+		cellMap[row][column] = QSharedPointer<Cell>(new Cell(value, cellType, styles.xfFormat(styleIndex), Q_NULLPTR, styleIndex));
+	});
+	report(out, "CellMap", "load", timer);
+
+	cellMap.clear();
+
+	// dense cell table
+	CellTable cellTable;
+
+	timer.start();
+	for (int i = 1; i <= rows; i++)
+	{
+		for (int j = 1; j <= BENCH_COLUMNS; j++)
+		{
+			QVariant value = cellValue(i, j, &type, &style);
+			cellTable.insert(i, j, value, type, CellTable::xfIndexOf(formats[qMax(style, 0)]));
+		}
+	}
+	report(out, "CellTable", "fill", timer);
+
+	timer.start();
+	QByteArray tableXml = saveTable(cellTable);
+	report(out, "CellTable", "save", timer);
+
+	cellTable.clear();
+
+	timer.start();
+	loadSheet(tableXml, [&](int row, int column, Cell::CellType cellType, qint32 styleIndex, const QVariant &value)
+	{
+		cellTable.insert(row, column, value, cellType, CellTable::xfIndexOf(styles.xfFormat(styleIndex)), styleIndex);
+	});
+	report(out, "CellTable", "load", timer);
+
+	cellTable.clear();
+
+	// the whole document, as the report writer uses it
+	QBuffer package;
+
+	{
+		Document xlsx;
+
+		timer.start();
+		for (int i = 1; i <= rows; i++)
+		{
+			for (int j = 1; j <= BENCH_COLUMNS; j++)
+			{
+				QVariant value = cellValue(i, j, &type, &style);
+				xlsx.write(i, j, value, formats[qMax(style, 0)]);
+			}
+		}
+		report(out, "Document", "fill", timer);
+
+		package.open(QIODevice::WriteOnly);
+		timer.start();
+		xlsx.saveAs(&package);
+		report(out, "Document", "save", timer);
+		package.close();
+	}
+
+	package.open(QIODevice::ReadOnly);
+	timer.start();
+	Document loaded(&package);
+	report(out, "Document", "load", timer);
+
+	if (mapXml != tableXml || !loaded.load() || loaded.read(rows, BENCH_COLUMNS).toString() != "ok")
+	{
+		QTextStream(stderr) << "Cell storage results differ" << Qt::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,17 @@
+# ----------------------------------------------------
+# xlsxbench: compares the map-of-maps cell storage
+# QXlsx used to have with the dense CellTable for load
+# time, save time and heap allocations
+# ------------------------------------------------------
+
+TEMPLATE = app
+TARGET = xlsxbench
+QT = core gui
+CONFIG += console c++17
+CONFIG -= app_bundle
+INCLUDEPATH += ../.. ../../header
+QXLSX_PARENTPATH = ../../
+QXLSX_HEADERPATH = ../../header/
+QXLSX_SOURCEPATH = ../../source/
+include(../../QXlsx.pri)
+SOURCES += main.cpp